@@ -18,6 +18,8 @@ limitations under the License.
 #include <algorithm>
 #include <atomic>
 #include <memory>
+#include <optional>
+#include <queue>
 #include <utility>
 #include <vector>
 
@@ -36,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_ready_queue.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
@@ -62,6 +65,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -170,12 +174,15 @@ class ExecutorImpl : public Executor {
       is_expensive_.resize(gview.num_nodes());
       cost_estimates_ =
           std::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
+      priorities_ =
+          std::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
       for (int32_t i = 0; i < gview.num_nodes(); ++i) {
         if (gview.node(i)) {
           is_expensive_[i] =
               gview.node(i)->kernel && gview.node(i)->kernel->IsExpensive();
           cost_estimates_[i] = kInitialCostEstimateCycles;
         }
+        priorities_[i] = 0;
       }
     }
 
@@ -210,17 +217,103 @@ class ExecutorImpl : public Executor {
       cost_estimate.store(new_estimate, std::memory_order_relaxed);
     }
 
+    // Returns the critical-path priority of the given node: the estimated
+    // cost, in CPU cycles, of the most expensive path from the node to the end
+    // of the graph. It is 0 until `MaybeUpdatePriorities()` has been called.
+    uint64 Priority(const NodeItem& node) const {
+      return priorities_[node.node_id].load(std::memory_order_relaxed);
+    }
+
+    // Recomputes the critical-path priorities from the current cost estimates
+    // on the first call and then every `kPriorityUpdateIntervalSteps` calls.
+    // Called at the start of every step that schedules by priority, so that
+    // the priorities follow the costs measured in previous steps.
+    void MaybeUpdatePriorities(const GraphView& gview) {
+      if (num_prioritized_steps_.fetch_add(1, std::memory_order_relaxed) %
+              kPriorityUpdateIntervalSteps !=
+          0) {
+        return;
+      }
+      mutex_lock l(priorities_mu_);
+      if (topological_order_.empty()) {
+        InitializeTopologicalOrder(gview);
+      }
+      for (auto it = topological_order_.rbegin();
+           it != topological_order_.rend(); ++it) {
+        const NodeItem& item = *gview.node(*it);
+        uint64 max_successor_priority = 0;
+        auto visit = [this, &max_successor_priority](int dst_id) {
+          max_successor_priority = std::max<uint64>(
+              max_successor_priority,
+              priorities_[dst_id].load(std::memory_order_relaxed));
+        };
+        if (!item.is_next_iteration) {
+          for (const EdgeInfo& e : item.output_edges()) visit(e.dst_id);
+          for (const ControlEdgeInfo& e : item.output_control_edges()) {
+            visit(e.dst_id);
+          }
+        }
+        const uint64 cost =
+            is_expensive_[*it]
+                ? cost_estimates_[*it].load(std::memory_order_relaxed)
+                : kInexpensiveCostEstimateCycles;
+        priorities_[*it].store(cost + max_successor_priority,
+                               std::memory_order_relaxed);
+      }
+    }
+
    private:
+    // Orders the nodes so that every node comes after its predecessors. The
+    // back edges of loops, which leave `NextIteration` nodes, are ignored.
+    void InitializeTopologicalOrder(const GraphView& gview)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(priorities_mu_) {
+      std::vector<int> num_pending(gview.num_nodes(), 0);
+      for (int32_t i = 0; i < gview.num_nodes(); ++i) {
+        const NodeItem* item = gview.node(i);
+        if (item == nullptr || item->is_next_iteration) continue;
+        for (const EdgeInfo& e : item->output_edges()) ++num_pending[e.dst_id];
+        for (const ControlEdgeInfo& e : item->output_control_edges()) {
+          ++num_pending[e.dst_id];
+        }
+      }
+      for (int32_t i = 0; i < gview.num_nodes(); ++i) {
+        if (gview.node(i) != nullptr && num_pending[i] == 0) {
+          topological_order_.push_back(i);
+        }
+      }
+      for (size_t i = 0; i < topological_order_.size(); ++i) {
+        const NodeItem& item = *gview.node(topological_order_[i]);
+        if (item.is_next_iteration) continue;
+        auto visit = [this, &num_pending](int dst_id) {
+          if (--num_pending[dst_id] == 0) topological_order_.push_back(dst_id);
+        };
+        for (const EdgeInfo& e : item.output_edges()) visit(e.dst_id);
+        for (const ControlEdgeInfo& e : item.output_control_edges()) {
+          visit(e.dst_id);
+        }
+      }
+    }
+
     // Initial time (in CPU cycles) we expect an operation to take.  Used to
     // determine whether an operation should be place in a threadpool.
     // Operations start out "expensive".
     static constexpr uint64 kInitialCostEstimateCycles = 100 * 1000 * 1000;
     static constexpr uint64 kOpIsExpensiveThresholdCycles = 8000;
     static constexpr uint64 kCostDecay = 10;
+    // Cost assumed for kernels that are not timed because they do not have
+    // the expensive marker.
+    static constexpr uint64 kInexpensiveCostEstimateCycles = 1000;
+    static constexpr uint64 kPriorityUpdateIntervalSteps = 16;
 
     std::vector<bool> is_expensive_;
     // std::unique_ptr<std::atomic<bool>[]> is_expensive_;
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
+
+    std::unique_ptr<std::atomic_uint_fast64_t[]> priorities_;
+    std::atomic<uint64> num_prioritized_steps_{0};
+    mutex priorities_mu_;
+    // Initialized by the first call to `MaybeUpdatePriorities()`.
+    std::vector<int> topological_order_ TF_GUARDED_BY(priorities_mu_);
   };
 
   ImmutableExecutorState immutable_state_;
@@ -346,6 +439,77 @@ class ExecutorState {
   template <typename Closure>
   void RunTask(Closure&& c, int sample_rate = 0);
 
+  // A node waiting in the work-stealing ready queue.
+  struct StealableNode {
+    TaggedNode tagged_node;
+    int64_t scheduled_nsec;
+  };
+
+  // State shared between this executor state and the closures that drain the
+  // work-stealing ready queue. It is reference counted because a draining
+  // closure may still inspect the queue after the last node has finished and
+  // this `ExecutorState` has been deleted.
+  struct WorkStealingState {
+    explicit WorkStealingState(int num_workers)
+        : queue(num_workers), num_active_workers(0) {}
+
+    WorkStealingReadyQueue<StealableNode> queue;
+    std::atomic<int> num_active_workers;
+
+    // Increments `num_active_workers` unless all workers are already active.
+    // Returns true if the caller became responsible for draining the queue.
+    bool TryStartWorker() {
+      int active = num_active_workers.load();
+      while (active < queue.num_workers()) {
+        if (num_active_workers.compare_exchange_weak(active, active + 1)) {
+          return true;
+        }
+      }
+      return false;
+    }
+  };
+
+  // Pushes `tagged_node` onto the calling thread's work-stealing deque and
+  // starts a draining closure if not all workers are busy.
+  //
+  // REQUIRES: `work_stealing_ != nullptr`.
+  void ScheduleStealable(const TaggedNode& tagged_node, int64_t scheduled_nsec);
+
+  // Processes nodes from the work-stealing ready queue until it is empty.
+  //
+  // NOTE: `state` may be deleted while this function runs; it is only
+  // dereferenced while a node that belongs to it is outstanding.
+  static void RunStealingWorker(ExecutorState* state,
+                                std::shared_ptr<WorkStealingState> ws);
+
+  // A node waiting in the priority ready queue. Nodes with equal priorities
+  // are run in the order in which they became ready.
+  struct PrioritizedNode {
+    uint64 priority;
+    int64_t sequence_number;
+    TaggedNode tagged_node;
+    int64_t scheduled_nsec;
+
+    bool operator<(const PrioritizedNode& other) const {
+      if (priority != other.priority) return priority < other.priority;
+      return sequence_number > other.sequence_number;
+    }
+  };
+
+  // Pushes `tagged_node` onto the priority ready queue and hands a closure to
+  // `runner_` that runs the node with the highest priority in the queue at
+  // the time the closure starts, which is not necessarily `tagged_node`.
+  //
+  // REQUIRES: `use_critical_path_priorities_`.
+  void SchedulePrioritized(const TaggedNode& tagged_node,
+                           int64_t scheduled_nsec);
+
+  // Returns true if `a` should run before `b` in critical-path order.
+  bool HasHigherPriority(const TaggedNode& a, const TaggedNode& b) const {
+    return kernel_stats_->Priority(*a.node_item) >
+           kernel_stats_->Priority(*b.node_item);
+  }
+
   // Clean up when this executor is done.
   void Finish();
   void ScheduleFinish();
@@ -398,6 +562,17 @@ class ExecutorState {
   bool sync_on_finish_;
   const bool run_all_kernels_inline_;
 
+  // Non-null iff `Executor::Args::use_work_stealing_ready_queue` is true.
+  std::shared_ptr<WorkStealingState> work_stealing_;
+
+  // True iff `Executor::Args::use_critical_path_priorities` is true and no
+  // other scheduling mode overrides it.
+  const bool use_critical_path_priorities_;
+  mutex priority_queue_mu_;
+  std::priority_queue<PrioritizedNode> priority_queue_
+      TF_GUARDED_BY(priority_queue_mu_);
+  int64_t next_sequence_number_ TF_GUARDED_BY(priority_queue_mu_) = 0;
+
   PropagatorStateType propagator_;
 
   // Invoked when the execution finishes.
@@ -446,6 +621,9 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
       run_all_kernels_inline_(args.run_all_kernels_inline),
+      use_critical_path_priorities_(args.use_critical_path_priorities &&
+                                    !args.run_all_kernels_inline &&
+                                    !args.use_work_stealing_ready_queue),
       propagator_(immutable_state, step_id_, vlog_),
       num_outstanding_ops_(0) {
   if (args.user_intra_op_threadpool != nullptr) {
@@ -453,6 +631,12 @@ ExecutorState<PropagatorStateType>::ExecutorState(
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (args.use_work_stealing_ready_queue && !run_all_kernels_inline_) {
+    const int num_workers = args.work_stealing_num_workers > 0
+                                ? args.work_stealing_num_workers
+                                : port::MaxParallelism();
+    work_stealing_ = std::make_shared<WorkStealingState>(num_workers);
+  }
 }
 
 template <class PropagatorStateType>
@@ -487,6 +671,58 @@ void ExecutorState<PropagatorStateType>::RunTask(Closure&& c, int sample_rate) {
   });
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleStealable(
+    const TaggedNode& tagged_node, int64_t scheduled_nsec) {
+  DCHECK(work_stealing_ != nullptr);
+  WorkStealingReadyQueue<StealableNode>& queue = work_stealing_->queue;
+  queue.Push(queue.CurrentWorker(), {tagged_node, scheduled_nsec});
+  if (work_stealing_->TryStartWorker()) {
+    RunTask([this, ws = work_stealing_]() mutable {
+      RunStealingWorker(this, std::move(ws));
+    });
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::RunStealingWorker(
+    ExecutorState* state, std::shared_ptr<WorkStealingState> ws) {
+  const int worker = ws->queue.CurrentWorker();
+  do {
+    while (std::optional<StealableNode> node = ws->queue.PopOrSteal(worker)) {
+      state->Process(node->tagged_node, node->scheduled_nsec);
+    }
+    ws->num_active_workers.fetch_sub(1);
+    // A producer may have pushed a node after our last pop, while it still
+    // observed this worker as active. Re-check the queue after retiring so
+    // that such a node is never left without a worker to run it.
+  } while (!ws->queue.empty() && ws->TryStartWorker());
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::SchedulePrioritized(
+    const TaggedNode& tagged_node, int64_t scheduled_nsec) {
+  DCHECK(use_critical_path_priorities_);
+  {
+    mutex_lock l(priority_queue_mu_);
+    priority_queue_.push({kernel_stats_->Priority(*tagged_node.node_item),
+                          next_sequence_number_++, tagged_node,
+                          scheduled_nsec});
+  }
+  // Every closure pops exactly one node, and there is one closure per pushed
+  // node, so the queue is not empty when a closure starts. The popped node is
+  // outstanding until it has been processed, which keeps `this` alive.
+  RunTask([this]() {
+    const PrioritizedNode node = [this]() {
+      mutex_lock l(priority_queue_mu_);
+      PrioritizedNode top = priority_queue_.top();
+      priority_queue_.pop();
+      return top;
+    }();
+    Process(node.tagged_node, node.scheduled_nsec);
+  });
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::RunAsync(Executor::DoneCallback done) {
   TaggedNodeSeq ready;
@@ -1300,8 +1536,14 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     if (inline_ready == nullptr) {
       // Schedule to run all the ready ops in thread pool.
       for (auto& tagged_node : *ready) {
-        RunTask([=]() { Process(tagged_node, scheduled_nsec); },
-                /*sample_rate=*/ready->size());
+        if (work_stealing_) {
+          ScheduleStealable(tagged_node, scheduled_nsec);
+        } else if (use_critical_path_priorities_) {
+          SchedulePrioritized(tagged_node, scheduled_nsec);
+        } else {
+          RunTask([=]() { Process(tagged_node, scheduled_nsec); },
+                  /*sample_rate=*/ready->size());
+        }
       }
     } else {
       for (auto& tagged_node : *ready) {
@@ -1309,6 +1551,10 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
         if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
           // Inline this inexpensive node.
           inline_ready->push_back(tagged_node);
+        } else if (use_critical_path_priorities_ && curr_expensive_node &&
+                   !HasHigherPriority(tagged_node, *curr_expensive_node)) {
+          // Keep the most critical expensive node for this thread.
+          expensive_nodes.push_back(tagged_node);
         } else {
           if (curr_expensive_node) {
             expensive_nodes.push_back(*curr_expensive_node);
@@ -1327,7 +1573,17 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
       }
     }
     if (!expensive_nodes.empty()) {
-      if (expensive_nodes.size() < kInlineScheduleReadyThreshold) {
+      if (work_stealing_) {
+        // Keep the expensive nodes on this worker's deque. Idle workers will
+        // steal them, so there is no need to fan them out via `runner_`.
+        for (auto& tagged_node : expensive_nodes) {
+          ScheduleStealable(tagged_node, scheduled_nsec);
+        }
+      } else if (use_critical_path_priorities_) {
+        for (auto& tagged_node : expensive_nodes) {
+          SchedulePrioritized(tagged_node, scheduled_nsec);
+        }
+      } else if (expensive_nodes.size() < kInlineScheduleReadyThreshold) {
         for (auto& tagged_node : expensive_nodes) {
           RunTask(std::bind(&ExecutorState::Process, this, tagged_node,
                             scheduled_nsec),
@@ -1508,6 +1764,9 @@ void ExecutorState<PropagatorStateType>::Finish() {
 }
 
 void ExecutorImpl::RunAsyncInternal(const Args& args, DoneCallback done) {
+  if (args.use_critical_path_priorities) {
+    kernel_stats_.MaybeUpdatePriorities(immutable_state_.graph_view());
+  }
   if (OpOrderDeterminismRequired()) {
     (new ExecutorState<OrderedPropagatorState>(args, immutable_state_,
                                                &kernel_stats_))
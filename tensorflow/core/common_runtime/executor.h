@@ -124,6 +124,24 @@ class Executor {
     // If true, all kernels will be treated as "inexpensive", and hence executed
     // on the scheduling thread.
     bool run_all_kernels_inline = false;
+
+    // If true, ready nodes that are not run inline are placed in a per-worker
+    // work-stealing ready queue instead of being handed to "runner" one by
+    // one. Successors of a node are preferentially run by the thread that
+    // produced their inputs, and idle workers steal from other workers'
+    // queues. Ignored if `run_all_kernels_inline` is true.
+    bool use_work_stealing_ready_queue = false;
+
+    // The maximum number of closures that drain the work-stealing ready queue
+    // concurrently for one step. If 0, `port::MaxParallelism()` is used.
+    int work_stealing_num_workers = 0;
+
+    // If true, ready nodes that are not run inline are handed to "runner" in
+    // order of decreasing critical-path priority, i.e. the estimated cost of
+    // the most expensive path from the node to the end of the graph. Node
+    // costs are measured in previous steps of the same executor. Ignored if
+    // `run_all_kernels_inline` or `use_work_stealing_ready_queue` is true.
+    bool use_critical_path_priorities = false;
   };
   typedef std::function<void(const Status&)> DoneCallback;
 
@@ -40,8 +40,10 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
@@ -102,6 +104,8 @@ class ExecutorTest : public ::testing::Test {
     args.rendezvous = rendez;
     args.stats_collector = &step_stats_collector_;
     args.runner = runner_;
+    args.use_work_stealing_ready_queue = use_work_stealing_ready_queue_;
+    args.use_critical_path_priorities = use_critical_path_priorities_;
     return exec_->Run(args);
   }
 
@@ -112,6 +116,8 @@ class ExecutorTest : public ::testing::Test {
   StepStats step_stats_;
   Executor::Args::Runner runner_;
   Rendezvous* rendez_ = nullptr;
+  bool use_work_stealing_ready_queue_ = false;
+  bool use_critical_path_priorities_ = false;
 };
 
 // A float val -> Tensor<float>
@@ -266,6 +272,38 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  use_work_stealing_ready_queue_ = true;
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, RandomTreeCriticalPathPriorities) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  use_critical_path_priorities_ = true;
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -544,6 +582,156 @@ static void BM_FeedInputFetchOutput(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_FeedInputFetchOutput);
 
+// How the executor of a scheduling benchmark hands ready nodes to its runner.
+enum class ReadyNodeScheduling {
+  kFifo,          // In the order in which they became ready.
+  kWorkStealing,  // Through the work-stealing ready queue.
+  kCriticalPath,  // In critical-path order.
+};
+
+// An executor on a CPU device for a graph of independent towers of
+// `matrix_size`x`matrix_size` matmuls, with one tower per element of
+// `tower_lengths`, that runs on a pool of `num_threads` threads.
+class MatmulTowersExecutor {
+ public:
+  MatmulTowersExecutor(const std::vector<int>& tower_lengths, int matrix_size,
+                       int num_threads, ReadyNodeScheduling scheduling)
+      : device_(DeviceFactory::NewDevice("CPU", {},
+                                         "/job:localhost/replica:0/task:0")),
+        pool_(Env::Default(), "matmul_towers", num_threads) {
+    Graph g(OpRegistry::Global());
+    Tensor m(DT_FLOAT, TensorShape({matrix_size, matrix_size}));
+    m.flat<float>().setConstant(1.0f / matrix_size);
+    for (const int length : tower_lengths) {
+      Node* cur = test::graph::Constant(&g, m);
+      Node* rhs = test::graph::Constant(&g, m);
+      for (int j = 0; j < length; ++j) {
+        cur = test::graph::Matmul(&g, cur, rhs, false, false);
+      }
+      num_nodes_ += 2 + length;
+    }
+    FixupSourceAndSinkEdges(&g);
+
+    const int version = g.versions().producer();
+    LocalExecutorParams params;
+    params.device = device_.get();
+    params.create_kernel =
+        [this, version](const std::shared_ptr<const NodeProperties>& props,
+                        OpKernel** kernel) {
+          return CreateNonCachedKernel(device_.get(), nullptr, props, version,
+                                       kernel);
+        };
+    params.delete_kernel = [](OpKernel* kernel) {
+      DeleteNonCachedKernel(kernel);
+    };
+    Executor* exec = nullptr;
+    TF_CHECK_OK(NewLocalExecutor(params, g, &exec));
+    executor_.reset(exec);
+
+    args_.runner = [this](std::function<void()> fn) { pool_.Schedule(fn); };
+    switch (scheduling) {
+      case ReadyNodeScheduling::kFifo:
+        break;
+      case ReadyNodeScheduling::kWorkStealing:
+        args_.use_work_stealing_ready_queue = true;
+        args_.work_stealing_num_workers = num_threads;
+        break;
+      case ReadyNodeScheduling::kCriticalPath:
+        args_.use_critical_path_priorities = true;
+        break;
+    }
+  }
+
+  Executor* executor() const { return executor_.get(); }
+  const Executor::Args& args() const { return args_; }
+  int num_nodes() const { return num_nodes_; }
+
+ private:
+  std::unique_ptr<Device> device_;
+  thread::ThreadPool pool_;
+  std::unique_ptr<Executor> executor_;
+  Executor::Args args_;
+  int num_nodes_ = 0;
+};
+
+// Runs `num_threads` concurrent steps of a graph made of 64 independent chains
+// of 8 small matmuls on a pool of `num_threads` threads, either handing every
+// expensive ready node to the runner (`use_work_stealing` == 0) or using the
+// work-stealing ready queue (`use_work_stealing` == 1).
+static void BM_executor_ready_queue(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const bool use_work_stealing = state.range(1) != 0;
+  MatmulTowersExecutor towers(
+      std::vector<int>(/*n=*/64, /*value=*/8), /*matrix_size=*/32,
+      num_threads,
+      use_work_stealing ? ReadyNodeScheduling::kWorkStealing
+                        : ReadyNodeScheduling::kFifo);
+
+  for (auto s : state) {
+    BlockingCounter counter(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      towers.executor()->RunAsync(towers.args(),
+                                  [&counter](const Status& status) {
+                                    TF_CHECK_OK(status);
+                                    counter.DecrementCount();
+                                  });
+    }
+    counter.Wait();
+  }
+
+  state.SetLabel(use_work_stealing ? "work_stealing" : "runner");
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_threads * towers.num_nodes());
+}
+
+BENCHMARK(BM_executor_ready_queue)
+    ->UseRealTime()
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1);
+
+// Runs one step at a time of a wide graph of 64 independent towers of 64x64
+// matmuls on a pool of `num_threads` threads. All towers but the last are
+// short, so the step latency is bound by how early the long tower starts.
+// Ready nodes are handed to the runner in the order in which they became ready
+// (`use_priorities` == 0) or in critical-path order (`use_priorities` == 1).
+static void BM_executor_critical_path(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const bool use_priorities = state.range(1) != 0;
+  std::vector<int> tower_lengths(/*n=*/64, /*value=*/2);
+  tower_lengths.back() = 32;
+  MatmulTowersExecutor towers(tower_lengths, /*matrix_size=*/64, num_threads,
+                              use_priorities
+                                  ? ReadyNodeScheduling::kCriticalPath
+                                  : ReadyNodeScheduling::kFifo);
+
+  // Warm up the cost estimates of the kernels.
+  for (int i = 0; i < 16; ++i) {
+    TF_CHECK_OK(towers.executor()->Run(towers.args()));
+  }
+  for (auto s : state) {
+    TF_CHECK_OK(towers.executor()->Run(towers.args()));
+  }
+
+  state.SetLabel(use_priorities ? "critical_path" : "fifo");
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          towers.num_nodes());
+}
+
+BENCHMARK(BM_executor_critical_path)
+    ->UseRealTime()
+    ->ArgPair(2, 0)
+    ->ArgPair(2, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1);
+
 Status ReplaceEdgeWithSendRecv(Graph* g, const Edge* edge, const string& tensor,
                                const string& sender,
                                const uint64 sender_incarnation,
@@ -152,10 +152,16 @@ LocalDevice::LocalDevice(const SessionOptions& options,
     }
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
-    // computations.
-    // TODO(tucker): NUMA for these too?
-    owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(
-        options, port::kNUMANoAffinity, nullptr));
+    // computations, whose threads are bound to the NUMA node of the device.
+    if (options.config.experimental().use_numa_affinity()) {
+      int numa_node = attributes.locality().numa_node();
+      owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(
+          options, numa_node,
+          ProcessState::singleton()->GetCPUAllocator(numa_node)));
+    } else {
+      owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(
+          options, port::kNUMANoAffinity, nullptr));
+    }
     tp_info = owned_tp_info_.get();
   }
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/process_state.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstring>
 #include <vector>
@@ -61,8 +62,25 @@ ProcessState::MemDesc ProcessState::PtrType(const void* ptr) {
   return MemDesc();
 }
 
+bool ProcessState::EnableNUMA() {
+  mutex_lock lock(mu_);
+  if (numa_enabled_.load(std::memory_order_relaxed)) return true;
+  if (!cpu_allocators_.empty()) {
+    LOG(WARNING) << "Not enabling NUMA allocation: "
+                 << cpu_allocators_.size()
+                 << " CPU allocator(s) were created before EnableNUMA.";
+    return false;
+  }
+  numa_enabled_.store(true, std::memory_order_release);
+  return true;
+}
+
 Allocator* ProcessState::GetCPUAllocator(int numa_node) {
-  if (!numa_enabled_ || numa_node == port::kNUMANoAffinity) numa_node = 0;
+  const int requested_numa_node = numa_node;
+  if (!numa_enabled_.load(std::memory_order_acquire) ||
+      numa_node == port::kNUMANoAffinity) {
+    numa_node = 0;
+  }
 
   // Check if allocator for the numa node is in lock-free cache.
   if (numa_node < cpu_allocators_cached_.load(std::memory_order_acquire)) {
@@ -70,6 +88,13 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
   }
 
   mutex_lock lock(mu_);
+  // EnableNUMA may have run since the unlocked read above; it only succeeds
+  // while `cpu_allocators_` is empty, so the value read under `mu_` is final
+  // for every allocator created below.
+  const bool numa_enabled = numa_enabled_.load(std::memory_order_relaxed);
+  if (numa_enabled && requested_numa_node != port::kNUMANoAffinity) {
+    numa_node = requested_numa_node;
+  }
   while (cpu_allocators_.size() <= static_cast<size_t>(numa_node)) {
     // If visitors have been defined we need an Allocator built from
     // a SubAllocator.  Prefer BFCAllocator, but fall back to PoolAllocator
@@ -84,9 +109,9 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
     }
     Allocator* allocator = nullptr;
     SubAllocator* sub_allocator =
-        (numa_enabled_ || alloc_visitors_defined || use_bfc_allocator)
+        (numa_enabled || alloc_visitors_defined || use_bfc_allocator)
             ? new BasicCPUAllocator(
-                  numa_enabled_ ? numa_node : port::kNUMANoAffinity,
+                  numa_enabled ? numa_node : port::kNUMANoAffinity,
                   cpu_alloc_visitors_, cpu_free_visitors_)
             : nullptr;
     if (use_bfc_allocator) {
@@ -101,8 +126,17 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
       int64_t cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
       DCHECK(sub_allocator);
 
+      int64_t thread_cache_max_bytes = 0;
+      status = ReadInt64FromEnvVar("TF_CPU_BFC_THREAD_CACHE_BYTES",
+                                   /*default_val=*/0, &thread_cache_max_bytes);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.message();
+      }
+
       BFCAllocator::Options allocator_opts;
       allocator_opts.allow_growth = true;
+      allocator_opts.thread_cache_max_bytes =
+          std::max<int64_t>(thread_cache_max_bytes, 0);
       allocator = new BFCAllocator(
           absl::WrapUnique(sub_allocator), cpu_mem_limit,
           /*name=*/"bfc_cpu_allocator_for_gpu", allocator_opts);
@@ -115,7 +149,7 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
           new PoolAllocator(/*pool_size_limit=*/100, /*auto_resize=*/true,
                             sub_allocator, new NoopRounder, "cpu_pool");
       VLOG(2) << "Using PoolAllocator for ProcessState CPU allocator "
-              << "numa_enabled_=" << numa_enabled_
+              << "numa_enabled_=" << numa_enabled
               << " numa_node=" << numa_node;
     } else {
       DCHECK(!sub_allocator);
@@ -168,6 +202,7 @@ void ProcessState::TestOnlyReset() {
     delete a;
   }
   cpu_al_.clear();
+  numa_enabled_.store(false, std::memory_order_relaxed);
 }
 
 }  // namespace tensorflow
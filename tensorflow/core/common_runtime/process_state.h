@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_STATE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_STATE_H_
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <unordered_map>
@@ -55,8 +56,11 @@ class ProcessState : public ProcessStateInterface {
   };
 
   // If NUMA Allocators are desired, call this before calling any
-  // Allocator accessor.
-  void EnableNUMA() { numa_enabled_ = true; }
+  // Allocator accessor. NUMA allocation is process-wide and can only be
+  // switched on while no CPU allocator exists, so that every node gets an
+  // allocator of the same kind. Returns false, leaving NUMA disabled, if it is
+  // called too late.
+  bool EnableNUMA();
 
   // Returns what we know about the memory at ptr.
   // If we know nothing, it's called CPU 0 with no other attributes.
@@ -92,7 +96,9 @@ class ProcessState : public ProcessStateInterface {
   void TestOnlyReset();
 
   static ProcessState* instance_;
-  bool numa_enabled_;
+  // Only set under `mu_`, but read without it on the GetCPUAllocator fast
+  // path.
+  std::atomic<bool> numa_enabled_;
 
   mutex mu_;
 
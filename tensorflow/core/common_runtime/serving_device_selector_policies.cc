@@ -28,4 +28,21 @@ int RoundRobinPolicy::SelectDevice(
   return ordinal_.fetch_add(1, std::memory_order_relaxed) % num_devices;
 }
 
+int LeastLoadedPolicy::SelectDevice(
+    absl::string_view program_fingerprint,
+    const ServingDeviceSelector::DeviceStates& device_states) {
+  const int num_devices = device_states.states.size();
+  const int start =
+      ordinal_.fetch_add(1, std::memory_order_relaxed) % num_devices;
+  int best_device = start;
+  for (int i = 1; i < num_devices; ++i) {
+    const int device = (start + i) % num_devices;
+    if (device_states.states[device].scheduled_programs.size() <
+        device_states.states[best_device].scheduled_programs.size()) {
+      best_device = device;
+    }
+  }
+  return best_device;
+}
+
 }  // namespace tensorflow
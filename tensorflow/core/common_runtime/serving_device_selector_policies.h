@@ -23,6 +23,7 @@ namespace tensorflow {
 
 enum class ServingDeviceSelectorPolicy {
   kRoundRobin,
+  kLeastLoaded,
 };
 
 class RoundRobinPolicy : public ServingDeviceSelector::Policy {
@@ -37,6 +38,21 @@ class RoundRobinPolicy : public ServingDeviceSelector::Policy {
   std::atomic<uint64_t> ordinal_;
 };
 
+// Selects the device with the fewest scheduled programs, breaking ties in
+// round-robin order. With one CPU device per NUMA node, this spreads requests
+// evenly across the nodes even when their programs take different times.
+class LeastLoadedPolicy : public ServingDeviceSelector::Policy {
+ public:
+  LeastLoadedPolicy() : ordinal_(0) {}
+
+  int SelectDevice(
+      absl::string_view program_fingerprint,
+      const ServingDeviceSelector::DeviceStates& device_states) override;
+
+ private:
+  std::atomic<uint64_t> ordinal_;
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SERVING_DEVICE_SELECTOR_POLICIES_H_
@@ -0,0 +1,55 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/serving_device_selector_policies.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/types/span.h"
+#include "tensorflow/core/common_runtime/serving_device_selector.h"
+
+namespace tensorflow {
+namespace {
+
+ServingDeviceSelector::DeviceStates MakeDeviceStates(
+    const std::vector<ServingDeviceSelector::DeviceState>& states) {
+  ServingDeviceSelector::DeviceStates device_states;
+  device_states.states = absl::MakeConstSpan(states);
+  return device_states;
+}
+
+TEST(LeastLoadedPolicy, SelectsDeviceWithFewestPrograms) {
+  std::vector<ServingDeviceSelector::DeviceState> states(3);
+  states[0].scheduled_programs.resize(2);
+  states[1].scheduled_programs.resize(1);
+  states[2].scheduled_programs.resize(3);
+
+  LeastLoadedPolicy policy;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(policy.SelectDevice("TensorFlow", MakeDeviceStates(states)), 1);
+  }
+}
+
+TEST(LeastLoadedPolicy, BreaksTiesInRoundRobinOrder) {
+  std::vector<ServingDeviceSelector::DeviceState> states(2);
+
+  LeastLoadedPolicy policy;
+  EXPECT_EQ(policy.SelectDevice("TensorFlow", MakeDeviceStates(states)), 0);
+  EXPECT_EQ(policy.SelectDevice("TensorFlow", MakeDeviceStates(states)), 1);
+  EXPECT_EQ(policy.SelectDevice("TensorFlow", MakeDeviceStates(states)), 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -38,7 +38,21 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<std::unique_ptr<Device>>* devices) override {
     int num_numa_nodes = port::NUMANumNodes();
-    int n = 1;
+    const bool use_numa_affinity =
+        options.config.experimental().use_numa_affinity();
+    if (use_numa_affinity && port::NUMAEnabled()) {
+      // Allocate the memory of each device on its own NUMA node instead of
+      // from one allocator that spans all nodes. This is a process-wide
+      // switch that only takes effect before the first CPU allocator is
+      // created, e.g. by the first session of the process.
+      if (!ProcessState::singleton()->EnableNUMA()) {
+        LOG(WARNING) << "use_numa_affinity is set, but CPU allocators already "
+                     << "exist; all CPU devices share the node 0 allocator.";
+      }
+    }
+    // With NUMA affinity, there is one CPU device, with its own intra-op
+    // thread pool and allocator, per NUMA node unless a count is requested.
+    int n = use_numa_affinity ? num_numa_nodes : 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
       n = iter->second;
@@ -46,7 +60,7 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:CPU:", i);
       std::unique_ptr<ThreadPoolDevice> tpd;
-      if (options.config.experimental().use_numa_affinity()) {
+      if (use_numa_affinity) {
         int numa_node = i % num_numa_nodes;
         if (numa_node != i) {
           LOG(INFO) << "Only " << num_numa_nodes
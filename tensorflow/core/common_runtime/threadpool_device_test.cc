@@ -15,7 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -68,5 +73,49 @@ TEST(ThreadPoolDeviceTest, CopyTensor) {
   device_context->Unref();
 }
 
+std::vector<std::unique_ptr<Device>> CreateCPUDevices(
+    const SessionOptions& options) {
+  std::vector<std::unique_ptr<Device>> devices;
+  DeviceFactory* factory = DeviceFactory::GetFactory("CPU");
+  EXPECT_NE(factory, nullptr);
+  if (factory == nullptr) return devices;
+  TF_EXPECT_OK(factory->CreateDevices(options, "/job:a/replica:0/task:0",
+                                      &devices));
+  return devices;
+}
+
+TEST(ThreadPoolDeviceFactoryTest, OneDevicePerNUMANodeByDefault) {
+  SessionOptions options;
+  options.config.mutable_experimental()->set_use_numa_affinity(true);
+  std::vector<std::unique_ptr<Device>> devices = CreateCPUDevices(options);
+
+  ASSERT_EQ(devices.size(), static_cast<size_t>(port::NUMANumNodes()));
+  for (int i = 0; i < static_cast<int>(devices.size()); ++i) {
+    EXPECT_EQ(devices[i]->name(),
+              strings::StrCat("/job:a/replica:0/task:0/device:CPU:", i));
+    EXPECT_EQ(devices[i]->attributes().locality().numa_node(), i);
+  }
+}
+
+TEST(ThreadPoolDeviceFactoryTest, DeviceCountOverridesNUMANodes) {
+  SessionOptions options;
+  options.config.mutable_experimental()->set_use_numa_affinity(true);
+  (*options.config.mutable_device_count())["CPU"] = 3;
+  std::vector<std::unique_ptr<Device>> devices = CreateCPUDevices(options);
+
+  ASSERT_EQ(devices.size(), 3u);
+  for (int i = 0; i < static_cast<int>(devices.size()); ++i) {
+    EXPECT_EQ(devices[i]->attributes().locality().numa_node(),
+              i % port::NUMANumNodes());
+  }
+}
+
+TEST(ThreadPoolDeviceFactoryTest, SingleDeviceWithoutNUMAAffinity) {
+  std::vector<std::unique_ptr<Device>> devices =
+      CreateCPUDevices(SessionOptions());
+  ASSERT_EQ(devices.size(), 1u);
+  EXPECT_EQ(devices[0]->attributes().locality().numa_node(), 0);
+}
+
 }  // namespace
 }  // namespace tensorflow
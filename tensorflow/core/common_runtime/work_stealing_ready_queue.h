@@ -0,0 +1,127 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tsl/platform/thread_index.h"
+
+namespace tensorflow {
+
+// A ready queue made up of one double-ended queue per worker, which supports
+// work stealing between workers.
+//
+// Every thread that touches the queue is mapped to one of `num_workers`
+// deques. A worker pushes newly-ready items to the front of its own deque and
+// pops from the front of its own deque first, so the successors of a node tend
+// to run on the thread that produced their inputs while those inputs are still
+// in cache. When its own deque is empty, a worker steals the oldest item from
+// the back of another worker's deque.
+//
+// Each deque has its own mutex, so in the common case where a worker consumes
+// what it produces there is no contention with other workers.
+template <typename T>
+class WorkStealingReadyQueue {
+ public:
+  explicit WorkStealingReadyQueue(int num_workers)
+      : num_workers_(num_workers),
+        queues_(new WorkerQueue[num_workers]),
+        size_(0) {
+    DCHECK_GT(num_workers, 0);
+  }
+
+  int num_workers() const { return num_workers_; }
+
+  // Returns the index of the deque associated with the calling thread.
+  int CurrentWorker() const {
+    return tsl::port::CurrentThreadIndex() % num_workers_;
+  }
+
+  // Adds `item` to the front of the deque owned by `worker`.
+  void Push(int worker, T item) {
+    DCHECK_GE(worker, 0);
+    DCHECK_LT(worker, num_workers_);
+    WorkerQueue& q = queues_[worker];
+    {
+      mutex_lock l(q.mu);
+      q.items.push_front(std::move(item));
+    }
+    size_.fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  // Removes an item from the front of the deque owned by `worker`, or, if that
+  // deque is empty, steals one from the back of another worker's deque.
+  // Returns std::nullopt if no item was found.
+  std::optional<T> PopOrSteal(int worker) {
+    DCHECK_GE(worker, 0);
+    DCHECK_LT(worker, num_workers_);
+    if (size_.load(std::memory_order_seq_cst) == 0) return std::nullopt;
+    {
+      WorkerQueue& q = queues_[worker];
+      mutex_lock l(q.mu);
+      if (!q.items.empty()) {
+        std::optional<T> item(std::move(q.items.front()));
+        q.items.pop_front();
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return item;
+      }
+    }
+    for (int i = 1; i < num_workers_; ++i) {
+      WorkerQueue& victim = queues_[(worker + i) % num_workers_];
+      mutex_lock l(victim.mu);
+      if (!victim.items.empty()) {
+        std::optional<T> item(std::move(victim.items.back()));
+        victim.items.pop_back();
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return item;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Returns true if no items are queued. The result is exact only if no other
+  // thread is concurrently pushing or popping.
+  bool empty() const { return size() == 0; }
+
+  // Returns the number of queued items.
+  int64_t size() const { return size_.load(std::memory_order_seq_cst); }
+
+ private:
+  // Padded to a cache line so that workers operating on neighbouring deques do
+  // not false-share.
+  struct alignas(64) WorkerQueue {
+    mutex mu;
+    std::deque<T> items TF_GUARDED_BY(mu);
+  };
+
+  const int num_workers_;
+  std::unique_ptr<WorkerQueue[]> queues_;
+  std::atomic<int64_t> size_;
+
+  WorkStealingReadyQueue(const WorkStealingReadyQueue&) = delete;
+  void operator=(const WorkStealingReadyQueue&) = delete;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUE_H_
@@ -0,0 +1,97 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_ready_queue.h"
+
+#include <atomic>
+#include <optional>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingReadyQueue, OwnerPopsLifo) {
+  WorkStealingReadyQueue<int> q(2);
+  q.Push(0, 1);
+  q.Push(0, 2);
+  q.Push(0, 3);
+  EXPECT_EQ(3, q.size());
+
+  EXPECT_EQ(3, q.PopOrSteal(0));
+  EXPECT_EQ(2, q.PopOrSteal(0));
+  EXPECT_EQ(1, q.PopOrSteal(0));
+  EXPECT_EQ(std::nullopt, q.PopOrSteal(0));
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(WorkStealingReadyQueue, ThiefStealsOldest) {
+  WorkStealingReadyQueue<int> q(3);
+  q.Push(1, 1);
+  q.Push(1, 2);
+  q.Push(1, 3);
+
+  EXPECT_EQ(1, q.PopOrSteal(0));
+  EXPECT_EQ(2, q.PopOrSteal(2));
+  EXPECT_EQ(3, q.PopOrSteal(1));
+  EXPECT_EQ(std::nullopt, q.PopOrSteal(1));
+}
+
+TEST(WorkStealingReadyQueue, CurrentWorkerIsStable) {
+  WorkStealingReadyQueue<int> q(4);
+  const int worker = q.CurrentWorker();
+  EXPECT_GE(worker, 0);
+  EXPECT_LT(worker, 4);
+  EXPECT_EQ(worker, q.CurrentWorker());
+}
+
+TEST(WorkStealingReadyQueue, ConcurrentPushAndSteal) {
+  constexpr int kNumThreads = 8;
+  constexpr int kItemsPerThread = 10000;
+  WorkStealingReadyQueue<int> q(kNumThreads);
+  std::atomic<int64_t> sum(0);
+  std::atomic<int> popped(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&q, &sum, &popped, t]() {
+        for (int i = 0; i < kItemsPerThread; ++i) {
+          q.Push(t, i);
+          if (i % 2 == 0) {
+            if (std::optional<int> item = q.PopOrSteal(t)) {
+              sum += *item;
+              ++popped;
+            }
+          }
+        }
+      });
+    }
+  }
+  while (std::optional<int> item = q.PopOrSteal(0)) {
+    sum += *item;
+    ++popped;
+  }
+  EXPECT_EQ(kNumThreads * kItemsPerThread, popped.load());
+  EXPECT_EQ(static_cast<int64_t>(kNumThreads) * kItemsPerThread *
+                (kItemsPerThread - 1) / 2,
+            sum.load());
+  EXPECT_TRUE(q.empty());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,437 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/columnar_record_file.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/raw_coding.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/util/tensor_bundle/mapped_tensor_buffer.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// "TFCOLREC" read as a little-endian integer.
+constexpr uint64_t kColumnarRecordMagic = 0x4345524c4f434654ULL;
+
+// Largest supported chunk alignment.
+constexpr int64_t kMaxAlignment = 4096;
+
+Status ValidateOptions(const ColumnarRecordWriter::Options& options) {
+  if (!options.compression.empty() &&
+      options.compression != kColumnarRecordSnappy) {
+    return errors::InvalidArgument(
+        "Unsupported columnar record compression: ", options.compression);
+  }
+  if (options.alignment <= 0 || options.alignment > kMaxAlignment ||
+      (options.alignment & (options.alignment - 1)) != 0) {
+    return errors::InvalidArgument(
+        "Columnar record alignment must be a power of two no larger than ",
+        kMaxAlignment, ", got ", options.alignment);
+  }
+  if (options.row_group_size <= 0) {
+    return errors::InvalidArgument(
+        "Columnar record row group size must be positive, got ",
+        options.row_group_size);
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+Status ColumnarRecordWriter::Create(
+    Env* env, const std::string& filename, std::vector<Column> columns,
+    const Options& options, std::unique_ptr<ColumnarRecordWriter>* writer) {
+  TF_RETURN_IF_ERROR(ValidateOptions(options));
+  if (columns.empty()) {
+    return errors::InvalidArgument(
+        "A columnar record file needs at least one column.");
+  }
+  for (const Column& column : columns) {
+    if (!DataTypeCanUseMemcpy(column.dtype)) {
+      return errors::Unimplemented(
+          "Columnar record files only support fixed-size types, but column ",
+          column.name, " has type ", DataTypeString(column.dtype));
+    }
+  }
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  writer->reset(
+      new ColumnarRecordWriter(std::move(file), std::move(columns), options));
+  return OkStatus();
+}
+
+ColumnarRecordWriter::ColumnarRecordWriter(std::unique_ptr<WritableFile> file,
+                                           std::vector<Column> columns,
+                                           const Options& options)
+    : file_(std::move(file)),
+      columns_(std::move(columns)),
+      options_(options),
+      buffers_(columns_.size()) {
+  footer_.set_version(kColumnarRecordFileVersion);
+  footer_.set_compression(options_.compression);
+  footer_.set_alignment(options_.alignment);
+  for (const Column& column : columns_) {
+    ColumnarRecordColumn* proto = footer_.add_columns();
+    proto->set_name(column.name);
+    proto->set_dtype(column.dtype);
+    column.shape.AsProto(proto->mutable_shape());
+  }
+}
+
+ColumnarRecordWriter::~ColumnarRecordWriter() {
+  if (!closed_) {
+    Status s = Close();
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to close columnar record file: " << s;
+    }
+  }
+}
+
+Status ColumnarRecordWriter::Write(const std::vector<Tensor>& record) {
+  if (closed_) {
+    return errors::FailedPrecondition(
+        "Cannot write to a closed columnar record file.");
+  }
+  if (record.size() != columns_.size()) {
+    return errors::InvalidArgument("Expected a record with ", columns_.size(),
+                                   " components, got ", record.size());
+  }
+  for (int i = 0; i < columns_.size(); ++i) {
+    if (record[i].dtype() != columns_[i].dtype ||
+        record[i].shape() != columns_[i].shape) {
+      return errors::InvalidArgument(
+          "Component ", i, " of the record has type ",
+          DataTypeString(record[i].dtype()), " and shape ",
+          record[i].shape().DebugString(), ", but column ", columns_[i].name,
+          " has type ", DataTypeString(columns_[i].dtype), " and shape ",
+          columns_[i].shape.DebugString());
+    }
+  }
+  for (int i = 0; i < columns_.size(); ++i) {
+    const absl::string_view data = record[i].tensor_data();
+    buffers_[i].append(data.data(), data.size());
+  }
+  if (++num_buffered_records_ == options_.row_group_size) {
+    TF_RETURN_IF_ERROR(FlushRowGroup());
+  }
+  return OkStatus();
+}
+
+Status ColumnarRecordWriter::Close() {
+  if (closed_) return OkStatus();
+  closed_ = true;
+  TF_RETURN_IF_ERROR(FlushRowGroup());
+  std::string footer;
+  if (!footer_.SerializeToString(&footer)) {
+    return errors::Internal("Failed to serialize columnar record footer.");
+  }
+  char trailer[kColumnarRecordTrailerSize];
+  core::EncodeFixed64(trailer, footer.size());
+  core::EncodeFixed64(
+      trailer + 8, crc32c::Mask(crc32c::Value(footer.data(), footer.size())));
+  core::EncodeFixed64(trailer + 16, kColumnarRecordMagic);
+  TF_RETURN_IF_ERROR(file_->Append(footer));
+  TF_RETURN_IF_ERROR(
+      file_->Append(absl::string_view(trailer, kColumnarRecordTrailerSize)));
+  return file_->Close();
+}
+
+Status ColumnarRecordWriter::FlushRowGroup() {
+  if (num_buffered_records_ == 0) return OkStatus();
+  ColumnarRecordRowGroup* row_group = footer_.add_row_groups();
+  row_group->set_num_records(num_buffered_records_);
+  std::string compressed;
+  for (std::string& buffer : buffers_) {
+    ColumnarRecordChunk* chunk = row_group->add_chunks();
+    chunk->set_uncompressed_size(buffer.size());
+    if (options_.compression == kColumnarRecordSnappy) {
+      compressed.clear();
+      if (!port::Snappy_Compress(buffer.data(), buffer.size(), &compressed)) {
+        return errors::Internal("Failed to compress columnar record chunk.");
+      }
+      TF_RETURN_IF_ERROR(AppendChunk(compressed, chunk));
+    } else {
+      TF_RETURN_IF_ERROR(AppendChunk(buffer, chunk));
+    }
+    buffer.clear();
+  }
+  num_buffered_records_ = 0;
+  return OkStatus();
+}
+
+Status ColumnarRecordWriter::AppendChunk(absl::string_view data,
+                                         ColumnarRecordChunk* chunk) {
+  static const char kPadding[kMaxAlignment] = {};
+  const uint64_t padding = -offset_ & (options_.alignment - 1);
+  if (padding > 0) {
+    TF_RETURN_IF_ERROR(file_->Append(absl::string_view(kPadding, padding)));
+    offset_ += padding;
+  }
+  chunk->set_offset(offset_);
+  chunk->set_size(data.size());
+  chunk->set_crc32c(crc32c::Mask(crc32c::Value(data.data(), data.size())));
+  TF_RETURN_IF_ERROR(file_->Append(data));
+  offset_ += data.size();
+  return OkStatus();
+}
+
+Status ColumnarRecordReader::Open(
+    Env* env, const std::string& filename,
+    std::unique_ptr<ColumnarRecordReader>* reader) {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  std::unique_ptr<RandomAccessFile> file;
+  Status s = env->NewReadOnlyMemoryRegionFromFile(filename, &region);
+  if (!s.ok()) {
+    // Not every file system supports memory-mapping.
+    VLOG(2) << "Reading columnar record file " << filename
+            << " without memory-mapping: " << s;
+    TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  }
+  std::unique_ptr<ColumnarRecordReader> result(new ColumnarRecordReader(
+      filename, std::move(file),
+      std::shared_ptr<ReadOnlyMemoryRegion>(std::move(region))));
+  if (result->region_ != nullptr) {
+    result->file_size_ = result->region_->length();
+  } else {
+    TF_RETURN_IF_ERROR(env->GetFileSize(filename, &result->file_size_));
+  }
+
+  if (result->file_size_ < kColumnarRecordTrailerSize) {
+    return errors::DataLoss("Columnar record file ", filename,
+                            " is too short: ", result->file_size_, " bytes");
+  }
+  char trailer_scratch[kColumnarRecordTrailerSize];
+  absl::string_view trailer;
+  TF_RETURN_IF_ERROR(
+      result->ReadBytes(result->file_size_ - kColumnarRecordTrailerSize,
+                        kColumnarRecordTrailerSize, trailer_scratch, &trailer));
+  if (core::DecodeFixed64(trailer.data() + 16) != kColumnarRecordMagic) {
+    return errors::DataLoss(filename, " is not a columnar record file.");
+  }
+  const uint64_t footer_size = core::DecodeFixed64(trailer.data());
+  const uint32 footer_crc =
+      static_cast<uint32>(core::DecodeFixed64(trailer.data() + 8));
+  if (footer_size > result->file_size_ - kColumnarRecordTrailerSize) {
+    return errors::DataLoss("Columnar record file ", filename,
+                            " has a corrupted footer size: ", footer_size);
+  }
+  std::string footer_scratch(footer_size, '\0');
+  absl::string_view footer;
+  TF_RETURN_IF_ERROR(result->ReadBytes(
+      result->file_size_ - kColumnarRecordTrailerSize - footer_size,
+      footer_size, footer_scratch.data(), &footer));
+  if (crc32c::Unmask(footer_crc) !=
+      crc32c::Value(footer.data(), footer.size())) {
+    return errors::DataLoss("Checksum of the footer of columnar record file ",
+                            filename, " does not match.");
+  }
+  if (!result->footer_.ParseFromArray(footer.data(), footer.size())) {
+    return errors::DataLoss("Failed to parse the footer of columnar record "
+                            "file ",
+                            filename);
+  }
+  if (result->footer_.version() > kColumnarRecordFileVersion) {
+    return errors::Unimplemented(
+        "Columnar record file ", filename, " has version ",
+        result->footer_.version(), ", but only versions up to ",
+        kColumnarRecordFileVersion, " are supported.");
+  }
+  if (!result->footer_.compression().empty() &&
+      result->footer_.compression() != kColumnarRecordSnappy) {
+    return errors::Unimplemented("Columnar record file ", filename,
+                                 " uses unsupported compression ",
+                                 result->footer_.compression());
+  }
+
+  for (const ColumnarRecordColumn& column : result->footer_.columns()) {
+    if (!DataTypeCanUseMemcpy(column.dtype())) {
+      return errors::DataLoss("Column ", column.name(), " of ", filename,
+                              " has unsupported type ",
+                              DataTypeString(column.dtype()));
+    }
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(TensorShape::BuildTensorShape(column.shape(), &shape));
+    result->column_shapes_.push_back(std::move(shape));
+  }
+  for (const ColumnarRecordRowGroup& row_group : result->footer_.row_groups()) {
+    if (row_group.num_records() < 0 ||
+        row_group.chunks_size() != result->footer_.columns_size()) {
+      return errors::DataLoss("Columnar record file ", filename,
+                              " has a corrupted row group.");
+    }
+    result->num_records_ += row_group.num_records();
+  }
+  *reader = std::move(result);
+  return OkStatus();
+}
+
+Status ColumnarRecordReader::IsColumnarRecordFile(Env* env,
+                                                  const std::string& filename,
+                                                  bool* result) {
+  uint64_t file_size = 0;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+  if (file_size < kColumnarRecordTrailerSize) {
+    *result = false;
+    return OkStatus();
+  }
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  char scratch[sizeof(uint64_t)];
+  StringPiece magic;
+  TF_RETURN_IF_ERROR(file->Read(file_size - sizeof(uint64_t), sizeof(uint64_t),
+                                &magic, scratch));
+  *result = magic.size() == sizeof(uint64_t) &&
+            core::DecodeFixed64(magic.data()) == kColumnarRecordMagic;
+  return OkStatus();
+}
+
+ColumnarRecordReader::ColumnarRecordReader(
+    std::string filename, std::unique_ptr<RandomAccessFile> file,
+    std::shared_ptr<ReadOnlyMemoryRegion> region)
+    : filename_(std::move(filename)),
+      file_(std::move(file)),
+      region_(std::move(region)) {}
+
+int ColumnarRecordReader::ColumnIndex(absl::string_view name) const {
+  for (int i = 0; i < footer_.columns_size(); ++i) {
+    if (footer_.columns(i).name() == name) return i;
+  }
+  return -1;
+}
+
+Status ColumnarRecordReader::ReadBytes(uint64_t offset, uint64_t n,
+                                       char* scratch,
+                                       absl::string_view* result) const {
+  if (offset > file_size_ || n > file_size_ - offset) {
+    return errors::DataLoss("Columnar record file ", filename_, " (",
+                            file_size_, " bytes) is too short to hold ", n,
+                            " bytes at offset ", offset);
+  }
+  if (region_ != nullptr) {
+    *result = absl::string_view(
+        static_cast<const char*>(region_->data()) + offset, n);
+    return OkStatus();
+  }
+  StringPiece piece;
+  TF_RETURN_IF_ERROR(file_->Read(offset, n, &piece, scratch));
+  if (piece.size() != n) {
+    return errors::DataLoss("Requested ", n, " bytes at offset ", offset,
+                            " of ", filename_, " but got ", piece.size());
+  }
+  *result = absl::string_view(piece.data(), piece.size());
+  return OkStatus();
+}
+
+Status ColumnarRecordReader::ReadChunk(int row_group, int column,
+                                       Tensor* value,
+                                       int64_t* bytes_read) const {
+  if (row_group < 0 || row_group >= footer_.row_groups_size() || column < 0 ||
+      column >= footer_.columns_size()) {
+    return errors::InvalidArgument("Invalid chunk (", row_group, ", ", column,
+                                   ") of columnar record file ", filename_);
+  }
+  const ColumnarRecordRowGroup& group = footer_.row_groups(row_group);
+  const ColumnarRecordChunk& chunk = group.chunks(column);
+  const DataType dtype = footer_.columns(column).dtype();
+  TensorShape shape = column_shapes_[column];
+  shape.InsertDim(0, group.num_records());
+  const uint64_t expected_size = shape.num_elements() * DataTypeSize(dtype);
+  if (chunk.uncompressed_size() != expected_size) {
+    return errors::DataLoss("Chunk (", row_group, ", ", column, ") of ",
+                            filename_, " holds ", chunk.uncompressed_size(),
+                            " bytes, expected ", expected_size);
+  }
+  const bool compressed = !footer_.compression().empty();
+  if (!compressed && chunk.size() != expected_size) {
+    return errors::DataLoss("Chunk (", row_group, ", ", column, ") of ",
+                            filename_, " has size ", chunk.size(),
+                            ", expected ", expected_size);
+  }
+
+  // Uncompressed chunks of a memory-mapped file are read in place if they are
+  // suitably aligned, and otherwise directly into the output tensor.
+  Tensor result;
+  if (compressed || region_ == nullptr) {
+    result = Tensor(dtype, shape);
+  }
+  std::string scratch;
+  char* scratch_data = nullptr;
+  if (region_ == nullptr) {
+    if (compressed) {
+      scratch.resize(chunk.size());
+      scratch_data = scratch.data();
+    } else {
+      scratch_data = const_cast<char*>(result.tensor_data().data());
+    }
+  }
+  absl::string_view data;
+  TF_RETURN_IF_ERROR(
+      ReadBytes(chunk.offset(), chunk.size(), scratch_data, &data));
+  if (crc32c::Unmask(chunk.crc32c()) !=
+      crc32c::Value(data.data(), data.size())) {
+    return errors::DataLoss("Checksum of chunk (", row_group, ", ", column,
+                            ") of columnar record file ", filename_,
+                            " does not match.");
+  }
+  *bytes_read = chunk.size();
+
+  if (compressed) {
+    size_t uncompressed_size;
+    if (!port::Snappy_GetUncompressedLength(data.data(), data.size(),
+                                            &uncompressed_size) ||
+        uncompressed_size != expected_size) {
+      return errors::DataLoss("Failed to decompress chunk (", row_group, ", ",
+                              column, ") of columnar record file ", filename_);
+    }
+    if (expected_size > 0 &&
+        !port::Snappy_Uncompress(
+            data.data(), data.size(),
+            const_cast<char*>(result.tensor_data().data()))) {
+      return errors::DataLoss("Failed to decompress chunk (", row_group, ", ",
+                              column, ") of columnar record file ", filename_);
+    }
+  } else if (region_ != nullptr && expected_size > 0) {
+    if (reinterpret_cast<uintptr_t>(data.data()) % EIGEN_MAX_ALIGN_BYTES ==
+        0) {
+      auto* buf = new MappedTensorBuffer(region_, data.data(), data.size());
+      result = Tensor(dtype, shape, buf);
+      buf->Unref();
+    } else {
+      result = Tensor(dtype, shape);
+      std::memcpy(const_cast<char*>(result.tensor_data().data()), data.data(),
+                  data.size());
+    }
+  } else if (result.dtype() == DT_INVALID) {
+    result = Tensor(dtype, shape);
+  }
+  *value = std::move(result);
+  return OkStatus();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,174 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_COLUMNAR_RECORD_FILE_H_
+#define TENSORFLOW_CORE_DATA_COLUMNAR_RECORD_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/columnar_record.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// Reading and writing of columnar record files. See
+// tensorflow/core/protobuf/columnar_record.proto for a description of the
+// file format.
+
+inline constexpr int64_t kColumnarRecordFileVersion = 1;
+inline constexpr char kColumnarRecordSnappy[] = "SNAPPY";
+
+// Size of the trailer at the end of a columnar record file.
+inline constexpr int64_t kColumnarRecordTrailerSize = 24;
+
+// Writes records to a columnar record file. Records are buffered in memory
+// until a row group is full, at which point the row group is written out one
+// column chunk at a time.
+//
+// Not thread-safe.
+class ColumnarRecordWriter {
+ public:
+  struct Column {
+    std::string name;
+    DataType dtype;
+    TensorShape shape;
+  };
+
+  struct Options {
+    // One of "" (no compression) or "SNAPPY".
+    std::string compression;
+    // Alignment of the chunk offsets. Must be a power of two. The default
+    // matches the alignment of tensor buffers allocated by TensorFlow, so that
+    // uncompressed chunks of a memory-mapped file can be used without copying.
+    int64_t alignment = 64;
+    // Maximum number of records in a row group.
+    int64_t row_group_size = 1024;
+  };
+
+  // Creates a writer for `filename`. Only columns whose type can be copied
+  // with memcpy are supported.
+  static Status Create(Env* env, const std::string& filename,
+                       std::vector<Column> columns, const Options& options,
+                       std::unique_ptr<ColumnarRecordWriter>* writer);
+
+  ~ColumnarRecordWriter();
+
+  // Appends a record. `record[i]` must match the type and shape of column `i`.
+  Status Write(const std::vector<Tensor>& record);
+
+  // Flushes the buffered records and writes the footer. The writer must not be
+  // used after it is closed.
+  Status Close();
+
+ private:
+  ColumnarRecordWriter(std::unique_ptr<WritableFile> file,
+                       std::vector<Column> columns, const Options& options);
+
+  // Writes the buffered records as a new row group.
+  Status FlushRowGroup();
+
+  // Appends `data` to the file, preceded by zero padding up to the next
+  // multiple of `options_.alignment`.
+  Status AppendChunk(absl::string_view data, ColumnarRecordChunk* chunk);
+
+  std::unique_ptr<WritableFile> file_;
+  const std::vector<Column> columns_;
+  const Options options_;
+  ColumnarRecordFooter footer_;
+  uint64_t offset_ = 0;
+  bool closed_ = false;
+
+  // The values of each column for the records of the current row group.
+  std::vector<std::string> buffers_;
+  int64_t num_buffered_records_ = 0;
+
+  ColumnarRecordWriter(const ColumnarRecordWriter&) = delete;
+  void operator=(const ColumnarRecordWriter&) = delete;
+};
+
+// Reads column chunks from a columnar record file.
+//
+// If the file system supports memory-mapping, the file is mapped and
+// uncompressed chunks are returned as tensors that alias the mapping, so no
+// bytes are copied. Otherwise chunks are read with a `RandomAccessFile`.
+//
+// Thread-safe.
+class ColumnarRecordReader {
+ public:
+  // Opens `filename` and reads its footer.
+  static Status Open(Env* env, const std::string& filename,
+                     std::unique_ptr<ColumnarRecordReader>* reader);
+
+  // Sets `*result` to whether `filename` ends with the trailer of a columnar
+  // record file. Only reads the trailer, so a file for which this is true may
+  // still fail to `Open`.
+  static Status IsColumnarRecordFile(Env* env, const std::string& filename,
+                                     bool* result);
+
+  const ColumnarRecordFooter& footer() const { return footer_; }
+
+  int num_row_groups() const { return footer_.row_groups_size(); }
+
+  // Returns the total number of records in the file.
+  int64_t num_records() const { return num_records_; }
+
+  // Returns the index of the column called `name`, or -1 if there is none.
+  int ColumnIndex(absl::string_view name) const;
+
+  // Returns the values of `column` for all records of `row_group` as a tensor
+  // of shape `[num_records] + column shape`. `bytes_read` is set to the
+  // number of bytes that were read from the file.
+  //
+  // The returned tensor may alias the memory-mapped file, in which case it is
+  // only valid as long as some reference to it is held; it keeps the mapping
+  // alive by itself.
+  Status ReadChunk(int row_group, int column, Tensor* value,
+                   int64_t* bytes_read) const;
+
+ private:
+  ColumnarRecordReader(std::string filename,
+                       std::unique_ptr<RandomAccessFile> file,
+                       std::shared_ptr<ReadOnlyMemoryRegion> region);
+
+  // Returns a view of `n` bytes at `offset` of the file. If the file is not
+  // memory-mapped, the bytes are read into `scratch`.
+  Status ReadBytes(uint64_t offset, uint64_t n, char* scratch,
+                   absl::string_view* result) const;
+
+  const std::string filename_;
+  const std::unique_ptr<RandomAccessFile> file_;
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  uint64_t file_size_ = 0;
+  ColumnarRecordFooter footer_;
+  std::vector<TensorShape> column_shapes_;
+  int64_t num_records_ = 0;
+
+  ColumnarRecordReader(const ColumnarRecordReader&) = delete;
+  void operator=(const ColumnarRecordReader&) = delete;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_COLUMNAR_RECORD_FILE_H_
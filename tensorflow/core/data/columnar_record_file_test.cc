@@ -0,0 +1,194 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/columnar_record_file.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::string TestFilename(const std::string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+// Writes `num_records` records with an int64 column "id" and a float column
+// "values" of shape [3].
+Status WriteTestFile(const std::string& filename, int64_t num_records,
+                     const ColumnarRecordWriter::Options& options) {
+  std::unique_ptr<ColumnarRecordWriter> writer;
+  TF_RETURN_IF_ERROR(ColumnarRecordWriter::Create(
+      Env::Default(), filename,
+      {{"id", DT_INT64, TensorShape({})},
+       {"values", DT_FLOAT, TensorShape({3})}},
+      options, &writer));
+  for (int64_t i = 0; i < num_records; ++i) {
+    TF_RETURN_IF_ERROR(writer->Write(
+        {test::AsScalar<int64_t>(i),
+         test::AsTensor<float>({1.0f * i, 2.0f * i, 3.0f * i})}));
+  }
+  return writer->Close();
+}
+
+class ColumnarRecordCompressionTest
+    : public ::testing::TestWithParam<std::string> {};
+
+TEST_P(ColumnarRecordCompressionTest, RoundTrip) {
+  const std::string filename = TestFilename("round_trip");
+  ColumnarRecordWriter::Options options;
+  options.compression = GetParam();
+  options.row_group_size = 4;
+  TF_ASSERT_OK(WriteTestFile(filename, 10, options));
+
+  std::unique_ptr<ColumnarRecordReader> reader;
+  TF_ASSERT_OK(ColumnarRecordReader::Open(Env::Default(), filename, &reader));
+  EXPECT_EQ(10, reader->num_records());
+  ASSERT_EQ(3, reader->num_row_groups());
+  EXPECT_EQ(0, reader->ColumnIndex("id"));
+  EXPECT_EQ(1, reader->ColumnIndex("values"));
+  EXPECT_EQ(-1, reader->ColumnIndex("missing"));
+
+  int64_t first_record = 0;
+  for (int row_group = 0; row_group < reader->num_row_groups(); ++row_group) {
+    Tensor ids;
+    Tensor values;
+    int64_t bytes_read = 0;
+    TF_ASSERT_OK(reader->ReadChunk(row_group, 0, &ids, &bytes_read));
+    EXPECT_GT(bytes_read, 0);
+    TF_ASSERT_OK(reader->ReadChunk(row_group, 1, &values, &bytes_read));
+    const int64_t n = ids.dim_size(0);
+    std::vector<int64_t> expected_ids;
+    std::vector<float> expected_values;
+    for (int64_t i = first_record; i < first_record + n; ++i) {
+      expected_ids.push_back(i);
+      expected_values.insert(expected_values.end(),
+                             {1.0f * i, 2.0f * i, 3.0f * i});
+    }
+    test::ExpectTensorEqual<int64_t>(
+        ids, test::AsTensor<int64_t>(expected_ids, TensorShape({n})));
+    test::ExpectTensorEqual<float>(
+        values, test::AsTensor<float>(expected_values, TensorShape({n, 3})));
+    first_record += n;
+  }
+  EXPECT_EQ(10, first_record);
+}
+
+INSTANTIATE_TEST_SUITE_P(Compression, ColumnarRecordCompressionTest,
+                         ::testing::Values("", kColumnarRecordSnappy));
+
+TEST(ColumnarRecordFileTest, ChunksAreAligned) {
+  const std::string filename = TestFilename("aligned");
+  ColumnarRecordWriter::Options options;
+  options.alignment = 128;
+  options.row_group_size = 3;
+  TF_ASSERT_OK(WriteTestFile(filename, 7, options));
+
+  std::unique_ptr<ColumnarRecordReader> reader;
+  TF_ASSERT_OK(ColumnarRecordReader::Open(Env::Default(), filename, &reader));
+  EXPECT_EQ(128, reader->footer().alignment());
+  for (const ColumnarRecordRowGroup& row_group :
+       reader->footer().row_groups()) {
+    for (const ColumnarRecordChunk& chunk : row_group.chunks()) {
+      EXPECT_EQ(0, chunk.offset() % 128);
+    }
+  }
+}
+
+TEST(ColumnarRecordFileTest, DetectsCorruptedChunk) {
+  const std::string filename = TestFilename("corrupted");
+  TF_ASSERT_OK(WriteTestFile(filename, 4, ColumnarRecordWriter::Options()));
+  std::unique_ptr<ColumnarRecordReader> reader;
+  TF_ASSERT_OK(ColumnarRecordReader::Open(Env::Default(), filename, &reader));
+  const uint64_t offset = reader->footer().row_groups(0).chunks(1).offset();
+  reader.reset();
+
+  std::string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  contents[offset] ^= 0x1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, contents));
+
+  TF_ASSERT_OK(ColumnarRecordReader::Open(Env::Default(), filename, &reader));
+  Tensor value;
+  int64_t bytes_read;
+  TF_EXPECT_OK(reader->ReadChunk(0, 0, &value, &bytes_read));
+  EXPECT_EQ(error::DATA_LOSS,
+            reader->ReadChunk(0, 1, &value, &bytes_read).code());
+}
+
+TEST(ColumnarRecordFileTest, DetectsTruncatedFile) {
+  const std::string filename = TestFilename("truncated");
+  TF_ASSERT_OK(WriteTestFile(filename, 4, ColumnarRecordWriter::Options()));
+  std::string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  contents.resize(contents.size() - 1);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, contents));
+
+  std::unique_ptr<ColumnarRecordReader> reader;
+  EXPECT_EQ(
+      error::DATA_LOSS,
+      ColumnarRecordReader::Open(Env::Default(), filename, &reader).code());
+}
+
+TEST(ColumnarRecordFileTest, IsColumnarRecordFile) {
+  const std::string filename = TestFilename("detect");
+  TF_ASSERT_OK(WriteTestFile(filename, 4, ColumnarRecordWriter::Options()));
+  bool is_columnar = false;
+  TF_ASSERT_OK(ColumnarRecordReader::IsColumnarRecordFile(
+      Env::Default(), filename, &is_columnar));
+  EXPECT_TRUE(is_columnar);
+
+  const std::string other_filename = TestFilename("not_columnar");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), other_filename,
+                                 std::string(100, 'x')));
+  TF_ASSERT_OK(ColumnarRecordReader::IsColumnarRecordFile(
+      Env::Default(), other_filename, &is_columnar));
+  EXPECT_FALSE(is_columnar);
+}
+
+TEST(ColumnarRecordFileTest, RejectsStringColumns) {
+  std::unique_ptr<ColumnarRecordWriter> writer;
+  EXPECT_EQ(error::UNIMPLEMENTED,
+            ColumnarRecordWriter::Create(
+                Env::Default(), TestFilename("strings"),
+                {{"name", DT_STRING, TensorShape({})}},
+                ColumnarRecordWriter::Options(), &writer)
+                .code());
+}
+
+TEST(ColumnarRecordFileTest, RejectsMismatchedRecords) {
+  std::unique_ptr<ColumnarRecordWriter> writer;
+  TF_ASSERT_OK(ColumnarRecordWriter::Create(
+      Env::Default(), TestFilename("mismatched"),
+      {{"id", DT_INT64, TensorShape({})}}, ColumnarRecordWriter::Options(),
+      &writer));
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            writer->Write({test::AsScalar<int32>(1)}).code());
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            writer->Write({test::AsTensor<int64_t>({1, 2})}).code());
+  TF_EXPECT_OK(writer->Write({test::AsScalar<int64_t>(1)}));
+  TF_EXPECT_OK(writer->Close());
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -1013,6 +1013,8 @@ REGISTER_DATASET_EXPERIMENT("map_fusion", RandomJobSamplePercentage<50>,
                             AllTasks);
 REGISTER_DATASET_EXPERIMENT("log_filenames", RandomJobSamplePercentage<50>,
                             AllTasks);
+REGISTER_DATASET_EXPERIMENT("prefetch_ring_buffer",
+                            RandomJobSamplePercentage<0>, AllTasks);
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
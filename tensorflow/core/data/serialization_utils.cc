@@ -100,31 +100,51 @@ Status ReadElementsFromCheckpoint(IteratorContext* ctx,
                                   std::vector<std::vector<Tensor>>* elements) {
   int64_t num_elements;
   TF_RETURN_IF_ERROR(
-      reader->ReadScalar(key_prefix, kNumElements, &num_elements));
+      ReadNumElementsFromCheckpoint(reader, key_prefix, &num_elements));
   DCHECK(elements->empty());
   elements->reserve(num_elements);
   for (int i = 0; i < num_elements; ++i) {
-    std::string element_prefix = absl::StrCat(key_prefix, "::", i);
-    int64_t num_components;
-    TF_RETURN_IF_ERROR(
-        reader->ReadScalar(element_prefix, kNumComponents, &num_components));
     elements->emplace_back();
-    std::vector<Tensor>& element = elements->at(i);
-    element.reserve(num_components);
-    for (int j = 0; j < num_components; ++j) {
-      element.emplace_back();
-      TF_RETURN_IF_ERROR(reader->ReadTensor(
-          ctx->flr(), element_prefix, absl::StrCat(kComponent, "[", j, "]"),
-          &element.back()));
-    }
+    TF_RETURN_IF_ERROR(ReadElementFromCheckpoint(ctx, reader, key_prefix, i,
+                                                 &elements->at(i)));
+  }
+  return OkStatus();
+}
+
+Status ReadNumElementsFromCheckpoint(IteratorStateReader* reader,
+                                     StringPiece key_prefix,
+                                     int64_t* num_elements) {
+  return reader->ReadScalar(key_prefix, kNumElements, num_elements);
+}
+
+Status ReadElementFromCheckpoint(IteratorContext* ctx,
+                                 IteratorStateReader* reader,
+                                 StringPiece key_prefix, int64_t index,
+                                 std::vector<Tensor>* element) {
+  std::string element_prefix = absl::StrCat(key_prefix, "::", index);
+  int64_t num_components;
+  TF_RETURN_IF_ERROR(
+      reader->ReadScalar(element_prefix, kNumComponents, &num_components));
+  element->clear();
+  element->reserve(num_components);
+  for (int j = 0; j < num_components; ++j) {
+    element->emplace_back();
+    TF_RETURN_IF_ERROR(reader->ReadTensor(
+        ctx->flr(), element_prefix, absl::StrCat(kComponent, "[", j, "]"),
+        &element->back()));
   }
   return OkStatus();
 }
 
-Status WriteElement(IteratorStateWriter* writer, StringPiece key_prefix,
-                    const std::vector<std::vector<Tensor>>& elements,
-                    int64_t index) {
-  const std::vector<Tensor>& element = elements[index];
+Status WriteNumElementsToCheckpoint(IteratorStateWriter* writer,
+                                    StringPiece key_prefix,
+                                    int64_t num_elements) {
+  return writer->WriteScalar(key_prefix, kNumElements, num_elements);
+}
+
+Status WriteElementToCheckpoint(IteratorStateWriter* writer,
+                                StringPiece key_prefix, int64_t index,
+                                const std::vector<Tensor>& element) {
   std::string element_prefix = absl::StrCat(key_prefix, "::", index);
   TF_RETURN_IF_ERROR(
       writer->WriteScalar(element_prefix, kNumComponents, element.size()));
@@ -141,7 +161,8 @@ Status WriteElementsToCheckpoint(
   TF_RETURN_IF_ERROR(
       writer->WriteScalar(key_prefix, kNumElements, elements.size()));
   for (int i = 0; i < elements.size(); ++i) {
-    TF_RETURN_IF_ERROR(WriteElement(writer, key_prefix, elements, i));
+    TF_RETURN_IF_ERROR(
+        WriteElementToCheckpoint(writer, key_prefix, i, elements[i]));
   }
   return OkStatus();
 }
@@ -153,7 +174,8 @@ Status UpdateCheckpointElements(
   TF_RETURN_IF_ERROR(
       writer->WriteScalar(key_prefix, kNumElements, elements.size()));
   for (int64_t i : checkpoint_indices) {
-    TF_RETURN_IF_ERROR(WriteElement(writer, key_prefix, elements, i));
+    TF_RETURN_IF_ERROR(
+        WriteElementToCheckpoint(writer, key_prefix, i, elements[i]));
   }
   return OkStatus();
 }
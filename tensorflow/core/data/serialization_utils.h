@@ -56,6 +56,33 @@ Status UpdateCheckpointElements(
     const std::vector<std::vector<Tensor>>& elements,
     const absl::flat_hash_set<int64_t>& checkpoint_indices);
 
+// Reads the number of dataset elements written under the given key prefix by
+// WriteElementsToCheckpoint, UpdateCheckpointElements or
+// WriteNumElementsToCheckpoint.
+Status ReadNumElementsFromCheckpoint(IteratorStateReader* reader,
+                                     StringPiece key_prefix,
+                                     int64_t* num_elements);
+
+// Reads the dataset element at `index` under the given key prefix. Together
+// with ReadNumElementsFromCheckpoint, this allows reading back the elements one
+// at a time instead of materializing all of them.
+Status ReadElementFromCheckpoint(IteratorContext* ctx,
+                                 IteratorStateReader* reader,
+                                 StringPiece key_prefix, int64_t index,
+                                 std::vector<Tensor>* element);
+
+// Writes the number of dataset elements under the given key prefix. The
+// elements themselves are written with WriteElementToCheckpoint, and the list
+// can be read back with ReadElementsFromCheckpoint.
+Status WriteNumElementsToCheckpoint(IteratorStateWriter* writer,
+                                    StringPiece key_prefix,
+                                    int64_t num_elements);
+
+// Writes the dataset element at `index` under the given key prefix.
+Status WriteElementToCheckpoint(IteratorStateWriter* writer,
+                                StringPiece key_prefix, int64_t index,
+                                const std::vector<Tensor>& element);
+
 // Helper class for reading data from a vector of VariantTensorData objects.
 class VariantTensorDataReader : public IteratorStateReader {
  public:
@@ -27,11 +27,15 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "tensorflow/core/data/columnar_record_file.h"
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/data/service/snapshot/utils.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tsl/lib/io/compression.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/path.h"
@@ -41,18 +45,52 @@ limitations under the License.
 
 namespace tensorflow {
 namespace data {
+namespace {
 
-ParallelTFRecordWriter::ParallelTFRecordWriter(const std::string& file_prefix,
-                                               const std::string& compression,
-                                               tsl::Env* env,
-                                               ByteSize max_file_size,
-                                               int64_t num_write_threads,
-                                               int64_t buffer_size_per_thread)
+// Returns the columns of a columnar record file for `record`, or
+// `std::nullopt` if some component cannot be stored as a raw buffer.
+std::optional<std::vector<ColumnarRecordWriter::Column>> GetColumns(
+    const std::vector<Tensor>& record) {
+  if (record.empty()) {
+    return std::nullopt;
+  }
+  std::vector<ColumnarRecordWriter::Column> columns;
+  columns.reserve(record.size());
+  for (int i = 0; i < record.size(); ++i) {
+    if (!DataTypeCanUseMemcpy(record[i].dtype())) {
+      return std::nullopt;
+    }
+    columns.push_back({absl::StrCat("component_", i), record[i].dtype(),
+                       record[i].shape()});
+  }
+  return columns;
+}
+
+bool MatchesColumns(const std::vector<ColumnarRecordWriter::Column>& columns,
+                    const std::vector<Tensor>& record) {
+  if (record.size() != columns.size()) {
+    return false;
+  }
+  for (int i = 0; i < record.size(); ++i) {
+    if (record[i].dtype() != columns[i].dtype ||
+        record[i].shape() != columns[i].shape) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+ParallelTFRecordWriter::ParallelTFRecordWriter(
+    const std::string& file_prefix, const std::string& compression,
+    tsl::Env* env, ByteSize max_file_size, int64_t num_write_threads,
+    int64_t buffer_size_per_thread, FileFormat file_format)
     : env_(env),
       file_prefix_(file_prefix),
       compression_(compression),
       max_file_size_(max_file_size),
-      buffer_size_(num_write_threads * buffer_size_per_thread) {
+      buffer_size_(num_write_threads * buffer_size_per_thread),
+      file_format_(file_format) {
   thread_pool_ = std::make_unique<tsl::thread::ThreadPool>(
       env_, tsl::ThreadOptions{}, "write_tfrecord_thread", num_write_threads);
   for (int64_t i = 0; i < num_write_threads; ++i) {
@@ -114,7 +152,11 @@ bool ParallelTFRecordWriter::HasNext() const ABSL_LOCKS_EXCLUDED(mu_) {
 }
 
 absl::Status ParallelTFRecordWriter::WriteFile() ABSL_LOCKS_EXCLUDED(mu_) {
-  TF_ASSIGN_OR_RETURN(const std::string filename, GetUniqueFile());
+  if (UseColumnarFormat()) {
+    TF_ASSIGN_OR_RETURN(const std::string filename, GetUniqueFile(".columnar"));
+    return WriteColumnarFile(filename);
+  }
+  TF_ASSIGN_OR_RETURN(const std::string filename, GetUniqueFile(".tfrecord"));
   snapshot_util::TFRecordWriter writer(filename, compression_);
   TF_RETURN_IF_ERROR(writer.Initialize(env_));
   while (ShouldWriteFile(filename)) {
@@ -124,6 +166,43 @@ absl::Status ParallelTFRecordWriter::WriteFile() ABSL_LOCKS_EXCLUDED(mu_) {
   return DeleteEmptyFile(filename);
 }
 
+absl::Status ParallelTFRecordWriter::WriteColumnarFile(
+    const std::string& filename) {
+  std::vector<ColumnarRecordWriter::Column> columns;
+  std::unique_ptr<ColumnarRecordWriter> writer;
+  while (ShouldWriteFile(filename)) {
+    TF_ASSIGN_OR_RETURN(std::optional<std::vector<Tensor>> record,
+                        GetNextRecord(filename, &columns));
+    if (!record.has_value()) {
+      break;
+    }
+    if (writer == nullptr) {
+      ColumnarRecordWriter::Options options;
+      if (compression_ != tsl::io::compression::kNone) {
+        options.compression = "SNAPPY";
+      }
+      TF_RETURN_IF_ERROR(ColumnarRecordWriter::Create(env_, filename, columns,
+                                                      options, &writer));
+    }
+    tsl::profiler::TraceMe activity("WriteColumnarRecord",
+                                    tsl::profiler::TraceMeLevel::kInfo);
+    TF_RETURN_IF_ERROR(writer->Write(*record));
+  }
+  if (writer == nullptr) {
+    return absl::OkStatus();
+  }
+  return writer->Close();
+}
+
+bool ParallelTFRecordWriter::UseColumnarFormat() const
+    ABSL_LOCKS_EXCLUDED(mu_) {
+  if (file_format_ != FileFormat::kColumnar) {
+    return false;
+  }
+  absl::MutexLock l(&mu_);
+  return !columnar_fallback_;
+}
+
 bool ParallelTFRecordWriter::ShouldWriteFile(const std::string& filename) const
     ABSL_LOCKS_EXCLUDED(mu_) {
   if (!HasNext()) {
@@ -150,7 +229,9 @@ absl::Status ParallelTFRecordWriter::WriteRecord(
 }
 
 absl::StatusOr<std::optional<std::vector<Tensor>>>
-ParallelTFRecordWriter::GetNextRecord(const std::string& filename)
+ParallelTFRecordWriter::GetNextRecord(
+    const std::string& filename,
+    std::vector<ColumnarRecordWriter::Column>* columns)
     ABSL_LOCKS_EXCLUDED(mu_) {
   absl::MutexLock l(&mu_);
   while (status_.ok() && !finalized_ && buffer_.empty()) {
@@ -160,6 +241,25 @@ ParallelTFRecordWriter::GetNextRecord(const std::string& filename)
   if (buffer_.empty()) {
     return std::nullopt;
   }
+  if (columns != nullptr) {
+    if (columnar_fallback_) {
+      return std::nullopt;
+    }
+    if (columns->empty()) {
+      std::optional<std::vector<ColumnarRecordWriter::Column>> record_columns =
+          GetColumns(buffer_.front());
+      if (record_columns.has_value()) {
+        *columns = *std::move(record_columns);
+      }
+    }
+    if (columns->empty() || !MatchesColumns(*columns, buffer_.front())) {
+      LOG(INFO) << "Writing the remaining records of " << file_prefix_
+                << " as TFRecords, because they have types that are not "
+                << "memcpy-able or shapes that vary.";
+      columnar_fallback_ = true;
+      return std::nullopt;
+    }
+  }
 
   std::vector<Tensor> record = std::move(buffer_.front());
   ++file_stats_[filename].num_records;
@@ -184,9 +284,10 @@ absl::Status ParallelTFRecordWriter::DeleteEmptyFile(
   return absl::OkStatus();
 }
 
-absl::StatusOr<std::string> ParallelTFRecordWriter::GetUniqueFile() const {
+absl::StatusOr<std::string> ParallelTFRecordWriter::GetUniqueFile(
+    absl::string_view suffix) const {
   std::string filename = absl::StrCat(file_prefix_, "__shard__");
-  if (!env_->CreateUniqueFileName(&filename, ".tfrecord")) {
+  if (!env_->CreateUniqueFileName(&filename, std::string(suffix))) {
     return absl::InternalError(
         absl::StrCat("Failed to write file ", filename,
                      ": Unable to open temporary files."));
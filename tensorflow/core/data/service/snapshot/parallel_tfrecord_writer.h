@@ -26,7 +26,9 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "tensorflow/core/data/columnar_record_file.h"
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -40,6 +42,15 @@ namespace data {
 // waiting for the file writes, and it writes one shard of file per thread.
 // Returns the file names when writes are finished. This class is thread-safe.
 //
+// With `FileFormat::kColumnar`, the files are columnar record files (see
+// `ColumnarRecordWriter`) instead: each row group holds the components of a
+// batch of elements as contiguous, aligned raw buffers, which are written and
+// read back without serializing tensor protos. This requires that all
+// components have memcpy-able types and that elements in a file have the same
+// shapes. Once an element is found that does not satisfy this, the writer
+// falls back to TFRecords for the rest of the elements. Readers should use
+// `ColumnarRecordReader::IsColumnarRecordFile` to tell the formats apart.
+//
 // Usage example:
 //
 // ParallelTFRecordWriter writer(
@@ -56,11 +67,19 @@ namespace data {
 //                     writer.Finalize());
 class ParallelTFRecordWriter {
  public:
-  explicit ParallelTFRecordWriter(const std::string& file_prefix,
-                                  const std::string& compression, tsl::Env* env,
-                                  ByteSize max_file_size = ByteSize::GB(2),
-                                  int64_t num_write_threads = 10,
-                                  int64_t buffer_size_per_thread = 1);
+  enum class FileFormat { kTFRecord, kColumnar };
+
+  static constexpr int64_t kDefaultNumWriteThreads = 10;
+  static constexpr int64_t kDefaultBufferSizePerThread = 1;
+
+  // For `FileFormat::kColumnar`, any `compression` other than
+  // `tsl::io::compression::kNone` compresses the files with Snappy.
+  explicit ParallelTFRecordWriter(
+      const std::string& file_prefix, const std::string& compression,
+      tsl::Env* env, ByteSize max_file_size = ByteSize::GB(2),
+      int64_t num_write_threads = kDefaultNumWriteThreads,
+      int64_t buffer_size_per_thread = kDefaultBufferSizePerThread,
+      FileFormat file_format = FileFormat::kTFRecord);
   virtual ~ParallelTFRecordWriter();
   ParallelTFRecordWriter(const ParallelTFRecordWriter&) = delete;
   ParallelTFRecordWriter& operator=(const ParallelTFRecordWriter&) = delete;
@@ -94,6 +113,13 @@ class ParallelTFRecordWriter {
   // Writes a new file.
   absl::Status WriteFile();
 
+  // Writes a new columnar record file. The file is only created once there is
+  // a record that can be written to it.
+  absl::Status WriteColumnarFile(const std::string& filename);
+
+  // Whether new files should be columnar record files.
+  bool UseColumnarFormat() const;
+
   // Whether the file can hold more records without exceeding `max_file_size_`.
   bool ShouldWriteFile(const std::string& filename) const;
 
@@ -103,14 +129,20 @@ class ParallelTFRecordWriter {
 
   // Gets the next record from the buffer to write. Returns `std::nullopt` if
   // there are no more records to write.
+  //
+  // If `columns` is not null, the record is written to a columnar record file
+  // with these columns, or with the columns of the record if `columns` is
+  // empty, in which case they are stored in `columns`. Returns `std::nullopt`
+  // and leaves the record in the buffer if it cannot be written to that file.
   absl::StatusOr<std::optional<std::vector<Tensor>>> GetNextRecord(
-      const std::string& filename);
+      const std::string& filename,
+      std::vector<ColumnarRecordWriter::Column>* columns = nullptr);
 
   // Deletes the file if it's empty.
   absl::Status DeleteEmptyFile(const std::string& filename);
 
   // Generates a unique file name in the requested directory.
-  absl::StatusOr<std::string> GetUniqueFile() const;
+  absl::StatusOr<std::string> GetUniqueFile(absl::string_view suffix) const;
 
   // Updates the status of the writer and notifies waiters.
   void UpdateStatus(absl::Status status);
@@ -120,6 +152,7 @@ class ParallelTFRecordWriter {
   const std::string compression_;
   const ByteSize max_file_size_;
   const int64_t buffer_size_;
+  const FileFormat file_format_;
 
   mutable absl::Mutex mu_;
   mutable absl::CondVar ready_to_push_;
@@ -128,6 +161,10 @@ class ParallelTFRecordWriter {
   bool finalized_ ABSL_GUARDED_BY(mu_) = false;
   absl::Status status_ ABSL_GUARDED_BY(mu_);
 
+  // Set once a record could not be written to a columnar record file. New
+  // files are TFRecord files from then on.
+  bool columnar_fallback_ ABSL_GUARDED_BY(mu_) = false;
+
   // A map from absolute paths to the number of records in the files.
   FileToStatsMap file_stats_ ABSL_GUARDED_BY(mu_);
 
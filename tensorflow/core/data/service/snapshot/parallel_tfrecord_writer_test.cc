@@ -30,6 +30,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/columnar_record_file.h"
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -270,6 +271,87 @@ INSTANTIATE_TEST_SUITE_P(
                           tsl::io::compression::kSnappy,
                           tsl::io::compression::kZlib)));
 
+// Reads the int64 scalar elements of `filenames`, which may be columnar record
+// files or TFRecord files.
+absl::StatusOr<std::vector<int64_t>> ReadColumnarOrTFRecords(
+    const std::vector<std::string>& filenames, const std::string& compression,
+    int64_t* num_columnar_files) {
+  std::vector<int64_t> result;
+  *num_columnar_files = 0;
+  for (const std::string& filename : filenames) {
+    bool is_columnar = false;
+    TF_RETURN_IF_ERROR(ColumnarRecordReader::IsColumnarRecordFile(
+        tsl::Env::Default(), filename, &is_columnar));
+    if (!is_columnar) {
+      TF_ASSIGN_OR_RETURN(std::vector<int64_t> records,
+                          ReadRecords<int64_t>(filename, compression));
+      absl::c_move(records, std::back_inserter(result));
+      continue;
+    }
+    ++*num_columnar_files;
+    std::unique_ptr<ColumnarRecordReader> reader;
+    TF_RETURN_IF_ERROR(
+        ColumnarRecordReader::Open(tsl::Env::Default(), filename, &reader));
+    for (int i = 0; i < reader->num_row_groups(); ++i) {
+      Tensor chunk;
+      int64_t bytes_read = 0;
+      TF_RETURN_IF_ERROR(reader->ReadChunk(i, 0, &chunk, &bytes_read));
+      for (int64_t j = 0; j < chunk.NumElements(); ++j) {
+        result.push_back(chunk.flat<int64_t>()(j));
+      }
+    }
+  }
+  return result;
+}
+
+TEST(ParallelTFRecordWriterTest, WriteColumnarFiles) {
+  TF_ASSERT_OK_AND_ASSIGN(std::string test_dir, TestDir());
+  ParallelTFRecordWriter parallel_tfrecord_writer(
+      test_dir, tsl::io::compression::kSnappy, tsl::Env::Default(),
+      ByteSize::GB(1), /*num_write_threads=*/5, /*buffer_size_per_thread=*/10,
+      ParallelTFRecordWriter::FileFormat::kColumnar);
+
+  RangeIterator range_iterator(1000);
+  TF_ASSERT_OK_AND_ASSIGN(
+      ParallelTFRecordWriter::FileToStatsMap file_stats,
+      WriteRecords(parallel_tfrecord_writer, range_iterator));
+
+  const auto [files, stats] = Unzip(file_stats);
+  int64_t num_columnar_files = 0;
+  EXPECT_THAT(ReadColumnarOrTFRecords(files, tsl::io::compression::kSnappy,
+                                      &num_columnar_files),
+              IsOkAndHolds(UnorderedElementsAreArray(Range(1000))));
+  EXPECT_EQ(num_columnar_files, files.size());
+  EXPECT_THAT(stats, SizeIs(Le(5)));
+}
+
+TEST(ParallelTFRecordWriterTest, ColumnarFallsBackToTFRecord) {
+  TF_ASSERT_OK_AND_ASSIGN(std::string test_dir, TestDir());
+  ParallelTFRecordWriter parallel_tfrecord_writer(
+      test_dir, tsl::io::compression::kNone, tsl::Env::Default(),
+      ByteSize::GB(1), /*num_write_threads=*/1, /*buffer_size_per_thread=*/1,
+      ParallelTFRecordWriter::FileFormat::kColumnar);
+
+  // Elements are scalars at first, and vectors of one element after that.
+  for (int64_t i = 0; i < 20; ++i) {
+    Tensor element = i < 10 ? Tensor(i) : Tensor(DT_INT64, {1});
+    if (i >= 10) {
+      element.flat<int64_t>()(0) = i;
+    }
+    TF_ASSERT_OK(parallel_tfrecord_writer.Write({element}));
+  }
+  TF_ASSERT_OK_AND_ASSIGN(ParallelTFRecordWriter::FileToStatsMap file_stats,
+                          parallel_tfrecord_writer.Finalize());
+
+  const auto [files, stats] = Unzip(file_stats);
+  int64_t num_columnar_files = 0;
+  EXPECT_THAT(ReadColumnarOrTFRecords(files, tsl::io::compression::kNone,
+                                      &num_columnar_files),
+              IsOkAndHolds(UnorderedElementsAreArray(Range(20))));
+  EXPECT_EQ(num_columnar_files, 1);
+  EXPECT_THAT(stats, SizeIs(2));
+}
+
 TEST(ParallelTFRecordWriterTest, WriteNoRecord) {
   TF_ASSERT_OK_AND_ASSIGN(std::string test_dir, TestDir());
   ParallelTFRecordWriter parallel_tfrecord_writer(
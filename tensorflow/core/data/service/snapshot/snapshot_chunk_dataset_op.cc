@@ -19,7 +19,9 @@ limitations under the License.
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/core/data/columnar_record_file.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/data/utils.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tsl/platform/env.h"
@@ -128,9 +131,16 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
     ~Iterator() override { RecordBytesRead(); }
 
     absl::Status Initialize(IteratorContext* ctx) override {
+      const std::string chunk_file = TranslateFileName(dataset()->chunk_file_);
+      bool is_columnar = false;
+      TF_RETURN_IF_ERROR(ColumnarRecordReader::IsColumnarRecordFile(
+          ctx->env(), chunk_file, &is_columnar));
+      if (is_columnar) {
+        return InitializeColumnar(ctx, chunk_file);
+      }
       reader_ = std::make_unique<snapshot_util::TFRecordReader>(
-          TranslateFileName(dataset()->chunk_file_), dataset()->compression_,
-          dataset()->dtypes_, kTFRecordReaderOutputBufferSize);
+          chunk_file, dataset()->compression_, dataset()->dtypes_,
+          kTFRecordReaderOutputBufferSize);
       return reader_->Initialize(ctx->env());
     }
 
@@ -139,6 +149,15 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
                                  std::vector<Tensor>* out_tensors,
                                  bool* end_of_sequence) override {
       *end_of_sequence = false;
+      if (columnar_reader_ != nullptr) {
+        TF_RETURN_WITH_CONTEXT_IF_ERROR(
+            ReadColumnarElement(out_tensors, end_of_sequence),
+            " Failed to read tf.data snapshot file: ", dataset()->chunk_file_);
+        if (!*end_of_sequence) {
+          ++start_index_;
+        }
+        return absl::OkStatus();
+      }
       absl::Status status = reader_->ReadTensors(out_tensors);
       if (absl::IsOutOfRange(status)) {
         *end_of_sequence = true;
@@ -171,6 +190,9 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
     // may consider switching the data format to ArrayRecords so we can use the
     // index to jump straight to the starting record.
     absl::Status AdvanceToStartIndex(IteratorContext* ctx) {
+      if (columnar_reader_ != nullptr) {
+        return AdvanceColumnarToStartIndex();
+      }
       for (int64_t i = 0; i < start_index_; ++i) {
         std::vector<Tensor> unused;
         TF_RETURN_IF_ERROR(reader_->ReadTensors(&unused));
@@ -178,14 +200,109 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
       return absl::OkStatus();
     }
 
+    // Columnar chunk files hold row groups of elements as raw tensor buffers,
+    // so elements are read by slicing the column chunks instead of parsing
+    // tensor protos.
+    absl::Status InitializeColumnar(IteratorContext* ctx,
+                                    const std::string& chunk_file) {
+      columnar_reader_.reset();
+      row_group_chunks_.clear();
+      next_row_group_ = 0;
+      row_group_num_records_ = 0;
+      next_row_ = 0;
+      TF_RETURN_IF_ERROR(ColumnarRecordReader::Open(ctx->env(), chunk_file,
+                                                    &columnar_reader_));
+      const ColumnarRecordFooter& footer = columnar_reader_->footer();
+      bool matches_dtypes = footer.columns_size() == dataset()->dtypes_.size();
+      for (int i = 0; matches_dtypes && i < footer.columns_size(); ++i) {
+        matches_dtypes = footer.columns(i).dtype() == dataset()->dtypes_[i];
+      }
+      if (!matches_dtypes) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "The columns of tf.data snapshot file ", chunk_file,
+            " do not match the expected types ",
+            DataTypeVectorString(dataset()->dtypes_), "."));
+      }
+      return absl::OkStatus();
+    }
+
+    absl::Status ReadColumnarElement(std::vector<Tensor>* out_tensors,
+                                     bool* end_of_sequence) {
+      while (next_row_ >= row_group_num_records_) {
+        if (next_row_group_ >= columnar_reader_->num_row_groups()) {
+          *end_of_sequence = true;
+          return absl::OkStatus();
+        }
+        TF_RETURN_IF_ERROR(ReadRowGroup(next_row_group_++));
+      }
+      out_tensors->clear();
+      out_tensors->reserve(row_group_chunks_.size());
+      for (const Tensor& chunk : row_group_chunks_) {
+        // Slices share the buffer of the chunk, but may not be aligned if the
+        // size of a component is not a multiple of the alignment.
+        Tensor component = chunk.SubSlice(next_row_);
+        out_tensors->push_back(component.IsAligned()
+                                   ? std::move(component)
+                                   : tensor::DeepCopy(component));
+      }
+      ++next_row_;
+      return absl::OkStatus();
+    }
+
+    absl::Status ReadRowGroup(int row_group) {
+      row_group_chunks_.resize(columnar_reader_->footer().columns_size());
+      for (int i = 0; i < row_group_chunks_.size(); ++i) {
+        int64_t bytes_read = 0;
+        TF_RETURN_IF_ERROR(columnar_reader_->ReadChunk(
+            row_group, i, &row_group_chunks_[i], &bytes_read));
+        columnar_bytes_read_ += bytes_read;
+      }
+      row_group_num_records_ =
+          columnar_reader_->footer().row_groups(row_group).num_records();
+      next_row_ = 0;
+      return absl::OkStatus();
+    }
+
+    // Skips the row groups before `start_index_` without reading them.
+    absl::Status AdvanceColumnarToStartIndex() {
+      const ColumnarRecordFooter& footer = columnar_reader_->footer();
+      int64_t num_to_skip = start_index_;
+      while (next_row_group_ < footer.row_groups_size() &&
+             footer.row_groups(next_row_group_).num_records() <= num_to_skip) {
+        num_to_skip -= footer.row_groups(next_row_group_).num_records();
+        ++next_row_group_;
+      }
+      if (num_to_skip == 0) {
+        return absl::OkStatus();
+      }
+      if (next_row_group_ >= footer.row_groups_size()) {
+        return absl::OutOfRangeError(absl::StrCat(
+            "tf.data snapshot file ", std::string(dataset()->chunk_file_),
+            " has fewer than ", start_index_, " elements."));
+      }
+      TF_RETURN_IF_ERROR(ReadRowGroup(next_row_group_++));
+      next_row_ = num_to_skip;
+      return absl::OkStatus();
+    }
+
     void RecordBytesRead() {
-      uint64_t bytes_read = reader_->BytesRead();
+      uint64_t bytes_read =
+          reader_ != nullptr ? reader_->BytesRead() : columnar_bytes_read_;
       metrics::GetTFDataBytesReadCounter(kSnapshotChunkDataset)
           ->IncrementBy(bytes_read);
     }
 
     std::unique_ptr<snapshot_util::TFRecordReader> reader_;
     int64_t start_index_ = 0;
+
+    // Only set if the chunk file is a columnar record file.
+    std::unique_ptr<ColumnarRecordReader> columnar_reader_;
+    // The column chunks of the row group that is being read.
+    std::vector<Tensor> row_group_chunks_;
+    int next_row_group_ = 0;
+    int64_t row_group_num_records_ = 0;
+    int64_t next_row_ = 0;
+    uint64_t columnar_bytes_read_ = 0;
   };
 
   const tstring chunk_file_;
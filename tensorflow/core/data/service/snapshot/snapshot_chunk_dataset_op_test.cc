@@ -0,0 +1,223 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/columnar_record_file.h"
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/data/snapshot_utils.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/env.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kNodeName[] = "snapshot_chunk_dataset";
+constexpr char kDatasetType[] = "SnapshotChunk";
+
+// Elements have an int64 scalar and an int32 vector of 3 values. Slices of a
+// row group are aligned only every few elements, so the reader copies most of
+// them.
+constexpr int64_t kNumElements = 10;
+constexpr int64_t kRowGroupSize = 4;
+
+class SnapshotChunkDatasetParams : public DatasetParams {
+ public:
+  SnapshotChunkDatasetParams(std::string chunk_file, std::string compression,
+                             DataTypeVector output_dtypes,
+                             std::vector<PartialTensorShape> output_shapes,
+                             std::string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        chunk_file_(std::move(chunk_file)),
+        compression_(std::move(compression)) {}
+
+  std::vector<Tensor> GetInputTensors() const override {
+    return {CreateTensor<tstring>(TensorShape({}), {chunk_file_})};
+  }
+
+  absl::Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {"chunk_file"};
+    return absl::OkStatus();
+  }
+
+  absl::Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{"output_types", output_dtypes_},
+                    {"output_shapes", output_shapes_},
+                    {"compression", compression_}};
+    return absl::OkStatus();
+  }
+
+  string dataset_type() const override { return kDatasetType; }
+
+ private:
+  std::string chunk_file_;
+  std::string compression_;
+};
+
+class SnapshotChunkDatasetOpTest : public DatasetOpsTestBase {};
+
+std::vector<Tensor> Element(int64_t i) {
+  return {CreateTensor<int64_t>(TensorShape({}), {i}),
+          CreateTensor<int32>(TensorShape({3}), {static_cast<int32>(i),
+                                                 static_cast<int32>(i + 1),
+                                                 static_cast<int32>(i + 2)})};
+}
+
+// Returns the components of all elements in order.
+std::vector<Tensor> ExpectedOutputs() {
+  std::vector<Tensor> outputs;
+  for (int64_t i = 0; i < kNumElements; ++i) {
+    std::vector<Tensor> element = Element(i);
+    outputs.insert(outputs.end(), element.begin(), element.end());
+  }
+  return outputs;
+}
+
+// Writes `kNumElements` elements to a columnar chunk file, in row groups of
+// `kRowGroupSize` elements.
+std::string WriteColumnarChunk(const std::string& name,
+                               const std::string& compression) {
+  const std::string chunk_file =
+      tsl::io::JoinPath(testing::TmpDir(), "chunks", name);
+  TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(
+      tsl::io::Dirname(chunk_file).data()));
+  ColumnarRecordWriter::Options options;
+  options.compression = compression;
+  options.row_group_size = kRowGroupSize;
+  std::unique_ptr<ColumnarRecordWriter> writer;
+  TF_CHECK_OK(ColumnarRecordWriter::Create(
+      Env::Default(), chunk_file,
+      {{"component_0", DT_INT64, TensorShape({})},
+       {"component_1", DT_INT32, TensorShape({3})}},
+      options, &writer));
+  for (int64_t i = 0; i < kNumElements; ++i) {
+    TF_CHECK_OK(writer->Write(Element(i)));
+  }
+  TF_CHECK_OK(writer->Close());
+  return chunk_file;
+}
+
+// Writes `kNumElements` elements to a TFRecord chunk file.
+std::string WriteTFRecordChunk(const std::string& name) {
+  const std::string chunk_file =
+      tsl::io::JoinPath(testing::TmpDir(), "chunks", name);
+  TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(
+      tsl::io::Dirname(chunk_file).data()));
+  snapshot_util::TFRecordWriter writer(chunk_file, /*compression_type=*/"");
+  TF_CHECK_OK(writer.Initialize(Env::Default()));
+  for (int64_t i = 0; i < kNumElements; ++i) {
+    TF_CHECK_OK(writer.WriteTensors(Element(i)));
+  }
+  TF_CHECK_OK(writer.Close());
+  return chunk_file;
+}
+
+SnapshotChunkDatasetParams ColumnarChunkParams() {
+  return SnapshotChunkDatasetParams(
+      WriteColumnarChunk("columnar_chunk", /*compression=*/""),
+      /*compression=*/"", {DT_INT64, DT_INT32},
+      {PartialTensorShape({}), PartialTensorShape({3})}, kNodeName);
+}
+
+SnapshotChunkDatasetParams SnappyColumnarChunkParams() {
+  return SnapshotChunkDatasetParams(
+      WriteColumnarChunk("snappy_columnar_chunk", kColumnarRecordSnappy),
+      /*compression=*/"SNAPPY", {DT_INT64, DT_INT32},
+      {PartialTensorShape({}), PartialTensorShape({3})}, kNodeName);
+}
+
+SnapshotChunkDatasetParams TFRecordChunkParams() {
+  return SnapshotChunkDatasetParams(
+      WriteTFRecordChunk("tfrecord_chunk"), /*compression=*/"",
+      {DT_INT64, DT_INT32}, {PartialTensorShape({}), PartialTensorShape({3})},
+      kNodeName);
+}
+
+std::vector<GetNextTestCase<SnapshotChunkDatasetParams>> GetNextTestCases() {
+  return {{/*dataset_params=*/ColumnarChunkParams(),
+           /*expected_outputs=*/ExpectedOutputs()},
+          {/*dataset_params=*/SnappyColumnarChunkParams(),
+           /*expected_outputs=*/ExpectedOutputs()},
+          {/*dataset_params=*/TFRecordChunkParams(),
+           /*expected_outputs=*/ExpectedOutputs()}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(SnapshotChunkDatasetOpTest,
+                         SnapshotChunkDatasetParams, GetNextTestCases())
+
+// Restoring skips the row groups before the breakpoint and resumes in the
+// middle of a row group unless the breakpoint is on a row group boundary. The
+// breakpoints fall at the start of the file, in the middle of the first, second
+// and last row groups, on a row group boundary and past the end.
+std::vector<IteratorSaveAndRestoreTestCase<SnapshotChunkDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/ColumnarChunkParams(),
+           /*breakpoints=*/{0, 1, 4, 6, 9, 12},
+           /*expected_outputs=*/ExpectedOutputs()},
+          {/*dataset_params=*/SnappyColumnarChunkParams(),
+           /*breakpoints=*/{0, 5, 8, 12},
+           /*expected_outputs=*/ExpectedOutputs()},
+          {/*dataset_params=*/TFRecordChunkParams(),
+           /*breakpoints=*/{0, 5, 12},
+           /*expected_outputs=*/ExpectedOutputs()}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(SnapshotChunkDatasetOpTest,
+                                 SnapshotChunkDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+TEST_F(SnapshotChunkDatasetOpTest, ColumnarElementsAreAligned) {
+  auto dataset_params = ColumnarChunkParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  int64_t num_elements = 0;
+  while (true) {
+    TF_ASSERT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+    if (end_of_sequence) break;
+    ASSERT_EQ(out_tensors.size(), 2);
+    for (const Tensor& component : out_tensors) {
+      EXPECT_TRUE(component.IsAligned());
+    }
+    test::ExpectEqual(out_tensors[1], Element(num_elements)[1]);
+    ++num_elements;
+  }
+  EXPECT_EQ(num_elements, kNumElements);
+}
+
+TEST_F(SnapshotChunkDatasetOpTest, ColumnarChunkWithDifferentTypes) {
+  auto dataset_params = SnapshotChunkDatasetParams(
+      WriteColumnarChunk("columnar_chunk_types", /*compression=*/""),
+      /*compression=*/"", {DT_INT64, DT_FLOAT},
+      {PartialTensorShape({}), PartialTensorShape({3})}, kNodeName);
+  EXPECT_TRUE(absl::IsInvalidArgument(Initialize(dataset_params)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -38,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/snapshot/file_utils.h"
 #include "tensorflow/core/data/service/snapshot/path_utils.h"
 #include "tensorflow/core/data/service/snapshot/prefetched_split_provider.h"
+#include "tensorflow/core/data/service/snapshot/utils.h"
 #include "tensorflow/core/data/service/split_provider.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -133,6 +134,7 @@ absl::StatusOr<std::unique_ptr<SnapshotManager>> SnapshotManager::Start(
 absl::Status SnapshotManager::Start(const SnapshotRequest& request)
     TF_LOCKS_EXCLUDED(mu_) {
   LOG(INFO) << "Starting to write tf.data snapshot at " << request.path();
+  TF_RETURN_IF_ERROR(ValidateChunkFormat(request.metadata().chunk_format()));
   if (env_->FileExists(request.path()).ok()) {
     return errors::AlreadyExists("tf.data snapshot at ", request.path(),
                                  " already exists.");
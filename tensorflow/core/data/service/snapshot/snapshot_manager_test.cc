@@ -37,6 +37,7 @@ namespace tensorflow {
 namespace data {
 namespace {
 
+using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::SizeIs;
 using ::tsl::testing::StatusIs;
@@ -288,6 +289,30 @@ TEST(SnapshotManagerTest, ResumeFromError) {
   EXPECT_THAT(heartbeat_response.snapshot_tasks(), IsEmpty());
 }
 
+TEST(SnapshotManagerTest, InvalidChunkFormat) {
+  std::string snapshot_path = testing::LocalTempFilename();
+  SnapshotRequest request;
+  *request.mutable_dataset() = testing::RangeDataset(10);
+  request.set_path(snapshot_path);
+  *request.mutable_metadata() =
+      testing::CreateDummyDistributedSnapshotMetadata();
+  request.mutable_metadata()->set_chunk_format("PARQUET");
+
+  SnapshotAssignmentManager snapshot_assignment_manager(
+      /*worker_max_concurrent_snapshots=*/2);
+  EXPECT_THAT(SnapshotManager::Start(request, snapshot_assignment_manager,
+                                     Env::Default()),
+              StatusIs(error::INVALID_ARGUMENT,
+                       HasSubstr("Invalid tf.data snapshot chunk "
+                                 "format: PARQUET")));
+  EXPECT_FALSE(Env::Default()->FileExists(snapshot_path).ok());
+
+  request.mutable_metadata()->set_chunk_format("COLUMNAR");
+  TF_EXPECT_OK(SnapshotManager::Start(request, snapshot_assignment_manager,
+                                      Env::Default())
+                   .status());
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -96,6 +96,14 @@ ByteSize TotalBytes(const ParallelTFRecordWriter::FileToStatsMap& file_stats) {
   }
   return bytes;
 }
+
+absl::StatusOr<ParallelTFRecordWriter::FileFormat> GetChunkFileFormat(
+    const std::string& chunk_format) {
+  TF_RETURN_IF_ERROR(ValidateChunkFormat(chunk_format));
+  return chunk_format == "COLUMNAR"
+             ? ParallelTFRecordWriter::FileFormat::kColumnar
+             : ParallelTFRecordWriter::FileFormat::kTFRecord;
+}
 }  // namespace
 
 SnapshotStreamWriter::SnapshotStreamWriter(
@@ -176,9 +184,12 @@ absl::Status SnapshotStreamWriter::WriteChunks() {
   std::string chunks_prefix = tsl::io::JoinPath(
       params_.UncommittedChunksDirectory(),
       absl::StrCat("chunk_", chunk_index_, kFileShardDelimiter));
-  ParallelTFRecordWriter writer(TranslateFileName(chunks_prefix),
-                                params_.compression, params_.env,
-                                params_.max_chunk_size);
+  TF_ASSIGN_OR_RETURN(const ParallelTFRecordWriter::FileFormat file_format,
+                      GetChunkFileFormat(params_.chunk_format));
+  ParallelTFRecordWriter writer(
+      TranslateFileName(chunks_prefix), params_.compression, params_.env,
+      params_.max_chunk_size, ParallelTFRecordWriter::kDefaultNumWriteThreads,
+      ParallelTFRecordWriter::kDefaultBufferSizePerThread, file_format);
   do {
     TF_RETURN_IF_ERROR(WriteRecord(writer));
   } while (ShouldWriteRecord());
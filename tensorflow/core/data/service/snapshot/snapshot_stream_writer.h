@@ -71,6 +71,11 @@ struct SnapshotWriterParams {
   // snapshot. Used only for unit testing.
   bool test_only_keep_temp_files = false;
 
+  // Format of the chunk files, as in `DistributedSnapshotMetadata`. Either
+  // empty or "TFRECORD" for TFRecord files, or "COLUMNAR" for columnar record
+  // files of raw tensor buffers.
+  std::string chunk_format;
+
   std::string StreamDirectory() const {
     return tensorflow::data::StreamDirectory(snapshot_path, stream_index);
   }
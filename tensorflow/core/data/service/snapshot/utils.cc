@@ -16,7 +16,9 @@ limitations under the License.
 
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/byte_size.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -37,5 +39,15 @@ ByteSize EstimatedSize(const std::vector<Tensor>& tensors) {
   return byte_size;
 }
 
+absl::Status ValidateChunkFormat(absl::string_view chunk_format) {
+  if (chunk_format.empty() || chunk_format == "TFRECORD" ||
+      chunk_format == "COLUMNAR") {
+    return absl::OkStatus();
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Invalid tf.data snapshot chunk format: ", chunk_format,
+                   ". Supported formats are TFRECORD and COLUMNAR."));
+}
+
 }  // namespace data
 }  // namespace tensorflow
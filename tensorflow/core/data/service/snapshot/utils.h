@@ -27,6 +27,10 @@ namespace data {
 
 ByteSize EstimatedSize(const std::vector<Tensor>& tensors);
 
+// Returns an InvalidArgument error unless `chunk_format` is a supported
+// `DistributedSnapshotMetadata.chunk_format`: empty, "TFRECORD" or "COLUMNAR".
+absl::Status ValidateChunkFormat(absl::string_view chunk_format);
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -739,15 +739,16 @@ Status DataServiceWorkerImpl::UpdateSnapshotWriters(
         &dataset_def));
     TF_ASSIGN_OR_RETURN(std::unique_ptr<StandaloneTaskIterator> iterator,
                         MakeSnapshotTaskIterator(snapshot_task, dataset_def));
+    SnapshotWriterParams writer_params{
+        snapshot_task.base_path(), snapshot_task.stream_index(),
+        snapshot_task.metadata().compression(), Env::Default(),
+        ByteSize::Bytes(config_.snapshot_max_chunk_size_bytes())};
+    writer_params.chunk_format = snapshot_task.metadata().chunk_format();
     mutex_lock l(mu_);
     snapshot_writers_.emplace(
         snapshot_task_key,
-        std::make_unique<SnapshotStreamWriter>(
-            SnapshotWriterParams{
-                snapshot_task.base_path(), snapshot_task.stream_index(),
-                snapshot_task.metadata().compression(), Env::Default(),
-                ByteSize::Bytes(config_.snapshot_max_chunk_size_bytes())},
-            std::move(iterator)));
+        std::make_unique<SnapshotStreamWriter>(writer_params,
+                                               std::move(iterator)));
   }
 
   // Cancel writers for snapshots that are no longer assigned by the dispatcher.
@@ -66,6 +66,7 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
+        batchrecvtensor_(Method(GrpcWorkerMethod::kBatchRecvTensor)),
         logger_(logger),
         target_(target) {}
 
@@ -258,6 +259,14 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, recvtensor_, callback, call_opts);
   }
 
+  void BatchRecvTensorAsync(CallOptions* call_opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done) override {
+    IssueRequest(request, response, batchrecvtensor_, std::move(done),
+                 call_opts);
+  }
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override {
     IssueRequest(request, response, logging_, done);
@@ -333,6 +342,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string batchrecvtensor_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 
+#include <vector>
+
 #include "grpcpp/support/byte_buffer.h"
 #include "grpcpp/support/slice.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -22,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/io/proto_encode_helper.h"
 #include "tensorflow/core/platform/env.h"
@@ -134,6 +137,75 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 #endif
 }
 
+// Encodes "response" followed by a RecvTensorResponse::tensor field that holds
+// the DT_STRING tensor "val" into "*result", without building the
+// TensorProto::string_val field first.
+//
+// Each element of "val" becomes a string_val entry. The data of elements
+// larger than "large_string_bytes" is not copied: it gets its own grpc::Slice
+// that points into the backing store of "val" and holds a reference on its
+// TensorBuffer. The entry headers and the smaller elements are copied into
+// the slices in between.
+static void EncodeStringTensorToByteBuffer(const RecvTensorResponse& response,
+                                           const Tensor& val,
+                                           size_t large_string_bytes,
+                                           ::grpc::ByteBuffer* result) {
+  const auto elements = val.flat<tstring>();
+  gtl::InlinedVector<char, 128> skeleton(SkeletonEncodingSizeUpperBound(val));
+  io::ProtoEncodeHelper e_skeleton(skeleton.data(), skeleton.size());
+  EncodeSkeleton(val, &e_skeleton);
+  size_t overall_tensor_proto_bytesize = e_skeleton.size();
+  for (int64_t i = 0; i < elements.size(); ++i) {
+    overall_tensor_proto_bytesize += VarLengthEncodingSize(
+        TensorProto::kStringValFieldNumber, elements(i).size());
+  }
+
+  string pending;  // Bytes to be copied into the next slice
+  char varlength[2 * core::kMaxVarint32Bytes];
+  auto append_varlength_beginning = [&pending, &varlength](int tag,
+                                                           uint32 len) {
+    io::ProtoEncodeHelper e(varlength, sizeof(varlength));
+    e.WriteVarlengthBeginning(tag, len);
+    pending.append(e.data(), e.size());
+  };
+  std::vector<::grpc::Slice> slices;
+  auto flush_pending = [&pending, &slices]() {
+    if (!pending.empty()) {
+      slices.emplace_back(pending.data(), pending.size());
+      pending.clear();
+    }
+  };
+
+  // (A), (B1) & (B2), and (C) as in EncodeTensorToByteBuffer.
+  response.AppendToString(&pending);
+  append_varlength_beginning(RecvTensorResponse::kTensorFieldNumber,
+                             overall_tensor_proto_bytesize);
+  pending.append(e_skeleton.data(), e_skeleton.size());
+
+  const TensorBuffer* buf = DMAHelper::buffer(&val);
+  for (int64_t i = 0; i < elements.size(); ++i) {
+    const tstring& element = elements(i);
+    append_varlength_beginning(TensorProto::kStringValFieldNumber,
+                               element.size());
+    // Views point to memory that "val" does not own, so they are copied.
+    if (element.size() <= large_string_bytes ||
+        element.type() == tstring::VIEW) {
+      pending.append(element.data(), element.size());
+      continue;
+    }
+    flush_pending();
+    buf->Ref();
+    slices.emplace_back(
+        const_cast<char*>(element.data()), element.size(),
+        [](void* backing) { static_cast<TensorBuffer*>(backing)->Unref(); },
+        const_cast<TensorBuffer*>(buf));
+  }
+  flush_pending();
+
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+}
+
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
@@ -153,7 +225,9 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
   response.set_require_ack(require_ack);
   response.set_send_start_micros(Env::Default()->NowMicros());
-  if (!DataTypeCanUseMemcpy(val.dtype())) {
+  if (val.dtype() == DT_STRING) {
+    EncodeStringTensorToByteBuffer(response, val, kLargeTensorBytes, result);
+  } else if (!DataTypeCanUseMemcpy(val.dtype())) {
     // Straightforward but slow path for complicated kinds of tensor data
     // TODO(jeff,sanjay): If this becomes an issue, we could
     // go directly from val -> ByteBuffer, with some effort.
@@ -250,5 +324,65 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
 }
 
+// The item is encoded as
+//
+// A:   <tag encoding for BatchRecvTensorResponse::item>
+// B:   <varint32 length of the item sub message>
+// C:   <protocol buffer encoding of the item except its response()>
+// D1:  <tag encoding for BatchRecvTensorResponse::Item::response>
+// D2:  <varint32 length of the response sub message>
+// E:   <the slices of EncodeTensorToByteBuffer() for the response>
+//
+// where D1 through E are only present if "status" is OK.
+void EncodeBatchRecvTensorItemToByteBuffer(int index, const Status& status,
+                                           bool is_dead, const Tensor& val,
+                                           ::grpc::ByteBuffer* result) {
+  BatchRecvTensorResponse::Item item;
+  item.set_index(index);
+  item.set_status_code(static_cast<error::Code>(status.code()));
+  if (!status.ok()) {
+    item.set_status_error_message(std::string(status.message()));
+  }
+  string header;  // (C)
+  item.AppendToString(&header);
+
+  std::vector<::grpc::Slice> response_slices;
+  size_t response_bytes = 0;
+  size_t item_bytes = header.size();
+  if (status.ok()) {
+    ::grpc::ByteBuffer response;
+    EncodeTensorToByteBuffer(is_dead, val, /*require_ack=*/false, &response);
+    response_bytes = response.Length();
+    item_bytes += VarLengthEncodingSize(
+        BatchRecvTensorResponse::Item::kResponseFieldNumber, response_bytes);
+    // Dumping takes references on the slices, it does not copy them.
+    (void)response.Dump(&response_slices);
+  }
+
+  char space[2 * core::kMaxVarint32Bytes];
+  io::ProtoEncodeHelper e(space, sizeof(space));
+  // (A) & (B)
+  e.WriteVarlengthBeginning(BatchRecvTensorResponse::kItemFieldNumber,
+                            item_bytes);
+  string prefix(e.data(), e.size());
+  prefix.append(header);
+  if (status.ok()) {
+    // (D1) & (D2)
+    io::ProtoEncodeHelper e_response(space, sizeof(space));
+    e_response.WriteVarlengthBeginning(
+        BatchRecvTensorResponse::Item::kResponseFieldNumber, response_bytes);
+    prefix.append(e_response.data(), e_response.size());
+  }
+
+  std::vector<::grpc::Slice> slices;
+  slices.reserve(1 + response_slices.size());
+  slices.emplace_back(prefix.data(), prefix.size());
+  for (::grpc::Slice& slice : response_slices) {
+    slices.push_back(std::move(slice));
+  }
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
 #include "grpcpp/impl/codegen/byte_buffer.h"
+#include "tensorflow/core/platform/status.h"
 
 namespace tensorflow {
 class Tensor;
@@ -49,6 +50,20 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result);
 
+// Encode the outcome of the request at "index" of a BatchRecvTensorRequest
+// into a byte buffer in a format that is parseable as a
+// BatchRecvTensorResponse holding that single item. The encodings of several
+// items can be concatenated into one BatchRecvTensorResponse.
+//
+// If "status" is OK, the item's response holds "is_dead" and "val", encoded
+// as by EncodeTensorToByteBuffer, so the tensor data is shared rather than
+// copied. Otherwise "is_dead" and "val" are ignored.
+//
+// Discards original contents of *result.
+void EncodeBatchRecvTensorItemToByteBuffer(int index, const Status& status,
+                                           bool is_dead, const Tensor& val,
+                                           ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
@@ -19,6 +19,7 @@ limitations under the License.
 #include "grpcpp/support/slice.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
@@ -100,4 +101,71 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, LargeStringsShareTensorBuffer) {
+  Tensor t(DT_STRING, TensorShape({4}));
+  auto flat = t.flat<tstring>();
+  flat(0) = "small";
+  flat(1) = string(5000, 'a');
+  flat(2) = "";
+  flat(3) = string(2000, 'b');
+  Validate(t, false);
+
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, false, &buf);
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  // The two large strings are not copied into the surrounding slices.
+  ASSERT_EQ(4, slices.size());
+  EXPECT_EQ(flat(1).data(), reinterpret_cast<const char*>(slices[1].begin()));
+  EXPECT_EQ(flat(3).data(), reinterpret_cast<const char*>(slices[3].begin()));
+
+  // The slices keep the strings alive after the tensor is gone.
+  t = Tensor();
+  string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  RecvTensorResponse response;
+  ASSERT_TRUE(response.ParseFromString(tmp));
+  ASSERT_EQ(4, response.tensor().string_val_size());
+  EXPECT_EQ(string(5000, 'a'), response.tensor().string_val(1));
+  EXPECT_EQ(string(2000, 'b'), response.tensor().string_val(3));
+}
+
+TEST_F(GrpcTensorCodingTest, BatchRecvTensorItemsConcatenate) {
+  Tensor t(DT_FLOAT, TensorShape({1024}));
+  test::FillIota<float>(&t, 0.0f);
+  std::vector<::grpc::Slice> slices;
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeBatchRecvTensorItemToByteBuffer(3, OkStatus(), false, t, &buf);
+  (void)buf.Dump(&slices);
+  // The tensor data is not copied.
+  ASSERT_EQ(2, slices.size());
+  EXPECT_EQ(t.tensor_data().data(),
+            reinterpret_cast<const char*>(slices[1].begin()));
+
+  grpc::EncodeBatchRecvTensorItemToByteBuffer(
+      1, errors::NotFound("missing"), false, Tensor(), &buf);
+  std::vector<::grpc::Slice> error_slices;
+  (void)buf.Dump(&error_slices);
+  slices.insert(slices.end(), error_slices.begin(), error_slices.end());
+
+  string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  BatchRecvTensorResponse response;
+  ASSERT_TRUE(response.ParseFromString(tmp));
+  ASSERT_EQ(2, response.item_size());
+  EXPECT_EQ(3, response.item(0).index());
+  EXPECT_EQ(error::OK, response.item(0).status_code());
+  Tensor result;
+  ASSERT_TRUE(result.FromProto(response.item(0).response().tensor()));
+  test::ExpectTensorEqual<float>(t, result);
+  EXPECT_EQ(1, response.item(1).index());
+  EXPECT_EQ(error::NOT_FOUND, response.item(1).status_code());
+  EXPECT_EQ("missing", response.item(1).status_error_message());
+  EXPECT_FALSE(response.item(1).has_response());
+}
+
 }  // namespace tensorflow
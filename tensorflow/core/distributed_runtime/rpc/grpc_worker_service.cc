@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <deque>
 #include <memory>
+#include <set>
 #include <unordered_map>
 #include <vector>
 
@@ -158,6 +159,13 @@ class GrpcWorkerServiceThread {
          ++i) {
       EnqueueRecvTensorRequestRaw();
     }
+    for (int i = 0;
+         i < gtl::FindWithDefault(
+                 queue_depth_,
+                 static_cast<int>(GrpcWorkerMethod::kBatchRecvTensor), 100);
+         ++i) {
+      EnqueueBatchRecvTensorRequestRaw();
+    }
 
     void* tag;
     bool ok;
@@ -284,6 +292,25 @@ class GrpcWorkerServiceThread {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void BatchRecvTensorHandlerRaw(
+      WorkerCall<BatchRecvTensorRequest, ::grpc::ByteBuffer>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->GrpcBatchRecvTensorAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(3) << "Bad response from BatchRecvTensor:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    EnqueueBatchRecvTensorRequestRaw();
+  }
+
   void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -353,6 +380,19 @@ class GrpcWorkerServiceThread {
     }
   }
 
+  void EnqueueBatchRecvTensorRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      tsl::Call<GrpcWorkerServiceThread, grpc::WorkerService::AsyncService,
+                BatchRecvTensorRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kBatchRecvTensor),
+              &GrpcWorkerServiceThread::BatchRecvTensorHandlerRaw,
+              true /* supports cancel*/);
+    }
+  }
+
   GrpcWorker* const worker_ = nullptr;  // Not owned.
   std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
   std::unique_ptr<Thread> thread_;
@@ -476,12 +516,19 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
     }
   };
 
-  auto fail = [&rendezvous_done](const Status& status) {
-    rendezvous_done(Tensor(), false, status);
+  RecvLocalTensorAsync(opts, request, std::move(rendezvous_done));
+}
+
+void GrpcWorker::RecvLocalTensorAsync(CallOptions* opts,
+                                      const RecvTensorRequest* request,
+                                      RpcResponseCache::FinishResponseCB done) {
+  const int64_t step_id = request->step_id();
+  auto fail = [&done](const Status& status) {
+    done(Tensor(), false, status);
   };
 
   Status s = recent_request_ids_.TrackUnique(
-      request_id, "RecvTensor (GrpcWorker)", *request);
+      request->request_id(), "RecvTensor (GrpcWorker)", *request);
   if (!s.ok()) {
     fail(s);
     return;
@@ -508,17 +555,21 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   // failures, and the client might not observe any errors or cancellations but
   // simply waits for the responses. Aborting the step would report an error to
   // the client, and avoid permanent hanging in distributed function execution.
-  opts->SetCancelCallback([this, step_id]() {
-    LOG(WARNING) << "RecvTensor cancelled for " << step_id;
-    AbortStep(step_id);
-  });
+  if (opts != nullptr) {
+    opts->SetCancelCallback([this, step_id]() {
+      LOG(WARNING) << "RecvTensor cancelled for " << step_id;
+      AbortStep(step_id);
+    });
+  }
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, rendezvous_done, src_dev, request](
+      [opts, rendezvous_done = std::move(done), src_dev, request](
           const Status& status, const Rendezvous::Args& send_args,
           const Rendezvous::Args& recv_args, const Tensor& val,
           const bool is_dead) {
-        opts->ClearCancelCallback();
+        if (opts != nullptr) {
+          opts->ClearCancelCallback();
+        }
         if (!status.ok()) {
           return rendezvous_done(val, is_dead, status);
         }
@@ -554,6 +605,151 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
       });
 }
 
+void GrpcWorker::BatchRecvTensorAsync(CallOptions* opts,
+                                      const BatchRecvTensorRequest* request,
+                                      BatchRecvTensorResponse* response,
+                                      StatusCallback done) {
+  BatchRecvLocalTensorsAsync(
+      opts, request,
+      [this, response](int index, const Tensor& tensor, bool is_dead,
+                       const Status& status) {
+        BatchRecvTensorResponse::Item* item = response->add_item();
+        item->set_index(index);
+        item->set_status_code(static_cast<error::Code>(status.code()));
+        if (status.ok()) {
+          RecvTensorResponse* item_response = item->mutable_response();
+          tensor.AsProtoTensorContent(item_response->mutable_tensor());
+          item_response->set_is_dead(is_dead);
+          item_response->set_send_start_micros(env_->env->NowMicros());
+        } else {
+          item->set_status_error_message(std::string(status.message()));
+        }
+      },
+      std::move(done));
+}
+
+// Like GrpcRecvTensorAsync, the response is generated directly into a
+// ::grpc::ByteBuffer, which shares the tensors' buffers instead of copying
+// them into a BatchRecvTensorResponse.
+void GrpcWorker::GrpcBatchRecvTensorAsync(CallOptions* opts,
+                                          const BatchRecvTensorRequest* request,
+                                          ::grpc::ByteBuffer* response,
+                                          StatusCallback done) {
+  // The encoded items, which are concatenated into `response` once the call
+  // is answered.
+  auto slices = std::make_shared<std::vector<::grpc::Slice>>();
+  BatchRecvLocalTensorsAsync(
+      opts, request,
+      [slices](int index, const Tensor& tensor, bool is_dead,
+               const Status& status) {
+        ::grpc::ByteBuffer item;
+        grpc::EncodeBatchRecvTensorItemToByteBuffer(index, status, is_dead,
+                                                    tensor, &item);
+        std::vector<::grpc::Slice> item_slices;
+        (void)item.Dump(&item_slices);
+        for (::grpc::Slice& slice : item_slices) {
+          slices->push_back(std::move(slice));
+        }
+      },
+      [slices, response, done = std::move(done)](const Status& s) {
+        ::grpc::ByteBuffer tmp(slices->data(), slices->size());
+        response->Swap(&tmp);
+        done(s);
+      });
+}
+
+void GrpcWorker::BatchRecvLocalTensorsAsync(
+    CallOptions* opts, const BatchRecvTensorRequest* request,
+    AddBatchItemCallback add_item, StatusCallback done) {
+  VLOG(3) << "BatchRecvTensorAsync: " << request->request_size()
+          << " requests";
+  std::set<int64_t> step_ids;
+  for (const RecvTensorRequest& item_request : request->request()) {
+    if (item_request.request_id() == 0) {
+      done(errors::InvalidArgument(
+          "BatchRecvTensor requires a request_id for every request."));
+      return;
+    }
+    step_ids.insert(item_request.step_id());
+  }
+  if (step_ids.empty()) {
+    done(OkStatus());
+    return;
+  }
+
+  // The call is answered once all of its requests have been started and at
+  // least one of them has completed. Requests that complete later stay in
+  // `batch_response_cache_` until the client asks for them again.
+  struct BatchState {
+    mutex mu;
+    bool started_all TF_GUARDED_BY(mu) = false;
+    bool responded TF_GUARDED_BY(mu) = false;
+    std::vector<int64_t> finished_request_ids TF_GUARDED_BY(mu);
+  };
+  auto state = std::make_shared<BatchState>();
+  auto respond = [this, state, opts, done = std::move(done)]() {
+    opts->ClearCancelCallback();
+    std::vector<int64_t> finished_request_ids;
+    {
+      mutex_lock l(state->mu);
+      finished_request_ids.swap(state->finished_request_ids);
+    }
+    for (int64_t request_id : finished_request_ids) {
+      batch_response_cache_.EraseRequestId(request_id);
+    }
+    done(OkStatus());
+  };
+
+  // As for RecvTensor, cancelling the call aborts the steps it waits for.
+  opts->SetCancelCallback([this, step_ids]() {
+    for (int64_t step_id : step_ids) {
+      LOG(WARNING) << "BatchRecvTensor cancelled for " << step_id;
+      AbortStep(step_id);
+    }
+  });
+  for (int i = 0; i < request->request_size(); ++i) {
+    const RecvTensorRequest& item_request = request->request(i);
+    const int64_t request_id = item_request.request_id();
+    auto item_done = [state, add_item, respond, i, request_id](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
+      {
+        mutex_lock l(state->mu);
+        if (state->responded) return;
+        add_item(i, tensor, is_dead, status);
+        state->finished_request_ids.push_back(request_id);
+        if (!state->started_all) return;
+        state->responded = true;
+      }
+      respond();
+    };
+    if (batch_response_cache_.QueueRequest(request_id, item_request.step_id(),
+                                           item_done)) {
+      continue;
+    }
+    // The request can outlive this call.
+    auto owned_request = std::make_shared<RecvTensorRequest>(item_request);
+    RecvLocalTensorAsync(
+        /*opts=*/nullptr, owned_request.get(),
+        [this, owned_request](const Tensor& tensor, bool is_dead,
+                              const Status& status) {
+          batch_response_cache_.RequestFinished(owned_request->request_id(),
+                                                tensor, is_dead, status);
+        });
+  }
+
+  bool respond_now = false;
+  {
+    mutex_lock l(state->mu);
+    state->started_all = true;
+    respond_now = !state->finished_request_ids.empty();
+    state->responded = respond_now;
+  }
+  if (respond_now) {
+    respond();
+  }
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
@@ -736,6 +932,7 @@ void GrpcWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
     // a worker crashes before acking a request.
     response_cache_->CleanEntriesForStep(request->step_id());
   }
+  batch_response_cache_.CleanEntriesForStep(request->step_id());
   Worker::CleanupGraphAsync(request, response, done);
 }
 
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_SERVICE_H_
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
 
@@ -51,6 +52,18 @@ class GrpcWorker : public Worker {
                                    ::grpc::ByteBuffer* response,
                                    StatusCallback done);
 
+  void BatchRecvTensorAsync(CallOptions* opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done) override;
+
+  // Specialized version of BatchRecvTensor for gRPC, which avoids copying the
+  // tensors.
+  void GrpcBatchRecvTensorAsync(CallOptions* opts,
+                                const BatchRecvTensorRequest* request,
+                                ::grpc::ByteBuffer* response,
+                                StatusCallback done);
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
@@ -68,7 +81,30 @@ class GrpcWorker : public Worker {
   void RemoveCacheEntryForId(int64_t request_id);
 
  private:
+  // Receives the tensor of `request` from the rendezvous of its step, copied
+  // to host memory if needed. If `opts` is not null, cancelling it aborts the
+  // step while the tensor is not available yet.
+  void RecvLocalTensorAsync(CallOptions* opts,
+                            const RecvTensorRequest* request,
+                            RpcResponseCache::FinishResponseCB done);
+
+  // Adds the outcome of the request at `index` of a BatchRecvTensorRequest to
+  // the response. Calls are serialized.
+  using AddBatchItemCallback =
+      std::function<void(int index, const Tensor& tensor, bool is_dead,
+                         const Status& status)>;
+
+  // Implements BatchRecvTensor, adding an item to the response for each of
+  // the requests that has completed when the call is answered.
+  void BatchRecvLocalTensorsAsync(CallOptions* opts,
+                                  const BatchRecvTensorRequest* request,
+                                  AddBatchItemCallback add_item,
+                                  StatusCallback done);
+
   std::unique_ptr<RpcResponseCache> response_cache_;
+  // Requests of BatchRecvTensor calls, which are answered by later calls if
+  // they complete after the call that started them. Always enabled.
+  RpcResponseCache batch_response_cache_;
   const int32 recv_buf_max_chunk_;
 };
 
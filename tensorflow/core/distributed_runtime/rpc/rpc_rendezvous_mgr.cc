@@ -15,6 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -23,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -31,15 +37,38 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Returns the time in microseconds during which the RecvTensor calls of a step
+// to the same worker are collected into one BatchRecvTensor RPC, or 0 if each
+// call is sent on its own.
+int64_t ReadBatchWindowMicros() {
+  int64_t window_micros;
+  Status s = ReadInt64FromEnvVar("TF_RPC_RENDEZVOUS_BATCH_WINDOW_MICROS", 0,
+                                 &window_micros);
+  if (!s.ok()) {
+    LOG(ERROR) << "Not batching RecvTensor calls: " << s;
+    return 0;
+  }
+  return window_micros;
+}
+
+// A batch is sent before the window ends once it has this many calls.
+constexpr int kMaxRecvTensorBatchSize = 512;
+
+class RpcRecvTensorCall;
+struct RecvTensorBatch;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64_t step_id)
-      : BaseRemoteRendezvous(env, step_id) {}
+  RpcRemoteRendezvous(const WorkerEnv* env, int64_t step_id,
+                      int64_t batch_window_micros)
+      : BaseRemoteRendezvous(env, step_id),
+        batch_window_micros_(batch_window_micros) {}
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -47,7 +76,35 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
                            DoneCallback done) override;
 
  private:
-  ~RpcRemoteRendezvous() override {}
+  ~RpcRemoteRendezvous() override {
+    const int64_t num_recv_rpcs = num_recv_rpcs_.load();
+    if (num_recv_rpcs > 0) {
+      metrics::RecordRendezvousStepRecvRpcs(num_recv_rpcs);
+    }
+  }
+
+  // Sends `call` in a RecvTensor RPC of its own.
+  void StartRecvTensorCall(RpcRecvTensorCall* call,
+                           std::function<void()> recv_done);
+  // Adds `call` to the open batch of its source worker, which is sent once
+  // the batch window ends or the batch is full.
+  void EnqueueBatchedCall(RpcRecvTensorCall* call,
+                          std::function<void()> recv_done);
+  // Sends `batch` unless it has been sent already.
+  void FlushBatch(const std::shared_ptr<RecvTensorBatch>& batch);
+  // Sends the calls of `batch` that are not completed yet.
+  void SendBatch(const std::shared_ptr<RecvTensorBatch>& batch);
+  void BatchDone(const std::shared_ptr<RecvTensorBatch>& batch,
+                 const Status& s);
+  void AbortBatchedCall(const std::shared_ptr<RecvTensorBatch>& batch,
+                        int index);
+
+  const int64_t batch_window_micros_;
+  mutex batch_mu_;
+  // Batches that are still collecting calls, by source worker.
+  absl::flat_hash_map<string, std::shared_ptr<RecvTensorBatch>> open_batches_
+      TF_GUARDED_BY(batch_mu_);
+  std::atomic<int64_t> num_recv_rpcs_{0};
 
   RpcRemoteRendezvous(const RpcRemoteRendezvous&) = delete;
   void operator=(const RpcRemoteRendezvous&) = delete;
@@ -132,6 +189,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
  private:
   friend class RpcRemoteRendezvous;
+  friend struct RecvTensorBatch;
 
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
@@ -230,6 +288,81 @@ static RpcRecvTensorFreeList* get_call_freelist() {
   return call_freelist;
 }
 
+// RecvTensor calls of a step to the same worker that are sent together.
+//
+// The calls are sent in BatchRecvTensor RPCs until each of them has its
+// response or has been aborted. The worker answers as soon as some of the
+// tensors are available, and the requests for the others are sent again, so a
+// tensor is never held back by one that depends on it. Aborting a call
+// completes it right away, and the RPC is cancelled once all of its calls
+// have been aborted.
+struct RecvTensorBatch {
+  struct Entry {
+    // Null once the call has been completed.
+    RpcRecvTensorCall* call;
+    std::function<void()> recv_done;
+  };
+
+  explicit RecvTensorBatch(const string& src_worker)
+      : src_worker(src_worker) {}
+
+  // Removes the call of entry `index` from the batch and returns it with its
+  // callback, or returns null if it has been completed already. Cancels the
+  // RPC in flight if no calls are left.
+  RpcRecvTensorCall* TakeCall(int index, std::function<void()>* recv_done) {
+    RpcRecvTensorCall* call;
+    bool cancel_rpc;
+    {
+      mutex_lock l(mu);
+      Entry& entry = entries[index];
+      call = entry.call;
+      if (call == nullptr) return nullptr;
+      entry.call = nullptr;
+      *recv_done = std::move(entry.recv_done);
+      cancel_rpc = --num_pending == 0 && in_flight;
+    }
+    if (cancel_rpc) {
+      opts.StartCancel();
+    }
+    return call;
+  }
+
+  // Takes every call that is not completed yet, with its status updated by
+  // `s`, and runs its callback.
+  void FailPendingCalls(const Status& s) {
+    for (int i = 0; i < num_entries(); ++i) {
+      std::function<void()> recv_done;
+      RpcRecvTensorCall* call = TakeCall(i, &recv_done);
+      if (call == nullptr) continue;
+      call->opts_.ClearCancelCallback();
+      {
+        mutex_lock l(call->mu_);
+        call->status_.Update(s);
+      }
+      recv_done();
+    }
+  }
+
+  int num_entries() {
+    mutex_lock l(mu);
+    return entries.size();
+  }
+
+  const string src_worker;
+
+  mutex mu;
+  std::vector<Entry> entries TF_GUARDED_BY(mu);
+  int num_pending TF_GUARDED_BY(mu) = 0;
+  bool in_flight TF_GUARDED_BY(mu) = false;
+
+  // The RPC in flight. `req_entries` holds the index in `entries` of each of
+  // its requests.
+  CallOptions opts;
+  BatchRecvTensorRequest req;
+  BatchRecvTensorResponse resp;
+  std::vector<int> req_entries;
+};
+
 void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
@@ -289,7 +422,7 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   // Start "call".
   Ref();
-  call->Start([this, call, recv_args, worker_cache]() {
+  auto recv_done = [this, call, recv_args, worker_cache]() {
     // Removes "call" from calls_. Prevent StartAbort().
     DeregisterCall(call, recv_args);
     // If StartAbort was called prior to DeregisterCall, then the
@@ -302,18 +435,208 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
     get_call_freelist()->Release(call);
     Unref();
+  };
+  if (batch_window_micros_ > 0) {
+    EnqueueBatchedCall(call, std::move(recv_done));
+    return;
+  }
+  StartRecvTensorCall(call, std::move(recv_done));
+}
+
+void RpcRemoteRendezvous::StartRecvTensorCall(
+    RpcRecvTensorCall* call, std::function<void()> recv_done) {
+  num_recv_rpcs_.fetch_add(1, std::memory_order_relaxed);
+  const uint64 start_micros = env_->env->NowMicros();
+  call->Start([this, start_micros, recv_done = std::move(recv_done)]() {
+    metrics::RecordRendezvousRecvRpcLatency(
+        "RecvTensor", env_->env->NowMicros() - start_micros);
+    recv_done();
   });
 }
 
+void RpcRemoteRendezvous::EnqueueBatchedCall(RpcRecvTensorCall* call,
+                                             std::function<void()> recv_done) {
+  std::shared_ptr<RecvTensorBatch> batch;
+  bool new_batch = false;
+  bool full = false;
+  {
+    // The batch cannot be sent while `batch_mu_` is held, so `call` stays
+    // valid until the end of this block.
+    mutex_lock l(batch_mu_);
+    std::shared_ptr<RecvTensorBatch>& open_batch =
+        open_batches_[call->src_worker_];
+    if (open_batch == nullptr) {
+      open_batch = std::make_shared<RecvTensorBatch>(call->src_worker_);
+      new_batch = true;
+    }
+    batch = open_batch;
+    int index;
+    {
+      mutex_lock batch_lock(batch->mu);
+      index = batch->entries.size();
+      batch->entries.push_back({call, std::move(recv_done)});
+      ++batch->num_pending;
+      full = batch->entries.size() >= kMaxRecvTensorBatchSize;
+    }
+    if (full) {
+      open_batches_.erase(call->src_worker_);
+    }
+    // From now on `call->StartAbort()` completes the call instead of
+    // cancelling its RPC. As in `StartRTCall()`, check for an abort that
+    // happened before.
+    call->opts_.SetCancelCallback(
+        [this, batch, index]() { AbortBatchedCall(batch, index); });
+    if (!call->status().ok()) {
+      AbortBatchedCall(batch, index);
+    }
+  }
+  if (full) {
+    SendBatch(batch);
+  } else if (new_batch) {
+    Ref();
+    env_->env->SchedClosureAfter(batch_window_micros_, [this, batch]() {
+      FlushBatch(batch);
+      Unref();
+    });
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(
+    const std::shared_ptr<RecvTensorBatch>& batch) {
+  {
+    mutex_lock l(batch_mu_);
+    auto it = open_batches_.find(batch->src_worker);
+    // The batch has been sent already if it filled up.
+    if (it == open_batches_.end() || it->second != batch) return;
+    open_batches_.erase(it);
+  }
+  SendBatch(batch);
+}
+
+void RpcRemoteRendezvous::SendBatch(
+    const std::shared_ptr<RecvTensorBatch>& batch) {
+  {
+    mutex_lock l(batch->mu);
+    batch->req.Clear();
+    batch->req_entries.clear();
+    for (int i = 0; i < batch->entries.size(); ++i) {
+      if (batch->entries[i].call != nullptr) {
+        *batch->req.add_request() = batch->entries[i].call->req_;
+        batch->req_entries.push_back(i);
+      }
+    }
+    batch->in_flight = !batch->req_entries.empty();
+  }
+  if (batch->req_entries.empty()) return;
+
+  std::shared_ptr<WorkerCacheInterface> worker_cache =
+      session()->GetSharedWorkerCache();
+  WorkerInterface* wi = worker_cache->GetOrCreateWorker(batch->src_worker);
+  if (wi == nullptr) {
+    batch->FailPendingCalls(
+        errors::Internal("No worker known as ", batch->src_worker));
+    return;
+  }
+  batch->resp.Clear();
+  num_recv_rpcs_.fetch_add(1, std::memory_order_relaxed);
+  const uint64 start_micros = env_->env->NowMicros();
+  Ref();
+  wi->BatchRecvTensorAsync(
+      &batch->opts, &batch->req, &batch->resp,
+      [this, batch, worker_cache, wi, start_micros](const Status& s) {
+        worker_cache->ReleaseWorker(batch->src_worker, wi);
+        metrics::RecordRendezvousRecvRpcLatency(
+            "BatchRecvTensor", env_->env->NowMicros() - start_micros);
+        BatchDone(batch, s);
+        Unref();
+      });
+
+  // Cancel the RPC if all calls have been aborted before it registered its
+  // cancellation.
+  bool cancel_rpc;
+  {
+    mutex_lock l(batch->mu);
+    cancel_rpc = batch->num_pending == 0;
+  }
+  if (cancel_rpc) {
+    batch->opts.StartCancel();
+  }
+}
+
+void RpcRemoteRendezvous::BatchDone(
+    const std::shared_ptr<RecvTensorBatch>& batch, const Status& s) {
+  {
+    mutex_lock l(batch->mu);
+    batch->in_flight = false;
+  }
+  if (errors::IsUnimplemented(s)) {
+    // The worker does not support BatchRecvTensor; send each call on its own.
+    LOG_FIRST_N(WARNING, 1)
+        << "Worker " << batch->src_worker
+        << " does not support BatchRecvTensor, not batching RecvTensor calls.";
+    for (int index : batch->req_entries) {
+      std::function<void()> recv_done;
+      RpcRecvTensorCall* call = batch->TakeCall(index, &recv_done);
+      if (call == nullptr) continue;
+      call->opts_.ClearCancelCallback();
+      StartRecvTensorCall(call, std::move(recv_done));
+    }
+    return;
+  }
+  if (!s.ok()) {
+    batch->FailPendingCalls(s);
+    return;
+  }
+  if (batch->resp.item_size() == 0) {
+    batch->FailPendingCalls(
+        errors::Internal("BatchRecvTensor returned no tensors."));
+    return;
+  }
+  for (BatchRecvTensorResponse::Item& item : *batch->resp.mutable_item()) {
+    if (item.index() < 0 || item.index() >= batch->req_entries.size()) {
+      batch->FailPendingCalls(errors::Internal(
+          "BatchRecvTensor returned an invalid index ", item.index()));
+      return;
+    }
+    std::function<void()> recv_done;
+    RpcRecvTensorCall* call =
+        batch->TakeCall(batch->req_entries[item.index()], &recv_done);
+    if (call == nullptr) continue;
+    call->opts_.ClearCancelCallback();
+    Status item_status(static_cast<absl::StatusCode>(item.status_code()),
+                       item.status_error_message());
+    if (item_status.ok()) {
+      call->resp_.InitAlloc(call->dst_device_, call->alloc_attrs_);
+      item_status = call->resp_.InitFrom(item.mutable_response());
+    }
+    if (!item_status.ok()) {
+      mutex_lock l(call->mu_);
+      call->status_.Update(item_status);
+    }
+    recv_done();
+  }
+  // The worker is still waiting for the other tensors.
+  SendBatch(batch);
+}
+
+void RpcRemoteRendezvous::AbortBatchedCall(
+    const std::shared_ptr<RecvTensorBatch>& batch, int index) {
+  std::function<void()> recv_done;
+  if (batch->TakeCall(index, &recv_done) == nullptr) return;
+  // This runs in `call->StartAbort()`, which must return before the call can
+  // be deregistered.
+  env_->env->SchedClosure(std::move(recv_done));
+}
+
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+    : BaseRendezvousMgr(env), batch_window_micros_(ReadBatchWindowMicros()) {}
 
 tsl::core::RefCountPtr<BaseRemoteRendezvous> RpcRendezvousMgr::Create(
     int64_t step_id, const WorkerEnv* worker_env) {
   return tsl::core::RefCountPtr<BaseRemoteRendezvous>(
-      new RpcRemoteRendezvous(worker_env, step_id));
+      new RpcRemoteRendezvous(worker_env, step_id, batch_window_micros_));
 }
 
 }  // end namespace tensorflow
@@ -42,6 +42,11 @@ class DeviceMgr;
 //
 // Tensors sent and recved through rendezvous managed by this
 // RendezvousMgr must have keys generated by Rendezvous::CreateKey.
+//
+// If the environment variable TF_RPC_RENDEZVOUS_BATCH_WINDOW_MICROS is
+// positive, the tensors that a step receives from the same worker within that
+// many microseconds of each other are requested in one BatchRecvTensor RPC
+// instead of one RecvTensor RPC each.
 class RpcRendezvousMgr : public BaseRendezvousMgr {
  public:
   explicit RpcRendezvousMgr(const WorkerEnv* env);
@@ -51,6 +56,8 @@ class RpcRendezvousMgr : public BaseRendezvousMgr {
       int64_t step_id, const WorkerEnv* worker_env) override;
 
  private:
+  const int64_t batch_window_micros_;
+
   RpcRendezvousMgr(const RpcRendezvousMgr&) = delete;
   void operator=(const RpcRendezvousMgr&) = delete;
 };
@@ -15,8 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/control_flow.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -66,6 +74,43 @@ class DummyWorker : public TestWorkerInterface {
       done(OkStatus());
     });
   }
+
+  // Answers at most three of the requests, failing those for tensors named
+  // "missing". If `hang_batches` is set, only answers when cancelled.
+  void BatchRecvTensorAsync(CallOptions* opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done) override {
+    num_batch_rpcs.fetch_add(1);
+    if (hang_batches) {
+      opts->SetCancelCallback([this, done = std::move(done)]() {
+        if (batch_cancelled.HasBeenNotified()) return;
+        done(errors::Cancelled("BatchRecvTensor cancelled"));
+        batch_cancelled.Notify();
+      });
+      return;
+    }
+    SchedClosure([request, response, done = std::move(done)]() {
+      for (int i = 0; i < std::min(request->request_size(), 3); ++i) {
+        const Rendezvous::ParsedKey key =
+            MakeKey(request->request(i).rendezvous_key());
+        BatchRecvTensorResponse::Item* item = response->add_item();
+        item->set_index(i);
+        if (key.edge_name == "missing") {
+          item->set_status_code(error::NOT_FOUND);
+          item->set_status_error_message("missing");
+        } else {
+          V(string(key.edge_name))
+              .AsProtoTensorContent(item->mutable_response()->mutable_tensor());
+        }
+      }
+      done(OkStatus());
+    });
+  }
+
+  std::atomic<int> num_batch_rpcs{0};
+  bool hang_batches = false;
+  Notification batch_cancelled;
 };
 
 // Fake cache implementation for WorkerEnv.
@@ -74,6 +119,10 @@ class DummyWorkerCache : public WorkerCacheInterface {
   void ListWorkersInJob(const string& job_name,
                         std::vector<string>* workers) const override {}
   WorkerInterface* GetOrCreateWorker(const string& target) override {
+    return worker();
+  }
+ public:
+  DummyWorker* worker() {
     if (dummy_remote_worker_ == nullptr) {
       // Ownership transferred to WorkerFreeList
       dummy_remote_worker_ = new DummyWorker;
@@ -104,7 +153,9 @@ static Device* CreateDevice(const char* type, const char* name) {
    public:
     explicit FakeDevice(const DeviceAttributes& attr) : Device(nullptr, attr) {}
     Status Sync() override { return OkStatus(); }
-    Allocator* GetAllocator(AllocatorAttributes) override { return nullptr; }
+    Allocator* GetAllocator(AllocatorAttributes) override {
+      return cpu_allocator();
+    }
   };
   DeviceAttributes attr;
   attr.set_name(name);
@@ -342,4 +393,94 @@ TEST_F(RpcRendezvousMgrTest, RemoteRecvAsyncMany) {
   rmgr_.Cleanup(step_id);
 }
 
+// Creates an RpcRendezvousMgr that batches RecvTensor calls.
+std::unique_ptr<RpcRendezvousMgr> CreateBatchingRendezvousMgr(
+    const WorkerEnv* env) {
+  setenv("TF_RPC_RENDEZVOUS_BATCH_WINDOW_MICROS", "100000", 1);
+  auto rmgr = std::make_unique<RpcRendezvousMgr>(env);
+  unsetenv("TF_RPC_RENDEZVOUS_BATCH_WINDOW_MICROS");
+  return rmgr;
+}
+
+TEST_F(RpcRendezvousMgrTest, RemoteRecvBatched) {
+  std::unique_ptr<RpcRendezvousMgr> rmgr = CreateBatchingRendezvousMgr(&env);
+  const int64_t step_id = 123;
+  const std::vector<string> names = {"a", "b", "missing", "c", "d", "e", "f"};
+  {
+    tsl::core::RefCountPtr<RemoteRendezvous> rendez = rmgr->Find(step_id);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    Rendezvous::Args args;
+
+    mutex mu;
+    std::map<string, Status> statuses;
+    std::map<string, string> values;
+    BlockingCounter counter(names.size());
+    for (const string& name : names) {
+      const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+          "/job:worker/replica:1/task:2/cpu:0", 7890,
+          "/job:mnist/replica:1/task:2/cpu:1", name, FrameAndIter(0, 0)));
+      rendez->RecvAsync(
+          key, args,
+          [&mu, &statuses, &values, &counter, name](
+              const Status& s, const Rendezvous::Args&,
+              const Rendezvous::Args&, const Tensor& val, const bool) {
+            {
+              mutex_lock l(mu);
+              statuses[name] = s;
+              if (s.ok()) values[name] = V(val);
+            }
+            counter.DecrementCount();
+          });
+    }
+    counter.Wait();
+    for (const string& name : names) {
+      if (name == "missing") {
+        EXPECT_TRUE(errors::IsNotFound(statuses[name])) << statuses[name];
+      } else {
+        TF_EXPECT_OK(statuses[name]);
+        EXPECT_EQ(name, values[name]);
+      }
+    }
+  }
+  rmgr->Cleanup(step_id);
+  // The worker answers three requests per RPC, and the rest are sent again.
+  EXPECT_EQ(3, cache_->worker()->num_batch_rpcs);
+}
+
+TEST_F(RpcRendezvousMgrTest, RemoteRecvBatchedCancel) {
+  std::unique_ptr<RpcRendezvousMgr> rmgr = CreateBatchingRendezvousMgr(&env);
+  DummyWorker* worker = cache_->worker();
+  worker->hang_batches = true;
+  const int64_t step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:worker/replica:1/task:2/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "foo", FrameAndIter(0, 0)));
+  {
+    tsl::core::RefCountPtr<RemoteRendezvous> rendez = rmgr->Find(step_id);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    CancellationManager cm;
+    Rendezvous::Args args;
+    args.cancellation_manager = &cm;
+
+    Status status;
+    Notification n;
+    rendez->RecvAsync(key, args,
+                      [&status, &n](const Status& s, const Rendezvous::Args&,
+                                    const Rendezvous::Args&, const Tensor&,
+                                    const bool) {
+                        status = s;
+                        n.Notify();
+                      });
+    while (worker->num_batch_rpcs == 0) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    cm.StartCancel();
+    n.WaitForNotification();
+    EXPECT_TRUE(errors::IsCancelled(status)) << status;
+    // The RPC is cancelled once none of its calls are left.
+    worker->batch_cancelled.WaitForNotification();
+  }
+  rmgr->Cleanup(step_id);
+}
+
 }  // namespace tensorflow
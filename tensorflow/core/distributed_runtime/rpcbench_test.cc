@@ -255,4 +255,47 @@ BENCHMARK(BM_SingleDevice)
     ->ArgPair(4, 10000)
     ->ArgPair(1, 1000000);
 
+// Measures the bandwidth of RecvTensor between two workers over loopback.
+// Every step reads a variable of `state.range(0)` bytes on the second worker,
+// and slices it down to one element on the first.
+static void BM_RecvTensorBandwidth(::testing::benchmark::State& state) {
+  const int64_t num_bytes = state.range(0);
+  const Cluster* cluster = GetCluster();
+
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+  Scope root = Scope::NewRootScope();
+  Scope remote = root.WithDevice(cluster->devices[1].name());
+  const int64_t num_elements = num_bytes / sizeof(float);
+  Output var = Variable(remote.WithOpName("var"), {num_elements}, DT_FLOAT);
+  Assign(remote.WithOpName("init"), var, Fill(remote, {num_elements}, 1.0f));
+  Slice(root.WithOpName("y").WithDevice(cluster->devices[0].name()),
+        Identity(remote, var), {0}, {1});
+  GraphDef def;
+  TF_CHECK_OK(root.ToGraphDef(&def));
+  graph::SetDefaultDevice(cluster->devices[0].name(), &def);
+
+  std::unique_ptr<Session> session(NewSession(cluster->options));
+  TF_CHECK_OK(session->Create(def));
+  TF_CHECK_OK(session->Run({}, {}, {"init"}, nullptr));
+
+  std::vector<Tensor> outputs;
+  // Warm up the connection between the workers.
+  TF_CHECK_OK(session->Run({}, {"y:0"}, {}, &outputs));
+  for (auto s : state) {
+    outputs.clear();
+    TF_CHECK_OK(session->Run({}, {"y:0"}, {}, &outputs));
+    CHECK_EQ(size_t{1}, outputs.size());
+  }
+  state.SetBytesProcessed(state.iterations() * num_bytes);
+  state.SetLabel(strings::StrCat("tensor bytes/send: ", num_bytes));
+  TF_CHECK_OK(session->Close());
+}
+BENCHMARK(BM_RecvTensorBandwidth)
+    ->UseRealTime()
+    ->Arg(1 << 20)
+    ->Arg(16 << 20)
+    ->Arg(256 << 20)
+    ->Arg(1 << 30);
+
 }  // namespace tensorflow
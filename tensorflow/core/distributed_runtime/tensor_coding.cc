@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/platform/notification.h"
 
 namespace tensorflow {
 
@@ -30,6 +31,8 @@ void TensorResponse::Clear() {
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
+  staging_device_ = nullptr;
+  staging_allocator_ = nullptr;
   already_used_ = false;
   ClearTensor();
 }
@@ -50,6 +53,21 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
   allocator_ = device_->GetAllocator(alloc_attrs_);
 }
 
+void TensorResponse::InitAlloc(Device* d, const AllocatorAttributes& aa) {
+  InitAlloc(static_cast<DeviceBase*>(d), aa);
+  const DeviceBase::AcceleratorDeviceInfo* device_info =
+      d->tensorflow_accelerator_device_info();
+  if (on_host_ || device_info == nullptr ||
+      device_info->default_context == nullptr) {
+    return;
+  }
+  AllocatorAttributes staging_attrs;
+  staging_attrs.set_on_host(true);
+  staging_attrs.set_gpu_compatible(true);
+  staging_device_ = d;
+  staging_allocator_ = d->GetAllocator(staging_attrs);
+}
+
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   Status s;
   meta_.Swap(response);
@@ -81,6 +99,15 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response,
 
 Status TensorResponse::ParseFrom(Source* source) {
   if (!on_host_) {
+    if (staging_allocator_ != nullptr) {
+      tensor_ = Tensor();
+      meta_.Clear();
+      if (ParseFast(source, staging_allocator_) &&
+          DataTypeCanUseMemcpy(tensor_.dtype())) {
+        return CopyStagedTensorToDevice();
+      }
+      meta_.Clear();
+    }
     protobuf::io::CodedInputStream input(source->contents());
 
     // Pre-parse into local storage, then delegate to device.
@@ -101,7 +128,7 @@ Status TensorResponse::ParseFrom(Source* source) {
     ClearTensor();
   }
   already_used_ = true;
-  if (ParseFast(source)) return OkStatus();
+  if (ParseFast(source, allocator_)) return OkStatus();
   meta_.Clear();
   if (ParseSlow(source)) return OkStatus();
   return errors::InvalidArgument("Cannot parse tensor from response");
@@ -144,8 +171,10 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta,
+    Allocator* allocator) {
   bool seen_tensor_content = false;
+  int64_t num_strings = 0;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
     int tag = GetTagFieldNumber(p.first);
@@ -155,9 +184,13 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
+      // A compact string_val encoding is left to the slow path.
+      if (ok && num_strings > 0 && num_strings != tensor_.NumElements()) {
+        return false;
+      }
       return ok;
     }
     switch (tag) {
@@ -166,7 +199,10 @@ bool TensorResponse::ParseTensorSubmessage(
         if ((wt != WIRETYPE_VARINT) || !input->ReadVarint32(&v)) return false;
         if (seen_tensor_content) return false;
         tensor_meta->set_dtype(static_cast<DataType>(static_cast<int>(v)));
-        if (!DataTypeCanUseMemcpy(tensor_meta->dtype())) return false;
+        if (!DataTypeCanUseMemcpy(tensor_meta->dtype()) &&
+            tensor_meta->dtype() != DT_STRING) {
+          return false;
+        }
         break;
       }
       case TensorProto::kTensorShapeFieldNumber: {
@@ -188,14 +224,15 @@ bool TensorResponse::ParseTensorSubmessage(
         // deal with this in the fast path.
         if (seen_tensor_content) return false;
         if (wt != WIRETYPE_LENGTH_DELIMITED ||
-            !tensor_meta->has_tensor_shape()) {
+            !tensor_meta->has_tensor_shape() ||
+            !DataTypeCanUseMemcpy(tensor_meta->dtype())) {
           return false;
         }
         int num_bytes;
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
         // TODO(jeff,sanjay): Figure out a way to avoid this copy if
@@ -206,6 +243,28 @@ bool TensorResponse::ParseTensorSubmessage(
         tensor_ = std::move(t);
         break;
       }
+      case TensorProto::kStringValFieldNumber: {
+        // Decode each string straight into its element of the destination
+        // tensor, instead of into a TensorProto first.
+        if (wt != WIRETYPE_LENGTH_DELIMITED ||
+            tensor_meta->dtype() != DT_STRING ||
+            !tensor_meta->has_tensor_shape()) {
+          return false;
+        }
+        if (!seen_tensor_content) {
+          seen_tensor_content = true;
+          TensorShape shape(tensor_meta->tensor_shape());
+          Tensor t(allocator, DT_STRING, shape);
+          tensor_ = std::move(t);
+        }
+        if (num_strings >= tensor_.NumElements()) return false;
+        int num_bytes;
+        if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
+        tstring& value = tensor_.flat<tstring>()(num_strings++);
+        value.resize_uninitialized(num_bytes);
+        if (!input->ReadRaw(value.mdata(), num_bytes)) return false;
+        break;
+      }
       default: {
         // Some other tag our fast path code is not prepared to handle.
         // return false.
@@ -215,7 +274,7 @@ bool TensorResponse::ParseTensorSubmessage(
   }
 }
 
-bool TensorResponse::ParseFast(Source* source) {
+bool TensorResponse::ParseFast(Source* source, Allocator* allocator) {
   protobuf::io::CodedInputStream input(source->contents());
   while (true) {
     auto p = input.ReadTagWithCutoff(127);
@@ -233,7 +292,8 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(&input, meta_.mutable_tensor(),
+                                   allocator)) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -275,6 +335,27 @@ bool TensorResponse::ParseFast(Source* source) {
   return false;
 }
 
+Status TensorResponse::CopyStagedTensorToDevice() {
+  Tensor staged = std::move(tensor_);
+  Tensor copy(allocator_, staged.dtype(), staged.shape());
+  if (!copy.IsInitialized()) {
+    return errors::ResourceExhausted("Failed to allocate tensor of shape ",
+                                     staged.shape().DebugString(), " on ",
+                                     device_->name());
+  }
+  Notification n;
+  Status status;
+  staging_device_->tensorflow_accelerator_device_info()
+      ->default_context->CopyCPUTensorToDevice(
+          &staged, staging_device_, &copy, [&n, &status](const Status& s) {
+            status = s;
+            n.Notify();
+          });
+  n.WaitForNotification();
+  if (status.ok()) tensor_ = std::move(copy);
+  return status;
+}
+
 bool TensorResponse::ParseSlow(Source* source) {
   if (!meta_.ParseFromZeroCopyStream(source->contents())) {
     return false;
@@ -25,6 +25,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class Device;
 class DeviceBase;
 class TensorProto;
 
@@ -45,6 +46,11 @@ class TensorResponse {
   // Initialize memory allocation related members.
   void InitAlloc(DeviceBase* d, const AllocatorAttributes& aa);
 
+  // As above. If "d" is an accelerator whose memory is the destination,
+  // tensor contents are decoded straight into host memory that "d" can copy
+  // from, and then copied to "d", instead of going through a TensorProto.
+  void InitAlloc(Device* d, const AllocatorAttributes& aa);
+
   // Source provides a way for a particular RPC implementation to provide
   // received data to ParseFrom.
   class Source {
@@ -92,14 +98,18 @@ class TensorResponse {
 
  private:
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
-                             TensorProto* tensor_meta);
-  bool ParseFast(Source* source);
+                             TensorProto* tensor_meta, Allocator* allocator);
+  bool ParseFast(Source* source, Allocator* allocator);
   bool ParseSlow(Source* source);
+  Status CopyStagedTensorToDevice();
 
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
+  // Only set for accelerator destinations. See InitAlloc(Device*, ...).
+  Device* staging_device_ = nullptr;
+  Allocator* staging_allocator_ = nullptr;
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
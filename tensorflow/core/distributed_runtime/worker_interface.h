@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/call_options.h"
 #include "tensorflow/core/distributed_runtime/message_wrappers.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/types.h"
@@ -106,6 +107,17 @@ class WorkerInterface {
                                TensorResponse* response,
                                StatusCallback done) = 0;
 
+  // Receives the tensors of several RecvTensor requests at once. See
+  // `BatchRecvTensorResponse` for which requests the response covers.
+  // Workers that do not support this fail with `Unimplemented`, and callers
+  // should fall back to `RecvTensorAsync()`.
+  virtual void BatchRecvTensorAsync(CallOptions* opts,
+                                    const BatchRecvTensorRequest* request,
+                                    BatchRecvTensorResponse* response,
+                                    StatusCallback done) {
+    done(errors::Unimplemented("BatchRecvTensorAsync()"));
+  }
+
   virtual void LoggingAsync(const LoggingRequest* request,
                             LoggingResponse* response, StatusCallback done) = 0;
 
@@ -56,6 +56,21 @@ auto* graph_pending_queue_length_histogram = tsl::monitoring::Sampler<0>::New(
     // Power of 1.5 with bucket count 30 (> 191k)
     {tsl::monitoring::Buckets::Exponential(1, 1.5, 30)});
 
+auto* rendezvous_step_recv_rpcs = tsl::monitoring::Sampler<0>::New(
+    {"/tensorflow/core/rendezvous_step_recv_rpcs",
+     "The number of RPCs that a step issued to receive tensors from other "
+     "workers."},
+    // Power of 2 with bucket count 20 (> 500k)
+    {tsl::monitoring::Buckets::Exponential(1, 2, 20)});
+
+auto* rendezvous_recv_rpc_latency_usecs = tsl::monitoring::Sampler<1>::New(
+    {"/tensorflow/core/rendezvous_recv_rpc_latency_usecs",
+     "The latency of RPCs that received tensors from other workers in "
+     "microseconds.",
+     "method"},
+    // Power of 2 with bucket count 24 (> 1 minute)
+    {tsl::monitoring::Buckets::Exponential(10, 2, 24)});
+
 auto* graph_run_input_tensor_bytes = tsl::monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_input_tensor_bytes",
      "The size of input tensors in bytes."},
@@ -306,6 +321,21 @@ auto* tf_data_error = tsl::monitoring::Counter<2>::New(
     "The number of times an error of this type occurred with this status code.",
     "error_type", "status_code");
 
+auto* checkpoint_restore_bytes_read = tsl::monitoring::Counter<0>::New(
+    "/tensorflow/core/checkpoint/restore_bytes_read",
+    "The number of bytes read from checkpoint data files by RestoreV2.");
+
+auto* checkpoint_restore_read_requests = tsl::monitoring::Counter<0>::New(
+    "/tensorflow/core/checkpoint/restore_read_requests",
+    "The number of read requests issued against checkpoint data files by "
+    "RestoreV2, after coalescing neighbouring tensors.");
+
+auto* checkpoint_restore_shard_throughput = tsl::monitoring::Sampler<0>::New(
+    {"/tensorflow/core/checkpoint/restore_shard_throughput",
+     "Read throughput in MB/s achieved on each checkpoint data file restored "
+     "by RestoreV2."},
+    {tsl::monitoring::Buckets::Exponential(1, 2, 14)});
+
 auto* parse_dense_feature_counter = tsl::monitoring::Counter<0>::New(
     "/tensorflow/data/dense_feature",
     "The number of dense features parsed by ops for parsing tf.Example.");
@@ -372,6 +402,13 @@ auto* graph_optimization_cache_load_count = tsl::monitoring::Counter<1>::New(
     "source"  // graph optimization source
 );
 
+auto* grappler_cache_lookup_count = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler_cache_lookup_count",
+    "The number of lookups in the persistent cache of graphs optimized by "
+    "Grappler.",
+    "result"  // "hit", "miss" or "failure"
+);
+
 auto* xla_compilations = tsl::monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilations",
     "The number of XLA compilations used to collect "
@@ -674,6 +711,22 @@ void RecordTFDataError(const string& error_type, const string& status_code) {
   tf_data_error->GetCell(error_type, status_code)->IncrementBy(1);
 }
 
+void RecordCheckpointRestoreShardRead(int64_t num_bytes, int64_t num_reads,
+                                      uint64 duration_usecs) {
+  static auto* bytes_read_cell = checkpoint_restore_bytes_read->GetCell();
+  static auto* read_requests_cell =
+      checkpoint_restore_read_requests->GetCell();
+  static auto* shard_throughput_cell =
+      checkpoint_restore_shard_throughput->GetCell();
+  bytes_read_cell->IncrementBy(num_bytes);
+  read_requests_cell->IncrementBy(num_reads);
+  if (duration_usecs > 0) {
+    // Bytes per microsecond is MB/s.
+    shard_throughput_cell->Add(static_cast<double>(num_bytes) /
+                               duration_usecs);
+  }
+}
+
 void RecordParseDenseFeature(int64 num_features) {
   static auto* parse_dense_feature_counter_cell =
       parse_dense_feature_counter->GetCell();
@@ -733,6 +786,17 @@ void UpdateGraphPendingQueueLength(uint64 len) {
   graph_pending_queue_length_cell->Add(len);
 }
 
+void RecordRendezvousStepRecvRpcs(int64_t num_rpcs) {
+  static auto* rendezvous_step_recv_rpcs_cell =
+      rendezvous_step_recv_rpcs->GetCell();
+  rendezvous_step_recv_rpcs_cell->Add(num_rpcs);
+}
+
+void RecordRendezvousRecvRpcLatency(const std::string& method,
+                                    uint64 latency_usecs) {
+  rendezvous_recv_rpc_latency_usecs->GetCell(method)->Add(latency_usecs);
+}
+
 void UpdateGraphBuildTime(const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
     static auto* build_graph_calls_cell = build_graph_calls->GetCell();
@@ -822,6 +886,14 @@ int64_t GetFunctionGraphOptimizationCacheLoadCount(
   return graph_optimization_cache_load_count->GetCell(mapped_source)->value();
 }
 
+void RecordGrapplerCacheLookup(const string& result) {
+  grappler_cache_lookup_count->GetCell(result)->IncrementBy(1);
+}
+
+int64_t GetGrapplerCacheLookupCount(const string& result) {
+  return grappler_cache_lookup_count->GetCell(result)->value();
+}
+
 void UpdateTpuVariableDistributionTime(const uint64 distribution_time_usecs) {
   if (distribution_time_usecs > 0) {
     tpu_variable_distribution_time_usecs->GetCell()->IncrementBy(
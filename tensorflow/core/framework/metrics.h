@@ -221,6 +221,11 @@ void RecordTFDataAutotuneStoppingCriteria(const string& name);
 // code.
 void RecordTFDataError(const string& error_type, const string& error_code);
 
+// Records the bytes and (coalesced) read requests that RestoreV2 issued against
+// one checkpoint data file, which took `duration_usecs` of wall time.
+void RecordCheckpointRestoreShardRead(int64_t num_bytes, int64_t num_reads,
+                                      uint64 duration_usecs);
+
 // Records parsing of dense tensor features.
 void RecordParseDenseFeature(int64_t num_features);
 
@@ -240,6 +245,15 @@ void RecordTPUXlaSpmdCoresPerReplica(int64_t cores_per_replica);
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 void UpdateGraphPendingQueueLength(uint64 len);
 
+// Records the number of RPCs that a step issued to receive tensors from other
+// workers, i.e. RecvTensor and BatchRecvTensor calls.
+void RecordRendezvousStepRecvRpcs(int64_t num_rpcs);
+
+// Records the latency of an RPC that received tensors from another worker.
+// `method` is "RecvTensor" or "BatchRecvTensor".
+void RecordRendezvousRecvRpcLatency(const std::string& method,
+                                    uint64 latency_usecs);
+
 // Records that one output of an op of type `op_name` was unused.
 void RecordUnusedOutput(const string& op_name);
 
@@ -307,6 +321,13 @@ void IncrementFunctionGraphOptimizationCacheLoadCount(
 int64_t GetFunctionGraphOptimizationCacheLoadCount(
     GraphOptimizationSource source);
 
+// Records a lookup in the persistent cache of graphs optimized by Grappler.
+// `result` is "hit", "miss" or "failure" (the cached graph was unreadable).
+void RecordGrapplerCacheLookup(const string& result);
+
+// Gets the number of Grappler cache lookups with the given `result`.
+int64_t GetGrapplerCacheLookupCount(const string& result);
+
 // Records the activity of the first phase of the mlir bridge using the
 // tf_metadata.tf_mlir_bridge_first_phase_count metric.
 // device_type: tpu, cpu, gpu, etc.
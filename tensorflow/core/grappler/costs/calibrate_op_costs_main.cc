@@ -0,0 +1,179 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the CPU kernels of ops that the analytical cost model of
+// OpLevelCostEstimator estimates poorly over sweeps of input shapes, and
+// writes the fitted OpCostModelList to --output. Point the
+// TF_GRAPPLER_OP_COST_MODELS environment variable at the file to use it.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/clusters/single_machine.h"
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+NodeDef MakeNode(const std::string& op, const std::string& name) {
+  NodeDef node;
+  node.set_op(op);
+  node.set_name(name);
+  return node;
+}
+
+// GatherV2 of `num_indices` rows of width `row_size` out of `num_rows`.
+void AddGatherCases(random::SimplePhilox* rnd,
+                    std::vector<OpCostCalibrationCase>* cases) {
+  for (int64_t num_rows : {1 << 10, 1 << 17}) {
+    for (int64_t row_size : {16, 128}) {
+      for (int64_t num_indices : {1 << 8, 1 << 12, 1 << 16}) {
+        OpCostCalibrationCase c;
+        c.node = MakeNode("GatherV2", absl::StrCat("gather_", num_rows, "_",
+                                                   row_size, "_", num_indices));
+        (*c.node.mutable_attr())["Tparams"].set_type(DT_FLOAT);
+        (*c.node.mutable_attr())["Tindices"].set_type(DT_INT32);
+        (*c.node.mutable_attr())["Taxis"].set_type(DT_INT32);
+        (*c.node.mutable_attr())["batch_dims"].set_i(0);
+        Tensor params(DT_FLOAT, TensorShape({num_rows, row_size}));
+        params.flat<float>().setRandom();
+        Tensor indices(DT_INT32, TensorShape({num_indices}));
+        for (int64_t i = 0; i < num_indices; ++i) {
+          indices.flat<int32>()(i) = rnd->Uniform(num_rows);
+        }
+        c.inputs = {params, indices, Tensor(0)};
+        cases->push_back(std::move(c));
+      }
+    }
+  }
+}
+
+// StringToHashBucketFast of `num_strings` strings of `length` bytes.
+void AddStringHashCases(random::SimplePhilox* rnd,
+                        std::vector<OpCostCalibrationCase>* cases) {
+  for (int64_t num_strings : {1 << 10, 1 << 14, 1 << 18}) {
+    for (int length : {8, 64}) {
+      OpCostCalibrationCase c;
+      c.node = MakeNode("StringToHashBucketFast",
+                        absl::StrCat("string_hash_", num_strings, "_", length));
+      (*c.node.mutable_attr())["num_buckets"].set_i(1000);
+      Tensor strings(DT_STRING, TensorShape({num_strings}));
+      for (int64_t i = 0; i < num_strings; ++i) {
+        std::string s(length, ' ');
+        for (char& ch : s) ch = 'a' + rnd->Uniform(26);
+        strings.flat<tstring>()(i) = s;
+      }
+      c.inputs = {strings};
+      cases->push_back(std::move(c));
+    }
+  }
+}
+
+// SparseTensorDenseMatMul of a [m, k] matrix with `nnz` non zeros by a dense
+// [k, n] matrix.
+void AddSparseMatMulCases(random::SimplePhilox* rnd,
+                          std::vector<OpCostCalibrationCase>* cases) {
+  constexpr int64_t kM = 1 << 10;
+  constexpr int64_t kK = 1 << 12;
+  for (int64_t nnz : {1 << 10, 1 << 14}) {
+    for (int64_t n : {8, 64, 256}) {
+      OpCostCalibrationCase c;
+      c.node = MakeNode("SparseTensorDenseMatMul",
+                        absl::StrCat("sparse_matmul_", nnz, "_", n));
+      (*c.node.mutable_attr())["T"].set_type(DT_FLOAT);
+      (*c.node.mutable_attr())["Tindices"].set_type(DT_INT64);
+      (*c.node.mutable_attr())["adjoint_a"].set_b(false);
+      (*c.node.mutable_attr())["adjoint_b"].set_b(false);
+      Tensor indices(DT_INT64, TensorShape({nnz, 2}));
+      for (int64_t i = 0; i < nnz; ++i) {
+        indices.matrix<int64_t>()(i, 0) = rnd->Uniform(kM);
+        indices.matrix<int64_t>()(i, 1) = rnd->Uniform(kK);
+      }
+      Tensor values(DT_FLOAT, TensorShape({nnz}));
+      values.flat<float>().setRandom();
+      Tensor shape(DT_INT64, TensorShape({2}));
+      shape.flat<int64_t>()(0) = kM;
+      shape.flat<int64_t>()(1) = kK;
+      Tensor dense(DT_FLOAT, TensorShape({kK, n}));
+      dense.flat<float>().setRandom();
+      c.inputs = {indices, values, shape, dense};
+      cases->push_back(std::move(c));
+    }
+  }
+}
+
+int Run(const std::string& output, int measurement_steps) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<OpCostCalibrationCase> cases;
+  AddGatherCases(&rnd, &cases);
+  AddStringHashCases(&rnd, &cases);
+  AddSparseMatMulCases(&rnd, &cases);
+
+  SingleMachine cluster(/*timeout_s=*/3600, /*num_cpu_cores=*/-1,
+                        /*num_gpus=*/0);
+  // Measure the kernels as they are, without any rewrite of the graphs.
+  cluster.DisableOptimizer(true);
+  Status status = cluster.Provision();
+  OpCostModelList models;
+  if (status.ok()) {
+    status = CalibrateOpCosts(&cluster, "CPU", cases, measurement_steps,
+                              &models);
+  }
+  if (status.ok()) {
+    status = WriteTextProto(Env::Default(), output, models);
+  }
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  for (const OpCostModel& model : models.model()) {
+    std::cout << model.ShortDebugString() << "\n";
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  std::string output;
+  int measurement_steps = 20;
+  std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag("output", &output,
+                       "File to write the OpCostModelList text proto to."),
+      tensorflow::Flag("measurement_steps", &measurement_steps,
+                       "Number of runs of each op and shape to measure."),
+  };
+  bool parse_result = tensorflow::Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result || output.empty()) {
+    std::cerr << tensorflow::Flags::Usage(argv[0], flag_list);
+    return -1;
+  }
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  return tensorflow::grappler::Run(output, measurement_steps);
+}
@@ -0,0 +1,349 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/measuring_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Exposes the counts that OpLevelCostEstimator derives from an op.
+class FeatureEstimator : public OpLevelCostEstimator {
+ public:
+  using OpLevelCostEstimator::PredictNodeCosts;
+};
+
+// The features of a sample: a constant for the intercept, the compute ops,
+// the bytes read and the bytes written.
+constexpr int kNumFeatures = 4;
+using Features = std::array<double, kNumFeatures>;
+
+Features ToFeatures(const OpCostSample& sample) {
+  return {1.0, sample.num_compute_ops, sample.num_read_bytes,
+          sample.num_write_bytes};
+}
+
+double Predict(const Features& coefficients, const Features& features) {
+  double prediction = 0;
+  for (int i = 0; i < kNumFeatures; ++i) {
+    prediction += coefficients[i] * features[i];
+  }
+  return prediction;
+}
+
+// Returns the coefficients of the `active` features that minimize the sum of
+// squared relative errors on `samples`, and zero for the others. The features
+// are scaled to [0, 1] and slightly regularized, because they span many orders
+// of magnitude and are often collinear (e.g. bytes read and written by a
+// copy).
+Features SolveLeastSquares(const std::vector<OpCostSample>& samples,
+                           const std::array<bool, kNumFeatures>& active) {
+  Features scale = {};
+  for (const OpCostSample& sample : samples) {
+    const Features features = ToFeatures(sample);
+    for (int i = 0; i < kNumFeatures; ++i) {
+      scale[i] = std::max(scale[i], std::abs(features[i] / sample.measured_ns));
+    }
+  }
+  std::vector<int> columns;
+  for (int i = 0; i < kNumFeatures; ++i) {
+    if (active[i] && scale[i] > 0) columns.push_back(i);
+  }
+  const int n = columns.size();
+  Features coefficients = {};
+  if (n == 0) return coefficients;
+
+  // Normal equations of the weighted problem: row i of the design matrix is
+  // features / measured_ns, and the target is 1.
+  constexpr double kRegularization = 1e-9;
+  std::vector<std::vector<double>> a(n, std::vector<double>(n + 1, 0.0));
+  for (const OpCostSample& sample : samples) {
+    const Features features = ToFeatures(sample);
+    for (int p = 0; p < n; ++p) {
+      const double x_p =
+          features[columns[p]] / sample.measured_ns / scale[columns[p]];
+      for (int q = 0; q < n; ++q) {
+        a[p][q] += x_p * features[columns[q]] / sample.measured_ns /
+                   scale[columns[q]];
+      }
+      a[p][n] += x_p;
+    }
+  }
+  for (int p = 0; p < n; ++p) a[p][p] += kRegularization * samples.size();
+
+  // Gaussian elimination with partial pivoting.
+  for (int p = 0; p < n; ++p) {
+    int pivot = p;
+    for (int r = p + 1; r < n; ++r) {
+      if (std::abs(a[r][p]) > std::abs(a[pivot][p])) pivot = r;
+    }
+    std::swap(a[p], a[pivot]);
+    for (int r = p + 1; r < n; ++r) {
+      const double factor = a[r][p] / a[p][p];
+      for (int c = p; c <= n; ++c) a[r][c] -= factor * a[p][c];
+    }
+  }
+  std::vector<double> solution(n);
+  for (int p = n - 1; p >= 0; --p) {
+    double value = a[p][n];
+    for (int c = p + 1; c < n; ++c) value -= a[p][c] * solution[c];
+    solution[p] = value / a[p][p];
+  }
+  for (int p = 0; p < n; ++p) {
+    coefficients[columns[p]] = solution[p] / scale[columns[p]];
+  }
+  return coefficients;
+}
+
+// Returns a graph that runs the op of `calibration_case` on its inputs, placed
+// on `device`. If `baseline` is true, the op is replaced by an Identity of its
+// first input. If `feed_inputs` is true, the inputs are placeholders fed by
+// `item.feed`, so that constant folding can't replace the op by its output
+// before it is measured. Otherwise they are constants, whose values are
+// visible to shape inference.
+GrapplerItem MakeCalibrationItem(const OpCostCalibrationCase& calibration_case,
+                                 const std::string& device, bool baseline,
+                                 bool feed_inputs) {
+  GrapplerItem item;
+  const NodeDef& op_node = calibration_case.node;
+  item.id = absl::StrCat(op_node.name(), baseline ? "_baseline" : "");
+  std::vector<std::string> inputs;
+  for (int i = 0; i < calibration_case.inputs.size(); ++i) {
+    const Tensor& input = calibration_case.inputs[i];
+    NodeDef* node = item.graph.add_node();
+    node->set_name(absl::StrCat(op_node.name(), "/input_", i));
+    node->set_device(device);
+    (*node->mutable_attr())["dtype"].set_type(input.dtype());
+    if (feed_inputs) {
+      node->set_op("Placeholder");
+      input.shape().AsProto((*node->mutable_attr())["shape"].mutable_shape());
+      item.feed.emplace_back(node->name(), input);
+    } else {
+      node->set_op("Const");
+      input.AsProtoTensorContent(
+          (*node->mutable_attr())["value"].mutable_tensor());
+    }
+    inputs.push_back(node->name());
+  }
+
+  NodeDef* node = item.graph.add_node();
+  if (baseline) {
+    node->set_name(absl::StrCat(op_node.name(), "/baseline"));
+    if (inputs.empty()) {
+      // Nothing to forward: fetch a scalar instead.
+      node->set_op("Const");
+      (*node->mutable_attr())["dtype"].set_type(DT_FLOAT);
+      Tensor(0.0f).AsProtoTensorContent(
+          (*node->mutable_attr())["value"].mutable_tensor());
+    } else {
+      node->set_op("Identity");
+      node->add_input(inputs[0]);
+      (*node->mutable_attr())["T"].set_type(calibration_case.inputs[0].dtype());
+    }
+  } else {
+    *node = op_node;
+    node->clear_input();
+    for (const std::string& input : inputs) node->add_input(input);
+  }
+  node->set_device(device);
+  item.fetch.push_back(node->name());
+  return item;
+}
+
+}  // namespace
+
+Status ComputeOpCostFeatures(const OpContext& op_context,
+                             OpCostSample* sample) {
+  FeatureEstimator estimator;
+  NodeCosts node_costs;
+  TF_RETURN_IF_ERROR(estimator.PredictNodeCosts(op_context, &node_costs));
+  if (node_costs.has_costs || node_costs.minimum_cost_op) {
+    // OpLevelCostEstimator doesn't apply cost models to these ops.
+    return errors::FailedPrecondition(
+        "Op ", op_context.op_info.op(),
+        " has a fixed cost estimate, it can't be calibrated.");
+  }
+  sample->num_compute_ops = node_costs.num_compute_ops;
+  sample->num_read_bytes = node_costs.num_total_read_bytes();
+  sample->num_write_bytes = node_costs.num_total_write_bytes();
+  return OkStatus();
+}
+
+OpCostModel FitOpCostModel(const std::string& op,
+                           const std::string& device_type,
+                           const std::vector<OpCostSample>& samples) {
+  std::vector<OpCostSample> valid_samples;
+  for (const OpCostSample& sample : samples) {
+    if (sample.measured_ns > 0) valid_samples.push_back(sample);
+  }
+
+  // Fit the features that have a non-negative coefficient, dropping the most
+  // negative one until all of them are: an op never gets faster with more
+  // work.
+  std::array<bool, kNumFeatures> active;
+  active.fill(true);
+  Features coefficients = {};
+  for (int round = 0; round < kNumFeatures; ++round) {
+    coefficients = SolveLeastSquares(valid_samples, active);
+    int most_negative = -1;
+    for (int i = 0; i < kNumFeatures; ++i) {
+      if (!active[i] || coefficients[i] >= 0) continue;
+      if (most_negative < 0 || coefficients[i] < coefficients[most_negative]) {
+        most_negative = i;
+      }
+    }
+    if (most_negative < 0) break;
+    active[most_negative] = false;
+    coefficients[most_negative] = 0;
+  }
+
+  double squared_error = 0;
+  for (const OpCostSample& sample : valid_samples) {
+    const double error =
+        (Predict(coefficients, ToFeatures(sample)) - sample.measured_ns) /
+        sample.measured_ns;
+    squared_error += error * error;
+  }
+
+  OpCostModel model;
+  model.set_op(op);
+  model.set_device_type(device_type);
+  model.set_intercept_ns(coefficients[0]);
+  model.set_ns_per_compute_op(coefficients[1]);
+  model.set_ns_per_read_byte(coefficients[2]);
+  model.set_ns_per_write_byte(coefficients[3]);
+  model.set_num_samples(valid_samples.size());
+  if (!valid_samples.empty()) {
+    model.set_relative_rmse(std::sqrt(squared_error / valid_samples.size()));
+  }
+  return model;
+}
+
+Status MeasureOpCost(Cluster* cluster, const std::string& device_type,
+                     const OpCostCalibrationCase& calibration_case,
+                     int measurement_steps, OpCostSample* sample) {
+  const DeviceProperties* device_properties = nullptr;
+  std::string device;
+  for (const string& name : cluster->GetDeviceNames()) {
+    const DeviceProperties& properties = cluster->GetDevices().at(name);
+    if (properties.type() == device_type) {
+      device = name;
+      device_properties = &properties;
+      break;
+    }
+  }
+  if (device_properties == nullptr) {
+    return errors::NotFound("The cluster has no ", device_type, " device.");
+  }
+
+  // Derive the features the same way as the VirtualScheduler does, from the
+  // statically inferred properties of the inputs and outputs.
+  const GrapplerItem const_item =
+      MakeCalibrationItem(calibration_case, device, /*baseline=*/false,
+                          /*feed_inputs=*/false);
+  GraphProperties properties(const_item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_input_tensor_values=*/true,
+      /*include_output_tensor_values=*/false));
+  const std::string& name = const_item.fetch[0];
+  OpContext op_context;
+  op_context.name = name;
+  op_context.device_name = device;
+  op_context.op_info.set_op(calibration_case.node.op());
+  *op_context.op_info.mutable_attr() = calibration_case.node.attr();
+  for (const auto& input : properties.GetInputProperties(name)) {
+    *op_context.op_info.add_inputs() = input;
+  }
+  for (const auto& output : properties.GetOutputProperties(name)) {
+    *op_context.op_info.add_outputs() = output;
+  }
+  *op_context.op_info.mutable_device() = *device_properties;
+  TF_RETURN_IF_ERROR(ComputeOpCostFeatures(op_context, sample));
+
+  // Time the op on fed inputs.
+  const GrapplerItem item =
+      MakeCalibrationItem(calibration_case, device, /*baseline=*/false,
+                          /*feed_inputs=*/true);
+  const GrapplerItem baseline_item =
+      MakeCalibrationItem(calibration_case, device, /*baseline=*/true,
+                          /*feed_inputs=*/true);
+  Costs costs;
+  MeasuringCostEstimator estimator(cluster, measurement_steps,
+                                   /*measurement_threads=*/0);
+  TF_RETURN_IF_ERROR(estimator.Initialize(item));
+  TF_RETURN_IF_ERROR(estimator.PredictCosts(item.graph, nullptr, &costs));
+  Costs baseline_costs;
+  TF_RETURN_IF_ERROR(estimator.Initialize(baseline_item));
+  TF_RETURN_IF_ERROR(
+      estimator.PredictCosts(baseline_item.graph, nullptr, &baseline_costs));
+
+  sample->measured_ns = std::max<double>(
+      costs.execution_time.count() - baseline_costs.execution_time.count(), 1);
+  VLOG(1) << "Measured " << calibration_case.node.op() << ": "
+          << sample->measured_ns << " ns, " << sample->num_compute_ops
+          << " ops, " << sample->num_read_bytes << " bytes read, "
+          << sample->num_write_bytes << " bytes written";
+  return OkStatus();
+}
+
+Status CalibrateOpCosts(Cluster* cluster, const std::string& device_type,
+                        const std::vector<OpCostCalibrationCase>& cases,
+                        int measurement_steps, OpCostModelList* models) {
+  std::map<std::string, std::vector<OpCostSample>> samples;
+  for (const OpCostCalibrationCase& calibration_case : cases) {
+    OpCostSample sample;
+    Status status = MeasureOpCost(cluster, device_type, calibration_case,
+                                  measurement_steps, &sample);
+    if (errors::IsFailedPrecondition(status)) {
+      LOG(WARNING) << status;
+      continue;
+    }
+    TF_RETURN_IF_ERROR(status);
+    samples[calibration_case.node.op()].push_back(sample);
+  }
+
+  models->Clear();
+  for (const auto& op_samples : samples) {
+    *models->add_model() =
+        FitOpCostModel(op_samples.first, device_type, op_samples.second);
+    VLOG(1) << "Fitted cost model: " << models->model().rbegin()->DebugString();
+  }
+  return OkStatus();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
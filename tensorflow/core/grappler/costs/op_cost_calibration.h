@@ -0,0 +1,90 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+class Cluster;
+
+// Offline calibration of the op cost models of OpLevelCostEstimator.
+//
+// The roofline formulas of OpLevelCostEstimator are far off for ops whose
+// time is dominated by something else than arithmetic or streaming memory
+// accesses, such as gathers, string ops and sparse ops. The calibration runs
+// an op on sweeps of input shapes, measures its execution time, and fits an
+// `OpCostModel` to the measurements. The features of the model are the
+// compute ops and bytes that OpLevelCostEstimator counts for the op, so the
+// model corrects the analytical estimate without changing how it is derived
+// from the shapes.
+
+// One point of a sweep: an op and the inputs to run it on. The inputs of
+// `node` are set by the calibration.
+struct OpCostCalibrationCase {
+  NodeDef node;
+  std::vector<Tensor> inputs;
+};
+
+// The features of one run of an op, and its measured execution time.
+struct OpCostSample {
+  double num_compute_ops = 0;
+  double num_read_bytes = 0;
+  double num_write_bytes = 0;
+  double measured_ns = 0;
+};
+
+// Returns the features that OpLevelCostEstimator derives from `op_context`.
+// `sample->measured_ns` is left unchanged.
+Status ComputeOpCostFeatures(const OpContext& op_context,
+                             OpCostSample* sample);
+
+// Fits the model of `op` on `device_type` to `samples`. The coefficients are
+// non-negative and minimize the squared relative error of the predictions,
+// so that fast and slow runs count the same.
+OpCostModel FitOpCostModel(const std::string& op,
+                           const std::string& device_type,
+                           const std::vector<OpCostSample>& samples);
+
+// Runs `calibration_case` on the first device of `cluster` of type
+// `device_type`, and returns its features and its execution time measured by
+// a MeasuringCostEstimator over `measurement_steps` steps. The inputs are fed
+// to the op, so that it is measured even if the optimizers of `cluster` are
+// enabled. The time of a graph that only forwards the inputs is subtracted,
+// to leave out the overhead of running a step.
+Status MeasureOpCost(Cluster* cluster, const std::string& device_type,
+                     const OpCostCalibrationCase& calibration_case,
+                     int measurement_steps, OpCostSample* sample);
+
+// Measures every case on `cluster` and fits one model per op. `device_type`
+// is the type of the devices of `cluster` the ops run on.
+Status CalibrateOpCosts(Cluster* cluster, const std::string& device_type,
+                        const std::vector<OpCostCalibrationCase>& cases,
+                        int measurement_steps, OpCostModelList* models);
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_OP_COST_CALIBRATION_H_
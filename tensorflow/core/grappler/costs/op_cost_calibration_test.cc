@@ -0,0 +1,128 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_cost_calibration.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/clusters/single_machine.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+OpCostSample MakeSample(double num_compute_ops, double num_read_bytes,
+                        double num_write_bytes, double measured_ns) {
+  OpCostSample sample;
+  sample.num_compute_ops = num_compute_ops;
+  sample.num_read_bytes = num_read_bytes;
+  sample.num_write_bytes = num_write_bytes;
+  sample.measured_ns = measured_ns;
+  return sample;
+}
+
+TEST(OpCostCalibrationTest, FitRecoversLinearModel) {
+  std::vector<OpCostSample> samples;
+  for (double ops : {1e3, 1e5}) {
+    for (double read : {4e3, 4e6}) {
+      for (double write : {1e3, 2e5, 1e6}) {
+        samples.push_back(MakeSample(
+            ops, read, write, 500 + 0.25 * ops + 0.5 * read + 0.125 * write));
+      }
+    }
+  }
+  const OpCostModel model = FitOpCostModel("GatherV2", "CPU", samples);
+  EXPECT_EQ("GatherV2", model.op());
+  EXPECT_EQ("CPU", model.device_type());
+  EXPECT_EQ(samples.size(), model.num_samples());
+  EXPECT_NEAR(500, model.intercept_ns(), 1e-3);
+  EXPECT_NEAR(0.25, model.ns_per_compute_op(), 1e-6);
+  EXPECT_NEAR(0.5, model.ns_per_read_byte(), 1e-6);
+  EXPECT_NEAR(0.125, model.ns_per_write_byte(), 1e-6);
+  EXPECT_NEAR(0, model.relative_rmse(), 1e-6);
+}
+
+TEST(OpCostCalibrationTest, FitKeepsCoefficientsNonNegative) {
+  // The time decreases with the bytes written, which would need a negative
+  // coefficient.
+  std::vector<OpCostSample> samples = {
+      MakeSample(1e3, 1e3, 1e5, 1000), MakeSample(1e4, 1e3, 1e4, 2000),
+      MakeSample(1e5, 1e3, 1e3, 4000), MakeSample(1e6, 1e3, 1e2, 8000)};
+  const OpCostModel model = FitOpCostModel("StringJoin", "CPU", samples);
+  EXPECT_GE(model.intercept_ns(), 0);
+  EXPECT_GE(model.ns_per_compute_op(), 0);
+  EXPECT_GE(model.ns_per_read_byte(), 0);
+  EXPECT_EQ(0, model.ns_per_write_byte());
+  EXPECT_GT(model.relative_rmse(), 0);
+}
+
+TEST(OpCostCalibrationTest, FitIgnoresFailedMeasurements) {
+  std::vector<OpCostSample> samples = {MakeSample(1e3, 1e3, 1e3, 0),
+                                       MakeSample(1e3, 1e3, 1e3, -1)};
+  const OpCostModel model = FitOpCostModel("Unique", "CPU", samples);
+  EXPECT_EQ(0, model.num_samples());
+}
+
+// GatherV2 of `num_indices` rows of 64 floats out of 2^16 rows.
+OpCostCalibrationCase MakeGatherCase(int64_t num_indices) {
+  constexpr int64_t kNumRows = 1 << 16;
+  OpCostCalibrationCase c;
+  c.node.set_op("GatherV2");
+  c.node.set_name(absl::StrCat("gather_", num_indices));
+  (*c.node.mutable_attr())["Tparams"].set_type(DT_FLOAT);
+  (*c.node.mutable_attr())["Tindices"].set_type(DT_INT32);
+  (*c.node.mutable_attr())["Taxis"].set_type(DT_INT32);
+  (*c.node.mutable_attr())["batch_dims"].set_i(0);
+  Tensor params(DT_FLOAT, TensorShape({kNumRows, 64}));
+  params.flat<float>().setConstant(1.0f);
+  Tensor indices(DT_INT32, TensorShape({num_indices}));
+  for (int64_t i = 0; i < num_indices; ++i) {
+    indices.flat<int32>()(i) = (i * 7919) % kNumRows;
+  }
+  c.inputs = {params, indices, Tensor(0)};
+  return c;
+}
+
+TEST(OpCostCalibrationTest, MeasuredTimeGrowsWithInputSize) {
+  // The optimizers of the cluster are left enabled: the op must be run rather
+  // than folded into a constant.
+  SingleMachine cluster(/*timeout_s=*/5 * 60, /*num_cpu_cores=*/3,
+                        /*num_gpus=*/0);
+  TF_ASSERT_OK(cluster.Provision());
+
+  OpCostSample small;
+  TF_ASSERT_OK(MeasureOpCost(&cluster, "CPU", MakeGatherCase(16),
+                             /*measurement_steps=*/10, &small));
+  OpCostSample large;
+  TF_ASSERT_OK(MeasureOpCost(&cluster, "CPU", MakeGatherCase(1 << 16),
+                             /*measurement_steps=*/10, &large));
+  TF_ASSERT_OK(cluster.Shutdown());
+
+  EXPECT_GT(large.num_write_bytes, small.num_write_bytes);
+  // Gathering 16MB takes far longer than the 1ns floor of a measurement.
+  EXPECT_GT(large.measured_ns, 1e4);
+  EXPECT_GT(large.measured_ns, small.measured_ns);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
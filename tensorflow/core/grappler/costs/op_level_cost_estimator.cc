@@ -45,9 +45,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/device_properties.pb.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/overflow.h"
 #include "tensorflow/core/util/padding.h"
 #include "tsl/platform/statusor.h"
@@ -339,6 +341,27 @@ bool IsEinsumCorrectlyFormed(const OpContext& einsum_context) {
   return true;
 }
 
+// Returns the cost models in the file named by the TF_GRAPPLER_OP_COST_MODELS
+// environment variable. The file is read once per process.
+const OpCostModelList& CostModelsFromEnv() {
+  static const OpCostModelList* cost_models = [] {
+    auto* cost_models = new OpCostModelList;
+    std::string filename;
+    absl::Status status =
+        ReadStringFromEnvVar("TF_GRAPPLER_OP_COST_MODELS", "", &filename);
+    if (status.ok() && !filename.empty()) {
+      status = ReadTextOrBinaryProto(Env::Default(), filename, cost_models);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to load the op cost models from " << filename
+                     << ": " << status;
+        cost_models->Clear();
+      }
+    }
+    return cost_models;
+  }();
+  return *cost_models;
+}
+
 }  // namespace
 
 // Return a minimum shape if the shape is unknown. If known, return the original
@@ -655,6 +678,39 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 
   // By default, use sum of memory_time and compute_time for execution_time.
   compute_memory_overlap_ = false;
+
+  SetCostModels(CostModelsFromEnv());
+}
+
+void OpLevelCostEstimator::SetCostModels(const OpCostModelList& cost_models) {
+  cost_models_.clear();
+  for (const OpCostModel& model : cost_models.model()) {
+    cost_models_[{model.op(), model.device_type()}] = model;
+  }
+}
+
+absl::Status OpLevelCostEstimator::LoadCostModels(
+    const std::string& filename) {
+  OpCostModelList cost_models;
+  TF_RETURN_IF_ERROR(
+      ReadTextOrBinaryProto(Env::Default(), filename, &cost_models));
+  SetCostModels(cost_models);
+  return absl::OkStatus();
+}
+
+std::optional<Costs::NanoSeconds> OpLevelCostEstimator::PredictCostModelTime(
+    const OpInfo& op_info, const NodeCosts& node_costs) const {
+  if (cost_models_.empty()) return std::nullopt;
+  auto it = cost_models_.find({op_info.op(), op_info.device().type()});
+  if (it == cost_models_.end()) return std::nullopt;
+  const OpCostModel& model = it->second;
+  const double time_ns =
+      model.intercept_ns() +
+      model.ns_per_compute_op() * node_costs.num_compute_ops +
+      model.ns_per_read_byte() * node_costs.num_total_read_bytes() +
+      model.ns_per_write_byte() * node_costs.num_total_write_bytes();
+  return Costs::NanoSeconds(
+      std::max<double>(std::ceil(time_ns), kMinComputeTime.count()));
 }
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
@@ -677,6 +733,13 @@ Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
       costs.intermediate_memory_time = 0;
       costs.intermediate_memory_read_time = 0;
       costs.intermediate_memory_write_time = 0;
+    } else if (std::optional<Costs::NanoSeconds> time =
+                   PredictCostModelTime(op_context.op_info, node_costs)) {
+      // The op has a model fitted to measured timings, which accounts for
+      // both its compute and memory time.
+      costs = Costs::ZeroCosts();
+      costs.compute_time = *time;
+      costs.execution_time = *time;
     } else {
       // Convert NodeCosts to Costs.
       costs = PredictOpCountBasedCost(
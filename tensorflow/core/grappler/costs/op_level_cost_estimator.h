@@ -20,7 +20,10 @@ limitations under the License.
 #include <functional>
 #include <map>
 #include <numeric>
+#include <optional>
 #include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -106,6 +109,16 @@ class OpLevelCostEstimator {
   // Returns basic device performance info.
   virtual DeviceInfo GetDeviceInfo(const DeviceProperties& device) const;
 
+  // Sets models of the execution time of ops fitted to measured kernel timings
+  // (see op_cost_calibration.h). Ops that have a model for the type of their
+  // device are estimated with it instead of the roofline formulas. The models
+  // in the file named by the TF_GRAPPLER_OP_COST_MODELS environment variable,
+  // if any, are loaded on construction.
+  void SetCostModels(const OpCostModelList& cost_models);
+
+  // Same as above, reading a text or binary OpCostModelList from `filename`.
+  absl::Status LoadCostModels(const std::string& filename);
+
  protected:
   // TODO(dyoon): Consider to remove PredictOpCountBasedCosts() with OpInfo.
   // Naive cost estimate based on the given operations count and total
@@ -125,6 +138,11 @@ class OpLevelCostEstimator {
   absl::Status PredictNodeCosts(const OpContext& op_context,
                                 NodeCosts* node_costs) const;
 
+  // Returns the execution time predicted by the cost model of the op, or
+  // nullopt if there is no model for it.
+  std::optional<Costs::NanoSeconds> PredictCostModelTime(
+      const OpInfo& op_info, const NodeCosts& node_costs) const;
+
   // Predict cost of an op for which no accurate estimator is defined.
   absl::Status PredictCostOfAnUnknownOp(const OpContext& op_context,
                                         NodeCosts* node_costs) const;
@@ -335,6 +353,8 @@ class OpLevelCostEstimator {
   // compute_time and memory_time, instead of sum of those two.
   bool compute_memory_overlap_;
   std::set<string> persistent_ops_;
+  // Cost models by op name and device type.
+  std::map<std::pair<string, string>, OpCostModel> cost_models_;
 
  private:
   friend class OpLevelCostEstimatorTest;
@@ -730,6 +730,44 @@ TEST_F(OpLevelCostEstimatorTest, TestGatherCostsWithoutOutput) {
   EXPECT_EQ(cost.persistent_memory, 0);
 }
 
+TEST_F(OpLevelCostEstimatorTest, TestGatherCostsWithCostModel) {
+  OpContext op_context;
+  SetCpuDevice(&op_context.op_info);
+  op_context.op_info.set_op("GatherV2");
+  DescribeArbitraryRankInput({10000000, 10}, DT_FLOAT, &op_context.op_info);
+  DescribeArbitraryRankInput({16}, DT_INT64, &op_context.op_info);
+  DescribeArbitraryRankOutput({16, 10}, DT_FLOAT, &op_context.op_info);
+
+  OpCostModelList cost_models;
+  OpCostModel* model = cost_models.add_model();
+  model->set_op("GatherV2");
+  model->set_device_type("CPU");
+  model->set_intercept_ns(1000);
+  // A model for another device is ignored.
+  OpCostModel* gpu_model = cost_models.add_model();
+  gpu_model->set_op("GatherV2");
+  gpu_model->set_device_type("GPU");
+  gpu_model->set_intercept_ns(7);
+  estimator_.SetCostModels(cost_models);
+
+  auto cost = estimator_.PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(0), cost.memory_time);
+  EXPECT_EQ(Costs::Duration(1000), cost.compute_time);
+  EXPECT_EQ(Costs::Duration(1000), cost.execution_time);
+  EXPECT_EQ(1, cost.num_ops_total);
+  EXPECT_FALSE(cost.inaccurate);
+
+  // Other ops keep their analytical estimate.
+  op_context.op_info.set_op("Gather");
+  cost = estimator_.PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(146), cost.execution_time);
+
+  estimator_.SetCostModels(OpCostModelList());
+  op_context.op_info.set_op("GatherV2");
+  cost = estimator_.PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(146), cost.execution_time);
+}
+
 TEST_F(OpLevelCostEstimatorTest, TestSliceCosts) {
   OpContext op_context;
   SetCpuDevice(&op_context.op_info);
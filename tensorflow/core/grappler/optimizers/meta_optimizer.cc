@@ -17,10 +17,14 @@ limitations under the License.
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -49,6 +53,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
@@ -62,8 +67,12 @@ limitations under the License.
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
 
@@ -80,6 +89,7 @@ namespace {
 
 constexpr int kDefaultNumberOfIterations = 2;
 constexpr int kDefaultMinGraphNodes = 4;
+constexpr int kDefaultNumFunctionOptimizationThreads = 4;
 constexpr char kGrapplerCategory[] = "Grappler";
 
 int64_t NumEdges(const GraphDef& graph) {
@@ -103,6 +113,24 @@ int NumIterations(const RewriterConfig& cfg) {
              : cfg.meta_optimizer_iterations();
 }
 
+// Returns the number of threads used to optimize the functions of the library
+// concurrently. It can be overridden with an environment variable, 1 optimizes
+// them one at a time on the calling thread. The optimized library is the same
+// for any number of threads.
+int NumFunctionOptimizationThreads() {
+  int64_t num_threads;
+  Status status = ReadInt64FromEnvVar(
+      "TF_GRAPPLER_NUM_FUNCTION_OPTIMIZATION_THREADS",
+      std::min(kDefaultNumFunctionOptimizationThreads,
+               port::MaxParallelism()),
+      &num_threads);
+  if (!status.ok()) {
+    LOG(WARNING) << status;
+    return 1;
+  }
+  return std::max<int64_t>(num_threads, 1);
+}
+
 // Check if optimizer is allowed to run only once.
 bool IsRunOnceOptimizer(const string& name) {
   return name == "layout" || name == "memory_optimizer" ||
@@ -883,7 +911,10 @@ Status MetaOptimizer::OptimizeGraph(
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock lock(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -1050,7 +1081,10 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       {kGrapplerCategory, "*"});
 
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
-  optimization_results_.clear();
+  {
+    mutex_lock lock(optimization_results_mu_);
+    optimization_results_.clear();
+  }
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -1159,12 +1193,79 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   // True if this is a TPU graph using the old bridge.
   bool is_tpu_graph = IsLegacyTPUBridgeGraphDef(*optimized_graph);
 
+  // Optimizes the body of `func` into `optimized_func_graph`. This only reads
+  // `flib`, so it can run concurrently for several functions as long as the
+  // library is not updated meanwhile.
+  const auto optimize_function =
+      [&](const FunctionDef& func, GrapplerFunctionItem* func_item,
+          GraphDef* optimized_func_graph) -> Status {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    const string& func_name = func.signature().name();
+
+    // Make a GrapplerItem from a FunctionDef.
+    TF_RETURN_IF_ERROR(
+        MakeGrapplerFunctionItem(func, flib, producer, func_item));
+
+    // If we need to compute the gradient of optimized function at runtime, we
+    // can't perform non-differentiable rewrites.
+    func_item->optimization_options().allow_non_differentiable_rewrites =
+        !differentiable_functions.contains(func_name);
+
+    // Device set available to the function is defined only by the runtime,
+    // when we instantiate and execute the function. We can't use all devices
+    // available to the main graph, because after partitioning the function
+    // call node might execute on a remote worker.
+    if (!func_item->devices().empty()) {
+      return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    }
+
+    // We are not allowed to prune certain types of ops from the graph
+    // instantiated by the function definition, because we must guarantee
+    // function execution semantics wrt side effects (see
+    // function_optimizer.cc).
+    func_item->optimization_options().allow_pruning_stateful_and_dataset_ops =
+        false;
+
+    // Optimize function body graph.
+    if (is_tpu_graph) {
+      // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+      // passes do not handle TPU functions correctly in a variety of ways
+      // (Note that due to the pre-placement TPU graph rewriting passes, the
+      // TPU-related ops are encapsulated away into functions). For example,
+      // TPU graphs contain TPUReplicateMetadata node that carries relevant
+      // TPU metadata and Grappler passes could prune that away. Grappler
+      // passes could also cause issues around shape inference. Since the
+      // desired and existing behavior is to not optimize TPU functions with
+      // Grappler, this check preserves that. The only exception is
+      // implementation selector what is required to swap in some TPU specific
+      // lowering code and is verified the work correctly on TPUs.
+      ImplementationSelector implementation_selector;
+
+      // Implementation selector needs to have access to valid function
+      // signature and attributes, and it doesn't need actual function body.
+      std::unique_ptr<FunctionDefLibrary> func_item_function_library(
+          func_item->graph.release_library());
+      *func_item->graph.mutable_library() =
+          GetFunctionDefLibraryStub(*func_item_function_library);
+
+      return implementation_selector.Optimize(cluster, *func_item,
+                                              optimized_func_graph);
+    }
+    GrapplerFunctionItem func_item_copy = *func_item;
+    return OptimizeGraph(cluster, std::move(func_item_copy),
+                         optimized_func_graph);
+  };
+
+  const int num_threads = NumFunctionOptimizationThreads();
+  std::unique_ptr<thread::ThreadPool> thread_pool;
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   while (optimize_function_library) {
     optimize_function_library = false;
 
-    int function_idx = 0;
+    // Functions to optimize in this pass, in the order of the library.
+    std::vector<const FunctionDef*> funcs;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
 
@@ -1188,69 +1289,29 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       if (data::IsTFDataFunction(func)) continue;
 
       VLOG(3) << "Optimize function: function=" << func_name << " ["
-              << function_idx++ << " of "
+              << funcs.size() << " of "
               << optimized_graph->library().function_size() << "]";
 
-      // Function optimization might specialize nested function calls, so we
-      // have to reset the flag and do at least one more pass over the library.
-      optimize_function_library = true;
       optimized_funcs.insert(func_name);
+      funcs.push_back(&func);
+    }
+    if (funcs.empty()) break;
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(
-          MakeGrapplerFunctionItem(func, flib, producer, &func_item));
-
-      // If we need to compute the gradient of optimized function at runtime, we
-      // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
-          !differentiable_functions.contains(func_name);
-
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
-      }
+    // Function optimization might specialize nested function calls, so we
+    // have to do at least one more pass over the library.
+    optimize_function_library = true;
 
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (is_tpu_graph) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
-            func_item.graph.release_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(*func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
-      }
+    std::vector<GrapplerFunctionItem> func_items(funcs.size());
+    std::vector<GraphDef> optimized_func_graphs(funcs.size());
+    std::vector<Status> statuses(funcs.size());
+
+    // Adds the optimized body of `funcs[i]` and the functions it specialized
+    // to the library.
+    const auto update_library = [&](int i) -> Status {
+      TF_RETURN_IF_ERROR(statuses[i]);
+      const string& func_name = funcs[i]->signature().name();
+      GrapplerFunctionItem& func_item = func_items[i];
+      GraphDef& optimized_func_graph = optimized_func_graphs[i];
 
       // Function body optimization might have created new specialized
       // functions for each instantiation context. Add them to the library.
@@ -1267,13 +1328,63 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
 
       // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
-    }
+      return flib.ReplaceFunction(func_name, optimized_func);
+    };
+
+    // Functions are optimized in waves of consecutive functions of the
+    // library, and the library is updated after every wave in the order of the
+    // functions. A function starts a new wave if it can reach, directly or
+    // through other functions, a function of the current wave. So every
+    // function sees the optimized bodies of the functions before it, exactly
+    // as if they were optimized one at a time, and the result does not depend
+    // on the number of threads. With a single thread every wave is a single
+    // function.
+    int wave_begin = 0;
+    while (wave_begin < funcs.size()) {
+      int wave_end = wave_begin + 1;
+      if (num_threads > 1) {
+        absl::flat_hash_set<string> wave_funcs = {
+            funcs[wave_begin]->signature().name()};
+        for (; wave_end < funcs.size(); ++wave_end) {
+          const std::vector<string> reachable =
+              flib.ReachableDefinitions(*funcs[wave_end]).ListFunctionNames();
+          if (absl::c_any_of(reachable, [&](const string& name) {
+                return wave_funcs.contains(name);
+              })) {
+            break;
+          }
+          wave_funcs.insert(funcs[wave_end]->signature().name());
+        }
+      }
 
-    // If optimized at least one function, update the graph library.
-    if (optimize_function_library) {
-      *optimized_graph->mutable_library() = flib.ToProto();
+      if (wave_end - wave_begin > 1) {
+        if (thread_pool == nullptr) {
+          thread_pool = std::make_unique<thread::ThreadPool>(
+              Env::Default(), "grappler_function_optimizer", num_threads);
+        }
+        BlockingCounter counter(wave_end - wave_begin);
+        for (int i = wave_begin; i < wave_end; ++i) {
+          thread_pool->Schedule([&, i]() {
+            statuses[i] = optimize_function(*funcs[i], &func_items[i],
+                                            &optimized_func_graphs[i]);
+            counter.DecrementCount();
+          });
+        }
+        counter.Wait();
+      } else {
+        statuses[wave_begin] =
+            optimize_function(*funcs[wave_begin], &func_items[wave_begin],
+                              &optimized_func_graphs[wave_begin]);
+      }
+
+      for (int i = wave_begin; i < wave_end; ++i) {
+        TF_RETURN_IF_ERROR(update_library(i));
+      }
+      wave_begin = wave_end;
     }
+
+    // Update the graph library with the optimized functions.
+    *optimized_graph->mutable_library() = flib.ToProto();
   }
 
   // Run module-level TFG optimizations at the end of the meta-optimizer.
@@ -1316,6 +1427,7 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
 string MetaOptimizer::GetResultString() const {
   std::string result_string;
+  tf_shared_lock lock(optimization_results_mu_);
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
     absl::StrAppend(&result_string,
                     "Optimization results for grappler item: ", graph_result.id,
@@ -1364,11 +1476,33 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
 Status RunMetaOptimizer(GrapplerItem&& item, const ConfigProto& cfg,
                         DeviceBase* cpu_device, Cluster* cluster,
                         GraphDef* optimized_graph) {
+  std::unique_ptr<MetaOptimizerCache> cache;
+  TF_RETURN_IF_ERROR(MetaOptimizerCache::FromEnv(&cache));
+  std::string cache_key;
+  if (cache != nullptr) {
+    tensorflow::metrics::ScopedCounter<2> timings(
+        tensorflow::metrics::GetGraphOptimizationCounter(),
+        {kGrapplerCategory, "MetaOptimizerCache"});
+    cache_key = MetaOptimizerCache::Key(item, cfg, cluster);
+    if (cache->Lookup(cache_key, optimized_graph)) return OkStatus();
+  }
+
   MetaOptimizer optimizer(cpu_device, cfg);
   optimizer.set_deadline_usec(
       DeadlineMicroSeconds(cfg.graph_options().rewrite_options()));
-  return optimizer.OptimizeConsumeItem(cluster, std::move(item),
-                                       optimized_graph);
+  TF_RETURN_IF_ERROR(optimizer.OptimizeConsumeItem(cluster, std::move(item),
+                                                   optimized_graph));
+
+  if (cache != nullptr) {
+    // Failing to fill the cache only makes the next load slower.
+    Status status = cache->Insert(cache_key, *optimized_graph);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to write the optimized graph to the Grappler "
+                      "cache in "
+                   << cache->dir() << ": " << status;
+    }
+  }
+  return OkStatus();
 }
 
 Status OptimizeGraph(
@@ -0,0 +1,248 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Accumulates a 128-bit fingerprint of a sequence of strings and protos.
+class Fingerprinter {
+ public:
+  void Add(StringPiece s) {
+    // Length-prefix every piece so that different splits of the same bytes
+    // have different fingerprints.
+    fp_ = tsl::FingerprintCat128(fp_, s.size());
+    fp_ = tsl::FingerprintCat128(fp_, Fingerprint128(s));
+  }
+
+  void Add(int64_t value) { fp_ = tsl::FingerprintCat128(fp_, value); }
+
+  void Add(const protobuf::MessageLite& proto) {
+    std::string serialized;
+    SerializeToStringDeterministic(proto, &serialized);
+    Add(serialized);
+  }
+
+  // Adds the strings of `values` in sorted order.
+  void AddSorted(std::vector<std::string> values) {
+    std::sort(values.begin(), values.end());
+    Add(static_cast<int64_t>(values.size()));
+    for (const std::string& value : values) Add(value);
+  }
+
+  std::string ToString() const {
+    return absl::StrCat(absl::Hex(fp_.high64, absl::kZeroPad16),
+                        absl::Hex(fp_.low64, absl::kZeroPad16));
+  }
+
+ private:
+  Fprint128 fp_ = {0, 0};
+};
+
+// Adds the nodes of `nodes` in the order of their names, so that the
+// fingerprint does not depend on the order of nodes in the graph.
+template <typename NodeDefs>
+void AddNodes(const NodeDefs& nodes, Fingerprinter* fingerprinter) {
+  std::vector<const NodeDef*> sorted;
+  sorted.reserve(nodes.size());
+  for (const NodeDef& node : nodes) sorted.push_back(&node);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const NodeDef* a, const NodeDef* b) {
+              return a->name() < b->name();
+            });
+  fingerprinter->Add(static_cast<int64_t>(sorted.size()));
+  for (const NodeDef* node : sorted) fingerprinter->Add(*node);
+}
+
+void AddLibrary(const FunctionDefLibrary& library,
+                Fingerprinter* fingerprinter) {
+  std::vector<const FunctionDef*> functions;
+  functions.reserve(library.function_size());
+  for (const FunctionDef& function : library.function()) {
+    functions.push_back(&function);
+  }
+  std::sort(functions.begin(), functions.end(),
+            [](const FunctionDef* a, const FunctionDef* b) {
+              return a->signature().name() < b->signature().name();
+            });
+  fingerprinter->Add(static_cast<int64_t>(functions.size()));
+  for (const FunctionDef* function : functions) {
+    // The nodes of the body are added separately to ignore their order.
+    FunctionDef without_body = *function;
+    without_body.clear_node_def();
+    fingerprinter->Add(without_body);
+    AddNodes(function->node_def(), fingerprinter);
+  }
+
+  std::vector<std::string> gradients;
+  gradients.reserve(library.gradient_size());
+  for (const GradientDef& gradient : library.gradient()) {
+    gradients.push_back(
+        absl::StrCat(gradient.function_name(), ":", gradient.gradient_func()));
+  }
+  fingerprinter->AddSorted(std::move(gradients));
+}
+
+}  // namespace
+
+Status MetaOptimizerCache::FromEnv(std::unique_ptr<MetaOptimizerCache>* cache) {
+  std::string dir;
+  TF_RETURN_IF_ERROR(ReadStringFromEnvVar(kMetaOptimizerCacheDirEnvVar,
+                                          /*default_val=*/"", &dir));
+  if (dir.empty()) {
+    cache->reset();
+  } else {
+    *cache = std::make_unique<MetaOptimizerCache>(std::move(dir));
+  }
+  return OkStatus();
+}
+
+std::string MetaOptimizerCache::Key(const GrapplerItem& item,
+                                    const ConfigProto& cfg,
+                                    const Cluster* cluster) {
+  Fingerprinter fingerprinter;
+  fingerprinter.Add(TF_VERSION_STRING);
+  fingerprinter.Add(static_cast<int64_t>(TF_GRAPH_DEF_VERSION));
+
+  fingerprinter.Add(item.graph.versions());
+  AddNodes(item.graph.node(), &fingerprinter);
+  AddLibrary(item.graph.library(), &fingerprinter);
+
+  // The order of fetches is significant, the order of the other nodes that
+  // must be preserved is not.
+  fingerprinter.Add(static_cast<int64_t>(item.fetch.size()));
+  for (const std::string& fetch : item.fetch) fingerprinter.Add(fetch);
+  // Shape inference uses the dtypes and shapes of the fed tensors.
+  std::vector<std::string> feeds;
+  feeds.reserve(item.feed.size());
+  for (const auto& feed : item.feed) {
+    feeds.push_back(absl::StrCat(feed.first, ":",
+                                 DataTypeString(feed.second.dtype()), ":",
+                                 feed.second.shape().DebugString()));
+  }
+  fingerprinter.AddSorted(std::move(feeds));
+  fingerprinter.AddSorted(item.keep_ops);
+  fingerprinter.AddSorted(item.init_ops);
+  fingerprinter.Add(item.save_op);
+  fingerprinter.Add(item.restore_op);
+  fingerprinter.Add(item.save_restore_loc_tensor);
+  for (const QueueRunnerDef& queue_runner : item.queue_runners) {
+    fingerprinter.Add(queue_runner);
+  }
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  fingerprinter.Add(options.allow_non_differentiable_rewrites);
+  fingerprinter.Add(options.allow_pruning_stateful_and_dataset_ops);
+  fingerprinter.Add(options.optimize_function_library);
+  fingerprinter.Add(options.is_eager_mode);
+  fingerprinter.Add(options.intra_op_parallelism_threads);
+
+  // Not only the rewriter options matter: the MetaOptimizer reads the
+  // executor type and whether TFRT is used to decide on lowering control
+  // flow, and custom optimizers are initialized with the whole ConfigProto.
+  fingerprinter.Add(cfg);
+  fingerprinter.AddSorted(
+      std::vector<std::string>(item.devices().begin(), item.devices().end()));
+  if (cluster != nullptr) {
+    std::vector<std::string> devices;
+    for (const auto& device : cluster->GetDevices()) {
+      std::string properties;
+      SerializeToStringDeterministic(device.second, &properties);
+      devices.push_back(absl::StrCat(device.first, ":", properties));
+    }
+    fingerprinter.AddSorted(std::move(devices));
+  }
+  return fingerprinter.ToString();
+}
+
+std::string MetaOptimizerCache::FileName(const std::string& key) const {
+  return io::JoinPath(dir_, absl::StrCat("grappler_", key, ".pb"));
+}
+
+bool MetaOptimizerCache::Lookup(const std::string& key,
+                                GraphDef* optimized_graph) const {
+  const std::string file_name = FileName(key);
+  if (!env_->FileExists(file_name).ok()) {
+    metrics::RecordGrapplerCacheLookup("miss");
+    VLOG(2) << "Grappler cache miss: " << file_name;
+    return false;
+  }
+  Status status = ReadBinaryProto(env_, file_name, optimized_graph);
+  if (!status.ok()) {
+    metrics::RecordGrapplerCacheLookup("failure");
+    LOG(WARNING) << "Failed to read the optimized graph from the Grappler "
+                    "cache, optimizing it again: "
+                 << status;
+    optimized_graph->Clear();
+    return false;
+  }
+  metrics::RecordGrapplerCacheLookup("hit");
+  VLOG(1) << "Grappler cache hit: " << file_name;
+  return true;
+}
+
+Status MetaOptimizerCache::Insert(const std::string& key,
+                                  const GraphDef& optimized_graph) const {
+  if (!env_->FileExists(dir_).ok()) {
+    TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(dir_));
+  }
+  bool has_atomic_move = false;
+  TF_RETURN_IF_ERROR(env_->HasAtomicMove(dir_, &has_atomic_move));
+  if (!has_atomic_move) {
+    LOG_EVERY_POW_2(WARNING)
+        << "Filesystem for the Grappler cache at " << dir_
+        << " does not support atomic moves. Therefore the cache is racy if "
+           "the same graph is optimized by several processes at once!";
+  }
+
+  const std::string file_name = FileName(key);
+  std::string temp_file_name = file_name;
+  if (!env_->CreateUniqueFileName(&temp_file_name, ".tmp")) {
+    return errors::Unavailable("Could not create a unique file inside ",
+                               dir_);
+  }
+  std::string serialized;
+  if (!SerializeToStringDeterministic(optimized_graph, &serialized)) {
+    return errors::Internal("Failed to serialize the optimized graph.");
+  }
+  TF_RETURN_IF_ERROR(WriteStringToFile(env_, temp_file_name, serialized));
+  return env_->RenameFile(temp_file_name, file_name);
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,91 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Environment variable naming the directory of the persistent MetaOptimizer
+// cache. The cache is disabled when it is unset or empty.
+inline constexpr char kMetaOptimizerCacheDirEnvVar[] = "TF_GRAPPLER_CACHE_DIR";
+
+// A persistent cache of graphs optimized by the MetaOptimizer.
+//
+// Loading the same SavedModel over and over (e.g. on every restart of a
+// serving job) runs the whole Grappler pipeline on the same input each time.
+// This cache stores the optimized graph on local disk, keyed by a canonical
+// fingerprint of everything that determines the output of the optimization,
+// so that later loads can skip it.
+//
+// The key covers the input graph and function library (independent of the
+// order of nodes and functions), the fetch, keep and init nodes, the fed
+// tensors with their dtypes and shapes, the optimization options of the item,
+// the whole session config (the RewriterConfig, but also e.g. the executor
+// type, which decides whether control flow is lowered), the devices of the
+// item and of the cluster and the version of TensorFlow. It does not cover
+// the environment variables that tune individual optimizers: the cache
+// directory must be cleared when those are changed. A graph whose
+// optimization ran into `meta_optimizer_timeout_ms` is cached as is: it is
+// correct, but may be less optimized than it would be with more time.
+//
+// Entries are written to a temporary file and then renamed, so concurrent
+// loads of the same model do not observe partially written graphs.
+class MetaOptimizerCache {
+ public:
+  explicit MetaOptimizerCache(std::string dir, Env* env = Env::Default())
+      : dir_(std::move(dir)), env_(env) {}
+
+  // Returns the cache in the directory named by `kMetaOptimizerCacheDirEnvVar`
+  // in `*cache`, or nullptr if the cache is disabled.
+  static Status FromEnv(std::unique_ptr<MetaOptimizerCache>* cache);
+
+  // Returns the cache key of optimizing `item` with `cfg` on `cluster`.
+  // `cluster` may be null.
+  static std::string Key(const GrapplerItem& item, const ConfigProto& cfg,
+                         const Cluster* cluster);
+
+  // Reads the graph cached under `key` into `optimized_graph`. Returns false
+  // if there is no such graph or if it can't be read.
+  bool Lookup(const std::string& key, GraphDef* optimized_graph) const;
+
+  // Stores `optimized_graph` under `key`.
+  Status Insert(const std::string& key, const GraphDef& optimized_graph) const;
+
+  const std::string& dir() const { return dir_; }
+
+ private:
+  std::string FileName(const std::string& key) const;
+
+  const std::string dir_;
+  Env* const env_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_CACHE_H_
@@ -0,0 +1,218 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/meta_optimizer_cache.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kDevice[] = "/device:CPU:0";
+
+// Counts how many times it runs, without changing the graph.
+class CountingOptimizer : public CustomGraphOptimizer {
+ public:
+  static int num_runs() { return num_runs_; }
+
+  string name() const override { return "counting_optimizer"; }
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Init(const tensorflow::RewriterConfig_CustomGraphOptimizer* config =
+                  nullptr) override {
+    return OkStatus();
+  }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override {
+    ++num_runs_;
+    *optimized_graph = item.graph;
+    return OkStatus();
+  }
+
+ private:
+  static int num_runs_;
+};
+
+int CountingOptimizer::num_runs_ = 0;
+
+REGISTER_GRAPH_OPTIMIZER(CountingOptimizer);
+
+GrapplerItem MakeItem() {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
+  GrapplerItem item;
+  CHECK(fake_input.NextItem(&item));
+  return item;
+}
+
+ConfigProto MakeConfig() {
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("CountingOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+  return config_proto;
+}
+
+class MetaOptimizerCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = io::JoinPath(testing::TmpDir(),
+                        ::testing::UnitTest::GetInstance()
+                            ->current_test_info()
+                            ->name());
+  }
+
+  std::string dir_;
+};
+
+TEST_F(MetaOptimizerCacheTest, KeyIgnoresNodeAndFunctionOrder) {
+  GrapplerItem item = MakeItem();
+  *item.graph.mutable_library()->add_function() =
+      test::function::XTimesTwo();
+  *item.graph.mutable_library()->add_function() =
+      test::function::XTimesFour();
+  const ConfigProto cfg = MakeConfig();
+  const std::string key = MetaOptimizerCache::Key(item, cfg, nullptr);
+
+  GrapplerItem reordered = item;
+  auto* nodes = reordered.graph.mutable_node();
+  std::reverse(nodes->begin(), nodes->end());
+  auto* functions = reordered.graph.mutable_library()->mutable_function();
+  std::reverse(functions->begin(), functions->end());
+  EXPECT_EQ(key, MetaOptimizerCache::Key(reordered, cfg, nullptr));
+}
+
+TEST_F(MetaOptimizerCacheTest, KeyDependsOnGraphConfigAndDevices) {
+  const GrapplerItem item = MakeItem();
+  const ConfigProto cfg = MakeConfig();
+  const std::string key = MetaOptimizerCache::Key(item, cfg, nullptr);
+
+  GrapplerItem other_graph = item;
+  other_graph.graph.mutable_node(0)->set_name("renamed");
+  EXPECT_NE(key, MetaOptimizerCache::Key(other_graph, cfg, nullptr));
+
+  GrapplerItem other_fetch = item;
+  other_fetch.fetch.push_back(item.graph.node(0).name());
+  EXPECT_NE(key, MetaOptimizerCache::Key(other_fetch, cfg, nullptr));
+
+  ConfigProto other_cfg = cfg;
+  other_cfg.mutable_graph_options()->mutable_rewrite_options()->set_remapping(
+      RewriterConfig::OFF);
+  EXPECT_NE(key, MetaOptimizerCache::Key(item, other_cfg, nullptr));
+
+  ConfigProto other_executor = cfg;
+  other_executor.mutable_experimental()->set_executor_type(
+      "SINGLE_THREADED_EXECUTOR");
+  EXPECT_NE(key, MetaOptimizerCache::Key(item, other_executor, nullptr));
+
+  ConfigProto tfrt = cfg;
+  tfrt.mutable_experimental()->set_use_tfrt(true);
+  EXPECT_NE(key, MetaOptimizerCache::Key(item, tfrt, nullptr));
+
+  GrapplerItem other_devices = item;
+  TF_ASSERT_OK(other_devices.AddDevice(kDevice));
+  EXPECT_NE(key, MetaOptimizerCache::Key(other_devices, cfg, nullptr));
+}
+
+TEST_F(MetaOptimizerCacheTest, KeyDependsOnFeedDtypesAndShapes) {
+  GrapplerItem item = MakeItem();
+  const std::string feed_name = item.graph.node(0).name();
+  item.feed.emplace_back(feed_name, Tensor(DT_FLOAT, TensorShape({2, 3})));
+  const ConfigProto cfg = MakeConfig();
+  const std::string key = MetaOptimizerCache::Key(item, cfg, nullptr);
+
+  GrapplerItem other_dtype = item;
+  other_dtype.feed[0].second = Tensor(DT_DOUBLE, TensorShape({2, 3}));
+  EXPECT_NE(key, MetaOptimizerCache::Key(other_dtype, cfg, nullptr));
+
+  GrapplerItem other_shape = item;
+  other_shape.feed[0].second = Tensor(DT_FLOAT, TensorShape({3, 2}));
+  EXPECT_NE(key, MetaOptimizerCache::Key(other_shape, cfg, nullptr));
+}
+
+TEST_F(MetaOptimizerCacheTest, LookupReturnsInsertedGraph) {
+  MetaOptimizerCache cache(dir_);
+  const std::string key =
+      MetaOptimizerCache::Key(MakeItem(), MakeConfig(), nullptr);
+  GraphDef graph;
+  const int64_t misses = metrics::GetGrapplerCacheLookupCount("miss");
+  EXPECT_FALSE(cache.Lookup(key, &graph));
+  EXPECT_EQ(misses + 1, metrics::GetGrapplerCacheLookupCount("miss"));
+
+  const GraphDef inserted = MakeItem().graph;
+  TF_ASSERT_OK(cache.Insert(key, inserted));
+  const int64_t hits = metrics::GetGrapplerCacheLookupCount("hit");
+  ASSERT_TRUE(cache.Lookup(key, &graph));
+  EXPECT_EQ(hits + 1, metrics::GetGrapplerCacheLookupCount("hit"));
+  EXPECT_EQ(inserted.DebugString(), graph.DebugString());
+}
+
+TEST_F(MetaOptimizerCacheTest, CorruptEntryIsAMiss) {
+  MetaOptimizerCache cache(dir_);
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir_));
+  const std::string key = "0123456789abcdef0123456789abcdef";
+  TF_ASSERT_OK(WriteStringToFile(
+      Env::Default(), io::JoinPath(dir_, "grappler_" + key + ".pb"),
+      "not a graph"));
+  GraphDef graph;
+  const int64_t failures = metrics::GetGrapplerCacheLookupCount("failure");
+  EXPECT_FALSE(cache.Lookup(key, &graph));
+  EXPECT_EQ(failures + 1, metrics::GetGrapplerCacheLookupCount("failure"));
+}
+
+TEST_F(MetaOptimizerCacheTest, RunMetaOptimizerSkipsOptimizationOnHit) {
+  setenv(kMetaOptimizerCacheDirEnvVar, dir_.c_str(), /*overwrite=*/1);
+  const ConfigProto cfg = MakeConfig();
+
+  const int num_runs = CountingOptimizer::num_runs();
+  GraphDef first;
+  TF_ASSERT_OK(RunMetaOptimizer(MakeItem(), cfg, /*cpu_device=*/nullptr,
+                                /*cluster=*/nullptr, &first));
+  EXPECT_EQ(num_runs + 1, CountingOptimizer::num_runs());
+
+  GraphDef second;
+  TF_ASSERT_OK(RunMetaOptimizer(MakeItem(), cfg, /*cpu_device=*/nullptr,
+                                /*cluster=*/nullptr, &second));
+  EXPECT_EQ(num_runs + 1, CountingOptimizer::num_runs());
+  EXPECT_EQ(first.DebugString(), second.DebugString());
+
+  unsetenv(kMetaOptimizerCacheDirEnvVar);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,9 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
 #include <atomic>
+#include <vector>
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -34,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
@@ -1412,6 +1418,226 @@ INSTANTIATE_TEST_SUITE_P(
       return test_name;
     });
 
+// Returns an item calling `num_functions` independent functions, each of them
+// adding `num_nodes` constants to its input one at a time.
+GrapplerItem MakeFunctionLibraryItem(int num_functions, int num_nodes) {
+  using test::function::NDef;
+
+  std::vector<NodeDef> nodes = {
+      NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  std::vector<FunctionDef> functions;
+  GrapplerItem item;
+  item.id = "tf_graph";
+  for (int i = 0; i < num_functions; ++i) {
+    std::vector<FunctionDefHelper::Node> body;
+    string input = "x";
+    for (int j = 0; j < num_nodes; ++j) {
+      const string c = absl::StrCat("c", j);
+      const string add = absl::StrCat("add", j);
+      body.push_back(FunctionDefHelper::Const<float>(c, j));
+      body.push_back({{add},
+                      "Add",
+                      {input, absl::StrCat(c, ":output:0")},
+                      {{"T", DT_FLOAT}}});
+      input = absl::StrCat(add, ":z:0");
+    }
+    const string name = absl::StrCat("AddConstants", i);
+    functions.push_back(FunctionDefHelper::Create(
+        name, {"x:float"}, {"z:float"}, {}, body, {{"z", input}}));
+    (*functions.back().mutable_attr())["_noinline"].set_b(true);
+
+    const string call = absl::StrCat("call", i);
+    nodes.push_back(NDef(call, name, {"x"}, {}, kDevice));
+    item.fetch.push_back(call);
+  }
+  item.graph = test::function::GDef(nodes, functions);
+  return item;
+}
+
+// Returns an item whose library holds `num_copies` copies of nested functions,
+// in an order where callers precede their callees for even copies and follow
+// them for odd ones:
+//
+//   MyMul_i(x, y)    = x * y
+//  *MySquare_i(x)    = MyMul_i(x, x)
+//  *MyQuadratic_i(x) = MySquare_i(MySquare_i(x))
+//  *Outer_i(x)       = Inner_i(x) + 1      (float only)
+//  *Inner_i(x)       = MySquare_i(x) * 2   (float only)
+//
+//  * - marked as noinline
+//
+// The main graph calls MySquare_i, MyQuadratic_i and Outer_i, so function
+// optimization creates specializations of specializations.
+GrapplerItem MakeNestedFunctionLibraryItem(int num_copies) {
+  using test::function::NDef;
+
+  std::vector<NodeDef> nodes = {
+      NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+      NDef("b", "Placeholder", {}, {{"dtype", DT_INT32}}, kDevice)};
+  std::vector<FunctionDef> functions;
+  GrapplerItem item;
+  item.id = "tf_graph";
+  for (int i = 0; i < num_copies; ++i) {
+    const string mul = absl::StrCat("MyMul_", i);
+    const string square = absl::StrCat("MySquare_", i);
+    const string quadratic = absl::StrCat("MyQuadratic_", i);
+    const string inner = absl::StrCat("Inner_", i);
+    const string outer = absl::StrCat("Outer_", i);
+
+    std::vector<FunctionDef> copy;
+    copy.push_back(FunctionDefHelper::Create(
+        mul, {"x:T", "y:T"}, {"z:T"}, {"T: {float, double, int32}"},
+        {{{"mul"}, "Mul", {"x", "y"}, {{"T", "$T"}}}},
+        /*ret_def=*/{{"z", "mul:z:0"}}));
+    copy.push_back(FunctionDefHelper::Create(
+        square, {"x:T"}, {"z:T"}, {"T: {float, double, int32}"},
+        {{{"my_mul"}, mul, {"x", "x"}, {{"T", "$T"}}}},
+        /*ret_def=*/{{"z", "my_mul:z:0"}}));
+    copy.push_back(FunctionDefHelper::Create(
+        quadratic, {"x:T"}, {"z:T"}, {"T: {float, double, int32}"},
+        {{{"square"}, square, {"x"}, {{"T", "$T"}}},
+         {{"quadratic"}, square, {"square:z"}, {{"T", "$T"}}}},
+        /*ret_def=*/{{"z", "quadratic:z:0"}}));
+    copy.push_back(FunctionDefHelper::Create(
+        inner, {"x:float"}, {"z:float"}, {},
+        {FunctionDefHelper::Const<float>("two", 2.0f),
+         {{"square"}, square, {"x"}, {{"T", DT_FLOAT}}},
+         {{"mul"}, "Mul", {"square:z:0", "two:output:0"}, {{"T", DT_FLOAT}}}},
+        /*ret_def=*/{{"z", "mul:z:0"}}));
+    copy.push_back(FunctionDefHelper::Create(
+        outer, {"x:float"}, {"z:float"}, {},
+        {FunctionDefHelper::Const<float>("one", 1.0f),
+         {{"inner"}, inner, {"x"}, {}},
+         {{"add"}, "Add", {"inner:z:0", "one:output:0"}, {{"T", DT_FLOAT}}}},
+        /*ret_def=*/{{"z", "add:z:0"}}));
+    for (int j = 1; j < copy.size(); ++j) {
+      (*copy[j].mutable_attr())["_noinline"].set_b(true);
+    }
+    if (i % 2 == 0) std::reverse(copy.begin(), copy.end());
+    functions.insert(functions.end(), copy.begin(), copy.end());
+
+    const string suffix = absl::StrCat("_", i);
+    nodes.push_back(NDef(absl::StrCat("square", suffix), square, {"a"},
+                         {{"T", DT_FLOAT}}, kDevice));
+    nodes.push_back(NDef(absl::StrCat("quadratic", suffix), quadratic, {"b"},
+                         {{"T", DT_INT32}}, kDevice));
+    nodes.push_back(
+        NDef(absl::StrCat("outer", suffix), outer, {"a"}, {}, kDevice));
+    item.fetch.push_back(absl::StrCat("square", suffix));
+    item.fetch.push_back(absl::StrCat("quadratic", suffix));
+    item.fetch.push_back(absl::StrCat("outer", suffix));
+  }
+  item.graph = test::function::GDef(nodes, functions);
+  return item;
+}
+
+// Sets the number of threads that optimize library functions, and restores the
+// default when the test ends.
+class MetaOptimizerFunctionThreadsTest : public MetaOptimizerTest {
+ protected:
+  void TearDown() override {
+    unsetenv("TF_GRAPPLER_NUM_FUNCTION_OPTIMIZATION_THREADS");
+  }
+
+  // Optimizes `item` with `num_threads` threads. A single thread optimizes
+  // the functions one at a time, each against the library updated with the
+  // functions before it.
+  void Optimize(const ConfigProto& config_proto, const GrapplerItem& item,
+                int num_threads, GraphDef* output) {
+    setenv("TF_GRAPPLER_NUM_FUNCTION_OPTIMIZATION_THREADS",
+           absl::StrCat(num_threads).c_str(), 1);
+    TF_EXPECT_OK(
+        MetaOptimizer(nullptr, config_proto).Optimize(nullptr, item, output));
+  }
+
+  void CompareOutputs(const GraphDef& sequential, const GraphDef& parallel) {
+    CompareGraphs(sequential, parallel);
+    ASSERT_EQ(sequential.library().function_size(),
+              parallel.library().function_size());
+    for (int i = 0; i < sequential.library().function_size(); ++i) {
+      CompareFunctions(sequential.library().function(i),
+                       parallel.library().function(i));
+    }
+  }
+};
+
+TEST_F(MetaOptimizerFunctionThreadsTest, IndependentFunctionsInParallel) {
+  ConfigProto config_proto;
+  config_proto.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_min_graph_nodes(-1);
+  const GrapplerItem item =
+      MakeFunctionLibraryItem(/*num_functions=*/32, /*num_nodes=*/8);
+
+  GraphDef sequential;
+  Optimize(config_proto, item, /*num_threads=*/1, &sequential);
+  GraphDef parallel;
+  Optimize(config_proto, item, /*num_threads=*/8, &parallel);
+  CompareOutputs(sequential, parallel);
+}
+
+TEST_F(MetaOptimizerFunctionThreadsTest, NestedFunctionsInParallel) {
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.set_min_graph_nodes(-1);
+  GrapplerItem item = MakeNestedFunctionLibraryItem(/*num_copies=*/4);
+
+  GraphDef sequential;
+  Optimize(config_proto, item, /*num_threads=*/1, &sequential);
+  GraphDef parallel;
+  Optimize(config_proto, item, /*num_threads=*/8, &parallel);
+  CompareOutputs(sequential, parallel);
+
+  // MySquare_0 is specialized for the specialization of MyQuadratic_0.
+  FunctionLibraryDefinition flib(OpRegistry::Global(), parallel.library());
+  EXPECT_TRUE(flib.Contains(
+      "MySquare_0_specialized_for_square_at_"
+      "MyQuadratic_0_specialized_for_quadratic_0_at_tf_graph"));
+
+  item.feed.emplace_back("a", test::AsScalar<float>(2.0f));
+  item.feed.emplace_back("b", test::AsScalar<int>(3));
+  const std::vector<Tensor> expected = EvaluateFetchNodes(item);
+  const std::vector<Tensor> tensors =
+      EvaluateFetchNodes(item.WithGraph(std::move(parallel)));
+  ASSERT_EQ(expected.size(), tensors.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    test::ExpectEqual(expected[i], tensors[i]);
+  }
+}
+
+// The first argument is the number of functions in the library and the second
+// one the number of threads used to optimize them.
+static void BM_OptimizeFunctionLibrary(::testing::benchmark::State& state) {
+  const int num_functions = state.range(0);
+  const int num_threads = state.range(1);
+  setenv("TF_GRAPPLER_NUM_FUNCTION_OPTIMIZATION_THREADS",
+         absl::StrCat(num_threads).c_str(), 1);
+
+  ConfigProto config_proto;
+  config_proto.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_min_graph_nodes(-1);
+  const GrapplerItem item = MakeFunctionLibraryItem(num_functions, 32);
+
+  for (auto s : state) {
+    GraphDef output;
+    TF_CHECK_OK(MetaOptimizer(nullptr, config_proto)
+                    .Optimize(nullptr, item, &output));
+  }
+  state.SetItemsProcessed(state.iterations() * num_functions);
+  unsetenv("TF_GRAPPLER_NUM_FUNCTION_OPTIMIZATION_THREADS");
+}
+
+BENCHMARK(BM_OptimizeFunctionLibrary)
+    ->UseRealTime()
+    ->ArgPair(16, 1)
+    ->ArgPair(16, 4)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 4)
+    ->ArgPair(256, 16);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
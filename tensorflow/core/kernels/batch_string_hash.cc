@@ -0,0 +1,43 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batch_string_hash.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace tensorflow {
+namespace {
+
+// Rough costs of farmhash on a modern x86 core, including the cache miss on
+// strings that are stored out of line.
+constexpr int64_t kCyclesPerString = 40;
+constexpr int64_t kCyclesPerByte = 1;
+constexpr int64_t kMaxSampledStrings = 64;
+
+}  // namespace
+
+int64_t StringHashCostPerUnit(const tstring* input, int64_t n) {
+  if (n <= 0) return kCyclesPerString;
+  const int64_t num_samples = std::min(n, kMaxSampledStrings);
+  const int64_t stride = n / num_samples;
+  int64_t sampled_bytes = 0;
+  for (int64_t i = 0; i < num_samples; ++i) {
+    sampled_bytes += input[i * stride].size();
+  }
+  return kCyclesPerString + kCyclesPerByte * sampled_bytes / num_samples;
+}
+
+}  // namespace tensorflow
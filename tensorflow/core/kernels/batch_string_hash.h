@@ -0,0 +1,91 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCH_STRING_HASH_H_
+#define TENSORFLOW_CORE_KERNELS_BATCH_STRING_HASH_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+// Hashes many strings of a tensor at once.
+//
+// Strings that do not fit in the inline representation of `tstring` live in
+// their own heap buffers, so hashing a tensor of them one at a time stalls on
+// a cache miss per string before the hash can start. The helpers below hash
+// strings in blocks of `kStringHashBlockSize`, prefetching the bytes of the
+// next block while the current one is hashed, so that the misses overlap with
+// each other and with the hashing. The hashes within a block are independent,
+// which lets the CPU run several of them in flight for short strings.
+//
+// The result for every string is exactly `hash(input[i])`: the batching only
+// changes the order in which memory is touched, never the hash function.
+constexpr int64_t kStringHashBlockSize = 16;
+
+// Calls `fn(i, hash(input[i]))` for every `i` in `[begin, end)`, in order.
+template <uint64 hash(StringPiece), typename Fn>
+inline void BatchStringHash(const tstring* input, int64_t begin, int64_t end,
+                            Fn fn) {
+  for (int64_t i = begin; i < std::min(end, begin + kStringHashBlockSize);
+       ++i) {
+    port::prefetch<port::PREFETCH_HINT_T0>(input[i].data());
+  }
+  for (int64_t block = begin; block < end; block += kStringHashBlockSize) {
+    const int64_t block_end = std::min(end, block + kStringHashBlockSize);
+    const int64_t next_end = std::min(end, block_end + kStringHashBlockSize);
+    for (int64_t i = block_end; i < next_end; ++i) {
+      port::prefetch<port::PREFETCH_HINT_T0>(input[i].data());
+    }
+    for (int64_t i = block; i < block_end; ++i) {
+      fn(i, hash(StringPiece(input[i].data(), input[i].size())));
+    }
+  }
+}
+
+// Stores `hash(input[i])` in `output[i]` for every `i` in `[0, n)`.
+template <uint64 hash(StringPiece)>
+inline void BatchStringHash(const tstring* input, int64_t n, uint64* output) {
+  BatchStringHash<hash>(input, 0, n,
+                        [output](int64_t i, uint64 h) { output[i] = h; });
+}
+
+// Returns the estimated cost in cycles of hashing one of the `n` strings in
+// `input`, from the lengths of a sample of them. Used to shard the hashing.
+int64_t StringHashCostPerUnit(const tstring* input, int64_t n);
+
+// Like `BatchStringHash`, but splits `[0, n)` into contiguous shards that run
+// on `worker_threads`. `fn` is called concurrently for different `i`.
+template <uint64 hash(StringPiece), typename Fn>
+inline void ParallelBatchStringHash(
+    const DeviceBase::CpuWorkerThreads& worker_threads, const tstring* input,
+    int64_t n, Fn fn) {
+  Shard(worker_threads.num_threads, worker_threads.workers, n,
+        StringHashCostPerUnit(input, n), [input, &fn](int64_t begin,
+                                                      int64_t end) {
+          BatchStringHash<hash>(input, begin, end, fn);
+        });
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCH_STRING_HASH_H_
@@ -0,0 +1,249 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batch_string_hash.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace {
+
+// Distributions of string lengths for the tests and benchmarks.
+enum LengthDistribution {
+  // 8 bytes, stored inline in the `tstring`.
+  kShort = 0,
+  // 48 bytes, stored out of line.
+  kMedium = 1,
+  // 512 bytes.
+  kLong = 2,
+  // Uniform in [0, 64).
+  kUniform = 3,
+  // Mostly short strings with a few long ones, like ids mixed with queries.
+  kHeavyTailed = 4,
+};
+
+int64_t SampleLength(LengthDistribution distribution,
+                     random::SimplePhilox* rnd) {
+  switch (distribution) {
+    case kShort:
+      return 8;
+    case kMedium:
+      return 48;
+    case kLong:
+      return 512;
+    case kUniform:
+      return rnd->Uniform(64);
+    case kHeavyTailed:
+      return rnd->OneIn(10) ? 256 + rnd->Uniform(256) : 1 + rnd->Uniform(16);
+  }
+  return 0;
+}
+
+Tensor MakeStrings(TensorShape shape, LengthDistribution distribution) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor strings(DT_STRING, shape);
+  auto flat = strings.flat<tstring>();
+  for (int64_t i = 0; i < flat.size(); ++i) {
+    std::string s(SampleLength(distribution, &rnd), ' ');
+    for (char& c : s) c = 'a' + rnd.Uniform(26);
+    flat(i) = s;
+  }
+  return strings;
+}
+
+class BatchStringHashTest
+    : public ::testing::TestWithParam<LengthDistribution> {};
+
+TEST_P(BatchStringHashTest, MatchesScalarHash) {
+  // Not a multiple of the block size, to cover the last partial block.
+  const Tensor strings = MakeStrings(TensorShape({1000}), GetParam());
+  const auto flat = strings.flat<tstring>();
+  std::vector<uint64> hashes(flat.size());
+  BatchStringHash<Fingerprint64>(flat.data(), flat.size(), hashes.data());
+  for (int64_t i = 0; i < flat.size(); ++i) {
+    EXPECT_EQ(Fingerprint64(flat(i)), hashes[i]) << "at " << i;
+  }
+}
+
+TEST_P(BatchStringHashTest, SubrangeCallsInOrder) {
+  const Tensor strings = MakeStrings(TensorShape({100}), GetParam());
+  const auto flat = strings.flat<tstring>();
+  std::vector<int64_t> indices;
+  BatchStringHash<Fingerprint64>(flat.data(), 13, 71,
+                                 [&](int64_t i, uint64 hash) {
+                                   EXPECT_EQ(Fingerprint64(flat(i)), hash);
+                                   indices.push_back(i);
+                                 });
+  ASSERT_EQ(58, indices.size());
+  for (int64_t i = 0; i < indices.size(); ++i) {
+    EXPECT_EQ(13 + i, indices[i]);
+  }
+}
+
+TEST_P(BatchStringHashTest, ParallelMatchesScalarHash) {
+  thread::ThreadPool pool(Env::Default(), "hash", 4);
+  DeviceBase::CpuWorkerThreads worker_threads;
+  worker_threads.num_threads = 4;
+  worker_threads.workers = &pool;
+
+  const Tensor strings = MakeStrings(TensorShape({100000}), GetParam());
+  const auto flat = strings.flat<tstring>();
+  std::vector<uint64> hashes(flat.size());
+  ParallelBatchStringHash<Fingerprint64>(
+      worker_threads, flat.data(), flat.size(),
+      [&hashes](int64_t i, uint64 hash) { hashes[i] = hash; });
+  for (int64_t i = 0; i < flat.size(); ++i) {
+    EXPECT_EQ(Fingerprint64(flat(i)), hashes[i]) << "at " << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(LengthDistributions, BatchStringHashTest,
+                         ::testing::Values(kShort, kMedium, kLong, kUniform,
+                                           kHeavyTailed));
+
+TEST(StringHashCostPerUnitTest, GrowsWithLength) {
+  const Tensor short_strings = MakeStrings(TensorShape({100}), kShort);
+  const Tensor long_strings = MakeStrings(TensorShape({100}), kLong);
+  EXPECT_LT(StringHashCostPerUnit(short_strings.flat<tstring>().data(), 100),
+            StringHashCostPerUnit(long_strings.flat<tstring>().data(), 100));
+  EXPECT_GT(StringHashCostPerUnit(nullptr, 0), 0);
+}
+
+// Benchmarks of the kernels that hash strings. The first argument is the
+// number of strings and the second one the `LengthDistribution`.
+
+Graph* StringToHashBucketFastGraph(const Tensor& input) {
+  Graph* g = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "StringToHashBucketFast")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("num_buckets", 1000)
+                  .Finalize(g, nullptr /* node */));
+  return g;
+}
+
+Graph* FingerprintGraph(const Tensor& input) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor method(DT_STRING, TensorShape({}));
+  method.scalar<tstring>()() = "farmhash64";
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Fingerprint")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, method))
+                  .Finalize(g, nullptr /* node */));
+  return g;
+}
+
+// Crosses two dense string columns of 8 features each into hashes.
+Graph* SparseCrossGraph(const Tensor& left, const Tensor& right) {
+  Graph* g = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseCross")
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Input(std::vector<NodeBuilder::NodeOut>())
+                  .Input(std::vector<NodeBuilder::NodeOut>(
+                      {test::graph::Constant(g, left),
+                       test::graph::Constant(g, right)}))
+                  .Attr("hashed_output", true)
+                  .Attr("num_buckets", 1000)
+                  .Attr("hash_key", 956888297470)
+                  .Attr("out_type", DT_INT64)
+                  .Attr("internal_type", DT_INT64)
+                  .Finalize(g, nullptr /* node */));
+  return g;
+}
+
+static void BM_StringToHashBucketFast(::testing::benchmark::State& state) {
+  const int64_t num_strings = state.range(0);
+  const auto distribution = static_cast<LengthDistribution>(state.range(1));
+  const Tensor input = MakeStrings(TensorShape({num_strings}), distribution);
+  test::Benchmark("cpu", StringToHashBucketFastGraph(input),
+                  /*old_benchmark_api*/ false)
+      .Run(state);
+  state.SetItemsProcessed(state.iterations() * num_strings);
+}
+
+static void BM_Fingerprint(::testing::benchmark::State& state) {
+  const int64_t num_strings = state.range(0);
+  const auto distribution = static_cast<LengthDistribution>(state.range(1));
+  const Tensor input = MakeStrings(TensorShape({num_strings}), distribution);
+  test::Benchmark("cpu", FingerprintGraph(input), /*old_benchmark_api*/ false)
+      .Run(state);
+  state.SetItemsProcessed(state.iterations() * num_strings);
+}
+
+static void BM_SparseCrossHashed(::testing::benchmark::State& state) {
+  const int64_t batch_size = state.range(0) / 8;
+  const auto distribution = static_cast<LengthDistribution>(state.range(1));
+  const Tensor left = MakeStrings(TensorShape({batch_size, 8}), distribution);
+  const Tensor right = MakeStrings(TensorShape({batch_size, 8}), distribution);
+  test::Benchmark("cpu", SparseCrossGraph(left, right),
+                  /*old_benchmark_api*/ false)
+      .Run(state);
+  state.SetItemsProcessed(state.iterations() * batch_size * 64);
+}
+
+BENCHMARK(BM_StringToHashBucketFast)
+    ->UseRealTime()
+    ->ArgPair(1 << 10, kShort)
+    ->ArgPair(1 << 10, kMedium)
+    ->ArgPair(1 << 10, kLong)
+    ->ArgPair(1 << 10, kUniform)
+    ->ArgPair(1 << 10, kHeavyTailed)
+    ->ArgPair(1 << 16, kShort)
+    ->ArgPair(1 << 16, kMedium)
+    ->ArgPair(1 << 16, kLong)
+    ->ArgPair(1 << 16, kUniform)
+    ->ArgPair(1 << 16, kHeavyTailed);
+
+BENCHMARK(BM_Fingerprint)
+    ->UseRealTime()
+    ->ArgPair(1 << 10, kShort)
+    ->ArgPair(1 << 10, kMedium)
+    ->ArgPair(1 << 10, kLong)
+    ->ArgPair(1 << 10, kUniform)
+    ->ArgPair(1 << 10, kHeavyTailed)
+    ->ArgPair(1 << 16, kShort)
+    ->ArgPair(1 << 16, kMedium)
+    ->ArgPair(1 << 16, kLong)
+    ->ArgPair(1 << 16, kUniform)
+    ->ArgPair(1 << 16, kHeavyTailed);
+
+BENCHMARK(BM_SparseCrossHashed)
+    ->UseRealTime()
+    ->ArgPair(1 << 10, kShort)
+    ->ArgPair(1 << 10, kMedium)
+    ->ArgPair(1 << 10, kLong)
+    ->ArgPair(1 << 10, kUniform)
+    ->ArgPair(1 << 10, kHeavyTailed)
+    ->ArgPair(1 << 16, kShort)
+    ->ArgPair(1 << 16, kMedium)
+    ->ArgPair(1 << 16, kLong)
+    ->ArgPair(1 << 16, kUniform)
+    ->ArgPair(1 << 16, kHeavyTailed);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,239 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_size_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// The minimum number of samples needed to estimate the processing time of a
+// batch size.
+constexpr int kMinSamples = 8;
+
+// The number of most recent queueing delays that are kept.
+constexpr int kNumQueueingSamples = 1024;
+
+void RecordAdaptiveBatchSize(int64_t batch_size, const string& model_name,
+                             const string& op_name) {
+  static auto* cell = monitoring::Gauge<int64_t, 2>::New(
+      "/tensorflow/serving/batching/adaptive_batch_size",
+      "Tracks the batch size chosen by the adaptive batch size controller.",
+      "model_name", "op_name");
+  cell->GetCell(model_name, op_name)->Set(batch_size);
+}
+
+void RecordAdaptiveBatchTimeoutMicros(int64_t batch_timeout_micros,
+                                      const string& model_name,
+                                      const string& op_name) {
+  static auto* cell = monitoring::Gauge<int64_t, 2>::New(
+      "/tensorflow/serving/batching/adaptive_batch_timeout_micros",
+      "Tracks the batch timeout chosen by the adaptive batch size controller.",
+      "model_name", "op_name");
+  cell->GetCell(model_name, op_name)->Set(batch_timeout_micros);
+}
+
+void RecordAdaptiveEstimatedP99LatencyMicros(int64_t latency_micros,
+                                             const string& model_name,
+                                             const string& op_name) {
+  static auto* cell = monitoring::Gauge<int64_t, 2>::New(
+      "/tensorflow/serving/batching/adaptive_estimated_p99_latency_micros",
+      "Tracks the p99 latency that the adaptive batch size controller expects "
+      "from its current decision.",
+      "model_name", "op_name");
+  cell->GetCell(model_name, op_name)->Set(latency_micros);
+}
+
+}  // namespace
+
+void BatchSizeController::Samples::Add(int64_t value) {
+  if (values_.size() < capacity_) {
+    values_.push_back(value);
+  } else {
+    values_[next_] = value;
+  }
+  next_ = (next_ + 1) % capacity_;
+}
+
+int64_t BatchSizeController::Samples::Percentile(double percentile) const {
+  if (values_.empty()) return 0;
+  std::vector<int64_t> sorted = values_;
+  const int index = std::clamp<int>(
+      static_cast<int>(std::ceil(percentile * sorted.size())) - 1, 0,
+      sorted.size() - 1);
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return sorted[index];
+}
+
+double BatchSizeController::Samples::Mean() const {
+  if (values_.empty()) return 0;
+  double sum = 0;
+  for (int64_t value : values_) sum += value;
+  return sum / values_.size();
+}
+
+/*static*/ Status BatchSizeController::Create(
+    const Options& options, std::unique_ptr<BatchSizeController>* controller) {
+  if (options.target_p99_latency_micros <= 0) {
+    return errors::InvalidArgument(
+        "target_p99_latency_micros must be positive; was ",
+        options.target_p99_latency_micros);
+  }
+  if (options.batch_sizes.empty()) {
+    return errors::InvalidArgument("batch_sizes must not be empty");
+  }
+  for (int i = 0; i < options.batch_sizes.size(); ++i) {
+    if (options.batch_sizes[i] <= 0 ||
+        (i > 0 && options.batch_sizes[i] <= options.batch_sizes[i - 1])) {
+      return errors::InvalidArgument(
+          "batch_sizes must be positive and strictly increasing; got ",
+          options.batch_sizes[i], " at index ", i);
+    }
+  }
+  if (options.max_batch_timeout_micros < 0) {
+    return errors::InvalidArgument(
+        "max_batch_timeout_micros must be non-negative; was ",
+        options.max_batch_timeout_micros);
+  }
+  if (options.num_samples_per_batch_size < kMinSamples) {
+    return errors::InvalidArgument(
+        "num_samples_per_batch_size must be at least ", kMinSamples, "; was ",
+        options.num_samples_per_batch_size);
+  }
+  if (options.decision_interval_batches <= 0) {
+    return errors::InvalidArgument(
+        "decision_interval_batches must be positive; was ",
+        options.decision_interval_batches);
+  }
+  controller->reset(new BatchSizeController(options));
+  return OkStatus();
+}
+
+BatchSizeController::BatchSizeController(const Options& options)
+    : options_(options),
+      excess_queueing_micros_(kNumQueueingSamples),
+      // Start out with the static configuration: the largest batch size and
+      // the longest timeout.
+      current_(options.batch_sizes.size() - 1),
+      batch_timeout_micros_(options.max_batch_timeout_micros) {
+  processing_micros_.reserve(options_.batch_sizes.size());
+  for (int i = 0; i < options_.batch_sizes.size(); ++i) {
+    processing_micros_.emplace_back(options_.num_samples_per_batch_size);
+  }
+  ExportDecision();
+}
+
+void BatchSizeController::RecordQueueingDelay(int64_t queueing_micros) {
+  excess_queueing_micros_.Add(
+      std::max<int64_t>(0, queueing_micros - batch_timeout_micros_));
+}
+
+void BatchSizeController::RecordBatch(int64_t batch_size,
+                                      int64_t processing_micros) {
+  processing_micros_[BatchSizeIndex(batch_size)].Add(processing_micros);
+  if (++num_batches_since_decision_ >= options_.decision_interval_batches) {
+    num_batches_since_decision_ = 0;
+    Decide();
+  }
+}
+
+int BatchSizeController::BatchSizeIndex(int64_t batch_size) const {
+  const auto it = std::lower_bound(options_.batch_sizes.begin(),
+                                   options_.batch_sizes.end(), batch_size);
+  if (it == options_.batch_sizes.end()) return options_.batch_sizes.size() - 1;
+  return it - options_.batch_sizes.begin();
+}
+
+bool BatchSizeController::IsMeasured(int index) const {
+  return processing_micros_[index].size() >= kMinSamples;
+}
+
+void BatchSizeController::Decide() {
+  const int64_t target = options_.target_p99_latency_micros;
+  const int64_t excess_queueing = excess_queueing_micros_.Percentile(0.99);
+
+  int best = -1;
+  int largest_measured = -1;
+  double best_throughput = 0;
+  int64_t best_processing = 0;
+  for (int i = 0; i < options_.batch_sizes.size(); ++i) {
+    if (!IsMeasured(i)) continue;
+    largest_measured = i;
+    const int64_t processing = processing_micros_[i].Percentile(0.99);
+    if (processing + excess_queueing > target) continue;
+    const double throughput = options_.batch_sizes[i] /
+                              std::max(1.0, processing_micros_[i].Mean());
+    if (best == -1 || throughput > best_throughput) {
+      best = i;
+      best_throughput = throughput;
+      best_processing = processing;
+    }
+  }
+  if (largest_measured == -1) return;
+
+  if (best == -1) {
+    // No measured batch size meets the target. Trade throughput for latency.
+    current_ = std::max(0, current_ - 1);
+    batch_timeout_micros_ = 0;
+    estimated_p99_latency_micros_ =
+        IsMeasured(current_)
+            ? processing_micros_[current_].Percentile(0.99) + excess_queueing
+            : -1;
+    ExportDecision();
+    return;
+  }
+
+  int next = best;
+  int64_t processing = best_processing;
+  if (best == largest_measured && best + 1 < options_.batch_sizes.size()) {
+    // Explore the next larger batch size if it is expected to meet the target.
+    const int64_t extrapolated = best_processing *
+                                 options_.batch_sizes[best + 1] /
+                                 options_.batch_sizes[best];
+    if (extrapolated + excess_queueing <= target) {
+      next = best + 1;
+      processing = extrapolated;
+    }
+  }
+
+  current_ = next;
+  batch_timeout_micros_ = std::clamp<int64_t>(
+      target - processing - excess_queueing, 0,
+      options_.max_batch_timeout_micros);
+  estimated_p99_latency_micros_ =
+      processing + excess_queueing + batch_timeout_micros_;
+  ExportDecision();
+}
+
+void BatchSizeController::ExportDecision() const {
+  RecordAdaptiveBatchSize(batch_size(), options_.model_name, options_.op_name);
+  RecordAdaptiveBatchTimeoutMicros(batch_timeout_micros_, options_.model_name,
+                                   options_.op_name);
+  RecordAdaptiveEstimatedP99LatencyMicros(estimated_p99_latency_micros_,
+                                          options_.model_name,
+                                          options_.op_name);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
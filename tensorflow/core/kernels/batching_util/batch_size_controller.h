@@ -0,0 +1,156 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_SIZE_CONTROLLER_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_SIZE_CONTROLLER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Chooses the batch size and batch timeout of a batching queue online, so as to
+// maximize throughput while keeping the p99 latency of tasks below a target.
+//
+// The controller keeps a window of recent processing times for each candidate
+// batch size, and a window of recent queueing delays. Every
+// `decision_interval_batches` processed batches it estimates, for every batch
+// size with enough samples,
+//
+//   p99 latency = p99 processing time + p99 queueing delay beyond the timeout
+//
+// and picks the batch size with the highest throughput (tasks per microsecond
+// of processing) whose estimate meets the target. The remaining latency budget
+// becomes the batch timeout. The part of the queueing delay that exceeds the
+// timeout comes from waiting for a batch thread, and is independent of the
+// decision. Summing two p99s overestimates the p99 of the sum, which keeps the
+// controller on the safe side.
+//
+// If the best batch size is also the largest one measured so far, the
+// controller tries the next larger size once a linear extrapolation of its
+// processing time meets the target. If no measured size meets the target, it
+// steps down to the next smaller size without a timeout.
+//
+// Decisions are exported to /tensorflow/serving/batching/adaptive_* metrics.
+//
+// This class is not thread-safe.
+class BatchSizeController {
+ public:
+  struct Options {
+    // The p99 latency target in microseconds. Covers the time from the arrival
+    // of a task until its batch is processed. Must be positive.
+    int64_t target_p99_latency_micros = 0;
+
+    // The batch sizes to choose from, in increasing order. Batches are
+    // accounted to the smallest of these sizes that they fit in, since that is
+    // the size they are padded to. Must not be empty.
+    std::vector<int64_t> batch_sizes;
+
+    // The largest batch timeout the controller may choose.
+    int64_t max_batch_timeout_micros = 0;
+
+    // The number of most recent batches per batch size whose processing times
+    // are kept.
+    int num_samples_per_batch_size = 64;
+
+    // The number of processed batches between two decisions.
+    int decision_interval_batches = 32;
+
+    // Labels of the exported metrics.
+    string model_name;
+    string op_name;
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<BatchSizeController>* controller);
+
+  // Records that a batch was scheduled `queueing_micros` after its first task
+  // arrived.
+  void RecordQueueingDelay(int64_t queueing_micros);
+
+  // Records that processing a batch of `batch_size` tasks took
+  // `processing_micros`.
+  void RecordBatch(int64_t batch_size, int64_t processing_micros);
+
+  // The batch size at which a batch is scheduled without waiting any longer.
+  int64_t batch_size() const { return options_.batch_sizes[current_]; }
+
+  // How long a batch that is smaller than `batch_size()` may wait for more
+  // tasks.
+  int64_t batch_timeout_micros() const { return batch_timeout_micros_; }
+
+  // The p99 latency that the current decision is expected to yield, or -1 if
+  // it is unknown.
+  int64_t estimated_p99_latency_micros() const {
+    return estimated_p99_latency_micros_;
+  }
+
+ private:
+  // A window of the most recent samples of a quantity.
+  class Samples {
+   public:
+    explicit Samples(int capacity) : capacity_(capacity) {}
+
+    void Add(int64_t value);
+    int size() const { return values_.size(); }
+    int64_t Percentile(double percentile) const;
+    double Mean() const;
+
+   private:
+    const int capacity_;
+    std::vector<int64_t> values_;
+    int next_ = 0;
+  };
+
+  explicit BatchSizeController(const Options& options);
+
+  // Returns the index of the candidate batch size that a batch of
+  // `batch_size` tasks is accounted to.
+  int BatchSizeIndex(int64_t batch_size) const;
+
+  // Whether there are enough samples to estimate the processing time of the
+  // candidate batch size at `index`.
+  bool IsMeasured(int index) const;
+
+  void Decide();
+  void ExportDecision() const;
+
+  const Options options_;
+
+  // Processing times per candidate batch size.
+  std::vector<Samples> processing_micros_;
+
+  // Queueing delays beyond the batch timeout in effect.
+  Samples excess_queueing_micros_;
+
+  // Index of the current batch size in `options_.batch_sizes`.
+  int current_;
+  int64_t batch_timeout_micros_;
+  int64_t estimated_p99_latency_micros_ = -1;
+  int num_batches_since_decision_ = 0;
+
+  BatchSizeController(const BatchSizeController&) = delete;
+  void operator=(const BatchSizeController&) = delete;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_SIZE_CONTROLLER_H_
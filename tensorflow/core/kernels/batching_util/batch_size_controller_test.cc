@@ -0,0 +1,129 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_size_controller.h"
+
+#include <memory>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+BatchSizeController::Options CreateOptions(int64_t target_p99_latency_micros) {
+  BatchSizeController::Options options;
+  options.target_p99_latency_micros = target_p99_latency_micros;
+  options.batch_sizes = {1, 2, 4, 8};
+  options.max_batch_timeout_micros = 1000;
+  options.num_samples_per_batch_size = 16;
+  options.decision_interval_batches = 8;
+  return options;
+}
+
+// Processing a batch of `batch_size` tasks takes 100us plus 10us per task.
+int64_t ProcessingMicros(int64_t batch_size) { return 100 + 10 * batch_size; }
+
+// Feeds the controller batches of its current batch size until it has made
+// `num_decisions` decisions.
+void RunDecisions(BatchSizeController* controller, int num_decisions,
+                  int64_t queueing_micros = 0) {
+  for (int i = 0; i < num_decisions * 8; ++i) {
+    controller->RecordQueueingDelay(queueing_micros);
+    controller->RecordBatch(controller->batch_size(),
+                            ProcessingMicros(controller->batch_size()));
+  }
+}
+
+TEST(BatchSizeControllerTest, StartsWithStaticConfiguration) {
+  std::unique_ptr<BatchSizeController> controller;
+  TF_ASSERT_OK(BatchSizeController::Create(CreateOptions(1000), &controller));
+  EXPECT_EQ(8, controller->batch_size());
+  EXPECT_EQ(1000, controller->batch_timeout_micros());
+  EXPECT_EQ(-1, controller->estimated_p99_latency_micros());
+}
+
+TEST(BatchSizeControllerTest, PicksLargestBatchSizeThatMeetsTarget) {
+  // A batch of 8 takes 180us, which leaves 820us of the target for waiting.
+  std::unique_ptr<BatchSizeController> controller;
+  TF_ASSERT_OK(BatchSizeController::Create(CreateOptions(1000), &controller));
+  RunDecisions(controller.get(), 4);
+  EXPECT_EQ(8, controller->batch_size());
+  EXPECT_EQ(820, controller->batch_timeout_micros());
+  EXPECT_EQ(1000, controller->estimated_p99_latency_micros());
+}
+
+TEST(BatchSizeControllerTest, StepsDownWhenTargetIsMissed) {
+  // Only batches of 1 (110us) and 2 (120us) meet a 125us target.
+  std::unique_ptr<BatchSizeController> controller;
+  TF_ASSERT_OK(BatchSizeController::Create(CreateOptions(125), &controller));
+  RunDecisions(controller.get(), 1);
+  EXPECT_EQ(4, controller->batch_size());
+  EXPECT_EQ(0, controller->batch_timeout_micros());
+  RunDecisions(controller.get(), 1);
+  EXPECT_EQ(2, controller->batch_size());
+  // Batches of 2 meet the target, and the extrapolated cost of batches of 4
+  // (240us) does not, so the controller stays.
+  RunDecisions(controller.get(), 4);
+  EXPECT_EQ(2, controller->batch_size());
+  EXPECT_EQ(5, controller->batch_timeout_micros());
+}
+
+TEST(BatchSizeControllerTest, ExploresLargerBatchSizes) {
+  std::unique_ptr<BatchSizeController> controller;
+  TF_ASSERT_OK(BatchSizeController::Create(CreateOptions(400), &controller));
+  // Only small batches have been measured so far.
+  for (int64_t batch_size : {1, 2}) {
+    for (int i = 0; i < 8; ++i) {
+      controller->RecordBatch(batch_size, ProcessingMicros(batch_size));
+    }
+  }
+  // The extrapolated cost of batches of 4 (240us) meets the target.
+  EXPECT_EQ(4, controller->batch_size());
+  RunDecisions(controller.get(), 1);
+  // So does the extrapolated cost of batches of 8 (280us).
+  EXPECT_EQ(8, controller->batch_size());
+  RunDecisions(controller.get(), 2);
+  EXPECT_EQ(8, controller->batch_size());
+  EXPECT_EQ(400 - ProcessingMicros(8), controller->batch_timeout_micros());
+}
+
+TEST(BatchSizeControllerTest, AccountsForQueueingBeyondTimeout) {
+  std::unique_ptr<BatchSizeController> controller;
+  TF_ASSERT_OK(BatchSizeController::Create(CreateOptions(1000), &controller));
+  // Batches wait 1500us, i.e. 500us longer than the initial timeout.
+  RunDecisions(controller.get(), 1, /*queueing_micros=*/1500);
+  EXPECT_EQ(8, controller->batch_size());
+  EXPECT_EQ(1000 - 500 - ProcessingMicros(8),
+            controller->batch_timeout_micros());
+}
+
+TEST(BatchSizeControllerTest, InvalidOptions) {
+  std::unique_ptr<BatchSizeController> controller;
+  EXPECT_FALSE(BatchSizeController::Create(CreateOptions(0), &controller).ok());
+  auto options = CreateOptions(1000);
+  options.batch_sizes = {};
+  EXPECT_FALSE(BatchSizeController::Create(options, &controller).ok());
+  options.batch_sizes = {4, 2};
+  EXPECT_FALSE(BatchSizeController::Create(options, &controller).ok());
+  options = CreateOptions(1000);
+  options.decision_interval_batches = 0;
+  EXPECT_FALSE(BatchSizeController::Create(options, &controller).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -29,6 +29,7 @@ limitations under the License.
 #include "absl/types/variant.h"
 #include "tensorflow/core/kernels/batching_util/batch_input_task.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/batch_size_controller.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -243,6 +244,29 @@ class SharedBatchScheduler
     PriorityQueueOptions high_priority_queue_options;
     // A subset of queue options for low priority input.
     PriorityQueueOptions low_priority_queue_options;
+
+    // Options to tune the batch size and batch timeout online instead of
+    // using fixed values.
+    struct AdaptiveBatchSizeOptions {
+      // If positive, the queue measures how long batches of each size take to
+      // process and picks the batch size and timeout that maximize throughput
+      // while keeping the p99 latency below this target; see
+      // batch_size_controller.h.
+      //
+      // The batch size is chosen from `allowed_batch_sizes` if set, and from
+      // the powers of two up to the maximum execution batch size otherwise.
+      // The open batch is scheduled once it reaches that size or waited for
+      // the chosen timeout; batches still grow up to the maximum execution
+      // batch size while all batch threads are busy. `batch_timeout_micros`
+      // bounds the chosen timeout if positive, and the target does otherwise.
+      int64_t target_p99_latency_micros = 0;
+      // See BatchSizeController::Options.
+      int decision_interval_batches = 32;
+      // Labels of the metrics to which the decisions are exported.
+      string model_name;
+      string op_name;
+    };
+    AdaptiveBatchSizeOptions adaptive_batch_size_options;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -335,11 +359,17 @@ class Queue {
       std::vector<std::unique_ptr<TaskType>>* output_tasks)>;
   Queue(const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
         Env* env, ProcessBatchCallback process_batch_callback,
-        SchedulableBatchCallback schedulable_batch_callback);
+        SchedulableBatchCallback schedulable_batch_callback,
+        std::unique_ptr<BatchSizeController> batch_size_controller = nullptr);
 
   // Illegal to destruct unless the queue is empty.
   ~Queue();
 
+  // Creates the controller for `options.adaptive_batch_size_options`.
+  static Status CreateBatchSizeController(
+      const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
+      std::unique_ptr<BatchSizeController>* controller);
+
   // Submits a task to the queue, with the same semantics as
   // BatchScheduler::Schedule().
   Status Schedule(std::unique_ptr<TaskType>* task);
@@ -431,6 +461,17 @@ class Queue {
   bool IsOpenBatchSchedulableAfterEagerSplit() const
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // The size at which the open batch becomes schedulable.
+  size_t schedulable_batch_size() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // How long the open batch may wait for more tasks before it becomes
+  // schedulable.
+  int64_t batch_timeout_micros() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Reports the queueing delay of the front-most batch, which is about to be
+  // scheduled, to `batch_size_controller_`.
+  void RecordScheduledBatch() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Same as SchedulingCapacity(), but assumes the caller already holds a
   // lock on 'mu_'.
   size_t SchedulingCapacityInternal() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -513,6 +554,16 @@ class Queue {
   // task.
   uint64 open_batch_start_time_micros_ TF_GUARDED_BY(mu_);
 
+  // Tunes the batch size and timeout at which the open batch becomes
+  // schedulable, if set.
+  const std::unique_ptr<BatchSizeController> batch_size_controller_
+      TF_PT_GUARDED_BY(mu_);
+
+  // The times at which the first task was added to each closed batch that is
+  // still enqueued, front to back. Only tracked if `batch_size_controller_` is
+  // set.
+  std::deque<uint64> closed_batch_start_times_micros_ TF_GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled.
   // Used to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ TF_GUARDED_BY(mu_) = false;
@@ -663,10 +714,16 @@ Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
     mutex_lock l(mu_);
     schedulable_batch_cv_.notify_one();
   };
+  std::unique_ptr<BatchSizeController> batch_size_controller;
+  if (options.adaptive_batch_size_options.target_p99_latency_micros != 0) {
+    TF_RETURN_IF_ERROR(internal::Queue<TaskType>::CreateBatchSizeController(
+        options, &batch_size_controller));
+  }
+
   auto internal_queue =
       std::unique_ptr<internal::Queue<TaskType>>(new internal::Queue<TaskType>(
           options, options_.env, process_batch_callback,
-          schedulable_batch_callback));
+          schedulable_batch_callback, std::move(batch_size_controller)));
   auto handle = std::unique_ptr<BatchScheduler<TaskType>>(
       new internal::QueueHandle<TaskType>(this->shared_from_this(),
                                           internal_queue.get()));
@@ -802,12 +859,14 @@ template <typename TaskType>
 Queue<TaskType>::Queue(
     const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
     Env* env, ProcessBatchCallback process_batch_callback,
-    SchedulableBatchCallback schedulable_batch_callback)
+    SchedulableBatchCallback schedulable_batch_callback,
+    std::unique_ptr<BatchSizeController> batch_size_controller)
     : options_(options),
       env_(env),
       max_execution_batch_size_(GetMaxExecutionBatchSize(options_)),
       process_batch_callback_(process_batch_callback),
-      schedulable_batch_callback_(schedulable_batch_callback) {
+      schedulable_batch_callback_(schedulable_batch_callback),
+      batch_size_controller_(std::move(batch_size_controller)) {
   // Set the higher 32 bits of traceme_context_id_counter_ to be the creation
   // time of the queue. This prevents the batches in different queues to have
   // the same traceme_context_id_counter_.
@@ -835,6 +894,37 @@ Queue<TaskType>::~Queue() {
   }
 }
 
+template <typename TaskType>
+Status Queue<TaskType>::CreateBatchSizeController(
+    const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
+    std::unique_ptr<BatchSizeController>* controller) {
+  const auto& adaptive_options = options.adaptive_batch_size_options;
+  const int64_t max_batch_size = GetMaxExecutionBatchSize(options);
+  BatchSizeController::Options controller_options;
+  controller_options.target_p99_latency_micros =
+      adaptive_options.target_p99_latency_micros;
+  for (int32 batch_size : options.allowed_batch_sizes) {
+    if (batch_size < max_batch_size) {
+      controller_options.batch_sizes.push_back(batch_size);
+    }
+  }
+  if (options.allowed_batch_sizes.empty()) {
+    for (int64_t batch_size = 1; batch_size < max_batch_size; batch_size *= 2) {
+      controller_options.batch_sizes.push_back(batch_size);
+    }
+  }
+  controller_options.batch_sizes.push_back(max_batch_size);
+  controller_options.max_batch_timeout_micros =
+      options.batch_timeout_micros > 0
+          ? options.batch_timeout_micros
+          : adaptive_options.target_p99_latency_micros;
+  controller_options.decision_interval_batches =
+      adaptive_options.decision_interval_batches;
+  controller_options.model_name = adaptive_options.model_name;
+  controller_options.op_name = adaptive_options.op_name;
+  return BatchSizeController::Create(controller_options, controller);
+}
+
 template <typename TaskType>
 Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
   if ((*task)->size() > options_.input_batch_size_limit) {
@@ -1084,6 +1174,7 @@ Queue<TaskType>::ScheduleBatchWithEagerSplit() {
     if (batches.size() >= 2) {
       // There is at least one closed batch that is ready to be scheduled.
       ++num_batches_being_processed_;
+      RecordScheduledBatch();
       batch_to_schedule = std::move(batches.front());
       batches.pop_front();
     } else {
@@ -1116,6 +1207,7 @@ Queue<TaskType>::ScheduleBatch() {
     if (task_handle_batches_.size() >= 2) {
       // There is at least one closed batch that is ready to be scheduled.
       ++num_batches_being_processed_;
+      RecordScheduledBatch();
       task_handles_to_schedule = std::move(task_handle_batches_.front());
       task_handle_batches_.pop_front();
     } else {
@@ -1136,10 +1228,17 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
       },
       profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
+  const size_t batch_size = batch->size();
+  const uint64 start_time_micros =
+      batch_size_controller_ != nullptr ? env_->NowMicros() : 0;
   process_batch_callback_(std::move(batch));
 
   {
     mutex_lock l(mu_);
+    if (batch_size_controller_ != nullptr) {
+      batch_size_controller_->RecordBatch(
+          batch_size, env_->NowMicros() - start_time_micros);
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -1183,6 +1282,9 @@ bool Queue<TaskType>::IsEmptyInternal() const {
 
 template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
+  if (batch_size_controller_ != nullptr) {
+    closed_batch_start_times_micros_.push_back(open_batch_start_time_micros_);
+  }
   if (options_.enable_lazy_split) {
     task_handle_batches_.back()->Close();
     task_handle_batches_.emplace_back(new Batch<BatchInputTaskHandle<TaskType>>(
@@ -1211,9 +1313,9 @@ bool Queue<TaskType>::IsOpenBatchSchedulableAfterEagerSplit() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= max_execution_batch_size() ||
+  return closed_ || open_batch->size() >= schedulable_batch_size() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + batch_timeout_micros();
 }
 
 template <typename TaskType>
@@ -1226,9 +1328,34 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= max_execution_batch_size() ||
+  return closed_ || open_batch->size() >= schedulable_batch_size() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + batch_timeout_micros();
+}
+
+template <typename TaskType>
+size_t Queue<TaskType>::schedulable_batch_size() const {
+  if (batch_size_controller_ != nullptr) {
+    return batch_size_controller_->batch_size();
+  }
+  return max_execution_batch_size();
+}
+
+template <typename TaskType>
+int64_t Queue<TaskType>::batch_timeout_micros() const {
+  if (batch_size_controller_ != nullptr) {
+    return batch_size_controller_->batch_timeout_micros();
+  }
+  return options_.batch_timeout_micros;
+}
+
+template <typename TaskType>
+void Queue<TaskType>::RecordScheduledBatch() {
+  if (batch_size_controller_ == nullptr) return;
+  DCHECK(!closed_batch_start_times_micros_.empty());
+  batch_size_controller_->RecordQueueingDelay(
+      env_->NowMicros() - closed_batch_start_times_micros_.front());
+  closed_batch_start_times_micros_.pop_front();
 }
 
 template <typename TaskType>
@@ -758,6 +758,76 @@ TEST_P(SharedBatchSchedulerTest, InvalidLazySplitOptions) {
                         "enable_large_batch_splitting is enabled."));
 }
 
+TEST_P(SharedBatchSchedulerTest, AdaptiveBatchSizeMeetsLatencyTarget) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<size_t> processed_batch_sizes;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      // Every batch takes twice the latency target.
+      env.AdvanceByMicroseconds(2000);
+      mutex_lock l(mu);
+      processed_batch_sizes.push_back(batch->size());
+    };
+    auto num_processed_batches = [&]() {
+      mutex_lock l(mu);
+      return processed_batch_sizes.size();
+    };
+
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+    const size_t max_batch_size = 4;
+    const size_t batch_timeout_micros = 1000 * 1000;  // 1 second
+    const size_t max_enqueued_batches = 16;
+    QueueOptions options =
+        CreateQueueOptions(max_batch_size, max_batch_size,
+                           batch_timeout_micros, max_enqueued_batches);
+    options.adaptive_batch_size_options.target_p99_latency_micros = 1000;
+    options.adaptive_batch_size_options.decision_interval_batches = 8;
+    auto queue = CreateQueue(scheduler, options, callback);
+
+    // Full batches miss the target.
+    for (int i = 0; i < 8; ++i) {
+      TF_ASSERT_OK(ScheduleTask(max_batch_size, queue.get()));
+    }
+    while (num_processed_batches() < 8) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+
+    // So the controller picks smaller batches and gives up on the timeout, and
+    // a single task is processed without waiting for the fake clock.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    while (num_processed_batches() < 9) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    {
+      mutex_lock l(mu);
+      EXPECT_EQ(1, processed_batch_sizes.back());
+    }
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+TEST_P(SharedBatchSchedulerTest, InvalidAdaptiveBatchSizeOptions) {
+  auto callback = [](std::unique_ptr<Batch<FakeTask>> batch) {
+    // do nothing.
+  };
+
+  auto scheduler = CreateSharedBatchScheduler(2);
+
+  QueueOptions options = CreateQueueOptions(10, 10, 100, 2);
+  options.adaptive_batch_size_options.target_p99_latency_micros = -1;
+  std::unique_ptr<Queue> queue;
+  EXPECT_THAT(scheduler->AddQueue(options, callback, &queue),
+              testing::StatusIs(error::INVALID_ARGUMENT,
+                                HasSubstr("target_p99_latency_micros")));
+}
+
 // Tests that queue configured with zero `max_enqueued_batches` get one queue.
 // Note, technically an invalid-argument error should be returned.
 // Since existing models (with very low QPS) rely on the rewrite, retain the
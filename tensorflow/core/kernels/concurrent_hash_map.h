@@ -0,0 +1,376 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_CONCURRENT_HASH_MAP_H_
+#define TENSORFLOW_CORE_KERNELS_CONCURRENT_HASH_MAP_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// Returns whether a ConcurrentHashMap can map `K` to `V`.
+template <typename K, typename V>
+constexpr bool IsConcurrentHashMapSupported() {
+  if constexpr (std::is_integral_v<K> && std::is_arithmetic_v<V>) {
+    return std::atomic<K>::is_always_lock_free &&
+           std::atomic<V>::is_always_lock_free;
+  } else {
+    return false;
+  }
+}
+
+// A hash map from integral keys to arithmetic values for read-mostly use by
+// many threads.
+//
+// Lookups take no lock and write no shared memory. The map is an
+// open-addressing table with linear probing, guarded by a sequence lock:
+// writers serialize on a mutex and make the sequence number odd while they
+// modify the table, and a reader retries its lookups if the sequence number
+// was odd or changed while it read. A reader that keeps failing, e.g. because
+// of a long insertion, takes the writer mutex instead, so lookups always make
+// progress.
+//
+// Growing the table publishes a new slot array. Readers may still be probing
+// the old array, so retired arrays are only freed when the map is destroyed.
+// Since the capacity doubles on every growth, they take at most as much memory
+// as the current array. Clearing the map reuses the current array.
+//
+// Lookups of a batch of keys compute the hashes of a group of keys first and
+// prefetch their home slots, so that the cache misses of a group overlap.
+template <typename K, typename V>
+class ConcurrentHashMap {
+ public:
+  static_assert(IsConcurrentHashMapSupported<K, V>(),
+                "Unsupported key or value type");
+
+  ConcurrentHashMap() {
+    auto slots = std::make_unique<Slots>(kMinCapacity);
+    slots_.store(slots.get(), std::memory_order_release);
+    all_slots_.push_back(std::move(slots));
+  }
+
+  ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+  ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  // Returns the number of slots of the current array.
+  size_t capacity() const {
+    return slots_.load(std::memory_order_acquire)->capacity;
+  }
+
+  // Returns the memory taken by all slot arrays, including retired ones.
+  size_t MemoryUsed() const {
+    mutex_lock l(mu_);
+    size_t bytes = sizeof(*this);
+    for (const auto& slots : all_slots_) {
+      bytes += sizeof(Slots) + slots->capacity * sizeof(Slot);
+    }
+    return bytes;
+  }
+
+  // Sets `values[i]` to the value of `keys[i]`, or to `defaults[i]` if the key
+  // is missing. If `per_key_defaults` is false, `defaults[0]` is the default
+  // value of all keys.
+  void Find(const K* keys, int64_t num_keys, const V* defaults,
+            bool per_key_defaults, V* values) const {
+    for (int64_t start = 0; start < num_keys; start += kGroupSize) {
+      const int64_t end = std::min(num_keys, start + kGroupSize);
+      int attempt = 0;
+      while (!TryFindGroup(keys, start, end, defaults, per_key_defaults,
+                           values)) {
+        if (++attempt >= kMaxOptimisticAttempts) {
+          // Writers keep interfering. Exclude them.
+          mutex_lock l(mu_);
+          FindGroup(*slots_.load(std::memory_order_relaxed), keys, start, end,
+                    defaults, per_key_defaults, values);
+          break;
+        }
+      }
+    }
+  }
+
+  // Inserts the given key-value pairs, replacing the values of keys that are
+  // already present.
+  void InsertOrAssign(const K* keys, const V* values, int64_t num_keys) {
+    mutex_lock l(mu_);
+    for (int64_t i = 0; i < num_keys; ++i) {
+      MaybeGrow();
+      WriteSection section(&sequence_);
+      InsertOrAssignLocked(keys[i], values[i]);
+    }
+  }
+
+  // Removes the given keys. Missing keys are ignored.
+  void Erase(const K* keys, int64_t num_keys) {
+    mutex_lock l(mu_);
+    Slots& slots = *slots_.load(std::memory_order_relaxed);
+    for (int64_t i = 0; i < num_keys; ++i) {
+      const int64_t index = FindIndex(slots, keys[i]);
+      if (index < 0) continue;
+      WriteSection section(&sequence_);
+      slots.slots[index].state.store(kDeleted, std::memory_order_relaxed);
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      ++num_deleted_;
+    }
+  }
+
+  // Removes all keys.
+  void Clear() {
+    mutex_lock l(mu_);
+    Slots& slots = *slots_.load(std::memory_order_relaxed);
+    WriteSection section(&sequence_);
+    for (size_t i = 0; i < slots.capacity; ++i) {
+      slots.slots[i].state.store(kEmpty, std::memory_order_relaxed);
+    }
+    size_.store(0, std::memory_order_relaxed);
+    num_deleted_ = 0;
+  }
+
+  // Calls `fn(key, value)` for every key, with writers excluded.
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    mutex_lock l(mu_);
+    ForEachLocked(*slots_.load(std::memory_order_relaxed), fn);
+  }
+
+ private:
+  static constexpr uint8_t kEmpty = 0;
+  static constexpr uint8_t kFull = 1;
+  static constexpr uint8_t kDeleted = 2;
+
+  static constexpr size_t kMinCapacity = 16;
+  static constexpr int64_t kGroupSize = 16;
+  static constexpr int kMaxOptimisticAttempts = 8;
+
+  // The fields are atomic so that readers may race with writers; the
+  // sequence lock tells readers whether what they read is consistent.
+  struct Slot {
+    std::atomic<uint8_t> state{kEmpty};
+    std::atomic<K> key{};
+    std::atomic<V> value{};
+  };
+
+  struct Slots {
+    explicit Slots(size_t capacity)
+        : capacity(capacity), mask(capacity - 1), slots(new Slot[capacity]) {
+      DCHECK_EQ(capacity & mask, 0) << "Capacity must be a power of two";
+    }
+    const size_t capacity;
+    const size_t mask;
+    const std::unique_ptr<Slot[]> slots;
+  };
+
+  // Makes the sequence number odd for the lifetime of the object.
+  class WriteSection {
+   public:
+    explicit WriteSection(std::atomic<uint64_t>* sequence)
+        : sequence_(sequence) {
+      sequence_->store(sequence_->load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+      // Orders the odd sequence number before the writes to the slots.
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+    ~WriteSection() {
+      sequence_->store(sequence_->load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+    }
+
+   private:
+    std::atomic<uint64_t>* const sequence_;
+  };
+
+  // Mixes the bits of `key`, since integer keys are often sequential and
+  // linear probing needs them spread out.
+  static uint64_t Hash(K key) {
+    uint64_t x = static_cast<uint64_t>(key);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  // Returns the index of the slot that holds `key` in `slots`, or -1. Safe to
+  // call concurrently with writers as long as `slots` stays alive, although
+  // the result is then only meaningful if the sequence number did not change.
+  static int64_t FindIndex(const Slots& slots, K key, uint64_t hash) {
+    size_t index = hash & slots.mask;
+    for (size_t probes = 0; probes < slots.capacity; ++probes) {
+      const Slot& slot = slots.slots[index];
+      const uint8_t state = slot.state.load(std::memory_order_relaxed);
+      if (state == kEmpty) return -1;
+      if (state == kFull && slot.key.load(std::memory_order_relaxed) == key) {
+        return index;
+      }
+      index = (index + 1) & slots.mask;
+    }
+    return -1;
+  }
+
+  static int64_t FindIndex(const Slots& slots, K key) {
+    return FindIndex(slots, key, Hash(key));
+  }
+
+  // Looks up `keys[start:end]` in `slots` without checking for writers.
+  static void FindGroup(const Slots& slots, const K* keys, int64_t start,
+                        int64_t end, const V* defaults, bool per_key_defaults,
+                        V* values) {
+    uint64_t hashes[kGroupSize];
+    for (int64_t i = start; i < end; ++i) {
+      hashes[i - start] = Hash(keys[i]);
+      port::prefetch<port::PREFETCH_HINT_T0>(
+          &slots.slots[hashes[i - start] & slots.mask]);
+    }
+    for (int64_t i = start; i < end; ++i) {
+      const int64_t index = FindIndex(slots, keys[i], hashes[i - start]);
+      values[i] =
+          index >= 0
+              ? slots.slots[index].value.load(std::memory_order_relaxed)
+              : defaults[per_key_defaults ? i : 0];
+    }
+  }
+
+  // Looks up `keys[start:end]` optimistically. Returns false if a writer
+  // interfered, in which case `values[start:end]` must be discarded.
+  bool TryFindGroup(const K* keys, int64_t start, int64_t end,
+                    const V* defaults, bool per_key_defaults,
+                    V* values) const {
+    const uint64_t sequence = sequence_.load(std::memory_order_acquire);
+    if (sequence & 1) return false;
+    FindGroup(*slots_.load(std::memory_order_acquire), keys, start, end,
+              defaults, per_key_defaults, values);
+    // Orders the reads of the slots before the re-read of the sequence
+    // number.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence_.load(std::memory_order_relaxed) == sequence;
+  }
+
+  void InsertOrAssignLocked(K key, V value) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Slots& slots = *slots_.load(std::memory_order_relaxed);
+    size_t index = Hash(key) & slots.mask;
+    int64_t first_deleted = -1;
+    for (size_t probes = 0; probes < slots.capacity; ++probes) {
+      Slot& slot = slots.slots[index];
+      const uint8_t state = slot.state.load(std::memory_order_relaxed);
+      if (state == kFull && slot.key.load(std::memory_order_relaxed) == key) {
+        slot.value.store(value, std::memory_order_relaxed);
+        return;
+      }
+      if (state == kDeleted && first_deleted < 0) first_deleted = index;
+      if (state == kEmpty) break;
+      index = (index + 1) & slots.mask;
+    }
+    // MaybeGrow() keeps an empty slot around, so the probe ends before it
+    // wraps around.
+    if (first_deleted >= 0) {
+      index = first_deleted;
+      --num_deleted_;
+    }
+    Slot& slot = slots.slots[index];
+    slot.key.store(key, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.state.store(kFull, std::memory_order_relaxed);
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Makes room for one more key, keeping the load factor, including deleted
+  // slots, at most 3/4.
+  void MaybeGrow() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Slots& old_slots = *slots_.load(std::memory_order_relaxed);
+    const size_t size = size_.load(std::memory_order_relaxed);
+    if (4 * (size + num_deleted_ + 1) <= 3 * old_slots.capacity) return;
+    if (4 * (size + 1) <= 3 * old_slots.capacity / 2) {
+      // Dropping the deleted slots makes enough room. Rehash in place, so
+      // that churn does not retire arrays.
+      std::vector<std::pair<K, V>> entries;
+      entries.reserve(size);
+      ForEachLocked(old_slots, [&entries](K key, V value) {
+        entries.emplace_back(key, value);
+      });
+      WriteSection section(&sequence_);
+      for (size_t i = 0; i < old_slots.capacity; ++i) {
+        old_slots.slots[i].state.store(kEmpty, std::memory_order_relaxed);
+      }
+      for (const auto& [key, value] : entries) {
+        AddNew(old_slots, key, value);
+      }
+      num_deleted_ = 0;
+      return;
+    }
+    auto new_slots = std::make_unique<Slots>(2 * old_slots.capacity);
+    ForEachLocked(old_slots, [&new_slots](K key, V value) {
+      AddNew(*new_slots, key, value);
+    });
+    num_deleted_ = 0;
+    // The new array is complete before it is published, so readers need not
+    // be excluded: the release store makes its contents visible to readers
+    // that load the pointer, and readers that still probe the old array see
+    // the same keys.
+    slots_.store(new_slots.get(), std::memory_order_release);
+    all_slots_.push_back(std::move(new_slots));
+  }
+
+  // Adds `key`, which must not be in `slots`, to an empty slot.
+  static void AddNew(Slots& slots, K key, V value) {
+    size_t index = Hash(key) & slots.mask;
+    while (slots.slots[index].state.load(std::memory_order_relaxed) !=
+           kEmpty) {
+      index = (index + 1) & slots.mask;
+    }
+    Slot& slot = slots.slots[index];
+    slot.key.store(key, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.state.store(kFull, std::memory_order_relaxed);
+  }
+
+  template <typename Fn>
+  static void ForEachLocked(const Slots& slots, Fn fn) {
+    for (size_t i = 0; i < slots.capacity; ++i) {
+      const Slot& slot = slots.slots[i];
+      if (slot.state.load(std::memory_order_relaxed) == kFull) {
+        fn(slot.key.load(std::memory_order_relaxed),
+           slot.value.load(std::memory_order_relaxed));
+      }
+    }
+  }
+
+  mutable mutex mu_;
+  // Odd while a writer modifies the current slot array.
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<Slots*> slots_{nullptr};
+  std::atomic<size_t> size_{0};
+  size_t num_deleted_ TF_GUARDED_BY(mu_) = 0;
+  // Owns the current and all retired slot arrays.
+  std::vector<std::unique_ptr<Slots>> all_slots_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CONCURRENT_HASH_MAP_H_
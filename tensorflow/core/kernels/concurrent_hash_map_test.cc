@@ -0,0 +1,249 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/concurrent_hash_map.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+std::map<int64_t, float> Contents(const ConcurrentHashMap<int64_t, float>& m) {
+  std::map<int64_t, float> contents;
+  m.ForEach([&contents](int64_t key, float value) { contents[key] = value; });
+  return contents;
+}
+
+TEST(ConcurrentHashMapTest, InsertFindEraseClear) {
+  ConcurrentHashMap<int64_t, float> m;
+  const std::vector<int64_t> keys = {1, -2, 30};
+  const std::vector<float> values = {0.5, 1.5, 2.5};
+  m.InsertOrAssign(keys.data(), values.data(), keys.size());
+  EXPECT_EQ(3, m.size());
+
+  const std::vector<int64_t> queries = {30, 4, 1, -2};
+  std::vector<float> found(queries.size());
+  const float default_value = -1;
+  m.Find(queries.data(), queries.size(), &default_value,
+         /*per_key_defaults=*/false, found.data());
+  EXPECT_EQ(std::vector<float>({2.5, -1, 0.5, 1.5}), found);
+
+  const std::vector<float> defaults = {10, 11, 12, 13};
+  const int64_t removed = -2;
+  m.Erase(&removed, 1);
+  EXPECT_EQ(2, m.size());
+  m.Find(queries.data(), queries.size(), defaults.data(),
+         /*per_key_defaults=*/true, found.data());
+  EXPECT_EQ(std::vector<float>({2.5, 11, 0.5, 13}), found);
+
+  // Inserting an existing key replaces its value.
+  const float new_value = 7;
+  m.InsertOrAssign(&keys[0], &new_value, 1);
+  EXPECT_EQ((std::map<int64_t, float>{{1, 7}, {30, 2.5}}), Contents(m));
+
+  m.Clear();
+  EXPECT_EQ(0, m.size());
+  EXPECT_TRUE(Contents(m).empty());
+}
+
+TEST(ConcurrentHashMapTest, GrowsAndReusesDeletedSlots) {
+  ConcurrentHashMap<int32, int64_t> m;
+  const size_t initial_capacity = m.capacity();
+  std::vector<int32> keys(1000);
+  std::vector<int64_t> values(keys.size());
+  for (int i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+    values[i] = 2 * i;
+  }
+  m.InsertOrAssign(keys.data(), values.data(), keys.size());
+  EXPECT_EQ(1000, m.size());
+  EXPECT_GT(m.capacity(), initial_capacity);
+
+  std::vector<int64_t> found(keys.size());
+  const int64_t default_value = -1;
+  m.Find(keys.data(), keys.size(), &default_value, false, found.data());
+  EXPECT_EQ(values, found);
+
+  // Churn through many more keys than the table holds at a time. Deleted
+  // slots are reclaimed instead of growing the table.
+  const size_t capacity = m.capacity();
+  const size_t memory_used = m.MemoryUsed();
+  for (int32 round = 1; round <= 20; ++round) {
+    m.Erase(keys.data(), keys.size());
+    for (int32& key : keys) key += 1000;
+    m.InsertOrAssign(keys.data(), values.data(), keys.size());
+  }
+  EXPECT_EQ(1000, m.size());
+  EXPECT_EQ(capacity, m.capacity());
+  EXPECT_EQ(memory_used, m.MemoryUsed());
+  m.Find(keys.data(), keys.size(), &default_value, false, found.data());
+  EXPECT_EQ(values, found);
+}
+
+TEST(ConcurrentHashMapTest, ConcurrentReadersAndWriter) {
+  constexpr int kNumReaders = 4;
+  constexpr int64_t kNumKeys = 1 << 14;
+  ConcurrentHashMap<int64_t, int64_t> m;
+  std::atomic<bool> done(false);
+  std::atomic<int64_t> num_inconsistent(0);
+  {
+    std::vector<std::unique_ptr<Thread>> readers;
+    for (int r = 0; r < kNumReaders; ++r) {
+      readers.emplace_back(Env::Default()->StartThread({}, "reader", [&, r]() {
+        std::vector<int64_t> keys(64);
+        std::vector<int64_t> found(keys.size());
+        const int64_t default_value = -1;
+        int64_t next = r;
+        while (!done.load()) {
+          for (int64_t& key : keys) key = (next++ * 7919) % kNumKeys;
+          m.Find(keys.data(), keys.size(), &default_value, false,
+                 found.data());
+          // Every value that is present is consistent with its key.
+          for (int i = 0; i < keys.size(); ++i) {
+            if (found[i] != -1 && found[i] != 3 * keys[i]) ++num_inconsistent;
+          }
+        }
+      }));
+    }
+    for (int64_t key = 0; key < kNumKeys; ++key) {
+      const int64_t value = 3 * key;
+      m.InsertOrAssign(&key, &value, 1);
+      if (key % 3 == 0) m.Erase(&key, 1);
+    }
+    done = true;
+  }
+  EXPECT_EQ(0, num_inconsistent);
+  EXPECT_EQ(kNumKeys - (kNumKeys + 2) / 3, m.size());
+}
+
+// The container that `MutableHashTableOfScalars` uses by default.
+class LockedUnorderedMap {
+ public:
+  void Insert(const std::vector<int64_t>& keys,
+              const std::vector<int64_t>& values) {
+    mutex_lock l(mu_);
+    for (int i = 0; i < keys.size(); ++i) map_[keys[i]] = values[i];
+  }
+
+  void Find(const int64_t* keys, int64_t num_keys, int64_t default_value,
+            int64_t* values) const {
+    tf_shared_lock l(mu_);
+    for (int64_t i = 0; i < num_keys; ++i) {
+      auto it = map_.find(keys[i]);
+      values[i] = it == map_.end() ? default_value : it->second;
+    }
+  }
+
+ private:
+  mutable mutex mu_;
+  std::unordered_map<int64_t, int64_t> map_ TF_GUARDED_BY(mu_);
+};
+
+// Looks up batches of random keys in a table with `state.range(0)` keys from
+// every benchmark thread, which is how many inference threads use one
+// vocabulary table.
+constexpr int64_t kBatchSize = 256;
+
+std::vector<int64_t> BenchmarkKeys(int64_t num_keys) {
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; ++i) keys[i] = i * 0x9E3779B97F4A7C15ULL;
+  return keys;
+}
+
+std::vector<int64_t> BenchmarkQueries(const std::vector<int64_t>& keys,
+                                      int thread_index) {
+  std::vector<int64_t> queries(1 << 16);
+  uint64_t x = thread_index + 1;
+  for (int64_t& query : queries) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    query = keys[(x >> 33) % keys.size()];
+  }
+  return queries;
+}
+
+void BM_ConcurrentHashMapFind(::testing::benchmark::State& state) {
+  static ConcurrentHashMap<int64_t, int64_t>* m = nullptr;
+  const std::vector<int64_t> keys = BenchmarkKeys(state.range(0));
+  if (state.thread_index() == 0) {
+    m = new ConcurrentHashMap<int64_t, int64_t>();
+    m->InsertOrAssign(keys.data(), keys.data(), keys.size());
+  }
+  const std::vector<int64_t> queries =
+      BenchmarkQueries(keys, state.thread_index());
+  std::vector<int64_t> values(kBatchSize);
+  const int64_t default_value = -1;
+  int64_t offset = 0;
+  for (auto s : state) {
+    m->Find(queries.data() + offset, kBatchSize, &default_value, false,
+            values.data());
+    offset = (offset + kBatchSize) % queries.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  if (state.thread_index() == 0) {
+    delete m;
+    m = nullptr;
+  }
+}
+
+void BM_LockedUnorderedMapFind(::testing::benchmark::State& state) {
+  static LockedUnorderedMap* m = nullptr;
+  const std::vector<int64_t> keys = BenchmarkKeys(state.range(0));
+  if (state.thread_index() == 0) {
+    m = new LockedUnorderedMap();
+    m->Insert(keys, keys);
+  }
+  const std::vector<int64_t> queries =
+      BenchmarkQueries(keys, state.thread_index());
+  std::vector<int64_t> values(kBatchSize);
+  int64_t offset = 0;
+  for (auto s : state) {
+    m->Find(queries.data() + offset, kBatchSize, -1, values.data());
+    offset = (offset + kBatchSize) % queries.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  if (state.thread_index() == 0) {
+    delete m;
+    m = nullptr;
+  }
+}
+
+BENCHMARK(BM_ConcurrentHashMapFind)
+    ->UseRealTime()
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->Threads(1)
+    ->Threads(16)
+    ->Threads(64);
+BENCHMARK(BM_LockedUnorderedMapFind)
+    ->UseRealTime()
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->Threads(1)
+    ->Threads(16)
+    ->Threads(64);
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
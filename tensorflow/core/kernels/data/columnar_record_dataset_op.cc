@@ -0,0 +1,395 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/columnar_record_dataset_op.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/columnar_record_file.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/utils.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+
+namespace tensorflow {
+namespace data {
+
+// See documentation in ../../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+/* static */ constexpr const char* const ColumnarRecordDatasetOp::kDatasetType;
+/* static */ constexpr const char* const ColumnarRecordDatasetOp::kFileNames;
+/* static */ constexpr const char* const ColumnarRecordDatasetOp::kColumns;
+/* static */ constexpr const char* const ColumnarRecordDatasetOp::kBatchSize;
+/* static */ constexpr const char* const
+    ColumnarRecordDatasetOp::kDropRemainder;
+/* static */ constexpr const char* const ColumnarRecordDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const
+    ColumnarRecordDatasetOp::kOutputShapes;
+
+constexpr char kCurrentFileIndex[] = "current_file_index";
+constexpr char kRecordIndex[] = "record_index";
+
+class ColumnarRecordDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+          std::vector<string> columns, int64_t batch_size, bool drop_remainder,
+          const DataTypeVector& output_types,
+          const std::vector<PartialTensorShape>& output_shapes)
+      : DatasetBase(DatasetContext(ctx)),
+        filenames_(std::move(filenames)),
+        columns_(std::move(columns)),
+        batch_size_(batch_size),
+        drop_remainder_(drop_remainder),
+        output_types_(output_types),
+        output_shapes_(output_shapes) {}
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return std::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return output_types_;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    return OkStatus();
+  }
+
+  Status CheckExternalState() const override { return OkStatus(); }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* filenames = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+    Node* columns = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(columns_, &columns));
+    Node* batch_size = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size));
+    Node* drop_remainder = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {filenames, columns, batch_size, drop_remainder}, output));
+    return OkStatus();
+  }
+
+ private:
+  // Reads whole column chunks of the projected columns and cuts them into
+  // batches.
+  //
+  // Only the chunks of the columns named in `columns` are read, so the cost of
+  // reading a file is proportional to the size of the projected columns. A
+  // batch that lies within a single row group is a slice of the chunk tensors,
+  // which in turn may alias the memory-mapped file, so in the common case where
+  // the batch size divides the row group size no bytes are copied.
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    bool SymbolicCheckpointCompatible() const override { return true; }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      const int num_columns = dataset()->columns_.size();
+      // The slices of the chunks that make up each column of the batch.
+      std::vector<std::vector<Tensor>> pieces(num_columns);
+      int64_t num_records = 0;
+      while (num_records < dataset()->batch_size_) {
+        if (!reader_) {
+          // Iteration ends when there are no more files to process.
+          if (current_file_index_ == dataset()->filenames_.size()) break;
+          TF_RETURN_IF_ERROR(SetupReaderLocked(ctx->env()));
+        }
+        if (row_group_ == reader_->num_row_groups()) {
+          ResetReaderLocked();
+          ++current_file_index_;
+          continue;
+        }
+        if (chunks_.empty()) {
+          Status s = ReadChunksLocked();
+          if (!s.ok()) {
+            // Move on to the next file so that the same file does not repeat
+            // when errors are ignored. The records already collected for this
+            // batch, and the rest of the file, are dropped: the iterator is
+            // left at the start of the next file, as if the batch had been
+            // produced, which is also what a checkpoint saves.
+            ResetReaderLocked();
+            ++current_file_index_;
+            return s;
+          }
+        }
+        const int64_t row_group_size = chunks_[0].dim_size(0);
+        const int64_t n = std::min(dataset()->batch_size_ - num_records,
+                                   row_group_size - row_offset_);
+        for (int i = 0; i < num_columns; ++i) {
+          pieces[i].push_back(chunks_[i].Slice(row_offset_, row_offset_ + n));
+        }
+        num_records += n;
+        row_offset_ += n;
+        if (row_offset_ == row_group_size) {
+          ++row_group_;
+          row_offset_ = 0;
+          chunks_.clear();
+        }
+      }
+
+      if (num_records == 0 ||
+          (dataset()->drop_remainder_ &&
+           num_records < dataset()->batch_size_)) {
+        *end_of_sequence = true;
+        return OkStatus();
+      }
+      out_tensors->reserve(num_columns);
+      for (int i = 0; i < num_columns; ++i) {
+        if (pieces[i].size() == 1 && pieces[i][0].IsAligned()) {
+          out_tensors->push_back(std::move(pieces[i][0]));
+          continue;
+        }
+        TensorShape shape = pieces[i][0].shape();
+        shape.set_dim(0, num_records);
+        out_tensors->emplace_back(ctx->allocator({}), pieces[i][0].dtype(),
+                                  shape);
+        char* dst = const_cast<char*>(out_tensors->back().tensor_data().data());
+        for (const Tensor& piece : pieces[i]) {
+          const StringPiece src = piece.tensor_data();
+          std::memcpy(dst, src.data(), src.size());
+          dst += src.size();
+        }
+      }
+      *end_of_sequence = false;
+      return OkStatus();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeSourceNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kCurrentFileIndex,
+                                             current_file_index_));
+      if (reader_) {
+        int64_t record_index = row_offset_;
+        for (int i = 0; i < row_group_; ++i) {
+          record_index += reader_->footer().row_groups(i).num_records();
+        }
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(prefix(), kRecordIndex, record_index));
+      }
+      return OkStatus();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      ResetReaderLocked();
+      int64_t current_file_index;
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(prefix(), kCurrentFileIndex, &current_file_index));
+      current_file_index_ = size_t(current_file_index);
+      if (reader->Contains(prefix(), kRecordIndex)) {
+        int64_t record_index;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(prefix(), kRecordIndex, &record_index));
+        TF_RETURN_IF_ERROR(SetupReaderLocked(ctx->env()));
+        if (record_index < 0 || record_index > reader_->num_records()) {
+          return errors::DataLoss("Invalid record index ", record_index,
+                                  " for ",
+                                  dataset()->filenames_[current_file_index_]);
+        }
+        while (row_group_ < reader_->num_row_groups() &&
+               record_index >=
+                   reader_->footer().row_groups(row_group_).num_records()) {
+          record_index -=
+              reader_->footer().row_groups(row_group_).num_records();
+          ++row_group_;
+        }
+        row_offset_ = record_index;
+      }
+      return OkStatus();
+    }
+
+   private:
+    // Opens the file at `current_file_index_` and resolves the projected
+    // columns.
+    Status SetupReaderLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (current_file_index_ >= dataset()->filenames_.size()) {
+        return errors::InvalidArgument(
+            "current_file_index_:", current_file_index_,
+            " >= filenames_.size():", dataset()->filenames_.size());
+      }
+      const string& filename = dataset()->filenames_[current_file_index_];
+      std::unique_ptr<ColumnarRecordReader> reader;
+      TF_RETURN_IF_ERROR(ColumnarRecordReader::Open(
+          env, TranslateFileName(filename), &reader));
+      std::vector<int> column_indices;
+      column_indices.reserve(dataset()->columns_.size());
+      for (int i = 0; i < dataset()->columns_.size(); ++i) {
+        const string& name = dataset()->columns_[i];
+        const int index = reader->ColumnIndex(name);
+        if (index < 0) {
+          return errors::InvalidArgument("Columnar record file ", filename,
+                                         " has no column named ", name);
+        }
+        const ColumnarRecordColumn& column = reader->footer().columns(index);
+        PartialTensorShape shape({-1});
+        shape = shape.Concatenate(PartialTensorShape(column.shape()));
+        if (column.dtype() != dataset()->output_types_[i] ||
+            !shape.IsCompatibleWith(dataset()->output_shapes_[i])) {
+          return errors::InvalidArgument(
+              "Column ", name, " of ", filename, " has type ",
+              DataTypeString(column.dtype()), " and shape ",
+              PartialTensorShape(column.shape()).DebugString(),
+              ", which does not match the expected type ",
+              DataTypeString(dataset()->output_types_[i]),
+              " and batched shape ",
+              dataset()->output_shapes_[i].DebugString());
+        }
+        column_indices.push_back(index);
+      }
+      reader_ = std::move(reader);
+      column_indices_ = std::move(column_indices);
+      row_group_ = 0;
+      row_offset_ = 0;
+      return OkStatus();
+    }
+
+    // Reads the projected chunks of `row_group_`.
+    Status ReadChunksLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      static monitoring::CounterCell* bytes_counter =
+          metrics::GetTFDataBytesReadCounter(kDatasetType);
+      std::vector<Tensor> chunks(column_indices_.size());
+      for (int i = 0; i < column_indices_.size(); ++i) {
+        int64_t bytes_read = 0;
+        TF_RETURN_IF_ERROR(reader_->ReadChunk(row_group_, column_indices_[i],
+                                              &chunks[i], &bytes_read));
+        bytes_counter->IncrementBy(bytes_read);
+      }
+      chunks_ = std::move(chunks);
+      return OkStatus();
+    }
+
+    void ResetReaderLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      chunks_.clear();
+      column_indices_.clear();
+      reader_.reset();
+      row_group_ = 0;
+      row_offset_ = 0;
+    }
+
+    mutex mu_;
+    size_t current_file_index_ TF_GUARDED_BY(mu_) = 0;
+    std::unique_ptr<ColumnarRecordReader> reader_ TF_GUARDED_BY(mu_);
+    // Index in the file of each projected column.
+    std::vector<int> column_indices_ TF_GUARDED_BY(mu_);
+    // Position of the next record to produce.
+    int row_group_ TF_GUARDED_BY(mu_) = 0;
+    int64_t row_offset_ TF_GUARDED_BY(mu_) = 0;
+    // The projected chunks of `row_group_`, or empty if not read yet.
+    std::vector<Tensor> chunks_ TF_GUARDED_BY(mu_);
+  };
+
+  const std::vector<string> filenames_;
+  const std::vector<string> columns_;
+  const int64_t batch_size_;
+  const bool drop_remainder_;
+  const DataTypeVector output_types_;
+  const std::vector<PartialTensorShape> output_shapes_;
+};
+
+ColumnarRecordDatasetOp::ColumnarRecordDatasetOp(OpKernelConstruction* ctx)
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
+}
+
+void ColumnarRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                          DatasetBase** output) {
+  const Tensor* filenames_tensor;
+  OP_REQUIRES_OK(ctx, ctx->input(kFileNames, &filenames_tensor));
+  OP_REQUIRES(
+      ctx, filenames_tensor->dims() <= 1,
+      errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+  std::vector<string> filenames;
+  filenames.reserve(filenames_tensor->NumElements());
+  for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+    VLOG(2) << "Reading file: " << filenames_tensor->flat<tstring>()(i);
+    filenames.push_back(filenames_tensor->flat<tstring>()(i));
+    metrics::RecordTFDataFilename(kDatasetType, filenames[i]);
+  }
+
+  const Tensor* columns_tensor;
+  OP_REQUIRES_OK(ctx, ctx->input(kColumns, &columns_tensor));
+  OP_REQUIRES(ctx, columns_tensor->dims() == 1,
+              errors::InvalidArgument("`columns` must be a vector."));
+  std::vector<string> columns;
+  columns.reserve(columns_tensor->NumElements());
+  for (int i = 0; i < columns_tensor->NumElements(); ++i) {
+    columns.push_back(columns_tensor->flat<tstring>()(i));
+  }
+  OP_REQUIRES(ctx, columns.size() == output_types_.size(),
+              errors::InvalidArgument(
+                  "Expected one output type per column, but got ",
+                  columns.size(), " columns and ", output_types_.size(),
+                  " output types."));
+  for (const PartialTensorShape& shape : output_shapes_) {
+    OP_REQUIRES(ctx, shape.dims() >= 1,
+                errors::InvalidArgument(
+                    "`output_shapes` must have a leading batch dimension."));
+  }
+
+  int64_t batch_size = 0;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64_t>(ctx, kBatchSize, &batch_size));
+  OP_REQUIRES(ctx, batch_size > 0,
+              errors::InvalidArgument("`batch_size` must be > 0"));
+  bool drop_remainder = false;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<bool>(ctx, kDropRemainder, &drop_remainder));
+
+  *output = new Dataset(ctx, std::move(filenames), std::move(columns),
+                        batch_size, drop_remainder, output_types_,
+                        output_shapes_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(Name("ColumnarRecordDataset").Device(DEVICE_CPU),
+                        ColumnarRecordDatasetOp);
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
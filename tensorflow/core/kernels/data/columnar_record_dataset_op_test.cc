@@ -0,0 +1,286 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/columnar_record_dataset_op.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/columnar_record_file.h"
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kNodeName[] = "columnar_record_dataset";
+
+class ColumnarRecordDatasetParams : public DatasetParams {
+ public:
+  ColumnarRecordDatasetParams(std::vector<tstring> filenames,
+                              std::vector<tstring> columns, int64_t batch_size,
+                              bool drop_remainder, DataTypeVector output_dtypes,
+                              std::vector<PartialTensorShape> output_shapes,
+                              string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        filenames_(std::move(filenames)),
+        columns_(std::move(columns)),
+        batch_size_(batch_size),
+        drop_remainder_(drop_remainder) {}
+
+  std::vector<Tensor> GetInputTensors() const override {
+    int num_files = filenames_.size();
+    int num_columns = columns_.size();
+    return {CreateTensor<tstring>(TensorShape({num_files}), filenames_),
+            CreateTensor<tstring>(TensorShape({num_columns}), columns_),
+            CreateTensor<int64_t>(TensorShape({}), {batch_size_}),
+            CreateTensor<bool>(TensorShape({}), {drop_remainder_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {
+        ColumnarRecordDatasetOp::kFileNames,
+        ColumnarRecordDatasetOp::kColumns,
+        ColumnarRecordDatasetOp::kBatchSize,
+        ColumnarRecordDatasetOp::kDropRemainder,
+    };
+    return OkStatus();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{ColumnarRecordDatasetOp::kOutputTypes, output_dtypes_},
+                    {ColumnarRecordDatasetOp::kOutputShapes, output_shapes_},
+                    {"metadata", ""}};
+    return OkStatus();
+  }
+
+  string dataset_type() const override {
+    return ColumnarRecordDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<tstring> filenames_;
+  std::vector<tstring> columns_;
+  int64_t batch_size_;
+  bool drop_remainder_;
+};
+
+class ColumnarRecordDatasetOpTest : public DatasetOpsTestBase {};
+
+// Writes records 0..4 to the first file and 5..7 to the second one, in row
+// groups of 2 records. Record `i` has an int64 column "id" with value `i` and a
+// float column "values" with value `[i, 10 * i]`.
+std::vector<tstring> CreateTestFiles() {
+  std::vector<tstring> filenames = {
+      absl::StrCat(testing::TmpDir(), "/columnar_record_1"),
+      absl::StrCat(testing::TmpDir(), "/columnar_record_2")};
+  ColumnarRecordWriter::Options options;
+  options.compression = kColumnarRecordSnappy;
+  options.row_group_size = 2;
+  int64_t id = 0;
+  for (int i = 0; i < filenames.size(); ++i) {
+    std::unique_ptr<ColumnarRecordWriter> writer;
+    TF_CHECK_OK(ColumnarRecordWriter::Create(
+        Env::Default(), filenames[i],
+        {{"id", DT_INT64, TensorShape({})},
+         {"values", DT_FLOAT, TensorShape({2})}},
+        options, &writer));
+    for (int64_t end = i == 0 ? 5 : 8; id < end; ++id) {
+      TF_CHECK_OK(writer->Write(
+          {CreateTensor<int64_t>(TensorShape({}), {id}),
+           CreateTensor<float>(TensorShape({2}), {1.0f * id, 10.0f * id})}));
+    }
+    TF_CHECK_OK(writer->Close());
+  }
+  return filenames;
+}
+
+// Test case 1: batches that span row groups and files.
+ColumnarRecordDatasetParams ColumnarRecordDatasetParams1() {
+  return ColumnarRecordDatasetParams(
+      CreateTestFiles(), /*columns=*/{"id", "values"}, /*batch_size=*/2,
+      /*drop_remainder=*/false,
+      /*output_dtypes=*/{DT_INT64, DT_FLOAT},
+      /*output_shapes=*/{PartialTensorShape({-1}), PartialTensorShape({-1, 2})},
+      /*node_name=*/kNodeName);
+}
+
+// Test case 2: projection of a single column, dropping the last batch.
+ColumnarRecordDatasetParams ColumnarRecordDatasetParams2() {
+  return ColumnarRecordDatasetParams(
+      CreateTestFiles(), /*columns=*/{"values"}, /*batch_size=*/3,
+      /*drop_remainder=*/true,
+      /*output_dtypes=*/{DT_FLOAT},
+      /*output_shapes=*/{PartialTensorShape({3, 2})},
+      /*node_name=*/kNodeName);
+}
+
+// Test case 3: a partial last batch.
+ColumnarRecordDatasetParams ColumnarRecordDatasetParams3() {
+  return ColumnarRecordDatasetParams(
+      CreateTestFiles(), /*columns=*/{"id"}, /*batch_size=*/3,
+      /*drop_remainder=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+ColumnarRecordDatasetParams MissingColumnParams() {
+  return ColumnarRecordDatasetParams(
+      CreateTestFiles(), /*columns=*/{"labels"}, /*batch_size=*/3,
+      /*drop_remainder=*/false,
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+ColumnarRecordDatasetParams MismatchedTypeParams() {
+  return ColumnarRecordDatasetParams(
+      CreateTestFiles(), /*columns=*/{"id"}, /*batch_size=*/3,
+      /*drop_remainder=*/false,
+      /*output_dtypes=*/{DT_INT32},
+      /*output_shapes=*/{PartialTensorShape({-1})},
+      /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> Ids(std::vector<int64_t> ids) {
+  const int64_t n = ids.size();
+  return {CreateTensor<int64_t>(TensorShape({n}), ids)};
+}
+
+std::vector<Tensor> Values(std::vector<int64_t> ids) {
+  const int64_t n = ids.size();
+  std::vector<float> values;
+  for (int64_t id : ids) {
+    values.push_back(1.0f * id);
+    values.push_back(10.0f * id);
+  }
+  return {CreateTensor<float>(TensorShape({n, 2}), values)};
+}
+
+std::vector<Tensor> IdsAndValues(std::vector<int64_t> ids) {
+  std::vector<Tensor> result = Ids(ids);
+  result.push_back(Values(ids)[0]);
+  return result;
+}
+
+std::vector<Tensor> Flatten(std::vector<std::vector<Tensor>> batches) {
+  std::vector<Tensor> result;
+  for (std::vector<Tensor>& batch : batches) {
+    for (Tensor& tensor : batch) result.push_back(std::move(tensor));
+  }
+  return result;
+}
+
+std::vector<GetNextTestCase<ColumnarRecordDatasetParams>> GetNextTestCases() {
+  return {{/*dataset_params=*/ColumnarRecordDatasetParams1(),
+           /*expected_outputs=*/
+           Flatten({IdsAndValues({0, 1}), IdsAndValues({2, 3}),
+                    IdsAndValues({4, 5}), IdsAndValues({6, 7})})},
+          {/*dataset_params=*/ColumnarRecordDatasetParams2(),
+           /*expected_outputs=*/
+           Flatten({Values({0, 1, 2}), Values({3, 4, 5})})},
+          {/*dataset_params=*/ColumnarRecordDatasetParams3(),
+           /*expected_outputs=*/
+           Flatten({Ids({0, 1, 2}), Ids({3, 4, 5}), Ids({6, 7})})}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(ColumnarRecordDatasetOpTest,
+                         ColumnarRecordDatasetParams, GetNextTestCases())
+
+TEST_F(ColumnarRecordDatasetOpTest, DatasetNodeName) {
+  auto dataset_params = ColumnarRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+}
+
+TEST_F(ColumnarRecordDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = ColumnarRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(ColumnarRecordDatasetOp::kDatasetType)));
+}
+
+TEST_F(ColumnarRecordDatasetOpTest, DatasetOutputDtypes) {
+  auto dataset_params = ColumnarRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputDtypes({DT_INT64, DT_FLOAT}));
+}
+
+TEST_F(ColumnarRecordDatasetOpTest, DatasetOutputShapes) {
+  auto dataset_params = ColumnarRecordDatasetParams2();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes({PartialTensorShape({3, 2})}));
+}
+
+TEST_F(ColumnarRecordDatasetOpTest, Cardinality) {
+  auto dataset_params = ColumnarRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(kUnknownCardinality));
+}
+
+TEST_F(ColumnarRecordDatasetOpTest, IteratorPrefix) {
+  auto dataset_params = ColumnarRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorPrefix(
+      name_utils::IteratorPrefix(ColumnarRecordDatasetOp::kDatasetType,
+                                 dataset_params.iterator_prefix())));
+}
+
+TEST_F(ColumnarRecordDatasetOpTest, MissingColumn) {
+  auto dataset_params = MissingColumnParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(ColumnarRecordDatasetOpTest, MismatchedType) {
+  auto dataset_params = MismatchedTypeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      absl::StatusCode::kInvalidArgument);
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<ColumnarRecordDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/ColumnarRecordDatasetParams1(),
+           /*breakpoints=*/{0, 2, 5},
+           /*expected_outputs=*/
+           Flatten({IdsAndValues({0, 1}), IdsAndValues({2, 3}),
+                    IdsAndValues({4, 5}), IdsAndValues({6, 7})})},
+          {/*dataset_params=*/ColumnarRecordDatasetParams3(),
+           /*breakpoints=*/{0, 1, 4},
+           /*expected_outputs=*/
+           Flatten({Ids({0, 1, 2}), Ids({3, 4, 5}), Ids({6, 7})})}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(ColumnarRecordDatasetOpTest,
+                                 ColumnarRecordDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
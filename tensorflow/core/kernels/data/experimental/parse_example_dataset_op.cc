@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <deque>
 
 #include "tensorflow/core/common_runtime/device.h"
@@ -33,6 +34,7 @@ namespace data {
 namespace experimental {
 namespace {
 
+constexpr char kParseExampleAndBatchDataset[] = "ParseExampleAndBatchDataset";
 constexpr char kInvocationResults[] = "invocation_results";
 constexpr char kSizeSuffix[] = ".size";
 constexpr char kEndOfInputSuffix[] = ".end_of_input";
@@ -45,11 +47,13 @@ constexpr int kStatsReportingPeriodMillis = 1000;
 class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
  public:
   static constexpr const char* const kDatasetType = "ParseExample";
+  static constexpr const char* const kFusedDatasetType = "ParseExampleAndBatch";
 
   explicit ParseExampleDatasetOp(OpKernelConstruction* ctx)
       : UnaryDatasetOpKernel(ctx),
         graph_def_version_(ctx->graph_def_version()),
-        op_version_(ctx->HasAttr("deterministic") ? 2 : 1) {
+        op_version_(ctx->HasAttr("deterministic") ? 2 : 1),
+        fused_batch_(ctx->def().op() == kParseExampleAndBatchDataset) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("sparse_keys", &sparse_keys_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_keys", &dense_keys_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("sparse_types", &sparse_types_));
@@ -118,6 +122,18 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
  protected:
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
+    // A batch size of zero means that the input elements are already batches.
+    int64_t batch_size = 0;
+    bool drop_remainder = false;
+    if (fused_batch_) {
+      OP_REQUIRES_OK(ctx,
+                     ParseScalarArgument(ctx, "batch_size", &batch_size));
+      OP_REQUIRES(ctx, batch_size > 0,
+                  errors::InvalidArgument("batch_size must be greater than "
+                                          "zero."));
+      OP_REQUIRES_OK(
+          ctx, ParseScalarArgument(ctx, "drop_remainder", &drop_remainder));
+    }
     int64_t num_parallel_calls = 0;
     OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_calls",
                                             &num_parallel_calls));
@@ -203,7 +219,8 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
         std::move(key_to_output_index), std::move(config), num_parallel_calls,
         sparse_types_, dense_types_, dense_shapes_, output_types_,
         output_shapes_, deterministic_, has_ragged_keys_, ragged_keys_,
-        ragged_value_types_, ragged_split_types_, op_version_);
+        ragged_value_types_, ragged_split_types_, op_version_, batch_size,
+        drop_remainder);
   }
 
  private:
@@ -222,7 +239,8 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
             const DeterminismPolicy& deterministic, bool has_ragged_keys,
             std::vector<string> ragged_keys,
             const DataTypeVector& ragged_value_types,
-            const DataTypeVector& ragged_split_types, int op_version)
+            const DataTypeVector& ragged_split_types, int op_version,
+            int64_t batch_size, bool drop_remainder)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           dense_defaults_(std::move(dense_defaults)),
@@ -241,7 +259,9 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
           output_shapes_(output_shapes),
           deterministic_(deterministic),
           has_ragged_keys_(has_ragged_keys),
-          op_version_(op_version) {
+          op_version_(op_version),
+          batch_size_(batch_size),
+          drop_remainder_(drop_remainder) {
       input_->Ref();
     }
 
@@ -252,7 +272,7 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
       name_utils::IteratorPrefixParams params;
       params.op_version = op_version_;
       return std::make_unique<Iterator>(Iterator::Params{
-          this, name_utils::IteratorPrefix(kDatasetType, prefix, params)});
+          this, name_utils::IteratorPrefix(DatasetType(), prefix, params)});
     }
 
     const DataTypeVector& output_dtypes() const override {
@@ -266,11 +286,20 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
     string DebugString() const override {
       name_utils::DatasetDebugStringParams params;
       params.op_version = op_version_;
-      return name_utils::DatasetDebugString(kDatasetType, params);
+      if (batch_size_ > 0) {
+        params.set_args(batch_size_);
+      }
+      return name_utils::DatasetDebugString(DatasetType(), params);
     }
 
     int64_t CardinalityInternal(CardinalityOptions options) const override {
-      return input_->Cardinality(options);
+      int64_t n = input_->Cardinality(options);
+      if (batch_size_ == 0 || n == kInfiniteCardinality ||
+          n == kUnknownCardinality) {
+        return n;
+      }
+      return n / batch_size_ +
+             (n % batch_size_ == 0 || drop_remainder_ ? 0 : 1);
     }
 
     Status InputDatasets(
@@ -290,6 +319,13 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
       Node* input_graph_node = nullptr;
       TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
 
+      Node* batch_size_node = nullptr;
+      Node* drop_remainder_node = nullptr;
+      if (batch_size_ > 0) {
+        TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size_node));
+        TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder_node));
+      }
+
       Node* num_parallel_calls_node;
       std::vector<Node*> dense_defaults_nodes;
       dense_defaults_nodes.reserve(dense_defaults_.size());
@@ -350,6 +386,18 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
         attrs.emplace_back("ragged_split_types", ragged_split_types_attr);
       }
 
+      if (batch_size_ > 0) {
+        TF_RETURN_IF_ERROR(b->AddDataset(this,
+                                         {
+                                             {0, input_graph_node},
+                                             {1, batch_size_node},
+                                             {2, drop_remainder_node},
+                                             {3, num_parallel_calls_node},
+                                         },
+                                         {{4, dense_defaults_nodes}}, attrs,
+                                         output));
+        return OkStatus();
+      }
       TF_RETURN_IF_ERROR(b->AddDataset(this,
                                        {
                                            {0, input_graph_node},
@@ -422,7 +470,7 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
           IteratorContext* ctx, model::Node::Args args) const override {
         return model::MakeAsyncKnownRatioNode(
             std::move(args),
-            /*ratio=*/1,
+            /*ratio=*/std::max<int64_t>(dataset()->batch_size_, 1),
             {model::MakeParameter("parallelism", num_parallel_calls_, /*min=*/1,
                                   /*max=*/ctx->runner_threadpool_size())});
       }
@@ -585,10 +633,16 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
           return profiler::TraceMeEncode("ParseExampleProduce",
                                          {{"element_id", result->id}});
         });
-        // Get the next input element.
+        // Get the next input element, or the serialized examples of the next
+        // batch.
         std::vector<Tensor> input_element;
-        result->status = input_impl_->GetNext(ctx.get(), &input_element,
-                                              &result->end_of_input);
+        if (dataset()->batch_size_ > 0) {
+          result->status = GetNextInputBatch(ctx.get(), &input_element,
+                                             &result->end_of_input);
+        } else {
+          result->status = input_impl_->GetNext(ctx.get(), &input_element,
+                                                &result->end_of_input);
+        }
         if (result->end_of_input || !result->status.ok()) {
           CallCompleted(ctx, result);
           return;
@@ -626,6 +680,39 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
         RecordStart(ctx.get());
       }
 
+      // Reads up to `batch_size` scalar strings from the input. They are parsed
+      // together, so that `FastParseExample` writes the examples straight into
+      // the batched output tensors instead of into per-example tensors that a
+      // separate batching stage would copy again.
+      Status GetNextInputBatch(IteratorContext* ctx,
+                               std::vector<Tensor>* batch, bool* end_of_input) {
+        const int64_t batch_size = dataset()->batch_size_;
+        batch->reserve(batch_size);
+        for (int64_t i = 0; i < batch_size; ++i) {
+          std::vector<Tensor> element;
+          bool end_of_sequence = false;
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &element, &end_of_sequence));
+          if (end_of_sequence) break;
+          if (element.size() != 1 || element[0].dtype() != DT_STRING ||
+              !TensorShapeUtils::IsScalar(element[0].shape())) {
+            return errors::InvalidArgument(
+                kParseExampleAndBatchDataset,
+                " expects an input dataset of scalar strings, but got an "
+                "element with types ",
+                DataTypeVectorString(dataset()->input_->output_dtypes()),
+                " and shapes ",
+                PartialTensorShapeUtils::PartialShapeListString(
+                    dataset()->input_->output_shapes()));
+          }
+          batch->push_back(std::move(element[0]));
+        }
+        *end_of_input =
+            batch->empty() ||
+            (dataset()->drop_remainder_ && batch->size() < batch_size);
+        return OkStatus();
+      }
+
       Status CheckOutputTensor(const Tensor& tensor, size_t value_index,
                                size_t output_index) const {
         if (tensor.dtype() != dataset()->output_dtypes()[output_index]) {
@@ -650,13 +737,25 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
                           std::vector<Tensor>* output) {
         thread::ThreadPool* device_threadpool =
             ctx->flr()->device()->tensorflow_cpu_worker_threads()->workers;
-        std::vector<tstring> slice_vec;
-        for (const Tensor& t : input) {
-          auto serialized_t = t.flat<tstring>();
-          gtl::ArraySlice<tstring> slice(serialized_t.data(),
-                                         serialized_t.size());
-          for (auto it = slice.begin(); it != slice.end(); it++)
-            slice_vec.push_back(*it);
+        // The serialized examples are only read during parsing, so they are
+        // passed as views into `input` rather than copied.
+        gtl::ArraySlice<tstring> serialized;
+        std::vector<tstring> serialized_views;
+        if (input.size() == 1) {
+          serialized = gtl::ArraySlice<tstring>(input[0].flat<tstring>().data(),
+                                                input[0].NumElements());
+        } else {
+          int64_t num_serialized = 0;
+          for (const Tensor& t : input) num_serialized += t.NumElements();
+          serialized_views.resize(num_serialized);
+          int64_t i = 0;
+          for (const Tensor& t : input) {
+            const auto serialized_t = t.flat<tstring>();
+            for (int64_t j = 0; j < serialized_t.size(); ++j) {
+              serialized_views[i++].assign_as_view(serialized_t(j));
+            }
+          }
+          serialized = serialized_views;
         }
         example::FastParseExampleConfig config = dataset()->config_;
         // local copy of config_ for modification.
@@ -666,7 +765,7 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
         }
         example::Result example_result;
         TF_RETURN_IF_ERROR(FastParseExample(
-            config, slice_vec, {}, device_threadpool, &example_result));
+            config, serialized, {}, device_threadpool, &example_result));
         (*output).resize(dataset()->key_to_output_index_.size());
         for (int d = 0; d < dataset()->dense_keys_.size(); ++d) {
           int output_index =
@@ -934,6 +1033,12 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
     const DeterminismPolicy deterministic_;
     const bool has_ragged_keys_;
     const int op_version_;
+    const int64_t batch_size_;
+    const bool drop_remainder_;
+
+    const char* DatasetType() const {
+      return batch_size_ > 0 ? kFusedDatasetType : kDatasetType;
+    }
   };
 
   const int graph_def_version_;
@@ -952,6 +1057,9 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
   std::vector<std::size_t> elements_per_stride_;
   bool has_ragged_keys_;
   const int op_version_;
+  // Whether this is a `ParseExampleAndBatchDataset`, which batches scalar
+  // serialized examples and parses each batch at once.
+  const bool fused_batch_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ParseExampleDataset").Device(DEVICE_CPU),
@@ -961,6 +1069,8 @@ REGISTER_KERNEL_BUILDER(Name("ParseExampleDatasetV2").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(
     Name("ExperimentalParseExampleDataset").Device(DEVICE_CPU),
     ParseExampleDatasetOp);
+REGISTER_KERNEL_BUILDER(Name(kParseExampleAndBatchDataset).Device(DEVICE_CPU),
+                        ParseExampleDatasetOp);
 
 }  // namespace
 }  // namespace experimental
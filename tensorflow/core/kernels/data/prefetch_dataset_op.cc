@@ -17,7 +17,9 @@ limitations under the License.
 #include <algorithm>
 #include <deque>
 #include <limits>
+#include <optional>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/prefetch_autotuner.h"
+#include "tensorflow/core/kernels/data/prefetch_ring_buffer.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -62,19 +65,22 @@ constexpr char kStatus[] = "status";
 constexpr char kSizeSuffix[] = ".size";
 constexpr char kCodeSuffix[] = ".code";
 constexpr char kErrorMessageSuffix[] = ".error_message";
+constexpr char kRingBufferExperiment[] = "prefetch_ring_buffer";
 
 }  // namespace
 
 class PrefetchDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64_t buffer_size,
-          int64_t slack_period, bool legacy_autotune, int64_t buffer_size_min)
+          int64_t slack_period, bool legacy_autotune, int64_t buffer_size_min,
+          bool use_ring_buffer)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
         slack_period_(slack_period),
         legacy_autotune_(legacy_autotune),
-        buffer_size_min_(buffer_size_min) {
+        buffer_size_min_(buffer_size_min),
+        use_ring_buffer_(use_ring_buffer) {
     input_->Ref();
   }
 
@@ -156,6 +162,15 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
               legacy_autotune_ ? 0 : params.dataset->buffer_size_, mu_,
               cond_var_)) {
       slack_us_ = 0;
+      // The ring buffer has a fixed capacity, so it is only used if the
+      // buffer size is neither autotuned nor zero. Slack injection needs
+      // to look at the buffer from the prefetch thread and is not supported.
+      if (params.dataset->use_ring_buffer_ &&
+          params.dataset->buffer_size_ > 0 &&
+          params.dataset->slack_period_ == 0) {
+        ring_buffer_ = std::make_unique<MpmcRingBuffer<BufferElement>>(
+            params.dataset->buffer_size_);
+      }
     }
 
     ~Iterator() override {
@@ -194,6 +209,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (ring_buffer_) {
+        return GetNextFromRingBuffer(ctx, out_tensors, end_of_sequence);
+      }
       const auto& stats_aggregator = ctx->stats_aggregator();
       {
         mutex_lock l(*mu_);
@@ -265,6 +283,17 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       // all GetNext threads are blocked.
       mutex_lock input_l(input_mu_);
       mutex_lock l(*mu_);
+      if (ring_buffer_) {
+        // Holding `input_mu_` keeps the prefetch thread from adding elements,
+        // so the ring can be drained into `buffer_`, saved like the regular
+        // buffer and refilled afterwards.
+        while (std::optional<BufferElement> buffer_element =
+                   ring_buffer_->TryPop()) {
+          buffer_.push_back(std::move(*buffer_element));
+        }
+      }
+      auto refill_ring_buffer = gtl::MakeCleanup(
+          [this]() TF_NO_THREAD_SAFETY_ANALYSIS { MoveBufferToRingBuffer(); });
       TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(prefix(), kBufferSize, buffer_.size()));
@@ -296,6 +325,13 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       if (!ctx->symbolic_checkpoint()) {
         TF_RETURN_IF_ERROR(RestoreBuffer(ctx, reader));
       }
+      if (ring_buffer_ && buffer_.size() > ring_buffer_->capacity()) {
+        return errors::FailedPrecondition(
+            "The checkpoint holds ", buffer_.size(),
+            " prefetched elements, which exceeds the buffer size ",
+            ring_buffer_->capacity());
+      }
+      MoveBufferToRingBuffer();
 
       if (ctx->warm_start()) {
         TF_RETURN_IF_ERROR(EnsureThreadsStarted(ctx));
@@ -311,7 +347,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       // right away to avoid introducing tracing overhead.
       if (mu_->try_lock()) {
         limit = buffer_limit();
-        size = buffer_.size();
+        size = ring_buffer_ ? ring_buffer_->size() : buffer_.size();
         if (!buffer_.empty()) {
           std::vector<std::string> shapes(buffer_.front().value.size());
           for (const auto& component : buffer_.front().value) {
@@ -408,6 +444,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       mutex_lock l(*mu_);
       cancelled_ = true;
       cond_var_->notify_all();
+      if (ring_buffer_) ring_buffer_->Close();
     }
 
     Status Consume(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
@@ -489,12 +526,81 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       if (!prefetch_thread_) {
         std::shared_ptr<IteratorContext> new_ctx =
             std::make_shared<IteratorContext>(*ctx);
-        prefetch_thread_ = ctx->StartThread(
-            "tf_data_prefetch", [this, new_ctx]() { PrefetchThread(new_ctx); });
+        if (ring_buffer_) {
+          prefetch_thread_ =
+              ctx->StartThread("tf_data_prefetch", [this, new_ctx]() {
+                RingBufferPrefetchThread(new_ctx);
+              });
+        } else {
+          prefetch_thread_ = ctx->StartThread(
+              "tf_data_prefetch",
+              [this, new_ctx]() { PrefetchThread(new_ctx); });
+        }
+        threads_started_.store(true, std::memory_order_release);
       }
       return OkStatus();
     }
 
+    // Like `GetNextInternal()`, but takes the element from `ring_buffer_`
+    // without acquiring `mu_`.
+    Status GetNextFromRingBuffer(IteratorContext* ctx,
+                                 std::vector<Tensor>* out_tensors,
+                                 bool* end_of_sequence)
+        TF_LOCKS_EXCLUDED(*mu_) {
+      if (!threads_started_.load(std::memory_order_acquire)) {
+        mutex_lock l(*mu_);
+        TF_RETURN_IF_ERROR(EnsureThreadsStarted(ctx));
+      }
+      std::optional<BufferElement> buffer_element = ring_buffer_->TryPop();
+      if (!buffer_element.has_value()) {
+        RecordStop(ctx);
+        if (std::optional<BufferElement> popped = ring_buffer_->Pop()) {
+          buffer_element.emplace(std::move(*popped));
+        }
+        RecordStart(ctx);
+      }
+      // The ring is only closed once the input is exhausted or the iterator is
+      // cancelled.
+      if (!buffer_element.has_value()) {
+        *end_of_sequence = true;
+        return OkStatus();
+      }
+      if (const auto& stats_aggregator = ctx->stats_aggregator()) {
+        stats_aggregator->AddScalar(
+            stats_utils::BufferSizeScalarName(dataset()->node_name()),
+            static_cast<float>(ring_buffer_->size()), num_elements());
+      }
+      *end_of_sequence = false;
+      if (!buffer_element->status.ok()) {
+        RecordBufferDequeue(ctx, buffer_element->value);
+        return buffer_element->status;
+      }
+      profiler::TraceMe traceme(
+          [&] {
+            return profiler::TraceMeEncode(
+                "PrefetchConsume", {{"element_id", buffer_element->uid}});
+          },
+          profiler::kInfo);
+      *out_tensors = std::move(buffer_element->value);
+      ctx->MergeCheckpoint(&buffer_element->checkpoint);
+      RecordBufferDequeue(ctx, *out_tensors);
+      return OkStatus();
+    }
+
+    // Moves the elements of `buffer_` to `ring_buffer_`, if it is used.
+    void MoveBufferToRingBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      if (!ring_buffer_) return;
+      while (!buffer_.empty()) {
+        // The ring has room for all of `buffer_`, so this only fails while a
+        // consumer is still releasing the slot it popped, which is about to
+        // happen.
+        while (!ring_buffer_->TryPush(std::move(buffer_.front()))) {
+          std::this_thread::yield();
+        }
+        buffer_.pop_front();
+      }
+    }
+
     // Prefetches elements of the input, storing results in an internal buffer.
     //
     // It owns the iterator context passed to it.
@@ -566,6 +672,66 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Like `PrefetchThread()`, but stores elements in `ring_buffer_`.
+    void RingBufferPrefetchThread(const std::shared_ptr<IteratorContext>& ctx) {
+      RecordStart(ctx.get());
+      auto cleanup = gtl::MakeCleanup([this, ctx] { RecordStop(ctx.get()); });
+      auto wait_for_space = [this, &ctx]() {
+        if (ring_buffer_->size() < ring_buffer_->capacity()) {
+          return !ring_buffer_->closed();
+        }
+        RecordStop(ctx.get());
+        const bool has_space = ring_buffer_->WaitForSpace();
+        RecordStart(ctx.get());
+        return has_space;
+      };
+      auto finish = [this]() {
+        mutex_lock l(*mu_);
+        prefetch_thread_finished_ = true;
+      };
+      while (true) {
+        // 1. Wait for a slot in the buffer. The ring is only closed here if the
+        // iterator is cancelled.
+        if (!wait_for_space()) {
+          finish();
+          return;
+        }
+
+        // 2. Read the next element. As in `PrefetchThread()`, `input_mu_` is
+        // held until the element is in the buffer.
+        mutex_lock input_l(input_mu_);
+        bool end_of_sequence = false;
+        BufferElement buffer_element(ctx.get());
+        {
+          profiler::TraceMe traceme(
+              [&] {
+                return profiler::TraceMeEncode(
+                    "PrefetchProduce", {{"element_id", buffer_element.uid}});
+              },
+              profiler::kInfo);
+          buffer_element.status = input_impl_->GetNext(
+              ctx.get(), &buffer_element.value, &end_of_sequence);
+          buffer_element.checkpoint.Merge(ctx->checkpoint());
+        }
+        if (buffer_element.status.ok() && end_of_sequence) {
+          finish();
+          ring_buffer_->Close();
+          return;
+        }
+
+        // 3. Publish the element.
+        RecordBufferEnqueue(ctx.get(), buffer_element.value);
+        buffer_element.created_us = EnvTime::NowMicros();
+        while (!ring_buffer_->TryPush(std::move(buffer_element))) {
+          if (!ring_buffer_->WaitForSpace()) {
+            RecordBufferDequeue(ctx.get(), buffer_element.value);
+            finish();
+            return;
+          }
+        }
+      }
+    }
+
     Status WriteStatus(IteratorStateWriter* writer, size_t index,
                        const Status& status) TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       TF_RETURN_IF_ERROR(
@@ -621,6 +787,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     const int64_t buffer_size_min_;
     std::unique_ptr<PrefetchAutotuner> auto_tuner_ TF_GUARDED_BY(*mu_);
     std::deque<BufferElement> buffer_ TF_GUARDED_BY(*mu_);
+    // If set, holds the prefetched elements instead of `buffer_`, which is
+    // then only used while saving and restoring.
+    std::unique_ptr<MpmcRingBuffer<BufferElement>> ring_buffer_;
+    std::atomic<bool> threads_started_{false};
     bool cancelled_ TF_GUARDED_BY(*mu_) = false;
     bool prefetch_thread_finished_ TF_GUARDED_BY(*mu_) = false;
     const bool legacy_autotune_;
@@ -655,6 +825,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
   // parameter.
   const int64_t buffer_size_min_ = 0;
 
+  // Determines whether the prefetched elements are kept in a lock-free ring
+  // buffer. Only applies to fixed buffer sizes.
+  const bool use_ring_buffer_ = false;
+
   TraceMeMetadata traceme_metadata_;
 };
 
@@ -673,6 +847,7 @@ PrefetchDatasetOp::PrefetchDatasetOp(OpKernelConstruction* ctx)
     legacy_autotune_ = false;
     buffer_size_min_ = std::max(static_cast<int64_t>(1), buffer_size_min_);
   }
+  use_ring_buffer_ = GetExperiments().contains(kRingBufferExperiment);
 }
 
 void PrefetchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -690,7 +865,7 @@ void PrefetchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   }
 
   *output = new Dataset(ctx, input, buffer_size, slack_period_,
-                        legacy_autotune_, buffer_size_min_);
+                        legacy_autotune_, buffer_size_min_, use_ring_buffer_);
 }
 
 namespace {
@@ -0,0 +1,265 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_PREFETCH_RING_BUFFER_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_PREFETCH_RING_BUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace data {
+
+// A bounded multi-producer multi-consumer queue.
+//
+// Pushing and popping are lock-free: each slot of the ring carries a sequence
+// number that tells producers and consumers whose turn it is, and producers
+// and consumers claim slots by advancing their own position with a
+// compare-and-swap (this is Dmitry Vyukov's bounded MPMC queue).
+//
+// A thread only takes a lock when it has to block, i.e. when a consumer finds
+// the ring empty or a producer finds it full. Such a thread registers itself
+// as a waiter before re-checking the ring and parking on a condition variable,
+// and the other side only touches the lock if it sees a registered waiter, so
+// in steady state neither side makes a system call.
+//
+// Once the ring is closed, blocking operations no longer wait: `Pop()` returns
+// the remaining items and then `std::nullopt`, and `Push()` fails if the ring
+// is full.
+template <typename T>
+class MpmcRingBuffer {
+ public:
+  explicit MpmcRingBuffer(size_t capacity)
+      : capacity_(capacity),
+        num_slots_(std::max<size_t>(capacity, 2)),
+        slots_(new Slot[num_slots_]) {
+    DCHECK_GT(capacity, 0);
+    for (size_t i = 0; i < num_slots_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  // Returns the number of queued items. The result is exact only if no other
+  // thread is concurrently pushing or popping.
+  size_t size() const {
+    const size_t tail = tail_.position.load(std::memory_order_acquire);
+    const size_t head = head_.position.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+  // Adds `item` to the ring if there is room, even if the ring is closed.
+  // Returns false, leaving `item` untouched, if the ring is full.
+  bool TryPush(T&& item) {
+    if (!TryPushInternal(std::move(item))) return false;
+    // Pairs with the fence in `Pop()`: either the consumer sees the new item,
+    // or this thread sees that the consumer is waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_waiting_consumers_.load(std::memory_order_relaxed) > 0) {
+      mutex_lock l(mu_);
+      not_empty_.notify_all();
+    }
+    return true;
+  }
+
+  // Removes the oldest item from the ring. Returns std::nullopt if the ring is
+  // empty.
+  std::optional<T> TryPop() {
+    std::optional<T> item = TryPopInternal();
+    if (!item.has_value()) return item;
+    // Pairs with the fence in `WaitForSpace()`.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_waiting_producers_.load(std::memory_order_relaxed) > 0) {
+      mutex_lock l(mu_);
+      not_full_.notify_all();
+    }
+    return item;
+  }
+
+  // Adds `item` to the ring, blocking while the ring is full. Returns false if
+  // the ring is closed while it is full.
+  bool Push(T item) {
+    // Another producer may take the slot freed for this one, in which case
+    // keep waiting.
+    while (!TryPush(std::move(item))) {
+      if (!WaitForSpace()) return false;
+    }
+    return true;
+  }
+
+  // Removes the oldest item from the ring, blocking while the ring is empty.
+  // Returns std::nullopt once the ring is closed and empty.
+  std::optional<T> Pop() {
+    if (std::optional<T> item = TryPop()) return item;
+    mutex_lock l(mu_);
+    num_waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+    while (true) {
+      // Pairs with the fence in `TryPush()`.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      std::optional<T> item = TryPopInternal();
+      if (item.has_value() || closed()) {
+        num_waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        if (item.has_value()) {
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          if (num_waiting_producers_.load(std::memory_order_relaxed) > 0) {
+            not_full_.notify_all();
+          }
+        }
+        return item;
+      }
+      not_empty_.wait(l);
+    }
+  }
+
+  // Blocks until the ring has room for at least one item and the slot at its
+  // tail has been released by the consumer of the previous lap. Returns false
+  // if the ring is closed first.
+  bool WaitForSpace() {
+    if (closed()) return false;
+    if (HasSpace()) return true;
+    mutex_lock l(mu_);
+    num_waiting_producers_.fetch_add(1, std::memory_order_seq_cst);
+    bool has_space;
+    while (true) {
+      // Pairs with the fence in `TryPop()`.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      has_space = HasSpace();
+      if (has_space || closed()) break;
+      not_full_.wait(l);
+    }
+    num_waiting_producers_.fetch_sub(1, std::memory_order_relaxed);
+    return has_space && !closed();
+  }
+
+  // Wakes up all blocked threads and makes blocking operations return instead
+  // of waiting.
+  void Close() {
+    mutex_lock l(mu_);
+    closed_.store(true, std::memory_order_release);
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  struct alignas(kCacheLineSize) Slot {
+    std::atomic<size_t> sequence;
+    std::optional<T> value;
+  };
+
+  // Padded to a cache line so that producers and consumers do not
+  // false-share.
+  struct alignas(kCacheLineSize) Position {
+    std::atomic<size_t> position{0};
+  };
+
+  // Returns true if a producer can claim the slot at the tail. A consumer
+  // advances the head before it releases the slot it popped, so the ring may
+  // have room while its next slot is still taken.
+  bool HasSpace() const {
+    const size_t tail = tail_.position.load(std::memory_order_acquire);
+    return size() < capacity_ &&
+           slots_[tail % num_slots_].sequence.load(std::memory_order_acquire) >=
+               tail;
+  }
+
+  bool TryPushInternal(T&& item) {
+    size_t position = tail_.position.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = slots_[position % num_slots_];
+      const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (diff == 0 && num_slots_ > capacity_ &&
+          position - head_.position.load(std::memory_order_acquire) >=
+              capacity_) {
+        // The ring has more slots than its capacity.
+        return false;
+      }
+      if (diff == 0) {
+        if (tail_.position.compare_exchange_weak(position, position + 1,
+                                                 std::memory_order_relaxed)) {
+          slot.value.emplace(std::move(item));
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // The slot still holds an item from the previous lap.
+        return false;
+      } else {
+        position = tail_.position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::optional<T> TryPopInternal() {
+    size_t position = head_.position.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = slots_[position % num_slots_];
+      const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) -
+                            static_cast<intptr_t>(position + 1);
+      if (diff == 0) {
+        if (head_.position.compare_exchange_weak(position, position + 1,
+                                                 std::memory_order_relaxed)) {
+          std::optional<T> item(std::move(*slot.value));
+          slot.value.reset();
+          slot.sequence.store(position + num_slots_, std::memory_order_release);
+          return item;
+        }
+      } else if (diff < 0) {
+        // The slot has not been filled yet.
+        return std::nullopt;
+      } else {
+        position = head_.position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  const size_t capacity_;
+  // A ring of a single slot cannot tell a full slot from an empty slot of the
+  // next lap, so there are always at least two slots.
+  const size_t num_slots_;
+  const std::unique_ptr<Slot[]> slots_;
+  Position tail_;
+  Position head_;
+  std::atomic<bool> closed_{false};
+
+  // Only used to park threads that find the ring empty or full.
+  mutex mu_;
+  condition_variable not_empty_;
+  condition_variable not_full_;
+  std::atomic<int> num_waiting_consumers_{0};
+  std::atomic<int> num_waiting_producers_{0};
+
+  MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+  void operator=(const MpmcRingBuffer&) = delete;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_PREFETCH_RING_BUFFER_H_
@@ -0,0 +1,216 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/prefetch_ring_buffer.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+TEST(MpmcRingBufferTest, FifoOrder) {
+  MpmcRingBuffer<int> ring(/*capacity=*/4);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(ring.TryPush(round * 4 + i));
+    }
+    EXPECT_EQ(4, ring.size());
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(round * 4 + i, ring.TryPop());
+    }
+    EXPECT_EQ(std::nullopt, ring.TryPop());
+  }
+}
+
+TEST(MpmcRingBufferTest, TryPushFailsWhenFull) {
+  for (size_t capacity : {1, 3}) {
+    MpmcRingBuffer<std::unique_ptr<int>> ring(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+      EXPECT_TRUE(ring.TryPush(std::make_unique<int>(i)));
+    }
+    auto item = std::make_unique<int>(42);
+    EXPECT_FALSE(ring.TryPush(std::move(item)));
+    // A failed push leaves the item with the caller.
+    ASSERT_NE(nullptr, item);
+    EXPECT_EQ(42, *item);
+    EXPECT_EQ(0, **ring.TryPop());
+    EXPECT_TRUE(ring.TryPush(std::move(item)));
+  }
+}
+
+TEST(MpmcRingBufferTest, CloseDrainsRemainingItems) {
+  MpmcRingBuffer<int> ring(/*capacity=*/2);
+  EXPECT_TRUE(ring.Push(1));
+  EXPECT_TRUE(ring.Push(2));
+  ring.Close();
+  EXPECT_TRUE(ring.closed());
+  EXPECT_FALSE(ring.Push(3));
+  EXPECT_FALSE(ring.WaitForSpace());
+  EXPECT_EQ(1, ring.Pop());
+  EXPECT_EQ(2, ring.Pop());
+  EXPECT_EQ(std::nullopt, ring.Pop());
+}
+
+TEST(MpmcRingBufferTest, CloseWakesBlockedThreads) {
+  MpmcRingBuffer<int> empty_ring(/*capacity=*/1);
+  MpmcRingBuffer<int> full_ring(/*capacity=*/1);
+  EXPECT_TRUE(full_ring.TryPush(0));
+  std::optional<int> popped = 0;
+  bool pushed = true;
+  {
+    std::unique_ptr<Thread> consumer(Env::Default()->StartThread(
+        {}, "consumer", [&]() { popped = empty_ring.Pop(); }));
+    std::unique_ptr<Thread> producer(Env::Default()->StartThread(
+        {}, "producer", [&]() { pushed = full_ring.Push(1); }));
+    Env::Default()->SleepForMicroseconds(10000);
+    empty_ring.Close();
+    full_ring.Close();
+  }
+  EXPECT_EQ(std::nullopt, popped);
+  EXPECT_FALSE(pushed);
+}
+
+TEST(MpmcRingBufferTest, ConcurrentProducersAndConsumers) {
+  constexpr int kNumThreads = 4;
+  constexpr int kItemsPerProducer = 10000;
+  for (size_t capacity : {1, 3, 64}) {
+    MpmcRingBuffer<int64_t> ring(capacity);
+    std::atomic<int64_t> sum(0);
+    std::atomic<int64_t> count(0);
+    {
+      std::vector<std::unique_ptr<Thread>> consumers;
+      for (int i = 0; i < kNumThreads; ++i) {
+        consumers.emplace_back(
+            Env::Default()->StartThread({}, "consumer", [&]() {
+              while (std::optional<int64_t> item = ring.Pop()) {
+                sum += *item;
+                ++count;
+              }
+            }));
+      }
+      {
+        std::vector<std::unique_ptr<Thread>> producers;
+        for (int i = 0; i < kNumThreads; ++i) {
+          producers.emplace_back(
+              Env::Default()->StartThread({}, "producer", [&]() {
+                for (int64_t j = 0; j < kItemsPerProducer; ++j) {
+                  ASSERT_TRUE(ring.Push(j));
+                }
+              }));
+        }
+      }
+      ring.Close();
+    }
+    EXPECT_EQ(kNumThreads * kItemsPerProducer, count);
+    EXPECT_EQ(kNumThreads * (kItemsPerProducer - 1) * kItemsPerProducer / 2,
+              sum);
+  }
+}
+
+// The buffer that `PrefetchDatasetOp` uses without the ring buffer: a deque
+// guarded by a mutex, with a condition variable for each side.
+template <typename T>
+class LockedQueue {
+ public:
+  explicit LockedQueue(size_t capacity) : capacity_(capacity) {}
+
+  bool Push(T item) {
+    mutex_lock l(mu_);
+    while (queue_.size() >= capacity_ && !closed_) not_full_.wait(l);
+    if (closed_) return false;
+    queue_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  std::optional<T> Pop() {
+    mutex_lock l(mu_);
+    while (queue_.empty() && !closed_) not_empty_.wait(l);
+    if (queue_.empty()) return std::nullopt;
+    std::optional<T> item(std::move(queue_.front()));
+    queue_.pop_front();
+    not_full_.notify_one();
+    return item;
+  }
+
+  void Close() {
+    mutex_lock l(mu_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+ private:
+  const size_t capacity_;
+  mutex mu_;
+  condition_variable not_empty_;
+  condition_variable not_full_;
+  std::deque<T> queue_ TF_GUARDED_BY(mu_);
+  bool closed_ TF_GUARDED_BY(mu_) = false;
+};
+
+// Moves tiny elements from one producer to `num_consumers` consumers, which
+// is where the cost of the buffer itself dominates.
+template <typename Queue>
+void BM_PrefetchBuffer(::testing::benchmark::State& state) {
+  const int num_consumers = state.range(0);
+  const int64_t num_elements = state.range(1);
+  for (auto s : state) {
+    Queue queue(/*capacity=*/16);
+    std::vector<std::unique_ptr<Thread>> consumers;
+    for (int i = 0; i < num_consumers; ++i) {
+      consumers.emplace_back(Env::Default()->StartThread(
+          {}, "consumer", [&queue]() {
+            while (queue.Pop().has_value()) {
+            }
+          }));
+    }
+    for (int64_t i = 0; i < num_elements; ++i) {
+      queue.Push(i);
+    }
+    queue.Close();
+  }
+  state.SetItemsProcessed(state.iterations() * num_elements);
+}
+
+void BM_PrefetchRingBuffer(::testing::benchmark::State& state) {
+  BM_PrefetchBuffer<MpmcRingBuffer<int64_t>>(state);
+}
+
+void BM_PrefetchLockedQueue(::testing::benchmark::State& state) {
+  BM_PrefetchBuffer<LockedQueue<int64_t>>(state);
+}
+
+BENCHMARK(BM_PrefetchRingBuffer)
+    ->ArgPair(1, 1 << 16)
+    ->ArgPair(2, 1 << 16)
+    ->ArgPair(4, 1 << 16);
+BENCHMARK(BM_PrefetchLockedQueue)
+    ->ArgPair(1, 1 << 16)
+    ->ArgPair(2, 1 << 16)
+    ->ArgPair(4, 1 << 16);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -33,12 +33,14 @@ limitations under the License.
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/random_seed_ops.h"
+#include "tensorflow/core/kernels/data/spilling_shuffle_buffer.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -81,6 +83,38 @@ constexpr char kShuffleDatasetV3[] = "ShuffleDatasetV3";
 constexpr char kShuffleAndRepeatDatasetV1[] = "ShuffleAndRepeatDataset";
 constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
 
+namespace {
+
+// Returns the options for shuffle buffers that spill to local disk, or nullptr
+// if they should stay in memory. Spilling is enabled by setting
+// TF_DATA_SHUFFLE_SPILL_DIR to a local directory. Each shuffle iterator then
+// keeps at most TF_DATA_SHUFFLE_SPILL_MEMORY_MB megabytes of its buffer in
+// memory.
+const SpillingShuffleBuffer::Options* ShuffleSpillOptions() {
+  static const SpillingShuffleBuffer::Options* spill_options =
+      []() -> const SpillingShuffleBuffer::Options* {
+    auto options = std::make_unique<SpillingShuffleBuffer::Options>();
+    int64_t memory_mb;
+    Status status = ReadStringFromEnvVar("TF_DATA_SHUFFLE_SPILL_DIR",
+                                         /*default_val=*/"",
+                                         &options->directory);
+    if (status.ok()) {
+      status = ReadInt64FromEnvVar("TF_DATA_SHUFFLE_SPILL_MEMORY_MB",
+                                   /*default_val=*/1024, &memory_mb);
+    }
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return nullptr;
+    }
+    if (options->directory.empty()) return nullptr;
+    options->memory_budget_bytes = memory_mb << 20;
+    return options.release();
+  }();
+  return spill_options;
+}
+
+}  // namespace
+
 ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx) {}
 
@@ -191,6 +225,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           seed_generator_(seed_generator),
           parent_generator_(seed_generator->seed(), seed_generator->seed2()),
           generator_(&parent_generator_) {
+      // With spilling, `spill_buffer_` is created in `Initialize()` instead.
+      if (ShuffleSpillOptions() != nullptr) return;
       if (params.dataset->buffer_size_ == kUnknownCardinality) {
         buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
       } else {
@@ -205,9 +241,12 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       mutex_lock l(mu_);
       seed_generator_->GenerateSeeds(&seed_, &seed2_);
       ResetRngs();
+      if (ShuffleSpillOptions() != nullptr) {
+        TF_RETURN_IF_ERROR(CreateSpillBuffer(ctx));
+      }
       // Initialize checkpoint_indices_ to the entire buffer.
       if (ctx->symbolic_checkpoint()) {
-        for (int64_t i = 0; i < buffer_->size(); ++i) {
+        for (int64_t i = 0; i < BufferSize(); ++i) {
           checkpoint_indices_.insert(i);
         }
       }
@@ -232,15 +271,21 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       // slice, and then remove the element from the slice.
       int64_t offset =
           Random() % (slices_.front()->end - slices_.front()->start);
-      int64_t index = (slices_.front()->start + offset) % buffer_->size();
-      *out_tensors = std::move(buffer_->at(index));
+      int64_t index = (slices_.front()->start + offset) % BufferSize();
+      int64_t start_index = slices_.front()->start % BufferSize();
+      if (spill_buffer_) {
+        TF_RETURN_IF_ERROR(spill_buffer_->Take(index, out_tensors));
+        if (index != start_index) spill_buffer_->Move(start_index, index);
+      } else {
+        *out_tensors = std::move(buffer_->at(index));
+        std::swap(buffer_->at(index), buffer_->at(start_index));
+      }
       this->RecordBufferDequeue(ctx, *out_tensors);
-      std::swap(buffer_->at(index),
-                buffer_->at(slices_.front()->start % buffer_->size()));
       checkpoint_indices_.insert(index);
-      checkpoint_indices_.insert(slices_.front()->start % buffer_->size());
+      checkpoint_indices_.insert(start_index);
       slices_.front()->start++;
       num_elements_--;
+      if (spill_buffer_) PrefetchSpilledElements();
       return OkStatus();
     }
 
@@ -284,7 +329,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(prefix(), kNumElements, num_elements_));
       const std::string key_prefix = absl::StrCat(prefix(), kColon, "buffer");
-      if (ctx->symbolic_checkpoint()) {
+      if (spill_buffer_) {
+        TF_RETURN_IF_ERROR(
+            WriteSpillBuffer(writer, key_prefix, ctx->symbolic_checkpoint()));
+      } else if (ctx->symbolic_checkpoint()) {
         // When symbolic checkpointing is turned on, `writer`
         // already contains checkpoint of the shuffle buffer created by the
         // previous invocation of this instance and the indices that need to be
@@ -357,20 +405,24 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             reader->ReadScalar(this->prefix(), kSlicesSize, &temp));
         slices_size = static_cast<size_t>(temp);
       }
-      buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
-      TF_RETURN_IF_ERROR(ReadElementsFromCheckpoint(
-          ctx, reader, absl::StrCat(prefix(), kColon, "buffer"),
-          buffer_.get()));
+      const std::string key_prefix = absl::StrCat(prefix(), kColon, "buffer");
+      if (ShuffleSpillOptions() != nullptr) {
+        TF_RETURN_IF_ERROR(ReadSpillBuffer(ctx, reader, key_prefix));
+      } else {
+        buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
+        TF_RETURN_IF_ERROR(
+            ReadElementsFromCheckpoint(ctx, reader, key_prefix, buffer_.get()));
+        for (const auto& element : *buffer_) {
+          RecordBufferEnqueue(ctx, element);
+        }
+      }
       if (ctx->symbolic_checkpoint()) {
         DCHECK(checkpoint_indices_.empty());
-        for (size_t i = 0; i < buffer_->size(); ++i) {
+        for (size_t i = 0; i < BufferSize(); ++i) {
           checkpoint_indices_.insert(i);
         }
       }
-      for (const auto& element : *buffer_) {
-        RecordBufferEnqueue(ctx, element);
-      }
-      if (!IsShuffleAll()) {
+      if (!IsShuffleAll() && !spill_buffer_) {
         buffer_->resize(dataset()->buffer_size_);
       }
       slices_.clear();
@@ -463,7 +515,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           slices_.back()->reached_end_of_sequence = true;
         }
         if (!end_of_input_sequence) {
-          AddToShuffleBuffer(ctx, std::move(input_element));
+          TF_RETURN_IF_ERROR(
+              AddToShuffleBuffer(ctx, std::move(input_element)));
           continue;
         }
         input_impl_.reset();
@@ -500,7 +553,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         // we need to add to the buffer.
         return true;
       }
-      return num_elements_ < buffer_->size();
+      return num_elements_ < BufferSize();
     }
 
     Status PrepareNextEpoch(IteratorContext* ctx)
@@ -520,7 +573,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return OkStatus();
     }
 
-    void AddToShuffleBuffer(IteratorContext* ctx, std::vector<Tensor>&& element)
+    Status AddToShuffleBuffer(IteratorContext* ctx,
+                              std::vector<Tensor>&& element)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       data_produced_ = true;
       if (num_elements_ == 0) {
@@ -528,17 +582,26 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                 << BufferSizeString();
       }
       this->RecordBufferEnqueue(ctx, element);
-      if (num_elements_ == buffer_->size()) {
+      if (num_elements_ == BufferSize()) {
         DCHECK(IsShuffleAll());
-        checkpoint_indices_.insert(buffer_->size());
-        buffer_->push_back(element);
+        checkpoint_indices_.insert(BufferSize());
+        if (spill_buffer_) {
+          TF_RETURN_IF_ERROR(spill_buffer_->PushBack(std::move(element)));
+        } else {
+          buffer_->push_back(element);
+        }
       } else {
-        size_t index = slices_.back()->end % buffer_->size();
+        size_t index = slices_.back()->end % BufferSize();
         checkpoint_indices_.insert(index);
-        buffer_->at(index) = std::move(element);
+        if (spill_buffer_) {
+          TF_RETURN_IF_ERROR(spill_buffer_->Put(index, std::move(element)));
+        } else {
+          buffer_->at(index) = std::move(element);
+        }
       }
       num_elements_++;
       slices_.back()->end++;
+      return OkStatus();
     }
 
     void ClearEmptySlices() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -556,10 +619,108 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return absl::StrCat(dataset()->buffer_size_);
     }
 
+    int64_t BufferSize() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return spill_buffer_ ? spill_buffer_->size() : buffer_->size();
+    }
+
+    Status CreateSpillBuffer(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return SpillingShuffleBuffer::Create(
+          ctx->env(), *ShuffleSpillOptions(),
+          IsShuffleAll() ? 0 : dataset()->buffer_size_, &spill_buffer_);
+    }
+
+    // Tells `spill_buffer_` which slots the next calls to `GetNextInternal()`
+    // will take, so that it can read spilled elements ahead of time. The
+    // prediction replays the random number generator, assuming that the
+    // buffer is refilled after each element while the input lasts. It stops at
+    // the end of the serving slice, where the generator is reseeded. A wrong
+    // prediction only costs wasted reads.
+    void PrefetchSpilledElements() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (spill_buffer_->num_spilled() == 0 || slices_.empty()) return;
+      random::PhiloxRandom parent_generator(seed_, seed2_);
+      random::SingleSampleAdapter<random::PhiloxRandom> generator(
+          &parent_generator);
+      generator.Skip(num_random_samples_);
+      const bool refilled =
+          !IsShuffleAll() && slices_.size() == 1 && input_impl_ != nullptr;
+      int64_t start = slices_.front()->start;
+      int64_t end = slices_.front()->end;
+      const int64_t size = BufferSize();
+      const size_t read_ahead = ShuffleSpillOptions()->read_ahead;
+      std::vector<SpillingShuffleBuffer::PlannedTake> takes;
+      takes.reserve(read_ahead);
+      while (takes.size() < read_ahead) {
+        if (refilled) end++;
+        if (start == end) break;
+        const int64_t offset = generator() % (end - start);
+        takes.push_back({(start + offset) % size, start % size});
+        start++;
+      }
+      spill_buffer_->Prefetch(takes);
+    }
+
+    // Writes the elements of `spill_buffer_` in the format of
+    // `WriteElementsToCheckpoint()`, reading spilled elements one at a time.
+    Status WriteSpillBuffer(IteratorStateWriter* writer,
+                            const std::string& key_prefix,
+                            bool symbolic_checkpoint)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      TF_RETURN_IF_ERROR(
+          WriteNumElementsToCheckpoint(writer, key_prefix, BufferSize()));
+      std::vector<Tensor> element;
+      auto write_element = [&](int64_t index) -> Status {
+        TF_RETURN_IF_ERROR(spill_buffer_->Get(index, &element));
+        return WriteElementToCheckpoint(writer, key_prefix, index, element);
+      };
+      if (symbolic_checkpoint) {
+        for (int64_t index : checkpoint_indices_) {
+          TF_RETURN_IF_ERROR(write_element(index));
+        }
+        checkpoint_indices_.clear();
+      } else {
+        for (int64_t index = 0; index < BufferSize(); ++index) {
+          TF_RETURN_IF_ERROR(write_element(index));
+        }
+      }
+      return OkStatus();
+    }
+
+    // Reads the buffer written by `SaveInternal()` into a new `spill_buffer_`
+    // one element at a time, so that it does not need to fit in memory.
+    Status ReadSpillBuffer(IteratorContext* ctx, IteratorStateReader* reader,
+                           const std::string& key_prefix)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      spill_buffer_.reset();
+      TF_RETURN_IF_ERROR(CreateSpillBuffer(ctx));
+      int64_t num_elements;
+      TF_RETURN_IF_ERROR(
+          ReadNumElementsFromCheckpoint(reader, key_prefix, &num_elements));
+      if (!IsShuffleAll() && num_elements > BufferSize()) {
+        return errors::FailedPrecondition(
+            "Checkpointed shuffle buffer has ", num_elements,
+            " elements, more than the buffer size ", BufferSize());
+      }
+      std::vector<Tensor> element;
+      for (int64_t i = 0; i < num_elements; ++i) {
+        TF_RETURN_IF_ERROR(
+            ReadElementFromCheckpoint(ctx, reader, key_prefix, i, &element));
+        RecordBufferEnqueue(ctx, element);
+        if (IsShuffleAll()) {
+          TF_RETURN_IF_ERROR(spill_buffer_->PushBack(std::move(element)));
+        } else if (!element.empty()) {
+          TF_RETURN_IF_ERROR(spill_buffer_->Put(i, std::move(element)));
+        }
+      }
+      return OkStatus();
+    }
+
     mutex mu_;
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
         TF_GUARDED_BY(mu_);
+    // Replaces `buffer_` if shuffle buffers spill to disk.
+    std::unique_ptr<SpillingShuffleBuffer> spill_buffer_ TF_GUARDED_BY(mu_);
     // Holds the indices of `buffer_` that have changed since the previous
     // `SaveInternal()` and need to be updated in the MemoryCheckpoint
     // (if symbolic checkpointing is used) in the next `SaveInternal()`.
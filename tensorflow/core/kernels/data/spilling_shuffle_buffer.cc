@@ -0,0 +1,360 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/spilling_shuffle_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/protobuf/snapshot.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr int kNumReadThreads = 4;
+
+// Elements with components that cannot be serialized to a `TensorProto`, such
+// as datasets, always stay in memory.
+bool CanSpill(const std::vector<Tensor>& element) {
+  for (const Tensor& component : element) {
+    if (component.dtype() == DT_VARIANT || component.dtype() == DT_RESOURCE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+// A read started by `Prefetch`. The element is handed to `Take` once `done`.
+struct SpillingShuffleBuffer::PendingRead {
+  mutex mu;
+  condition_variable cv;
+  bool done TF_GUARDED_BY(mu) = false;
+  Status status TF_GUARDED_BY(mu);
+  std::vector<Tensor> element TF_GUARDED_BY(mu);
+};
+
+Status SpillingShuffleBuffer::Create(
+    Env* env, const Options& options, int64_t size,
+    std::unique_ptr<SpillingShuffleBuffer>* buffer) {
+  if (options.directory.empty()) {
+    return errors::InvalidArgument(
+        "A spilling shuffle buffer needs a directory for its run files.");
+  }
+  if (options.memory_budget_bytes < 0 || options.max_run_bytes <= 0 ||
+      options.read_ahead < 0) {
+    return errors::InvalidArgument("Invalid spilling shuffle buffer options.");
+  }
+  const std::string directory = io::JoinPath(
+      options.directory,
+      strings::Printf("shuffle_buffer_%016llx",
+                      static_cast<unsigned long long>(random::New64())));
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory));
+  buffer->reset(new SpillingShuffleBuffer(env, options, directory, size));
+  return OkStatus();
+}
+
+SpillingShuffleBuffer::SpillingShuffleBuffer(Env* env, const Options& options,
+                                             const std::string& directory,
+                                             int64_t size)
+    : env_(env),
+      options_(options),
+      directory_(directory),
+      slots_(size),
+      thread_pool_(std::make_unique<thread::ThreadPool>(
+          env, "shuffle_buffer_reads", kNumReadThreads)) {}
+
+SpillingShuffleBuffer::~SpillingShuffleBuffer() {
+  // Joins the reads that are in flight before their files are deleted.
+  thread_pool_.reset();
+  runs_.clear();
+  int64_t undeleted_files, undeleted_dirs;
+  Status s =
+      env_->DeleteRecursively(directory_, &undeleted_files, &undeleted_dirs);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete shuffle buffer run files in "
+                 << directory_ << ": " << s;
+  }
+}
+
+Status SpillingShuffleBuffer::Put(int64_t index, std::vector<Tensor> element) {
+  DCHECK(slots_[index].state == SlotState::kEmpty);
+  return Store(std::move(element), &slots_[index]);
+}
+
+Status SpillingShuffleBuffer::PushBack(std::vector<Tensor> element) {
+  slots_.emplace_back();
+  return Store(std::move(element), &slots_.back());
+}
+
+Status SpillingShuffleBuffer::Store(std::vector<Tensor> element, Slot* slot) {
+  const int64_t bytes = GetTotalBytes(element);
+  if (memory_bytes_ + bytes > options_.memory_budget_bytes &&
+      CanSpill(element)) {
+    return Spill(element, slot);
+  }
+  slot->state = SlotState::kInMemory;
+  slot->element = std::move(element);
+  slot->bytes = bytes;
+  memory_bytes_ += bytes;
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::Spill(const std::vector<Tensor>& element,
+                                    Slot* slot) {
+  experimental::SnapshotRecord record;
+  for (const Tensor& component : element) {
+    component.AsProtoTensorContent(record.add_tensor());
+  }
+  std::string serialized;
+  if (!record.SerializeToString(&serialized)) {
+    return errors::Internal("Failed to serialize a shuffle buffer element.");
+  }
+  std::string compressed;
+  const bool is_compressed =
+      port::Snappy_Compress(serialized.data(), serialized.size(), &compressed);
+  const std::string& data = is_compressed ? compressed : serialized;
+
+  if (current_run_ < 0 ||
+      (runs_[current_run_].size > 0 &&
+       runs_[current_run_].size + static_cast<int64_t>(data.size()) >
+           options_.max_run_bytes)) {
+    TF_RETURN_IF_ERROR(StartRun());
+  }
+  Run& run = runs_[current_run_];
+  TF_RETURN_IF_ERROR(run.writer->Append(data));
+  slot->state = SlotState::kSpilled;
+  slot->compressed = is_compressed;
+  slot->run = current_run_;
+  slot->offset = run.size;
+  slot->length = data.size();
+  run.size += data.size();
+  ++run.num_live_records;
+  ++num_spilled_;
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::StartRun() {
+  if (current_run_ >= 0) {
+    Run& run = runs_[current_run_];
+    TF_RETURN_IF_ERROR(run.writer->Close());
+    run.writer.reset();
+    run.flushed_size = run.size;
+    const int64_t finished_run = current_run_;
+    current_run_ = -1;
+    if (run.num_live_records == 0) {
+      TF_RETURN_IF_ERROR(env_->DeleteFile(run.filename));
+      runs_.erase(finished_run);
+    }
+  }
+  Run run;
+  run.filename = io::JoinPath(directory_, absl::StrCat("run_", next_run_));
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(run.filename, &run.writer));
+  std::unique_ptr<RandomAccessFile> reader;
+  TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(run.filename, &reader));
+  run.reader = std::move(reader);
+  current_run_ = next_run_++;
+  runs_[current_run_] = std::move(run);
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::FlushRecord(const Slot& slot) {
+  Run& run = runs_[slot.run];
+  if (run.flushed_size < slot.offset + slot.length) {
+    TF_RETURN_IF_ERROR(run.writer->Flush());
+    run.flushed_size = run.size;
+  }
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::Take(int64_t index,
+                                   std::vector<Tensor>* element) {
+  Slot& slot = slots_[index];
+  switch (slot.state) {
+    case SlotState::kEmpty:
+      return errors::Internal("Shuffle buffer slot ", index, " is empty.");
+    case SlotState::kInMemory:
+      *element = std::move(slot.element);
+      slot.element.clear();
+      memory_bytes_ -= slot.bytes;
+      break;
+    case SlotState::kSpilled: {
+      auto it = pending_reads_.find(RecordKey(slot.run, slot.offset));
+      if (it != pending_reads_.end()) {
+        std::shared_ptr<PendingRead> read = std::move(it->second);
+        pending_reads_.erase(it);
+        mutex_lock l(read->mu);
+        while (!read->done) read->cv.wait(l);
+        TF_RETURN_IF_ERROR(read->status);
+        *element = std::move(read->element);
+      } else {
+        TF_RETURN_IF_ERROR(ReadSpilled(slot, element));
+      }
+      ReleaseRecord(slot);
+      break;
+    }
+  }
+  slot = Slot();
+  return OkStatus();
+}
+
+void SpillingShuffleBuffer::Move(int64_t from, int64_t to) {
+  DCHECK(slots_[to].state == SlotState::kEmpty);
+  slots_[to] = std::move(slots_[from]);
+  slots_[from] = Slot();
+}
+
+Status SpillingShuffleBuffer::Get(int64_t index,
+                                  std::vector<Tensor>* element) {
+  const Slot& slot = slots_[index];
+  if (slot.state == SlotState::kSpilled) {
+    return ReadSpilled(slot, element);
+  }
+  *element = slot.element;
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::ReadSpilled(const Slot& slot,
+                                          std::vector<Tensor>* element) {
+  TF_RETURN_IF_ERROR(FlushRecord(slot));
+  return ReadRecord(runs_[slot.run].reader.get(), slot.offset, slot.length,
+                    slot.compressed, element);
+}
+
+void SpillingShuffleBuffer::ReleaseRecord(const Slot& slot) {
+  --num_spilled_;
+  auto it = runs_.find(slot.run);
+  if (--it->second.num_live_records > 0 || slot.run == current_run_) return;
+  Status s = env_->DeleteFile(it->second.filename);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete shuffle buffer run file "
+                 << it->second.filename << ": " << s;
+  }
+  runs_.erase(it);
+}
+
+void SpillingShuffleBuffer::Prefetch(const std::vector<PlannedTake>& takes) {
+  if (num_spilled_ == 0) {
+    pending_reads_.clear();
+    return;
+  }
+  // Replays `takes` on a map from slots to the slots whose elements they will
+  // hold, where -1 stands for an element that is not in the buffer yet.
+  absl::flat_hash_map<int64_t, int64_t> sources;
+  auto source = [&sources](int64_t index) {
+    auto it = sources.find(index);
+    return it == sources.end() ? index : it->second;
+  };
+  std::vector<int64_t> to_read;
+  absl::flat_hash_set<RecordKey> planned;
+  for (const PlannedTake& take : takes) {
+    if (to_read.size() >= static_cast<size_t>(options_.read_ahead)) break;
+    const int64_t taken = source(take.index);
+    if (taken >= 0 && slots_[taken].state == SlotState::kSpilled &&
+        planned.insert(RecordKey(slots_[taken].run, slots_[taken].offset))
+            .second) {
+      to_read.push_back(taken);
+    }
+    if (take.replacement != take.index) {
+      sources[take.index] = source(take.replacement);
+      sources[take.replacement] = -1;
+    } else {
+      sources[take.index] = -1;
+    }
+  }
+
+  for (auto it = pending_reads_.begin(); it != pending_reads_.end();) {
+    if (planned.contains(it->first)) {
+      ++it;
+    } else {
+      pending_reads_.erase(it++);
+    }
+  }
+  for (int64_t index : to_read) {
+    const Slot& slot = slots_[index];
+    const RecordKey key(slot.run, slot.offset);
+    if (pending_reads_.contains(key)) continue;
+    // If the record cannot be flushed, `Take` reports the error.
+    if (!FlushRecord(slot).ok()) continue;
+    auto read = std::make_shared<PendingRead>();
+    pending_reads_[key] = read;
+    thread_pool_->Schedule([read, file = runs_[slot.run].reader,
+                            offset = slot.offset, length = slot.length,
+                            compressed = slot.compressed]() {
+      std::vector<Tensor> element;
+      Status s = ReadRecord(file.get(), offset, length, compressed, &element);
+      mutex_lock l(read->mu);
+      read->status = s;
+      read->element = std::move(element);
+      read->done = true;
+      read->cv.notify_all();
+    });
+  }
+}
+
+/* static */ Status SpillingShuffleBuffer::ReadRecord(
+    RandomAccessFile* file, int64_t offset, int64_t length, bool compressed,
+    std::vector<Tensor>* element) {
+  std::string scratch(length, '\0');
+  StringPiece data;
+  TF_RETURN_IF_ERROR(file->Read(offset, length, &data, &scratch[0]));
+  if (data.size() != length) {
+    return errors::DataLoss("Shuffle buffer run file is truncated.");
+  }
+  std::string uncompressed;
+  if (compressed) {
+    size_t uncompressed_length;
+    if (!port::Snappy_GetUncompressedLength(data.data(), data.size(),
+                                            &uncompressed_length)) {
+      return errors::DataLoss("Corrupted shuffle buffer record.");
+    }
+    uncompressed.resize(uncompressed_length);
+    if (!port::Snappy_Uncompress(data.data(), data.size(),
+                                 &uncompressed[0])) {
+      return errors::DataLoss("Corrupted shuffle buffer record.");
+    }
+    data = uncompressed;
+  }
+  experimental::SnapshotRecord record;
+  if (!record.ParseFromArray(data.data(), data.size())) {
+    return errors::DataLoss("Corrupted shuffle buffer record.");
+  }
+  element->clear();
+  element->reserve(record.tensor_size());
+  for (const TensorProto& proto : record.tensor()) {
+    element->emplace_back();
+    if (!element->back().FromProto(proto)) {
+      return errors::DataLoss("Corrupted shuffle buffer record.");
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace data
+}  // namespace tensorflow
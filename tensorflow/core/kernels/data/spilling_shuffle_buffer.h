@@ -0,0 +1,172 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_SPILLING_SHUFFLE_BUFFER_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_SPILLING_SHUFFLE_BUFFER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace data {
+
+// SpillingShuffleBuffer holds the slots of a shuffle buffer, keeping at most
+// `memory_budget_bytes` of elements in memory and writing the rest to
+// snappy-compressed run files on local disk.
+//
+// The shuffle samples slots uniformly at random, so it does not matter which
+// elements stay in memory: an element is written to disk if it does not fit in
+// the budget when it is put into the buffer, and it stays there until it is
+// taken. Moving an element between slots only moves its location. A run file
+// is deleted once all of its elements have been taken.
+//
+// The slots that a shuffle iterator takes are a deterministic function of its
+// seeds, so the iterator can tell the buffer which slots it is about to take.
+// `Prefetch` reads the spilled elements among them on a background thread
+// pool, so that `Take` usually does not wait for the disk.
+//
+// This class is thread-compatible.
+class SpillingShuffleBuffer {
+ public:
+  struct Options {
+    // Local directory to create run files in.
+    std::string directory;
+    // Elements that do not fit in this many bytes are spilled to disk.
+    int64_t memory_budget_bytes = 1LL << 30;
+    // A new run file is started once the current one exceeds this size.
+    int64_t max_run_bytes = 64LL << 20;
+    // Maximum number of spilled elements to read ahead of `Take`.
+    int64_t read_ahead = 64;
+  };
+
+  // A planned `Take(index)`, followed by `Move(replacement, index)` unless
+  // `replacement` is `index`.
+  struct PlannedTake {
+    int64_t index;
+    int64_t replacement;
+  };
+
+  // Creates a buffer of `size` empty slots, with run files in a new
+  // subdirectory of `options.directory`.
+  static Status Create(Env* env, const Options& options, int64_t size,
+                       std::unique_ptr<SpillingShuffleBuffer>* buffer);
+
+  // Waits for outstanding reads and deletes the run files.
+  ~SpillingShuffleBuffer();
+
+  SpillingShuffleBuffer(const SpillingShuffleBuffer&) = delete;
+  SpillingShuffleBuffer& operator=(const SpillingShuffleBuffer&) = delete;
+
+  int64_t size() const { return slots_.size(); }
+  // Number of elements in the buffer that are on disk.
+  int64_t num_spilled() const { return num_spilled_; }
+  // Bytes of the elements in the buffer that are in memory.
+  int64_t memory_bytes() const { return memory_bytes_; }
+  // Number of run files on disk.
+  int64_t num_runs() const { return runs_.size(); }
+
+  // Stores `element` in the empty slot `index`.
+  Status Put(int64_t index, std::vector<Tensor> element);
+  // Appends a slot holding `element`.
+  Status PushBack(std::vector<Tensor> element);
+  // Removes the element in slot `index` and stores it in `element`.
+  Status Take(int64_t index, std::vector<Tensor>* element);
+  // Moves the element in slot `from` to the empty slot `to`, without reading
+  // it.
+  void Move(int64_t from, int64_t to);
+  // Copies the element in slot `index` to `element`, which is empty if the
+  // slot is empty.
+  Status Get(int64_t index, std::vector<Tensor>* element);
+
+  // Starts reading the spilled elements that `takes` would remove from the
+  // buffer, in order, up to `options.read_ahead` of them. Slots that become
+  // empty during `takes` are assumed to be refilled with new elements.
+  // Reads started by an earlier call that are no longer planned are dropped.
+  void Prefetch(const std::vector<PlannedTake>& takes);
+
+ private:
+  enum class SlotState : int8_t { kEmpty, kInMemory, kSpilled };
+
+  struct Slot {
+    SlotState state = SlotState::kEmpty;
+    // Whether the record on disk is snappy-compressed.
+    bool compressed = false;
+    // If `state == kInMemory`.
+    std::vector<Tensor> element;
+    int64_t bytes = 0;
+    // If `state == kSpilled`.
+    int64_t run = -1;
+    int64_t offset = 0;
+    int64_t length = 0;
+  };
+
+  struct Run {
+    std::string filename;
+    // Only set for the run that is being appended to.
+    std::unique_ptr<WritableFile> writer;
+    std::shared_ptr<RandomAccessFile> reader;
+    int64_t size = 0;
+    int64_t flushed_size = 0;
+    int64_t num_live_records = 0;
+  };
+
+  struct PendingRead;
+
+  using RecordKey = std::pair<int64_t, int64_t>;  // Run and offset.
+
+  SpillingShuffleBuffer(Env* env, const Options& options,
+                        const std::string& directory, int64_t size);
+
+  Status Store(std::vector<Tensor> element, Slot* slot);
+  Status Spill(const std::vector<Tensor>& element, Slot* slot);
+  Status StartRun();
+  // Makes the record of `slot` visible to readers of its run file.
+  Status FlushRecord(const Slot& slot);
+  Status ReadSpilled(const Slot& slot, std::vector<Tensor>* element);
+  // Drops the record of `slot` from its run, deleting the run file if it has
+  // no other live records.
+  void ReleaseRecord(const Slot& slot);
+
+  static Status ReadRecord(RandomAccessFile* file, int64_t offset,
+                           int64_t length, bool compressed,
+                           std::vector<Tensor>* element);
+
+  Env* const env_;
+  const Options options_;
+  const std::string directory_;
+  std::vector<Slot> slots_;
+  int64_t num_spilled_ = 0;
+  int64_t memory_bytes_ = 0;
+  absl::flat_hash_map<int64_t, Run> runs_;
+  int64_t current_run_ = -1;
+  int64_t next_run_ = 0;
+  absl::flat_hash_map<RecordKey, std::shared_ptr<PendingRead>> pending_reads_;
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_SPILLING_SHUFFLE_BUFFER_H_
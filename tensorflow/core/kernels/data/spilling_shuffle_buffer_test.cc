@@ -0,0 +1,186 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/spilling_shuffle_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+SpillingShuffleBuffer::Options CreateOptions(int64_t memory_budget_bytes) {
+  SpillingShuffleBuffer::Options options;
+  options.directory = io::JoinPath(testing::TmpDir(), "spill");
+  options.memory_budget_bytes = memory_budget_bytes;
+  options.max_run_bytes = 1024;
+  options.read_ahead = 8;
+  return options;
+}
+
+// An element of an int64 scalar and a string vector that identify it. All
+// elements have the same size.
+std::vector<Tensor> MakeElement(int64_t i) {
+  return {test::AsScalar<int64_t>(i),
+          test::AsTensor<tstring>(
+              {strings::Printf("element %06lld", static_cast<long long>(i)),
+               "x"})};
+}
+
+void ExpectElement(int64_t i, const std::vector<Tensor>& element) {
+  ASSERT_EQ(2, element.size());
+  test::ExpectEqual(MakeElement(i)[0], element[0]);
+  test::ExpectEqual(MakeElement(i)[1], element[1]);
+}
+
+TEST(SpillingShuffleBufferTest, PutTakeAndMove) {
+  std::unique_ptr<SpillingShuffleBuffer> buffer;
+  TF_ASSERT_OK(SpillingShuffleBuffer::Create(
+      Env::Default(), CreateOptions(/*memory_budget_bytes=*/0), 4, &buffer));
+  EXPECT_EQ(4, buffer->size());
+  for (int64_t i = 0; i < 4; ++i) {
+    TF_ASSERT_OK(buffer->Put(i, MakeElement(i)));
+  }
+  EXPECT_EQ(4, buffer->num_spilled());
+  EXPECT_EQ(0, buffer->memory_bytes());
+
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(buffer->Get(2, &element));
+  ExpectElement(2, element);
+  TF_ASSERT_OK(buffer->Take(2, &element));
+  ExpectElement(2, element);
+  buffer->Move(0, 2);
+  TF_ASSERT_OK(buffer->Get(0, &element));
+  EXPECT_TRUE(element.empty());
+  EXPECT_FALSE(buffer->Take(0, &element).ok());
+  TF_ASSERT_OK(buffer->Take(2, &element));
+  ExpectElement(0, element);
+  EXPECT_EQ(2, buffer->num_spilled());
+
+  TF_ASSERT_OK(buffer->PushBack(MakeElement(4)));
+  EXPECT_EQ(5, buffer->size());
+  TF_ASSERT_OK(buffer->Take(4, &element));
+  ExpectElement(4, element);
+}
+
+TEST(SpillingShuffleBufferTest, KeepsElementsWithinMemoryBudget) {
+  const int64_t element_bytes = GetTotalBytes(MakeElement(0));
+  std::unique_ptr<SpillingShuffleBuffer> buffer;
+  TF_ASSERT_OK(SpillingShuffleBuffer::Create(
+      Env::Default(), CreateOptions(3 * element_bytes), 10, &buffer));
+  for (int64_t i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(buffer->Put(i, MakeElement(i)));
+  }
+  EXPECT_EQ(3 * element_bytes, buffer->memory_bytes());
+  EXPECT_EQ(7, buffer->num_spilled());
+
+  // Taking an element from memory makes room for the next one.
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(buffer->Take(1, &element));
+  ExpectElement(1, element);
+  TF_ASSERT_OK(buffer->Put(1, MakeElement(10)));
+  EXPECT_EQ(3 * element_bytes, buffer->memory_bytes());
+  EXPECT_EQ(7, buffer->num_spilled());
+}
+
+TEST(SpillingShuffleBufferTest, DeletesRunsOfTakenElements) {
+  std::unique_ptr<SpillingShuffleBuffer> buffer;
+  TF_ASSERT_OK(SpillingShuffleBuffer::Create(
+      Env::Default(), CreateOptions(/*memory_budget_bytes=*/0), 100, &buffer));
+  for (int64_t i = 0; i < 100; ++i) {
+    TF_ASSERT_OK(buffer->Put(i, MakeElement(i)));
+  }
+  EXPECT_GT(buffer->num_runs(), 2);
+  std::vector<Tensor> element;
+  for (int64_t i = 0; i < 100; ++i) {
+    TF_ASSERT_OK(buffer->Take(i, &element));
+    ExpectElement(i, element);
+  }
+  // Only the run that is being appended to is left.
+  EXPECT_EQ(1, buffer->num_runs());
+}
+
+// Runs the sampling of `ShuffleDatasetOp` with fixed seeds over `num_elements`
+// input elements, and returns the order in which it produces them. Like the
+// shuffle iterator, it plans the next takes before every step by replaying
+// the random number generator.
+std::vector<int64_t> Shuffle(SpillingShuffleBuffer* buffer,
+                             int64_t num_elements) {
+  const int64_t size = buffer->size();
+  random::PhiloxRandom parent_generator(7, 11);
+  random::SingleSampleAdapter<random::PhiloxRandom> generator(
+      &parent_generator);
+  int64_t start = 0;
+  int64_t end = 0;
+  std::vector<int64_t> output;
+  std::vector<Tensor> element;
+  while (start < num_elements) {
+    while (end < num_elements && end - start < size) {
+      TF_CHECK_OK(buffer->Put(end % size, MakeElement(end)));
+      ++end;
+    }
+    random::PhiloxRandom plan_parent(7, 11);
+    random::SingleSampleAdapter<random::PhiloxRandom> plan_generator(
+        &plan_parent);
+    plan_generator.Skip(output.size());
+    std::vector<SpillingShuffleBuffer::PlannedTake> takes;
+    for (int64_t s = start, e = end; s < e && takes.size() < 16; ++s) {
+      takes.push_back({(s + plan_generator() % (e - s)) % size, s % size});
+      if (e < num_elements) ++e;
+    }
+    buffer->Prefetch(takes);
+
+    const int64_t index = (start + generator() % (end - start)) % size;
+    TF_CHECK_OK(buffer->Take(index, &element));
+    if (index != start % size) buffer->Move(start % size, index);
+    output.push_back(element[0].scalar<int64_t>()());
+    ++start;
+  }
+  return output;
+}
+
+TEST(SpillingShuffleBufferTest, ShuffleIsIndependentOfMemoryBudget) {
+  std::unique_ptr<SpillingShuffleBuffer> in_memory;
+  TF_ASSERT_OK(SpillingShuffleBuffer::Create(
+      Env::Default(), CreateOptions(/*memory_budget_bytes=*/1LL << 30), 50,
+      &in_memory));
+  const std::vector<int64_t> expected = Shuffle(in_memory.get(), 1000);
+  EXPECT_EQ(0, in_memory->num_runs());
+
+  for (int64_t budget_elements : {0, 10, 40}) {
+    std::unique_ptr<SpillingShuffleBuffer> spilling;
+    TF_ASSERT_OK(SpillingShuffleBuffer::Create(
+        Env::Default(),
+        CreateOptions(budget_elements * GetTotalBytes(MakeElement(0))), 50,
+        &spilling));
+    EXPECT_EQ(expected, Shuffle(spilling.get(), 1000));
+    EXPECT_EQ(0, spilling->num_spilled());
+  }
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -95,17 +95,48 @@ Status InitializableLookupTable::Initialize(
   if (!errors::IsOutOfRange(iter.status())) {
     return iter.status();
   }
+  TF_RETURN_IF_ERROR(DoFinalize());
 
   initializer_serializer_ = std::move(serializer);
   is_initialized_.store(true, std::memory_order_release);
   return OkStatus();
 }
 
+Status InitializableLookupTable::InitializeFromSavedTable(
+    Env* env, const string& filename,
+    std::unique_ptr<InitializerSerializer>* serializer) {
+  mutex_lock l(mu_);
+  if (is_initialized()) {
+    bool result;
+    TF_RETURN_IF_ERROR(AreSavedEntriesSame(env, filename, &result));
+    // If the table is already initialized, we make sure that the entries in the
+    // table are the same that we want to initialize the table with.
+    if (!result) {
+      return errors::FailedPrecondition(
+          "Table was already initialized with "
+          "different data.");
+    } else {
+      return OkStatus();
+    }
+  }
+  TF_RETURN_IF_ERROR(DoLoad(env, filename));
+  initializer_serializer_ = std::move(*serializer);
+  is_initialized_.store(true, std::memory_order_release);
+  return OkStatus();
+}
+
 Status InitializableLookupTable::AreEntriesSame(const InitTableIterator& iter,
                                                 bool* result) {
   *result = static_cast<size_t>(iter.total_size()) == size();
   return OkStatus();
 }
 
+Status InitializableLookupTable::AreSavedEntriesSame(Env* env,
+                                                     const string& filename,
+                                                     bool* result) {
+  return errors::Unimplemented("Load not supported by ",
+                               "InitializableLookupTable implementations");
+}
+
 }  // namespace lookup
 }  // namespace tensorflow
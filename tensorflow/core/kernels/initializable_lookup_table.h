@@ -19,6 +19,7 @@ limitations under the License.
 #include <atomic>
 
 #include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
 
 namespace tensorflow {
@@ -100,6 +101,28 @@ class InitializableLookupTable : public LookupInterface {
   Status Initialize(InitTableIterator& iter,
                     std::unique_ptr<InitializerSerializer> serializer);
 
+  // Initializes the table from `filename`, a file that `Save` of a table of
+  // the same type wrote. On success, takes ownership of `*serializer`.
+  //
+  // Returns the following statuses:
+  // - OK: when the table was initialized from the file, or was already
+  //   initialized with the same entries.
+  // - FailedPrecondition: if the table was already initialized with different
+  //   entries.
+  // - Unimplemented: if the table does not support saving.
+  // - In addition, errors from reading and validating the file.
+  Status InitializeFromSavedTable(
+      Env* env, const string& filename,
+      std::unique_ptr<InitializerSerializer>* serializer);
+
+  // Writes the contents of the initialized table to `filename`, in a form
+  // that `InitializeFromSavedTable` loads faster than re-running the
+  // initializer. Returns Unimplemented if the table does not support it.
+  virtual Status Save(Env* env, const string& filename) const {
+    return errors::Unimplemented("Save not supported by ",
+                                 "InitializableLookupTable implementations");
+  }
+
   // Basic iterator to initialize lookup tables.
   // It yields a sequence of pairs of `keys()` and `values()` Tensors, so that
   // the consumer may insert key-value pairs in batches.
@@ -195,12 +218,26 @@ class InitializableLookupTable : public LookupInterface {
   // underlying data structure.
   virtual Status DoInsert(const Tensor& keys, const Tensor& values) = 0;
 
+  // Called once all entries were inserted, before the table is marked as
+  // initialized.
+  virtual Status DoFinalize() { return OkStatus(); }
+
+  // Initializes the underlying data structure from a file that `Save` wrote.
+  virtual Status DoLoad(Env* env, const string& filename) {
+    return errors::Unimplemented("Load not supported by ",
+                                 "InitializableLookupTable implementations");
+  }
+
   // Performs the batch find operation on the underlying data structure.
   virtual Status DoFind(const Tensor& keys, Tensor* values,
                         const Tensor& default_value) = 0;
 
   virtual Status AreEntriesSame(const InitTableIterator& iter, bool* result);
 
+  // Like AreEntriesSame, for the entries of a file that `Save` wrote.
+  virtual Status AreSavedEntriesSame(Env* env, const string& filename,
+                                     bool* result);
+
   mutex mu_;
 
  protected:
@@ -15,15 +15,25 @@ limitations under the License.
 
 // Tests kernels of lookup ops.
 
+#include <cstdlib>
+#include <typeinfo>
+
+#include "absl/strings/match.h"
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/initializable_lookup_table.h"
 #include "tensorflow/core/kernels/lookup_table_op.h"
+#include "tensorflow/core/kernels/lookup_util.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -100,5 +110,139 @@ TEST_F(LookupOpsTest, AnonymousHashTable_RefCounting) {
   EXPECT_FALSE(alive);
 }
 
+
+TEST_F(LookupOpsTest, AnonymousHashTable_PerfectHashTableSavedToCache) {
+  // The table type is chosen once per process, so this must be the first
+  // test in this binary that creates a HashTable.
+  // Key and value indices of TextFileIndex.WHOLE_LINE and LINE_NUMBER.
+  constexpr int32_t kWholeLine = -2;
+  constexpr int32_t kLineNumber = -1;
+  setenv("TF_LOOKUP_USE_PERFECT_HASH_TABLE", "true", /*overwrite=*/1);
+  Env* env = Env::Default();
+  const string dir = io::JoinPath(testing::TmpDir(), "perfect_hash_table");
+  const string cache_dir = io::JoinPath(dir, "cache");
+  TF_ASSERT_OK(env->RecursivelyCreateDir(cache_dir));
+  setenv("TF_LOOKUP_TABLE_CACHE_DIR", cache_dir.c_str(), /*overwrite=*/1);
+  const string vocab_file = io::JoinPath(dir, "vocab.txt");
+  TF_ASSERT_OK(WriteStringToFile(env, vocab_file, "a\nb\nc\n"));
+
+  TF_ASSERT_OK(NodeDefBuilder("anonymous_hash_table", "AnonymousHashTable")
+                   .Attr("key_dtype", DT_STRING)
+                   .Attr("value_dtype", DT_INT64)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // Returns a new table. Every run of the kernel creates one, which lives as
+  // long as the returned reference.
+  auto new_table = [this]() -> core::RefCountPtr<lookup::LookupInterface> {
+    TF_EXPECT_OK(RunOpKernel());
+    ResourceHandle& handle = GetOutput(0)->scalar<ResourceHandle>()();
+    auto table_or = handle.GetResource<lookup::LookupInterface>();
+    TF_EXPECT_OK(table_or.status());
+    if (!table_or.ok()) return nullptr;
+    table_or.value()->Ref();
+    return core::RefCountPtr<lookup::LookupInterface>(table_or.value());
+  };
+  auto expect_lookups = [this](lookup::LookupInterface* table,
+                               const std::vector<tstring>& keys,
+                               const std::vector<int64_t>& expected) {
+    Tensor values(DT_INT64, TensorShape({static_cast<int64_t>(keys.size())}));
+    TF_ASSERT_OK(table->Find(context_.get(), test::AsTensor<tstring>(keys),
+                             &values, test::AsScalar<int64_t>(-1)));
+    test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>(expected),
+                                     values);
+  };
+
+  // Initializing from the text file saves the table to the cache.
+  core::RefCountPtr<lookup::LookupInterface> table = new_table();
+  ASSERT_TRUE(table);
+  EXPECT_TRUE(absl::StrContains(typeid(*table).name(), "PerfectHashTable"));
+  lookup::InitializableLookupTable* text_table =
+      table->GetInitializableLookupTable();
+  ASSERT_NE(text_table, nullptr);
+  TF_ASSERT_OK(lookup::InitializeTableFromTextFile(
+      vocab_file, /*vocab_size=*/-1, '\t', kWholeLine,
+      kLineNumber, /*offset=*/0, env, text_table));
+  expect_lookups(table.get(), {"a", "b", "c", "d"}, {0, 1, 2, -1});
+  std::vector<string> children;
+  TF_ASSERT_OK(env->GetChildren(cache_dir, &children));
+  ASSERT_EQ(children.size(), 1);
+  EXPECT_TRUE(absl::EndsWith(children[0], ".table"));
+  const string saved_table = io::JoinPath(cache_dir, children[0]);
+
+  // Replace the saved table with a different one. A table initialized from
+  // the same text file now loads the replacement instead of the text file.
+  core::RefCountPtr<lookup::LookupInterface> other_table = new_table();
+  ASSERT_TRUE(other_table);
+  TF_ASSERT_OK(other_table->ImportValues(context_.get(),
+                                         test::AsTensor<tstring>({"x", "y"}),
+                                         test::AsTensor<int64_t>({7, 8})));
+  const string other_saved_table = io::JoinPath(dir, "other.table");
+  TF_ASSERT_OK(other_table->GetInitializableLookupTable()->Save(
+      env, other_saved_table));
+  TF_ASSERT_OK(env->CopyFile(other_saved_table, saved_table));
+
+  core::RefCountPtr<lookup::LookupInterface> cached_table = new_table();
+  ASSERT_TRUE(cached_table);
+  TF_ASSERT_OK(lookup::InitializeTableFromTextFile(
+      vocab_file, /*vocab_size=*/-1, '\t', kWholeLine,
+      kLineNumber, /*offset=*/0, env,
+      cached_table->GetInitializableLookupTable()));
+  EXPECT_EQ(cached_table->size(), 2);
+  expect_lookups(cached_table.get(), {"a", "x", "y"}, {-1, 7, 8});
+
+  // Initializing an initialized table again checks the saved entries.
+  const string text_saved_table = io::JoinPath(dir, "text.table");
+  TF_ASSERT_OK(text_table->Save(env, text_saved_table));
+  std::unique_ptr<lookup::InitializableLookupTable::InitializerSerializer>
+      serializer;
+  TF_EXPECT_OK(
+      text_table->InitializeFromSavedTable(env, text_saved_table, &serializer));
+  EXPECT_TRUE(errors::IsFailedPrecondition(text_table->InitializeFromSavedTable(
+      env, other_saved_table, &serializer)));
+  expect_lookups(table.get(), {"a", "b", "c", "x"}, {0, 1, 2, -1});
+}
+
+TEST_F(LookupOpsTest, AnonymousMutableHashTable_ConcurrentHashTable) {
+  // The table type is chosen once per process, so this must be the first
+  // test in this binary that creates a MutableHashTable.
+  setenv("TF_LOOKUP_USE_CONCURRENT_HASH_TABLE", "true", /*overwrite=*/1);
+  TF_ASSERT_OK(NodeDefBuilder("anonymous_mutable_hash_table",
+                              "AnonymousMutableHashTable")
+                   .Attr("key_dtype", DT_INT64)
+                   .Attr("value_dtype", DT_FLOAT)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  TF_ASSERT_OK(RunOpKernel());
+
+  ResourceHandle& handle = GetOutput(0)->scalar<ResourceHandle>()();
+  auto table_or = handle.GetResource<lookup::LookupInterface>();
+  TF_ASSERT_OK(table_or.status());
+  lookup::LookupInterface* table = table_or.value();
+  EXPECT_TRUE(absl::StrContains(typeid(*table).name(),
+                                "MutableConcurrentHashTableOfScalars"));
+
+  OpKernelContext* ctx = context_.get();
+  TF_ASSERT_OK(table->Insert(ctx, test::AsTensor<int64_t>({1, 2, 3}),
+                             test::AsTensor<float>({1.5f, 2.5f, 3.5f})));
+  TF_ASSERT_OK(table->Insert(ctx, test::AsTensor<int64_t>({2}),
+                             test::AsTensor<float>({20.5f})));
+  TF_ASSERT_OK(table->Remove(ctx, test::AsTensor<int64_t>({3})));
+  EXPECT_EQ(2, table->size());
+
+  Tensor values(DT_FLOAT, TensorShape({4}));
+  TF_ASSERT_OK(table->Find(ctx, test::AsTensor<int64_t>({1, 2, 3, 4}),
+                           &values, test::AsScalar<float>(-1.0f)));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1.5f, 20.5f, -1.0f, -1.0f}), values);
+
+  // One default per key.
+  TF_ASSERT_OK(table->Find(ctx, test::AsTensor<int64_t>({1, 2, 3, 4}),
+                           &values,
+                           test::AsTensor<float>({-1.0f, -2.0f, -3.0f,
+                                                  -4.0f})));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1.5f, 20.5f, -3.0f, -4.0f}), values);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -16,17 +16,23 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/kernels/concurrent_hash_map.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/perfect_hash_map.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -36,6 +42,76 @@ std::string UniqueNodeName(const std::string& base) {
   return strings::StrCat(base, "/", counter.fetch_add(1), "/", random::New64());
 }
 
+Status HashTableAsGraphDef(
+    GraphDefBuilder* builder, DataType key_dtype, DataType value_dtype,
+    bool empty, InitializableLookupTable::InitializerSerializer* serializer,
+    Node** out) {
+  // We set use_node_name_sharing with a unique node name so that the resource
+  // can outlive the HashTableV2 kernel. This means that the lifetime of the
+  // HashTable resource will be tied to the lifetime of the resource manager
+  // it is created in.
+  // TODO(b/181695913): Provide a mechanism for deleting this resource
+  // earlier when appropriate.
+  Node* hash_table_node = ops::SourceOp(
+      "HashTableV2", builder->opts()
+                         .WithName(UniqueNodeName("HashTableFromGraphDef"))
+                         .WithAttr("key_dtype", key_dtype)
+                         .WithAttr("value_dtype", value_dtype)
+                         .WithAttr("use_node_name_sharing", true));
+  if (empty) {
+    *out = hash_table_node;
+    return OkStatus();
+  }
+
+  if (serializer == nullptr) {
+    std::string message =
+        "Failed to serialize lookup table: no initialization function was "
+        "specified. Falling back to serializing a handle to the table.";
+    LOG(WARNING) << message;
+    return errors::Unimplemented(message);
+  }
+  Node* initializer;
+  TF_RETURN_IF_ERROR(
+      serializer->AsGraphDef(builder, hash_table_node, &initializer));
+  *out = ops::UnaryOp("Identity", hash_table_node,
+                      builder->opts().WithControlInput(initializer));
+  return OkStatus();
+}
+
+// Adds a graph to `builder` that recreates a MutableHashTableV2 with the given
+// contents.
+Status MutableHashTableAsGraphDef(GraphDefBuilder* builder, const Tensor& keys,
+                                  const Tensor& values, Node** out) {
+  // We set use_node_name_sharing with a unique node name so that the resource
+  // can outlive the MutableHashTableV2 kernel. This means that the lifetime
+  // of the resource will be tied to the lifetime of the resource manager it
+  // is created in.
+  // TODO(b/181695913): Provide a mechanism for deleting this resource
+  // earlier when appropriate.
+  Node* table = ops::SourceOp(
+      "MutableHashTableV2",
+      builder->opts()
+          .WithName(UniqueNodeName("MutableHashTableFromGraphDef"))
+          .WithAttr("use_node_name_sharing", true)
+          .WithAttr("key_dtype", keys.dtype())
+          .WithAttr("value_dtype", values.dtype()));
+  Node* keys_node = ops::SourceOp(
+      "Const",
+      builder->opts().WithAttr("dtype", keys.dtype()).WithAttr("value", keys));
+  Node* values_node =
+      ops::SourceOp("Const", builder->opts()
+                                 .WithAttr("dtype", values.dtype())
+                                 .WithAttr("value", values));
+  Node* import_table =
+      ops::TernaryOp("LookupTableImportV2", table, keys_node, values_node,
+                     builder->opts()
+                         .WithAttr("Tin", keys.dtype())
+                         .WithAttr("Tout", values.dtype()));
+  *out = ops::UnaryOp("Identity", table,
+                      builder->opts().WithControlInput(import_table));
+  return OkStatus();
+}
+
 // Lookup table that wraps an unordered_map, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
@@ -163,35 +239,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
     Tensor keys(key_dtype(), TensorShape({size}));
     Tensor values(value_dtype(), TensorShape({size}));
     ExportKeysAndValues(&keys, &values);
-
-    // We set use_node_name_sharing with a unique node name so that the resource
-    // can outlive the MutableHashTableV2 kernel. This means that the lifetime
-    // of the resource will be tied to the lifetime of the resource manager it
-    // is created in.
-    // TODO(b/181695913): Provide a mechanism for deleting this resource
-    // earlier when appropriate.
-    Node* table = ops::SourceOp(
-        "MutableHashTableV2",
-        builder->opts()
-            .WithName(UniqueNodeName("MutableHashTableFromGraphDef"))
-            .WithAttr("use_node_name_sharing", true)
-            .WithAttr("key_dtype", key_dtype())
-            .WithAttr("value_dtype", value_dtype()));
-    Node* keys_node = ops::SourceOp(
-        "Const",
-        builder->opts().WithAttr("dtype", key_dtype()).WithAttr("value", keys));
-    Node* values_node =
-        ops::SourceOp("Const", builder->opts()
-                                   .WithAttr("dtype", value_dtype())
-                                   .WithAttr("value", values));
-    Node* import_table =
-        ops::TernaryOp("LookupTableImportV2", table, keys_node, values_node,
-                       builder->opts()
-                           .WithAttr("Tin", key_dtype())
-                           .WithAttr("Tout", value_dtype()));
-    *out = ops::UnaryOp("Identity", table,
-                        builder->opts().WithControlInput(import_table));
-    return OkStatus();
+    return MutableHashTableAsGraphDef(builder, keys, values, out);
   }
 
  private:
@@ -212,6 +260,266 @@ class MutableHashTableOfScalars final : public LookupInterface {
   std::unordered_map<K, V> table_ TF_GUARDED_BY(mu_);
 };
 
+// Returns whether MutableHashTable kernels create a
+// MutableConcurrentHashTableOfScalars where the key and value types allow it.
+bool UseConcurrentHashTable() {
+  static const bool use_concurrent_hash_table = [] {
+    bool value;
+    Status status = ReadBoolFromEnvVar("TF_LOOKUP_USE_CONCURRENT_HASH_TABLE",
+                                       /*default_val=*/false, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return false;
+    }
+    return value;
+  }();
+  return use_concurrent_hash_table;
+}
+
+// Behaves like MutableHashTableOfScalars, but stores the table in a
+// ConcurrentHashMap, so that lookups neither take a lock nor write shared
+// memory. Lookups from many threads then scale instead of contending on the
+// cache line of a shared lock, which makes this table a better fit for large
+// read-mostly tables such as vocabularies that are served by many inference
+// threads. Only integral keys and arithmetic values are supported.
+template <class K, class V>
+class MutableConcurrentHashTableOfScalars final : public LookupInterface {
+ public:
+  MutableConcurrentHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
+
+  size_t size() const override { return table_.size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+    const auto default_flat = default_value.flat<V>();
+    // See MutableHashTableOfScalars::Find() for the two kinds of defaults.
+    table_.Find(key_values.data(), key_values.size(), default_flat.data(),
+                /*per_key_defaults=*/value_values.size() == default_flat.size(),
+                value_values.data());
+    return OkStatus();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+    table_.InsertOrAssign(key_values.data(), value_values.data(),
+                          key_values.size());
+    return OkStatus();
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+    table_.Erase(key_values.data(), key_values.size());
+    return OkStatus();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+    // Readers may see the table empty in between, as with the other mutable
+    // tables.
+    table_.Clear();
+    table_.InsertOrAssign(key_values.data(), value_values.data(),
+                          key_values.size());
+    return OkStatus();
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    std::vector<std::pair<K, V>> entries = Entries();
+    const int64_t size = entries.size();
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("values", TensorShape({size}), &values));
+    ExportEntries(entries, keys, values);
+    return OkStatus();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  int64_t MemoryUsed() const override {
+    return sizeof(MutableConcurrentHashTableOfScalars) + table_.MemoryUsed();
+  }
+
+  Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
+    std::vector<std::pair<K, V>> entries = Entries();
+    const int64_t size = entries.size();
+    Tensor keys(key_dtype(), TensorShape({size}));
+    Tensor values(value_dtype(), TensorShape({size}));
+    ExportEntries(entries, &keys, &values);
+    return MutableHashTableAsGraphDef(builder, keys, values, out);
+  }
+
+ private:
+  // Returns a consistent snapshot of the table.
+  std::vector<std::pair<K, V>> Entries() const {
+    std::vector<std::pair<K, V>> entries;
+    entries.reserve(table_.size());
+    table_.ForEach(
+        [&entries](K key, V value) { entries.emplace_back(key, value); });
+    return entries;
+  }
+
+  static void ExportEntries(const std::vector<std::pair<K, V>>& entries,
+                            Tensor* keys, Tensor* values) {
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    for (int64_t i = 0; i < entries.size(); ++i) {
+      keys_data(i) = entries[i].first;
+      values_data(i) = entries[i].second;
+    }
+  }
+
+  ConcurrentHashMap<K, V> table_;
+};
+
+// Returns whether HashTable kernels create a PerfectHashTable where the key
+// and value types allow it.
+bool UsePerfectHashTable() {
+  static const bool use_perfect_hash_table = [] {
+    bool value;
+    Status status = ReadBoolFromEnvVar("TF_LOOKUP_USE_PERFECT_HASH_TABLE",
+                                       /*default_val=*/false, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return false;
+    }
+    return value;
+  }();
+  return use_perfect_hash_table;
+}
+
+// Behaves like HashTable, but once initialized stores the table in a
+// PerfectHashMap, so that every lookup reads at most one entry. Entries are
+// collected while the table is initialized and the map is built from all of
+// them at the end. The table can be saved to a file and initialized from it
+// again, which memory-maps the map instead of rebuilding it.
+template <class K, class V>
+class PerfectHashTable final : public InitializableLookupTable {
+ public:
+  PerfectHashTable(OpKernelContext* ctx, OpKernel* kernel) {}
+
+  Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
+    return HashTableAsGraphDef(builder, key_dtype(), value_dtype(), size() == 0,
+                               initializer_serializer_.get(), out);
+  }
+
+  size_t size() const override {
+    return is_initialized() ? map_->size() : 0;
+  }
+
+  Status ExportValues(OpKernelContext* context) override {
+    if (!is_initialized()) {
+      return errors::Aborted("HashTable is not initialized.");
+    }
+    const int64_t size = map_->size();
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        context->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(
+        context->allocate_output("values", TensorShape({size}), &values));
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    int64_t i = 0;
+    map_->ForEach([&](const K& key, V value) {
+      keys_data(i) = key;
+      values_data(i) = value;
+      ++i;
+    });
+    return OkStatus();
+  }
+
+  Status Save(Env* env, const string& filename) const override {
+    if (!is_initialized()) {
+      return errors::FailedPrecondition("Table not initialized.");
+    }
+    return map_->Save(env, filename);
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  int64_t MemoryUsed() const override {
+    return is_initialized() ? map_->MemoryUsed() : 0;
+  }
+
+ protected:
+  Status DoPrepare(size_t size) override {
+    if (is_initialized()) {
+      return errors::Aborted("HashTable already initialized.");
+    }
+    keys_.clear();
+    values_.clear();
+    keys_.reserve(size);
+    values_.reserve(size);
+    return OkStatus();
+  }
+
+  Status DoLazyPrepare(std::function<int64(void)> size_fn) override {
+    return DoPrepare(std::max<int64_t>(size_fn(), 0));
+  }
+
+  Status DoInsert(const Tensor& keys, const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+    keys_.insert(keys_.end(), key_values.data(),
+                 key_values.data() + key_values.size());
+    values_.insert(values_.end(), value_values.data(),
+                   value_values.data() + value_values.size());
+    return OkStatus();
+  }
+
+  Status DoFinalize() override {
+    TF_RETURN_IF_ERROR(PerfectHashMap<K, V>::Build(keys_.data(), values_.data(),
+                                                   keys_.size(), &map_));
+    keys_ = std::vector<K>();
+    values_ = gtl::InlinedVector<V, 4>();
+    return OkStatus();
+  }
+
+  Status DoLoad(Env* env, const string& filename) override {
+    return PerfectHashMap<K, V>::Load(env, filename, &map_);
+  }
+
+  Status AreSavedEntriesSame(Env* env, const string& filename,
+                             bool* result) override {
+    std::unique_ptr<PerfectHashMap<K, V>> saved_map;
+    TF_RETURN_IF_ERROR(PerfectHashMap<K, V>::Load(env, filename, &saved_map));
+    *result = saved_map->size() == size();
+    return OkStatus();
+  }
+
+  Status DoFind(const Tensor& key, Tensor* value,
+                const Tensor& default_value) override {
+    const auto key_values = key.flat<K>();
+    map_->Find(key_values.data(), key_values.size(),
+               default_value.flat<V>()(0), value->flat<V>().data());
+    return OkStatus();
+  }
+
+ private:
+  // The entries inserted so far, while the table is initialized. Values are
+  // not in a std::vector, which has no contiguous storage for bools.
+  std::vector<K> keys_;
+  gtl::InlinedVector<V, 4> values_;
+
+  std::unique_ptr<PerfectHashMap<K, V>> map_;
+};
+
 // Lookup table that wraps an unordered_map. Behaves identical to
 // MutableHashTableOfScalars except that each value must be a vector.
 template <class K, class V>
@@ -520,9 +828,25 @@ class MutableDenseHashTable final : public LookupInterface {
     const auto deleted_key_matrix =
         deleted_key_.template shaped<K, 2>({1, key_size});
     const int64_t bit_mask = num_buckets_ - 1;
+    // Keys are looked up in groups. The home buckets of all keys of a group
+    // are prefetched first, so that their cache misses overlap.
+    constexpr int64_t kGroupSize = 16;
+    uint64 key_hashes[kGroupSize];
     // TODO(andreasst): parallelize using work_sharder
     for (int64_t i = 0; i < num_elements; ++i) {
-      const uint64 key_hash = HashKey(key_matrix, i);
+      if (i % kGroupSize == 0) {
+        const int64_t group_end = std::min(num_elements, i + kGroupSize);
+        for (int64_t k = i; k < group_end; ++k) {
+          const uint64 key_hash = HashKey(key_matrix, k);
+          key_hashes[k - i] = key_hash;
+          const int64_t bucket_index = key_hash & bit_mask;
+          port::prefetch<port::PREFETCH_HINT_T0>(
+              &key_buckets_matrix(bucket_index, 0));
+          port::prefetch<port::PREFETCH_HINT_T0>(
+              &value_buckets_matrix(bucket_index, 0));
+        }
+      }
+      const uint64 key_hash = key_hashes[i % kGroupSize];
       if (empty_key_hash_ == key_hash &&
           IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
         return errors::InvalidArgument(
@@ -1076,6 +1400,21 @@ REGISTER_KERNEL_BUILDER(Name("LookupTableImport").Device(DEVICE_CPU),
 REGISTER_KERNEL_BUILDER(Name("LookupTableImportV2").Device(DEVICE_CPU),
                         LookupTableImportOp);
 
+// Creates a PerfectHashTable instead of a HashTable if
+// TF_LOOKUP_USE_PERFECT_HASH_TABLE is set.
+template <class K, class V>
+struct LookupTableCreator<lookup::HashTable<K, V>> {
+  static lookup::LookupInterface* Create(OpKernelContext* ctx,
+                                         OpKernel* kernel) {
+    if constexpr (lookup::IsPerfectHashMapSupported<K, V>()) {
+      if (lookup::UsePerfectHashTable()) {
+        return new lookup::PerfectHashTable<K, V>(ctx, kernel);
+      }
+    }
+    return new lookup::HashTable<K, V>(ctx, kernel);
+  }
+};
+
 // Register the HashTable op with the currently supported key and value types.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                           \
   REGISTER_KERNEL_BUILDER(                                                \
@@ -1118,6 +1457,22 @@ REGISTER_KERNEL(tstring, tstring);
 
 #undef REGISTER_KERNEL
 
+// Creates a MutableConcurrentHashTableOfScalars instead of a
+// MutableHashTableOfScalars if TF_LOOKUP_USE_CONCURRENT_HASH_TABLE is set.
+template <class K, class V>
+struct LookupTableCreator<lookup::MutableHashTableOfScalars<K, V>> {
+  static lookup::LookupInterface* Create(OpKernelContext* ctx,
+                                         OpKernel* kernel) {
+    if constexpr (lookup::IsConcurrentHashMapSupported<K, V>()) {
+      if (lookup::UseConcurrentHashTable()) {
+        return new lookup::MutableConcurrentHashTableOfScalars<K, V>(ctx,
+                                                                     kernel);
+      }
+    }
+    return new lookup::MutableHashTableOfScalars<K, V>(ctx, kernel);
+  }
+};
+
 // Register the MutableHashTable op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                                \
   REGISTER_KERNEL_BUILDER(                                                     \
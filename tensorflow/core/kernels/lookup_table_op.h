@@ -34,6 +34,16 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Creates the table resource of a LookupTableOp or AnonymousLookupTableOp.
+// Specialized for containers whose implementation is chosen at runtime.
+template <class Container>
+struct LookupTableCreator {
+  static lookup::LookupInterface* Create(OpKernelContext* ctx,
+                                         OpKernel* kernel) {
+    return new Container(ctx, kernel);
+  }
+};
+
 // Lookup table op that supports different table implementations specified by
 // the 'Container' template. Container must be derived from LookupInterface. The
 // key and value are of the templated type "key_dtype" and "value_dtype"
@@ -69,7 +79,8 @@ class LookupTableOp : public OpKernel {
     auto creator =
         [ctx, this](lookup::LookupInterface** ret)
             TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-              lookup::LookupInterface* container = new Container(ctx, this);
+              lookup::LookupInterface* container =
+                  LookupTableCreator<Container>::Create(ctx, this);
               if (!ctx->status().ok()) {
                 container->Unref();
                 return ctx->status();
@@ -145,7 +156,8 @@ class AnonymousLookupTableOp : public OpKernel {
   explicit AnonymousLookupTableOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
 
   void Compute(OpKernelContext* ctx) override {
-    lookup::LookupInterface* table = new Container(ctx, this);
+    lookup::LookupInterface* table =
+        LookupTableCreator<Container>::Create(ctx, this);
     if (!ctx->status().ok()) {
       table->Unref();
       return;
@@ -202,6 +214,13 @@ inline const ResourceHandle& SubtleMustCopyIfIntegral(
 // Returns a unique node name starting with "base".
 std::string UniqueNodeName(const std::string& base);
 
+// Adds a graph to `builder` that recreates a HashTableV2, using `serializer`
+// to initialize it unless the table is `empty`.
+Status HashTableAsGraphDef(
+    GraphDefBuilder* builder, DataType key_dtype, DataType value_dtype,
+    bool empty, InitializableLookupTable::InitializerSerializer* serializer,
+    Node** out);
+
 // Lookup table that wraps an flat_hash_map, where the key and value data type
 // is specified.
 //
@@ -222,36 +241,9 @@ class HashTable : public InitializableLookupTable {
   HashTable(OpKernelContext* ctx, OpKernel* kernel) {}
 
   Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
-    // We set use_node_name_sharing with a unique node name so that the resource
-    // can outlive the HashTableV2 kernel. This means that the lifetime of the
-    // HashTable resource will be tied to the lifetime of the resource manager
-    // it is created in.
-    // TODO(b/181695913): Provide a mechanism for deleting this resource
-    // earlier when appropriate.
-    Node* hash_table_node = ops::SourceOp(
-        "HashTableV2", builder->opts()
-                           .WithName(UniqueNodeName("HashTableFromGraphDef"))
-                           .WithAttr("key_dtype", key_dtype())
-                           .WithAttr("value_dtype", value_dtype())
-                           .WithAttr("use_node_name_sharing", true));
-    if (table_.empty()) {
-      *out = hash_table_node;
-      return OkStatus();
-    }
-
-    if (initializer_serializer_ == nullptr) {
-      std::string message =
-          "Failed to serialize lookup table: no initialization function was "
-          "specified. Falling back to serializing a handle to the table.";
-      LOG(WARNING) << message;
-      return errors::Unimplemented(message);
-    }
-    Node* initializer;
-    TF_RETURN_IF_ERROR(initializer_serializer_->AsGraphDef(
-        builder, hash_table_node, &initializer));
-    *out = ops::UnaryOp("Identity", hash_table_node,
-                        builder->opts().WithControlInput(initializer));
-    return OkStatus();
+    return HashTableAsGraphDef(builder, key_dtype(), value_dtype(),
+                               table_.empty(), initializer_serializer_.get(),
+                               out);
   }
 
   size_t size() const override {
@@ -24,7 +24,12 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace lookup {
@@ -57,6 +62,61 @@ Status GetNumLinesInTextFile(Env* env, const string& vocab_file,
   return OkStatus();
 }
 
+// Returns the file in the directory TF_LOOKUP_TABLE_CACHE_DIR in which a table
+// that is initialized from `vocab_file` with the given arguments is saved, or
+// an empty string if that variable is not set. The name depends on the size
+// and modification time of `vocab_file`, so that changing the file
+// invalidates saved tables.
+string SavedTableFilename(const string& vocab_file, int64_t vocab_size,
+                          char delimiter, int32_t key_index,
+                          int32_t value_index, int64_t offset, Env* env,
+                          const InitializableLookupTable& table) {
+  string cache_dir;
+  Status s = ReadStringFromEnvVar("TF_LOOKUP_TABLE_CACHE_DIR",
+                                  /*default_val=*/"", &cache_dir);
+  if (!s.ok() || cache_dir.empty()) {
+    return "";
+  }
+  FileStatistics stat;
+  s = env->Stat(vocab_file, &stat);
+  if (!s.ok()) {
+    return "";
+  }
+  const string key = strings::StrCat(
+      vocab_file, ":", stat.length, ":", stat.mtime_nsec, ":", vocab_size, ":",
+      static_cast<int>(delimiter), ":", key_index, ":", value_index, ":",
+      offset, ":", DataTypeString(table.key_dtype()), ":",
+      DataTypeString(table.value_dtype()));
+  return io::JoinPath(
+      cache_dir,
+      strings::StrCat(io::Basename(vocab_file), ".",
+                      strings::Hex(Hash64(key), strings::kZeroPad16),
+                      ".table"));
+}
+
+// Saves `table` to `filename` if the table supports it. Failures are logged
+// and otherwise ignored, since the table is usable either way.
+void SaveTable(const InitializableLookupTable& table, const string& filename,
+               Env* env) {
+  // Write to a temporary file first so that concurrent readers never see a
+  // partially written table.
+  const string tmp_filename = strings::StrCat(
+      filename, ".tmp.", strings::Hex(random::New64(), strings::kZeroPad16));
+  Status s = table.Save(env, tmp_filename);
+  if (s.ok()) {
+    s = env->RenameFile(tmp_filename, filename);
+  }
+  if (!s.ok()) {
+    env->DeleteFile(tmp_filename).IgnoreError();
+    if (!absl::IsUnimplemented(s)) {
+      LOG(WARNING) << "Failed to save lookup table to " << filename << ": "
+                   << s;
+    }
+    return;
+  }
+  VLOG(1) << "Saved lookup table to " << filename;
+}
+
 // Iterator that reads a text file. Each iteration process one line, it parses
 // the line and populates the keys and values tensors used for initialization
 // with a single key and corresponding value.
@@ -401,6 +461,24 @@ Status InitializeTableFromTextFile(
         DataTypeString(table->value_dtype()));
   }
 
+  const string saved_table_filename =
+      SavedTableFilename(filename, vocab_size, delimiter, key_index,
+                         value_index, offset, env, *table);
+  if (!saved_table_filename.empty() &&
+      env->FileExists(saved_table_filename).ok()) {
+    Status s = table->InitializeFromSavedTable(env, saved_table_filename,
+                                               &serializer);
+    if (s.ok()) {
+      VLOG(1) << "Initialized table from file " << filename << " from "
+              << saved_table_filename;
+      return OkStatus();
+    }
+    if (!absl::IsUnimplemented(s)) {
+      LOG(WARNING) << "Failed to load lookup table from "
+                   << saved_table_filename << ": " << s;
+    }
+  }
+
   TextFileLineIterator iter;
   TF_RETURN_IF_ERROR(iter.Init(filename, vocab_size, delimiter, key_dtype,
                                key_index, value_dtype, value_index, offset,
@@ -415,6 +493,9 @@ Status InitializeTableFromTextFile(
               << " is already initialized.";
     return OkStatus();
   }
+  if (s.ok() && !saved_table_filename.empty()) {
+    SaveTable(*table, saved_table_filename, env);
+  }
   return s;
 }
 
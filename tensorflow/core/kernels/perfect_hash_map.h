@@ -0,0 +1,568 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_PERFECT_HASH_MAP_H_
+#define TENSORFLOW_CORE_KERNELS_PERFECT_HASH_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// Returns whether a PerfectHashMap can map `K` to `V`.
+template <typename K, typename V>
+constexpr bool IsPerfectHashMapSupported() {
+  return (std::is_same_v<K, int32> || std::is_same_v<K, int64_t> ||
+          std::is_same_v<K, tstring>) &&
+         std::is_arithmetic_v<V>;
+}
+
+namespace perfect_hash_map_internal {
+
+// Bumped whenever the image layout or the hash functions change.
+constexpr uint32 kFormatVersion = 1;
+
+// Reads as a different value on a machine of the other byte order.
+constexpr uint64 kMagic = 0x3130544854504654ULL;  // "TFPHTT01"
+
+constexpr size_t kSectionAlignment = 64;
+
+struct Header {
+  uint64 magic;
+  uint32 version;
+  uint32 key_dtype;
+  uint32 value_dtype;
+  uint32 entry_size;
+  uint64 seed;
+  uint64 num_keys;
+  uint64 num_slots;
+  uint64 num_buckets;
+  uint64 pilots_offset;
+  uint64 remap_offset;
+  uint64 entries_offset;
+  uint64 key_data_offset;
+  uint64 key_data_size;
+  uint64 total_size;
+};
+
+inline uint64 RoundUpToSectionAlignment(uint64 offset) {
+  return (offset + kSectionAlignment - 1) / kSectionAlignment *
+         kSectionAlignment;
+}
+
+// A slot of the table. Integer keys are stored inline. String keys are stored
+// as a range of the key data section, together with 32 bits of their hash so
+// that most misses are decided without touching the key data.
+template <typename K, typename V>
+struct Entry {
+  K key;
+  V value;
+};
+
+template <typename V>
+struct Entry<tstring, V> {
+  uint64 key_offset;
+  uint32 key_size;
+  uint32 key_hash;
+  V value;
+};
+
+// Returns the key of a string entry. Bounds are checked here rather than when
+// loading an image, so that loading does not need to touch every entry.
+template <typename V>
+StringPiece KeyOf(const Entry<tstring, V>& entry, const char* key_data,
+                  uint64 key_data_size) {
+  if (entry.key_offset > key_data_size ||
+      entry.key_size > key_data_size - entry.key_offset) {
+    return StringPiece();
+  }
+  return StringPiece(key_data + entry.key_offset, entry.key_size);
+}
+
+}  // namespace perfect_hash_map_internal
+
+// An immutable hash map that is built once from all of its entries, for
+// tables such as vocabularies that are fully known at initialization.
+//
+// Keys are placed with a minimal perfect hash function in the style of PTHash:
+// keys are hashed into buckets of a few keys, and every
+// bucket stores a "pilot" such that hashing its keys together with the pilot
+// sends them to slots that no other key occupies. A lookup therefore hashes
+// the key, reads the pilot of its bucket and compares the one slot the key can
+// be in. Pilots are searched for in a table that is slightly larger than the
+// number of keys, and the few keys that land past the end are redirected to
+// the free slots before it through a small remapping array, so the entry
+// array has no holes.
+//
+// Lookups of a batch of keys proceed in groups: all hashes of a group are
+// computed first, which the compiler can vectorize for integer keys, and the
+// pilots and then the entries of the group are prefetched before they are
+// read, so that the cache misses of a group overlap.
+//
+// The map lives in a single image of 64-byte aligned sections, which `Save`
+// writes as is. `Load` maps a saved image into memory instead of rebuilding
+// the map, so that large vocabularies load in time independent of their size.
+// Images store integers in the byte order of the machine that wrote them;
+// loading an image of the other byte order fails.
+//
+// The map is thread-safe, since it is never modified.
+template <typename K, typename V>
+class PerfectHashMap {
+ public:
+  static_assert(IsPerfectHashMapSupported<K, V>(),
+                "Unsupported key or value type");
+
+  // Builds a map from `num_keys` keys and values. A key may occur more than
+  // once, but only with the same value.
+  static Status Build(const K* keys, const V* values, int64_t num_keys,
+                      std::unique_ptr<PerfectHashMap>* map) {
+    if (num_keys >= std::numeric_limits<uint32>::max() / 2) {
+      return errors::InvalidArgument("Too many keys for a PerfectHashMap: ",
+                                     num_keys);
+    }
+    Status status;
+    for (int attempt = 0; attempt < kMaxSeeds; ++attempt) {
+      const uint64 seed = Mix(0x9e3779b97f4a7c15ULL * (attempt + 1));
+      std::unique_ptr<PerfectHashMap> result(new PerfectHashMap());
+      status = result->BuildWithSeed(keys, values, num_keys, seed);
+      if (status.ok()) {
+        *map = std::move(result);
+        return OkStatus();
+      }
+      if (!errors::IsAborted(status)) return status;
+    }
+    return errors::Internal("Failed to build a perfect hash function for ",
+                            num_keys, " keys: ", status.message());
+  }
+
+  // Loads a map that `Save` wrote to `filename`. The file is memory-mapped if
+  // its file system supports it, and read into memory otherwise.
+  static Status Load(Env* env, const string& filename,
+                     std::unique_ptr<PerfectHashMap>* map) {
+    std::unique_ptr<PerfectHashMap> result(new PerfectHashMap());
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    Status status = env->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    if (status.ok()) {
+      result->region_ = std::move(region);
+      result->image_ = static_cast<const char*>(result->region_->data());
+      result->image_size_ = result->region_->length();
+    } else if (errors::IsUnimplemented(status)) {
+      string contents;
+      TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+      result->Allocate(contents.size());
+      std::memcpy(result->buffer_.get(), contents.data(), contents.size());
+    } else {
+      return status;
+    }
+    TF_RETURN_IF_ERROR(result->ParseImage());
+    *map = std::move(result);
+    return OkStatus();
+  }
+
+  PerfectHashMap(const PerfectHashMap&) = delete;
+  PerfectHashMap& operator=(const PerfectHashMap&) = delete;
+
+  // Writes the image of the map to `filename`.
+  Status Save(Env* env, const string& filename) const {
+    return WriteStringToFile(env, filename, StringPiece(image_, image_size_));
+  }
+
+  size_t size() const { return num_keys_; }
+
+  // Returns the size of the image, including parts that are memory-mapped
+  // but not resident.
+  size_t MemoryUsed() const { return sizeof(*this) + image_size_; }
+
+  // Returns whether the image is memory-mapped from a file.
+  bool is_mapped() const { return region_ != nullptr; }
+
+  // Sets `values[i]` to the value of `keys[i]`, or to `default_value` if the
+  // key is missing.
+  void Find(const K* keys, int64_t num_keys, V default_value,
+            V* values) const {
+    if (num_keys_ == 0) {
+      std::fill(values, values + num_keys, default_value);
+      return;
+    }
+    uint64 hashes[kGroupSize];
+    uint64 slots[kGroupSize];
+    for (int64_t start = 0; start < num_keys; start += kGroupSize) {
+      const int n = std::min<int64_t>(kGroupSize, num_keys - start);
+      for (int i = 0; i < n; ++i) {
+        hashes[i] = HashKey(keys[start + i], seed_);
+      }
+      for (int i = 0; i < n; ++i) {
+        port::prefetch<port::PREFETCH_HINT_T0>(
+            &pilots_[Reduce(hashes[i], num_buckets_)]);
+      }
+      for (int i = 0; i < n; ++i) {
+        slots[i] = Slot(hashes[i]);
+        port::prefetch<port::PREFETCH_HINT_T0>(&entries_[slots[i]]);
+      }
+      for (int i = 0; i < n; ++i) {
+        const Entry& entry = entries_[slots[i]];
+        values[start + i] = Matches(entry, keys[start + i], hashes[i])
+                                ? entry.value
+                                : default_value;
+      }
+    }
+  }
+
+  // Calls `f(key, value)` for every entry, in no particular order.
+  template <typename F>
+  void ForEach(F f) const {
+    for (uint64 i = 0; i < num_keys_; ++i) {
+      if constexpr (std::is_same_v<K, tstring>) {
+        const StringPiece key = perfect_hash_map_internal::KeyOf(
+            entries_[i], key_data_, key_data_size_);
+        f(tstring(key.data(), key.size()), entries_[i].value);
+      } else {
+        f(entries_[i].key, entries_[i].value);
+      }
+    }
+  }
+
+ private:
+  using Entry = perfect_hash_map_internal::Entry<K, V>;
+  using Header = perfect_hash_map_internal::Header;
+  static_assert(std::is_trivially_copyable_v<Entry>);
+
+  static constexpr int kGroupSize = 16;
+  static constexpr int kAverageBucketSize = 3;
+  // The table has about 1.5% more slots than keys, which keeps the search
+  // for the pilots of the last buckets short.
+  static constexpr int kSlackDivisor = 64;
+  static constexpr uint32 kMaxPilot = 1 << 20;
+  static constexpr int kMaxSeeds = 16;
+
+  // The finalizer of MurmurHash3. A bijection, so distinct integer keys never
+  // collide.
+  static uint64 Mix(uint64 h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // Maps the high 32 bits of `h` uniformly to [0, n), for n < 2^32.
+  static uint64 Reduce(uint64 h, uint64 n) { return ((h >> 32) * n) >> 32; }
+
+  static uint64 HashKey(int32 key, uint64 seed) {
+    return Mix(static_cast<uint64>(static_cast<uint32>(key)) ^ seed);
+  }
+  static uint64 HashKey(int64_t key, uint64 seed) {
+    return Mix(static_cast<uint64>(key) ^ seed);
+  }
+  static uint64 HashKey(const tstring& key, uint64 seed) {
+    return Hash64(key.data(), key.size(), seed);
+  }
+
+  // Position of a key with hash `h` in a table of `num_slots` slots, given the
+  // pilot of its bucket.
+  static uint64 Position(uint64 h, uint32 pilot, uint64 num_slots) {
+    return Reduce(Mix(h ^ Mix(pilot + 1)), num_slots);
+  }
+
+  struct AlignedFree {
+    void operator()(char* p) const { port::AlignedFree(p); }
+  };
+
+  PerfectHashMap() = default;
+
+  void Allocate(size_t size) {
+    buffer_.reset(static_cast<char*>(
+        port::AlignedMalloc(std::max<size_t>(size, 1),
+                            perfect_hash_map_internal::kSectionAlignment)));
+    std::memset(buffer_.get(), 0, size);
+    image_ = buffer_.get();
+    image_size_ = size;
+  }
+
+  uint64 Slot(uint64 hash) const {
+    const uint64 position =
+        Position(hash, pilots_[Reduce(hash, num_buckets_)], num_slots_);
+    return position < num_keys_ ? position : remap_[position - num_keys_];
+  }
+
+  bool Matches(const Entry& entry, const K& key, uint64 hash) const {
+    if constexpr (std::is_same_v<K, tstring>) {
+      return entry.key_hash == static_cast<uint32>(hash) &&
+             perfect_hash_map_internal::KeyOf(entry, key_data_,
+                                              key_data_size_) ==
+                 StringPiece(key.data(), key.size());
+    } else {
+      return entry.key == key;
+    }
+  }
+
+  // Builds the map with the hash function given by `seed`. Returns Aborted if
+  // another seed should be tried.
+  Status BuildWithSeed(const K* keys, const V* values, int64_t num_input_keys,
+                       uint64 seed) {
+    // Sort the keys by hash to drop duplicates, which are adjacent unless
+    // distinct keys collide.
+    std::vector<uint64> input_hashes(num_input_keys);
+    for (int64_t i = 0; i < num_input_keys; ++i) {
+      input_hashes[i] = HashKey(keys[i], seed);
+    }
+    std::vector<int64_t> order(num_input_keys);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+      return input_hashes[a] < input_hashes[b];
+    });
+    std::vector<int64_t> unique;  // Indices into `keys`.
+    unique.reserve(num_input_keys);
+    for (int64_t i = 0; i < num_input_keys; ++i) {
+      const int64_t index = order[i];
+      if (!unique.empty() &&
+          input_hashes[unique.back()] == input_hashes[index]) {
+        if (keys[unique.back()] != keys[index]) {
+          return errors::Aborted("Hash collision");
+        }
+        if (values[unique.back()] != values[index]) {
+          return errors::FailedPrecondition(
+              "HashTable has different value for same key. Key ", keys[index],
+              " has ", values[unique.back()], " and trying to add value ",
+              values[index]);
+        }
+        continue;
+      }
+      unique.push_back(index);
+    }
+    const uint64 num_keys = unique.size();
+    const uint64 num_slots = num_keys + num_keys / kSlackDivisor + 1;
+    const uint64 num_buckets = num_keys / kAverageBucketSize + 1;
+
+    // Group the keys by bucket, and place the largest buckets first.
+    std::vector<uint64> bucket_start(num_buckets + 1, 0);
+    for (int64_t index : unique) {
+      ++bucket_start[Reduce(input_hashes[index], num_buckets) + 1];
+    }
+    std::partial_sum(bucket_start.begin(), bucket_start.end(),
+                     bucket_start.begin());
+    std::vector<int64_t> by_bucket(num_keys);
+    {
+      std::vector<uint64> next(bucket_start.begin(), bucket_start.end() - 1);
+      for (int64_t index : unique) {
+        by_bucket[next[Reduce(input_hashes[index], num_buckets)]++] =
+            index;
+      }
+    }
+    std::vector<uint64> bucket_order(num_buckets);
+    std::iota(bucket_order.begin(), bucket_order.end(), 0);
+    std::stable_sort(bucket_order.begin(), bucket_order.end(),
+                     [&](uint64 a, uint64 b) {
+                       return bucket_start[a + 1] - bucket_start[a] >
+                              bucket_start[b + 1] - bucket_start[b];
+                     });
+
+    // Find the pilots.
+    std::vector<uint32> pilots(num_buckets, 0);
+    std::vector<bool> taken(num_slots, false);
+    std::vector<uint64> position(num_input_keys);
+    for (uint64 bucket : bucket_order) {
+      const uint64 begin = bucket_start[bucket];
+      const uint64 end = bucket_start[bucket + 1];
+      if (begin == end) break;
+      uint32 pilot = 0;
+      for (;; ++pilot) {
+        if (pilot == kMaxPilot) return errors::Aborted("No pilot found");
+        uint64 i = begin;
+        for (; i < end; ++i) {
+          const int64_t index = by_bucket[i];
+          const uint64 p = Position(
+              input_hashes[index], pilot, num_slots);
+          if (taken[p]) break;
+          taken[p] = true;
+          position[index] = p;
+        }
+        if (i == end) break;
+        // Release the slots taken by this attempt.
+        for (uint64 j = begin; j < i; ++j) {
+          taken[position[by_bucket[j]]] = false;
+        }
+      }
+      pilots[bucket] = pilot;
+    }
+
+    // Lay out the image.
+    Header header = {};
+    header.magic = perfect_hash_map_internal::kMagic;
+    header.version = perfect_hash_map_internal::kFormatVersion;
+    header.key_dtype = DataTypeToEnum<K>::v();
+    header.value_dtype = DataTypeToEnum<V>::v();
+    header.entry_size = sizeof(Entry);
+    header.seed = seed;
+    header.num_keys = num_keys;
+    header.num_slots = num_slots;
+    header.num_buckets = num_buckets;
+    header.pilots_offset =
+        perfect_hash_map_internal::RoundUpToSectionAlignment(sizeof(Header));
+    header.remap_offset = perfect_hash_map_internal::RoundUpToSectionAlignment(
+        header.pilots_offset + num_buckets * sizeof(uint32));
+    header.entries_offset =
+        perfect_hash_map_internal::RoundUpToSectionAlignment(
+            header.remap_offset + (num_slots - num_keys) * sizeof(uint32));
+    header.key_data_offset =
+        perfect_hash_map_internal::RoundUpToSectionAlignment(
+            header.entries_offset + num_keys * sizeof(Entry));
+    if constexpr (std::is_same_v<K, tstring>) {
+      for (int64_t index : unique) header.key_data_size += keys[index].size();
+    }
+    header.total_size = header.key_data_offset + header.key_data_size;
+    Allocate(header.total_size);
+    std::memcpy(buffer_.get(), &header, sizeof(header));
+    std::memcpy(buffer_.get() + header.pilots_offset, pilots.data(),
+                num_buckets * sizeof(uint32));
+    TF_RETURN_IF_ERROR(ParseImage());
+
+    // Redirect the slots past `num_keys` to the free slots before it. There
+    // are exactly as many of both.
+    uint32* remap = reinterpret_cast<uint32*>(buffer_.get() + remap_offset_);
+    uint64 free_slot = 0;
+    for (uint64 p = num_keys; p < num_slots; ++p) {
+      if (!taken[p]) continue;
+      while (taken[free_slot]) ++free_slot;
+      remap[p - num_keys] = free_slot++;
+    }
+
+    // Fill in the entries.
+    Entry* entries = reinterpret_cast<Entry*>(buffer_.get() + entries_offset_);
+    [[maybe_unused]] uint64 key_data_end = 0;
+    for (int64_t index : unique) {
+      Entry& entry = entries[Slot(input_hashes[index])];
+      if constexpr (std::is_same_v<K, tstring>) {
+        entry.key_offset = key_data_end;
+        entry.key_size = keys[index].size();
+        entry.key_hash = static_cast<uint32>(input_hashes[index]);
+        std::memcpy(buffer_.get() + header.key_data_offset + key_data_end,
+                    keys[index].data(), keys[index].size());
+        key_data_end += keys[index].size();
+      } else {
+        entry.key = keys[index];
+      }
+      entry.value = values[index];
+    }
+    return OkStatus();
+  }
+
+  // Validates the header of `image_` and points the members at its sections.
+  Status ParseImage() {
+    if (image_size_ < sizeof(Header)) {
+      return errors::DataLoss("PerfectHashMap image is truncated");
+    }
+    Header header;
+    std::memcpy(&header, image_, sizeof(header));
+    if (header.magic != perfect_hash_map_internal::kMagic) {
+      return errors::DataLoss(
+          "Not a PerfectHashMap image, or an image of another byte order");
+    }
+    if (header.version != perfect_hash_map_internal::kFormatVersion) {
+      return errors::FailedPrecondition("Unsupported PerfectHashMap version ",
+                                        header.version);
+    }
+    if (header.key_dtype != DataTypeToEnum<K>::v() ||
+        header.value_dtype != DataTypeToEnum<V>::v() ||
+        header.entry_size != sizeof(Entry)) {
+      return errors::InvalidArgument(
+          "PerfectHashMap image has key and value types ",
+          DataTypeString(static_cast<DataType>(header.key_dtype)), " and ",
+          DataTypeString(static_cast<DataType>(header.value_dtype)),
+          ", expected ", DataTypeString(DataTypeToEnum<K>::v()), " and ",
+          DataTypeString(DataTypeToEnum<V>::v()));
+    }
+    const auto section_fits = [&](uint64 offset, uint64 count,
+                                  uint64 element_size) {
+      return offset % perfect_hash_map_internal::kSectionAlignment == 0 &&
+             offset <= header.total_size &&
+             count <= (header.total_size - offset) / element_size;
+    };
+    if (header.total_size != image_size_ ||
+        header.num_keys >= std::numeric_limits<uint32>::max() / 2 ||
+        header.num_slots <= header.num_keys ||
+        header.num_slots >= std::numeric_limits<uint32>::max() ||
+        header.num_buckets == 0 ||
+        !section_fits(header.pilots_offset, header.num_buckets,
+                      sizeof(uint32)) ||
+        !section_fits(header.remap_offset,
+                      header.num_slots - header.num_keys, sizeof(uint32)) ||
+        !section_fits(header.entries_offset, header.num_keys, sizeof(Entry)) ||
+        !section_fits(header.key_data_offset, header.key_data_size, 1)) {
+      return errors::DataLoss("PerfectHashMap image is corrupted");
+    }
+    seed_ = header.seed;
+    num_keys_ = header.num_keys;
+    num_slots_ = header.num_slots;
+    num_buckets_ = header.num_buckets;
+    remap_offset_ = header.remap_offset;
+    entries_offset_ = header.entries_offset;
+    pilots_ = reinterpret_cast<const uint32*>(image_ + header.pilots_offset);
+    remap_ = reinterpret_cast<const uint32*>(image_ + header.remap_offset);
+    entries_ = reinterpret_cast<const Entry*>(image_ + header.entries_offset);
+    key_data_ = image_ + header.key_data_offset;
+    key_data_size_ = header.key_data_size;
+    for (uint64 i = 0; i < num_slots_ - num_keys_; ++i) {
+      if (remap_[i] >= std::max<uint64>(num_keys_, 1)) {
+        return errors::DataLoss("PerfectHashMap image is corrupted");
+      }
+    }
+    return OkStatus();
+  }
+
+  // Owns the image, unless it is memory-mapped.
+  std::unique_ptr<char, AlignedFree> buffer_;
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  const char* image_ = nullptr;
+  size_t image_size_ = 0;
+
+  uint64 seed_ = 0;
+  uint64 num_keys_ = 0;
+  uint64 num_slots_ = 0;
+  uint64 num_buckets_ = 0;
+  uint64 remap_offset_ = 0;
+  uint64 entries_offset_ = 0;
+  const uint32* pilots_ = nullptr;
+  const uint32* remap_ = nullptr;
+  const Entry* entries_ = nullptr;
+  const char* key_data_ = nullptr;
+  uint64 key_data_size_ = 0;
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_PERFECT_HASH_MAP_H_
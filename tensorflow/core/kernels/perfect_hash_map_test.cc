@@ -0,0 +1,239 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/perfect_hash_map.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+template <typename K, typename V>
+std::map<K, V> Contents(const PerfectHashMap<K, V>& m) {
+  std::map<K, V> contents;
+  m.ForEach([&contents](const K& key, V value) { contents[key] = value; });
+  return contents;
+}
+
+TEST(PerfectHashMapTest, FindIntegerKeys) {
+  std::vector<int64_t> keys;
+  std::vector<float> values;
+  for (int64_t i = 0; i < 10000; ++i) {
+    keys.push_back(i * 7 - 5000);
+    values.push_back(i);
+  }
+  std::unique_ptr<PerfectHashMap<int64_t, float>> m;
+  TF_ASSERT_OK(PerfectHashMap<int64_t, float>::Build(keys.data(), values.data(),
+                                                     keys.size(), &m));
+  EXPECT_EQ(keys.size(), m->size());
+
+  std::vector<float> found(keys.size());
+  m->Find(keys.data(), keys.size(), -1, found.data());
+  EXPECT_EQ(values, found);
+
+  // Keys that are not in the map, including ones between present keys.
+  const std::vector<int64_t> missing = {-5001, -4999, 1, 70000, 1LL << 40};
+  found.resize(missing.size());
+  m->Find(missing.data(), missing.size(), -1, found.data());
+  EXPECT_EQ(std::vector<float>(missing.size(), -1), found);
+
+  const std::map<int64_t, float> contents = Contents(*m);
+  EXPECT_EQ(keys.size(), contents.size());
+  EXPECT_EQ(3, contents.at(-5000 + 3 * 7));
+}
+
+TEST(PerfectHashMapTest, FindStringKeys) {
+  const std::vector<tstring> keys = {"a", "b", "", "brown", "fox", "jumps"};
+  const std::vector<int64_t> values = {0, 1, 2, 3, 4, 5};
+  std::unique_ptr<PerfectHashMap<tstring, int64_t>> m;
+  TF_ASSERT_OK(PerfectHashMap<tstring, int64_t>::Build(
+      keys.data(), values.data(), keys.size(), &m));
+
+  const std::vector<tstring> queries = {"fox", "c", "", "brow", "a", "jumps!"};
+  std::vector<int64_t> found(queries.size());
+  m->Find(queries.data(), queries.size(), -1, found.data());
+  EXPECT_EQ(std::vector<int64_t>({4, -1, 2, -1, 0, -1}), found);
+  EXPECT_EQ((std::map<tstring, int64_t>{{"", 2},
+                                        {"a", 0},
+                                        {"b", 1},
+                                        {"brown", 3},
+                                        {"fox", 4},
+                                        {"jumps", 5}}),
+            Contents(*m));
+}
+
+TEST(PerfectHashMapTest, DuplicateKeys) {
+  const std::vector<int32> keys = {3, 1, 3, 2};
+  std::unique_ptr<PerfectHashMap<int32, int32>> m;
+  const std::vector<int32> same_values = {30, 10, 30, 20};
+  TF_ASSERT_OK(PerfectHashMap<int32, int32>::Build(
+      keys.data(), same_values.data(), keys.size(), &m));
+  EXPECT_EQ(3, m->size());
+
+  const std::vector<int32> different_values = {30, 10, 31, 20};
+  EXPECT_TRUE(errors::IsFailedPrecondition(PerfectHashMap<int32, int32>::Build(
+      keys.data(), different_values.data(), keys.size(), &m)));
+}
+
+TEST(PerfectHashMapTest, Empty) {
+  std::unique_ptr<PerfectHashMap<int64_t, int64_t>> m;
+  TF_ASSERT_OK(
+      PerfectHashMap<int64_t, int64_t>::Build(nullptr, nullptr, 0, &m));
+  EXPECT_EQ(0, m->size());
+  const int64_t key = 0;
+  int64_t found;
+  m->Find(&key, 1, -1, &found);
+  EXPECT_EQ(-1, found);
+}
+
+TEST(PerfectHashMapTest, SaveAndLoad) {
+  std::vector<tstring> keys;
+  std::vector<double> values;
+  for (int i = 0; i < 5000; ++i) {
+    keys.push_back(strings::StrCat("token", i));
+    values.push_back(i * 0.5);
+  }
+  std::unique_ptr<PerfectHashMap<tstring, double>> m;
+  TF_ASSERT_OK(PerfectHashMap<tstring, double>::Build(
+      keys.data(), values.data(), keys.size(), &m));
+  const string filename = io::JoinPath(testing::TmpDir(), "vocab.tfpht");
+  TF_ASSERT_OK(m->Save(Env::Default(), filename));
+
+  std::unique_ptr<PerfectHashMap<tstring, double>> loaded;
+  TF_ASSERT_OK(
+      PerfectHashMap<tstring, double>::Load(Env::Default(), filename, &loaded));
+  EXPECT_EQ(m->size(), loaded->size());
+  EXPECT_EQ(m->MemoryUsed(), loaded->MemoryUsed());
+  keys.push_back("token5000");
+  std::vector<double> found(keys.size());
+  loaded->Find(keys.data(), keys.size(), -1, found.data());
+  values.push_back(-1);
+  EXPECT_EQ(values, found);
+
+  // Images only load as the key and value types they were built for.
+  std::unique_ptr<PerfectHashMap<tstring, float>> wrong_type;
+  EXPECT_TRUE(errors::IsInvalidArgument(PerfectHashMap<tstring, float>::Load(
+      Env::Default(), filename, &wrong_type)));
+}
+
+TEST(PerfectHashMapTest, LoadRejectsCorruptedImages) {
+  const std::vector<int64_t> keys = {1, 2, 3};
+  std::unique_ptr<PerfectHashMap<int64_t, int64_t>> m;
+  TF_ASSERT_OK(PerfectHashMap<int64_t, int64_t>::Build(keys.data(), keys.data(),
+                                                       keys.size(), &m));
+  const string filename = io::JoinPath(testing::TmpDir(), "corrupted.tfpht");
+  TF_ASSERT_OK(m->Save(Env::Default(), filename));
+  string image;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &image));
+
+  std::unique_ptr<PerfectHashMap<int64_t, int64_t>> loaded;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename,
+                                 image.substr(0, image.size() - 1)));
+  EXPECT_TRUE(errors::IsDataLoss(PerfectHashMap<int64_t, int64_t>::Load(
+      Env::Default(), filename, &loaded)));
+  image[0] ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, image));
+  EXPECT_TRUE(errors::IsDataLoss(PerfectHashMap<int64_t, int64_t>::Load(
+      Env::Default(), filename, &loaded)));
+}
+
+// Looks up batches of random keys that are present with probability 1/2, in
+// a map of `state.range(0)` keys, with a PerfectHashMap or with the
+// flat_hash_map of HashTable.
+constexpr int64_t kBatchSize = 256;
+
+std::vector<int64_t> BenchmarkQueries(int64_t num_keys) {
+  std::vector<int64_t> queries(1 << 16);
+  uint64_t x = 1;
+  for (int64_t& query : queries) {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    query = (x >> 33) % (2 * num_keys) * 0x9E3779B97F4A7C15ULL;
+  }
+  return queries;
+}
+
+void BM_PerfectHashMapFind(::testing::benchmark::State& state) {
+  const int64_t num_keys = state.range(0);
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; ++i) keys[i] = i * 0x9E3779B97F4A7C15ULL;
+  std::unique_ptr<PerfectHashMap<int64_t, int64_t>> m;
+  TF_CHECK_OK(PerfectHashMap<int64_t, int64_t>::Build(keys.data(), keys.data(),
+                                                      num_keys, &m));
+  const std::vector<int64_t> queries = BenchmarkQueries(num_keys);
+  std::vector<int64_t> values(kBatchSize);
+  int64_t offset = 0;
+  for (auto s : state) {
+    m->Find(queries.data() + offset, kBatchSize, -1, values.data());
+    offset = (offset + kBatchSize) % queries.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_FlatHashMapFind(::testing::benchmark::State& state) {
+  const int64_t num_keys = state.range(0);
+  absl::flat_hash_map<int64_t, int64_t> m;
+  m.reserve(num_keys);
+  for (int64_t i = 0; i < num_keys; ++i) {
+    m.try_emplace(i * 0x9E3779B97F4A7C15ULL, i * 0x9E3779B97F4A7C15ULL);
+  }
+  const std::vector<int64_t> queries = BenchmarkQueries(num_keys);
+  std::vector<int64_t> values(kBatchSize);
+  int64_t offset = 0;
+  for (auto s : state) {
+    for (int64_t i = 0; i < kBatchSize; ++i) {
+      auto it = m.find(queries[offset + i]);
+      values[i] = it == m.end() ? -1 : it->second;
+    }
+    offset = (offset + kBatchSize) % queries.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+BENCHMARK(BM_PerfectHashMapFind)->Arg(1 << 10)->Arg(1 << 20)->Arg(1 << 24);
+BENCHMARK(BM_FlatHashMapFind)->Arg(1 << 10)->Arg(1 << 20)->Arg(1 << 24);
+
+void BM_PerfectHashMapBuild(::testing::benchmark::State& state) {
+  const int64_t num_keys = state.range(0);
+  std::vector<tstring> keys(num_keys);
+  std::vector<int64_t> values(num_keys);
+  for (int64_t i = 0; i < num_keys; ++i) {
+    keys[i] = strings::StrCat("token", i);
+    values[i] = i;
+  }
+  for (auto s : state) {
+    std::unique_ptr<PerfectHashMap<tstring, int64_t>> m;
+    TF_CHECK_OK(PerfectHashMap<tstring, int64_t>::Build(
+        keys.data(), values.data(), num_keys, &m));
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+
+BENCHMARK(BM_PerfectHashMapBuild)->Arg(1 << 20);
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
@@ -22,6 +22,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -284,7 +286,7 @@ struct RestoreOp {
 
   // Run this restore operation using a new BundleReader.
   void run_with_new_reader() {
-    BundleReader reader(Env::Default(), reader_prefix);
+    BundleReader reader(Env::Default(), reader_prefix, reader_options);
     if (!reader.status().ok()) {
       status = reader.status();
       return;
@@ -301,7 +303,15 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    if (shape_and_slice.empty() && reader_options.use_mmap) {
+      // Lookup the full tensor, aliasing the mapped data file if possible.
+      Tensor restored;
+      TF_RETURN_IF_ERROR(reader->LookupMaybeAliased(
+          tensor_name, context->get_allocator(context->output_alloc_attr(idx)),
+          &restored));
+      context->set_output(idx, restored);
+      restored_tensor = context->mutable_output(idx);
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -355,10 +365,63 @@ struct RestoreOp {
   string shape_and_slice;
   string reader_prefix;
   DataType dtype;
+  BundleReader::Options reader_options;
 
   ::tensorflow::Status status;
 };
 
+// Reads the options of the parallel read plan used by RestoreV2 from the
+// environment. The plan is opt-in: it is only used if TF_RESTORE_NUM_IO_THREADS
+// is set to a positive number of threads. It defaults to 0, which restores
+// every tensor with Lookup() as before.
+Status ReadParallelLookupOptionsFromEnv(
+    BundleReader::ParallelLookupOptions* options) {
+  int64_t num_threads;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RESTORE_NUM_IO_THREADS",
+                                         /*default_val=*/0, &num_threads));
+  options->num_threads = static_cast<int>(num_threads);
+  int64_t max_inflight_mb;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RESTORE_MAX_INFLIGHT_MB",
+                                         options->max_inflight_bytes >> 20,
+                                         &max_inflight_mb));
+  options->max_inflight_bytes = max_inflight_mb << 20;
+  return OkStatus();
+}
+
+// Restores the full tensors of "ops" with one read plan spanning all data
+// files of the checkpoint.
+Status RunPlannedRestoreOps(
+    OpKernelContext* context, BundleReader* reader,
+    const std::vector<RestoreOp*>& ops,
+    const BundleReader::ParallelLookupOptions& options) {
+  std::vector<string> keys;
+  std::vector<Tensor*> vals;
+  keys.reserve(ops.size());
+  vals.reserve(ops.size());
+  for (RestoreOp* op : ops) {
+    TensorShape restored_full_shape;
+    TF_RETURN_IF_ERROR(
+        reader->LookupTensorShape(op->tensor_name, &restored_full_shape));
+    Tensor* restored_tensor;
+    TF_RETURN_IF_ERROR(context->allocate_output(op->idx, restored_full_shape,
+                                                &restored_tensor));
+    keys.push_back(op->tensor_name);
+    vals.push_back(restored_tensor);
+  }
+
+  std::vector<BundleReader::ShardReadStats> stats;
+  TF_RETURN_IF_ERROR(reader->LookupMany(keys, vals, options, &stats));
+  for (const BundleReader::ShardReadStats& shard : stats) {
+    VLOG(1) << "Restored " << shard.num_tensors << " tensors from shard "
+            << shard.shard_id << " with " << shard.num_reads << " reads of "
+            << shard.bytes_read << " bytes in " << shard.elapsed_micros
+            << "us";
+    metrics::RecordCheckpointRestoreShardRead(
+        shard.bytes_read, shard.num_reads, shard.elapsed_micros);
+  }
+  return OkStatus();
+}
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
@@ -370,14 +433,22 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   const auto& tensor_names_flat = tensor_names.flat<tstring>();
   const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
+  // If TF_RESTORE_USE_MMAP is set, the data files are memory-mapped and
+  // unpartitioned tensors alias the mapping where alignment allows, which
+  // avoids holding a second copy of the checkpoint in memory while restoring.
+  BundleReader::Options reader_options;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_RESTORE_USE_MMAP", false,
+                                        &reader_options.use_mmap));
+
   std::vector<RestoreOp> restore_ops;
   restore_ops.reserve(tensor_names_flat.size());
   for (int i = 0; i < tensor_names_flat.size(); ++i) {
     restore_ops.push_back({context, i, tensor_names_flat(i),
                            shape_and_slices_flat(i), prefix_string, dtypes[i]});
+    restore_ops.back().reader_options = reader_options;
   }
 
-  BundleReader default_reader(Env::Default(), prefix_string);
+  BundleReader default_reader(Env::Default(), prefix_string, reader_options);
   TF_RETURN_IF_ERROR(default_reader.status());
 
   TF_RETURN_IF_ERROR(default_reader.SortForSequentialAccess<RestoreOp>(
@@ -402,10 +473,21 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  // If TF_RESTORE_NUM_IO_THREADS is positive, full tensors are fetched by a
+  // single read plan that coalesces and parallelizes reads across all data
+  // files. Otherwise, and for slices and tensors that may alias a
+  // memory-mapped data file, tensors are restored one by one.
+  BundleReader::ParallelLookupOptions lookup_options;
+  TF_RETURN_IF_ERROR(ReadParallelLookupOptionsFromEnv(&lookup_options));
+
+  std::vector<RestoreOp*> planned_restore_ops;
   std::vector<RestoreOp*> pool_restore_ops;
   std::vector<RestoreOp*> direct_restore_ops;
   for (RestoreOp& restore_op : restore_ops) {
-    if (restore_op.should_run_in_pool(&default_reader)) {
+    if (lookup_options.num_threads > 0 && !reader_options.use_mmap &&
+        restore_op.shape_and_slice.empty()) {
+      planned_restore_ops.push_back(&restore_op);
+    } else if (restore_op.should_run_in_pool(&default_reader)) {
       pool_restore_ops.push_back(&restore_op);
     } else {
       direct_restore_ops.push_back(&restore_op);
@@ -424,6 +506,12 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
       }
     }
 
+    if (!planned_restore_ops.empty()) {
+      TF_RETURN_IF_ERROR(RunPlannedRestoreOps(context, &default_reader,
+                                              planned_restore_ops,
+                                              lookup_options));
+    }
+
     // Read small tensors from the op thread
     for (auto* op : direct_restore_ops) {
       TF_RETURN_IF_ERROR(op->run(&default_reader));
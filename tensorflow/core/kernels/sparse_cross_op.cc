@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <limits>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/batch_string_hash.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/errors.h"
@@ -53,6 +55,21 @@ class ColumnInterface {
   virtual ~ColumnInterface() {}
 };
 
+// A string value is usually crossed with many features of the other columns,
+// so columns that cross hashes fingerprint all of their string values once, in
+// a batch, instead of on every access.
+template <typename InternalType>
+void MaybeFingerprintStrings(const Tensor& values,
+                             std::vector<uint64>* fingerprints) {
+  if (!std::is_same<InternalType, int64_t>::value ||
+      values.dtype() != DT_STRING) {
+    return;
+  }
+  fingerprints->resize(values.NumElements());
+  BatchStringHash<Fingerprint64>(values.flat<tstring>().data(),
+                                 values.NumElements(), fingerprints->data());
+}
+
 // A column that is backed by a sparse tensor.
 template <typename InternalType>
 class SparseTensorColumn : public ColumnInterface<InternalType> {
@@ -63,6 +80,7 @@ class SparseTensorColumn : public ColumnInterface<InternalType> {
         feature_counts_(std::move(feature_counts)),
         feature_start_indices_(std::move(feature_start_indices)) {
     CHECK_EQ(feature_counts_.size(), feature_start_indices_.size());
+    MaybeFingerprintStrings<InternalType>(values_, &fingerprints_);
   }
 
   int64_t FeatureCount(int64_t batch) const override {
@@ -78,6 +96,8 @@ class SparseTensorColumn : public ColumnInterface<InternalType> {
   const Tensor& values_;
   std::vector<int64_t> feature_counts_;
   std::vector<int64_t> feature_start_indices_;
+  // Fingerprints of the string values, if they are crossed as hashes.
+  std::vector<uint64> fingerprints_;
 };
 
 // A column that is backed by a sparse tensor.
@@ -116,8 +136,7 @@ template <>
 int64_t SparseTensorColumn<int64_t>::Feature(int64_t batch, int64_t n,
                                              bool strong_hash) const {
   const int64_t start = feature_start_indices_[batch];
-  if (DT_STRING == values_.dtype())
-    return Fingerprint64(values_.vec<tstring>().data()[start + n]);
+  if (DT_STRING == values_.dtype()) return fingerprints_[start + n];
   return values_.vec<int64_t>().data()[start + n];
 }
 
@@ -178,7 +197,9 @@ StringPiece KeyedSparseTensorColumn<StringPiece>::Feature(
 template <typename InternalType>
 class DenseTensorColumn : public ColumnInterface<InternalType> {
  public:
-  explicit DenseTensorColumn(const Tensor& tensor) : tensor_(tensor) {}
+  explicit DenseTensorColumn(const Tensor& tensor) : tensor_(tensor) {
+    MaybeFingerprintStrings<InternalType>(tensor_, &fingerprints_);
+  }
 
   int64_t FeatureCount(int64_t batch) const override {
     return tensor_.dim_size(1);
@@ -191,6 +212,8 @@ class DenseTensorColumn : public ColumnInterface<InternalType> {
 
  private:
   const Tensor& tensor_;
+  // Fingerprints of the string values, if they are crossed as hashes.
+  std::vector<uint64> fingerprints_;
 };
 
 // A column that is backed by a dense tensor.
@@ -222,7 +245,7 @@ template <>
 int64_t DenseTensorColumn<int64_t>::Feature(int64_t batch, int64_t n,
                                             bool strong_hash) const {
   if (DT_STRING == tensor_.dtype())
-    return Fingerprint64(tensor_.matrix<tstring>()(batch, n));
+    return fingerprints_[batch * tensor_.dim_size(1) + n];
   return tensor_.matrix<int64_t>()(batch, n);
 }
 
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/batch_string_hash.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
@@ -44,15 +45,18 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64_t>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64_t>(bucket_id);
-    }
+    const uint64 num_buckets = num_buckets_;
+    int64_t* output = output_flat.data();
+    ParallelBatchStringHash<hash>(
+        *context->device()->tensorflow_cpu_worker_threads(),
+        input_flat.data(), input_flat.size(),
+        [num_buckets, output](int64_t i, uint64 input_hash) {
+          const uint64 bucket_id = input_hash % num_buckets;
+          // The number of buckets is always in the positive range of int64 so
+          // is the resulting bucket_id. Casting the bucket_id from uint64 to
+          // int64 is safe.
+          output[i] = static_cast<int64_t>(bucket_id);
+        });
   }
 
  private:
@@ -18,6 +18,7 @@ limitations under the License.
 #include <utility>
 
 #include "tensorflow/core/common_runtime/gpu/gpu_serving_device_selector.h"
+#include "tensorflow/core/common_runtime/serving_device_selector.h"
 #include "tensorflow/core/common_runtime/serving_device_selector_policies.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/tfrt/gpu/kernel/gpu_runner.h"
@@ -29,7 +30,15 @@ namespace gpu {
 
 Status InitTfrtGpu(const GpuRunnerOptions& options,
                    tensorflow::tfrt_stub::Runtime& runtime) {
-  auto policy = std::make_unique<RoundRobinPolicy>();
+  std::unique_ptr<ServingDeviceSelector::Policy> policy;
+  switch (options.serving_selector_policy) {
+    case ServingDeviceSelectorPolicy::kRoundRobin:
+      policy = std::make_unique<RoundRobinPolicy>();
+      break;
+    case ServingDeviceSelectorPolicy::kLeastLoaded:
+      policy = std::make_unique<LeastLoadedPolicy>();
+      break;
+  }
   auto serving_device_selector =
       std::make_unique<tensorflow::gpu::GpuServingDeviceSelector>(
           options.num_gpu_streams, std::move(policy));
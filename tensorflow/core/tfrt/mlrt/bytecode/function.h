@@ -100,6 +100,10 @@ class Function {
 
   explicit operator bool() const { return p_ != nullptr; }
 
+  // The address of the function in the bytecode, which identifies it within
+  // an executable.
+  const char* data() const { return p_; }
+
  private:
   const char* p_ = nullptr;
 };
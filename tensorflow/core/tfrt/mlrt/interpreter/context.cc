@@ -14,6 +14,12 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tfrt/mlrt/interpreter/context.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace mlrt {
 namespace context_internal {
 
@@ -21,6 +27,41 @@ UserContextBase::~UserContextBase() = default;
 
 }
 
+namespace {
+
+// A superinstruction, as the codes of the kernels it fuses in an executable.
+struct FusedKernel {
+  std::vector<uint32_t> codes;
+  KernelImplementation implementation;
+};
+
+// Replaces the implementation of the first kernel of every sequence that
+// matches a superinstruction in `threaded_code`. The other kernels of the
+// sequence keep their implementation, as the execution resumes from them if
+// the sequence is interrupted. `fused_kernels` are tried in order, and the
+// sequences do not overlap.
+void ApplyFusedKernels(absl::Span<const FusedKernel> fused_kernels,
+                       std::vector<ThreadedKernel>& threaded_code) {
+  for (size_t pc = 0; pc < threaded_code.size();) {
+    size_t length = 1;
+    for (const auto& fused_kernel : fused_kernels) {
+      if (pc + fused_kernel.codes.size() > threaded_code.size()) continue;
+      bool match = true;
+      for (size_t i = 0; match && i < fused_kernel.codes.size(); ++i) {
+        match = threaded_code[pc + i].kernel.code() == fused_kernel.codes[i];
+      }
+      if (match) {
+        threaded_code[pc].implementation = fused_kernel.implementation;
+        length = fused_kernel.codes.size();
+        break;
+      }
+    }
+    pc += length;
+  }
+}
+
+}  // namespace
+
 void KernelRegistry::Register(absl::string_view name,
                               KernelImplementation kernel) {
   map_.emplace(name, kernel);
@@ -31,8 +72,16 @@ KernelImplementation KernelRegistry::Get(absl::string_view name) const {
   return map_.at(name);
 }
 
+void KernelRegistry::RegisterFused(std::vector<std::string> names,
+                                   KernelImplementation kernel) {
+  DCHECK_GT(names.size(), 1);
+  fused_kernels_.emplace_back(std::move(names), kernel);
+}
+
 void KernelRegistry::Merge(const KernelRegistry& other) {
   map_.insert(other.map_.begin(), other.map_.end());
+  fused_kernels_.insert(fused_kernels_.end(), other.fused_kernels_.begin(),
+                        other.fused_kernels_.end());
 }
 
 LoadedExecutable::LoadedExecutable(bc::Executable executable,
@@ -47,6 +96,40 @@ LoadedExecutable::LoadedExecutable(bc::Executable executable,
   for (auto function : executable_.functions()) {
     functions_[function.name().Get()] = function;
   }
+
+  // Look up the superinstructions whose kernels are all used by the
+  // executable, and try the longest ones first.
+  absl::flat_hash_map<absl::string_view, uint32_t> codes;
+  uint32_t code = 0;
+  for (auto kernel_name : executable_.kernel_names()) {
+    codes.emplace(kernel_name.Get(), code++);
+  }
+  std::vector<FusedKernel> fused_kernels;
+  for (const auto& [names, implementation] : kernel_registry.fused_kernels()) {
+    FusedKernel fused_kernel{{}, implementation};
+    for (const auto& name : names) {
+      auto iter = codes.find(name);
+      if (iter == codes.end()) break;
+      fused_kernel.codes.push_back(iter->second);
+    }
+    if (fused_kernel.codes.size() == names.size()) {
+      fused_kernels.push_back(std::move(fused_kernel));
+    }
+  }
+  std::stable_sort(fused_kernels.begin(), fused_kernels.end(),
+                   [](const FusedKernel& a, const FusedKernel& b) {
+                     return a.codes.size() > b.codes.size();
+                   });
+
+  threaded_code_.reserve(executable_.functions().size());
+  for (auto function : executable_.functions()) {
+    auto& threaded_code = threaded_code_[function.data()];
+    threaded_code.reserve(function.kernels().size());
+    for (auto kernel : function.kernels()) {
+      threaded_code.push_back({kernels_[kernel.code()], kernel});
+    }
+    ApplyFusedKernels(fused_kernels, threaded_code);
+  }
 }
 
 }  // namespace mlrt
@@ -48,6 +48,18 @@ Future AwaitAll(FutureLikeContainer futures);
 
 using KernelImplementation = void (*)(KernelFrame);
 
+// The implementation of a kernel class, which can be used as a template
+// argument of InvokeFused().
+template <typename KernelClass>
+void InvokeKernel(KernelFrame frame);
+
+// Invokes `First` and `Rest` on consecutive kernels of a function, starting
+// with the kernel of `frame`. It stops early if a kernel breaks the sequential
+// execution, e.g. by suspending or failing, so that the execution resumes
+// with the next kernel as if they were dispatched one by one.
+template <KernelImplementation First, KernelImplementation... Rest>
+void InvokeFused(KernelFrame frame);
+
 class KernelRegistry {
  public:
   void Register(absl::string_view name, KernelImplementation kernel);
@@ -62,10 +74,45 @@ class KernelRegistry {
     Register<KernelClass>(KernelClass::kName);
   }
 
+  // Registers a superinstruction: `kernel` replaces the dispatch of every
+  // sequence of consecutive kernels named `names` in a function. `kernel` must
+  // behave as the kernels of the sequence invoked one by one, which is the
+  // case for implementations generated by InvokeFused().
+  void RegisterFused(std::vector<std::string> names,
+                     KernelImplementation kernel);
+
+  template <KernelImplementation... Kernels>
+  void RegisterFused(std::vector<std::string> names) {
+    RegisterFused(std::move(names), &InvokeFused<Kernels...>);
+  }
+
+  template <typename... KernelClasses>
+  void RegisterFused() {
+    RegisterFused<&InvokeKernel<KernelClasses>...>({KernelClasses::kName...});
+  }
+
+  // Returns the superinstructions, each as the names of the kernels it fuses
+  // and its implementation.
+  const std::vector<std::pair<std::vector<std::string>, KernelImplementation>>&
+  fused_kernels() const {
+    return fused_kernels_;
+  }
+
   void Merge(const KernelRegistry& other);
 
  private:
   absl::flat_hash_map<std::string, KernelImplementation> map_;
+  std::vector<std::pair<std::vector<std::string>, KernelImplementation>>
+      fused_kernels_;
+};
+
+// A kernel of a function together with its implementation. The interpreter
+// dispatches the kernels of a function through an array of these (direct
+// threading), instead of looking up the implementation of each kernel by its
+// code.
+struct ThreadedKernel {
+  KernelImplementation implementation = nullptr;
+  bc::Kernel kernel;
 };
 
 class LoadedExecutable {
@@ -85,11 +132,23 @@ class LoadedExecutable {
 
   bc::Executable executable() const { return executable_; }
 
+  // Returns the threaded code of `function`, with the superinstructions of the
+  // kernel registry applied.
+  absl::Span<const ThreadedKernel> GetThreadedCode(
+      bc::Function function) const {
+    auto iter = threaded_code_.find(function.data());
+    DCHECK(iter != threaded_code_.end())
+        << "Function " << function.name().Get()
+        << " is not in the executable.";
+    return iter->second;
+  }
+
  private:
   bc::Executable executable_;
 
   absl::flat_hash_map<std::string, bc::Function> functions_;
   std::vector<KernelImplementation> kernels_;
+  absl::flat_hash_map<const char*, std::vector<ThreadedKernel>> threaded_code_;
 };
 
 // A helper structure that holds states for a kernel. Typical usuage is that a
@@ -110,13 +169,7 @@ void UnwindOnError(ExecutionContext& context, int64_t pc);
 
 class FunctionContext {
  public:
-  FunctionContext(bc::Function function, ExecutionContext* execution_context)
-      : pc_(0),
-        registers_(function.num_regs()),
-        function_object_(function),
-        execution_context_(execution_context) {
-    DCHECK(execution_context);
-  }
+  FunctionContext(bc::Function function, ExecutionContext* execution_context);
 
   FunctionContext(const FunctionContext&) = delete;
   FunctionContext& operator=(const FunctionContext&) = delete;
@@ -127,6 +180,10 @@ class FunctionContext {
 
   const bc::Function& function_object() const { return function_object_; }
 
+  absl::Span<const ThreadedKernel> threaded_code() const {
+    return threaded_code_;
+  }
+
   absl::Span<Value> regs() { return absl::MakeSpan(registers_); }
 
   // Argument passing is via either copy or move.
@@ -199,6 +256,7 @@ class FunctionContext {
   std::vector<Value> registers_;
   std::vector<Value*> results_;
   bc::Function function_object_;
+  absl::Span<const ThreadedKernel> threaded_code_;
   KernelContext kernel_context_;
 
   ExecutionContext* execution_context_ = nullptr;
@@ -509,12 +567,19 @@ class KernelFrame {
                     .loaded_executable()
                     .executable()
                     .attributes(),
-                &function_context->execution_context()) {}
+                &function_context->execution_context()) {
+      threaded_code = function_context->threaded_code();
+    }
 
     bc::Kernel kernel;
     absl::Span<Value> regs;
     bc::Span<bc::String> attrs;
     ExecutionContext* execution_context = nullptr;
+
+    // The code of the function being executed and the index of `kernel` in
+    // it. They are only set when the kernel is executed by the interpreter.
+    absl::Span<const ThreadedKernel> threaded_code;
+    int64_t pc = 0;
   };
 
   explicit KernelFrame(State* state) : state_(state) { DCHECK(state_); }
@@ -545,6 +610,15 @@ class KernelFrame {
 
   void set_kernel(bc::Kernel kernel) { this->kernel() = kernel; }
 
+  // Moves the frame to the next kernel of the function. It is used by
+  // superinstructions to execute the kernels they fuse.
+  void AdvanceToNextKernel() {
+    DCHECK_LT(state_->pc + 1,
+              static_cast<int64_t>(state_->threaded_code.size()));
+    ++state_->pc;
+    state_->kernel = state_->threaded_code[state_->pc].kernel;
+  }
+
  private:
   bc::Kernel& kernel() { return state_->kernel; }
   const bc::Kernel& kernel() const { return state_->kernel; }
@@ -557,10 +631,38 @@ class KernelFrame {
   friend void Execute(ExecutionContext& context);
 };
 
+inline FunctionContext::FunctionContext(bc::Function function,
+                                        ExecutionContext* execution_context)
+    : pc_(0),
+      registers_(function.num_regs()),
+      function_object_(function),
+      execution_context_(execution_context) {
+  DCHECK(execution_context);
+  threaded_code_ =
+      execution_context->loaded_executable().GetThreadedCode(function);
+}
+
+template <typename KernelClass>
+void InvokeKernel(KernelFrame frame) {
+  KernelClass(frame).Invoke();
+}
+
+template <KernelImplementation First, KernelImplementation... Rest>
+void InvokeFused(KernelFrame frame) {
+  First(frame);
+  if constexpr (sizeof...(Rest) > 0) {
+    if (frame.execution_context().state() !=
+        ExecutionContext::State::kRunning) {
+      return;
+    }
+    frame.AdvanceToNextKernel();
+    InvokeFused<Rest...>(frame);
+  }
+}
+
 template <typename KernelClass>
 inline void KernelRegistry::Register(absl::string_view name) {
-  Register(
-      name, +[](KernelFrame frame) { KernelClass(frame).Invoke(); });
+  Register(name, &InvokeKernel<KernelClass>);
 }
 
 }  // namespace mlrt
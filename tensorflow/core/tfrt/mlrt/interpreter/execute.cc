@@ -81,33 +81,28 @@ void Execute(ExecutionContext& ctx) {
 
     int function_stack_index = context.function_stack_.size() - 1;
     FunctionContext* current_function = &context.function_stack_.back();
-    int64_t pc = current_function->pc_;
-
-    auto kernels = context.loaded_executable().kernels();
-
-    auto kernel_object_iter =
-        current_function->function_object().kernels().begin();
-    kernel_object_iter += pc;
 
     KernelFrame::State kstate(current_function);
+    kstate.pc = current_function->pc_;
     KernelFrame frame(&kstate);
 
+    const ThreadedKernel* threaded_code = kstate.threaded_code.data();
+
     // The main loop for executing kernels in program order. The kernels may set
     // the execution state to break this loop for context-switching or error
-    // handling.
-    for (; context.state_ == ExecutionContext::State::kRunning; ++pc) {
-      DCHECK(kernel_object_iter <
-             current_function->function_object().kernels().end());
-      bc::Kernel kernel_object = *kernel_object_iter;
-      frame.set_kernel(kernel_object);
-      kernels[kernel_object.code()](frame);
-      ++kernel_object_iter;
+    // handling. Superinstructions advance `kstate.pc` over the kernels they
+    // execute.
+    for (; context.state_ == ExecutionContext::State::kRunning; ++kstate.pc) {
+      DCHECK_LT(kstate.pc, static_cast<int64_t>(kstate.threaded_code.size()));
+      const ThreadedKernel& threaded_kernel = threaded_code[kstate.pc];
+      kstate.kernel = threaded_kernel.kernel;
+      threaded_kernel.implementation(frame);
     }
 
     // Update the program counter if we need to break the sequential execution
     // loop.
     current_function = &context.function_stack_[function_stack_index];
-    current_function->pc_ = pc;
+    current_function->pc_ = kstate.pc;
 
     // The current execution is pasued, and we need to reset the per-thread
     // context pointer.
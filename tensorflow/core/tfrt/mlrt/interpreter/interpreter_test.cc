@@ -226,6 +226,50 @@ TEST(InterpreterTest, SequentialAddAttributes) {
   EXPECT_EQ(result.Get<int32_t>(), 100);
 }
 
+int num_fused_add_calls = 0;
+
+void FusedAddI32(KernelFrame frame) {
+  ++num_fused_add_calls;
+  InvokeFused<&InvokeKernel<AddI32Kernel>, &InvokeKernel<AddI32Kernel>>(frame);
+}
+
+TEST(InterpreterTest, SequentialAddFused) {
+  auto buffer = CreateSequentialAddExecutable(99);
+
+  bc::Executable executable(buffer.data());
+
+  KernelRegistry kernel_registry;
+  RegisterBuiltinKernels(kernel_registry);
+  kernel_registry.Register<AddI32Kernel>();
+  kernel_registry.RegisterFused({"add", "add"}, &FusedAddI32);
+
+  LoadedExecutable loaded_executable(executable, kernel_registry);
+
+  absl::Notification notification;
+
+  ExecutionContext execution_context(&loaded_executable);
+  execution_context.set_exit_handler([&]() { notification.Notify(); });
+
+  int32_t v = 1;
+  mlrt::Value arg(v);
+  mlrt::Value result;
+
+  auto function = loaded_executable.GetFunction("main");
+  ASSERT_TRUE(function);
+
+  num_fused_add_calls = 0;
+  std::vector<uint8_t> last_uses = {true};
+  execution_context.Call(function, last_uses, absl::Span<Value>(&arg, 1),
+                         absl::Span<Value>(&result, 1));
+  Execute(execution_context);
+
+  notification.WaitForNotification();
+
+  EXPECT_EQ(result.Get<int32_t>(), 100);
+  // The last add is not paired and is dispatched alone.
+  EXPECT_EQ(num_fused_add_calls, 49);
+}
+
 bc::Buffer CreateCallExecutable() {
   bc::Buffer buffer;
   bc::Allocator allocator(&buffer);
@@ -719,6 +763,57 @@ TEST(InterpreterTest, Await) {
   EXPECT_EQ(output.Get<int32_t>(), 100);
 }
 
+void ReturnI32(KernelFrame frame) {
+  frame.execution_context().Return(frame.arguments());
+}
+
+TEST(InterpreterTest, FusedAwait) {
+  auto buffer = CreateAwaitExecutable();
+
+  bc::Executable executable(buffer.data());
+
+  KernelRegistry kernel_registry;
+  RegisterBuiltinKernels(kernel_registry);
+  kernel_registry.Register("await.i32", &AwaitI32);
+  kernel_registry.RegisterFused<&AwaitI32, &ReturnI32>({"await.i32", "return"});
+
+  LoadedExecutable loaded_executable(executable, kernel_registry);
+
+  auto work_queue = tfrt::CreateMultiThreadedWorkQueue(
+      /*num_threads=*/4, /*num_blocking_threads=*/4);
+
+  // If the future is not ready, the execution is suspended in the middle of
+  // the fused kernels and resumes with the return.
+  for (bool ready : {true, false}) {
+    ExecutionContext execution_context(&loaded_executable);
+    execution_context.set_work_queue(work_queue.get());
+
+    absl::Notification notification;
+    execution_context.set_exit_handler(
+        [&notification]() { notification.Notify(); });
+
+    auto promise = Promise::Allocate<int32_t>();
+
+    Value input(promise.GetFuture());
+    Value output;
+
+    if (ready) std::move(promise).Set<int32_t>(100);
+
+    std::vector<uint8_t> last_uses = {true};
+    execution_context.Call(executable.functions()[0], last_uses,
+                           absl::Span<Value>(&input, 1),
+                           absl::Span<Value>(&output, 1));
+    Execute(execution_context);
+
+    if (!ready) std::move(promise).Set<int32_t>(100);
+
+    notification.WaitForNotification();
+    TF_ASSERT_OK(execution_context.status());
+
+    EXPECT_EQ(output.Get<int32_t>(), 100);
+  }
+}
+
 struct TestPayload {
   TestPayload() = default;
   TestPayload(const TestPayload& other)
@@ -3189,5 +3284,49 @@ void BM_SequentialAddAttributes(::testing::benchmark::State& state) {
 }
 BENCHMARK(BM_SequentialAddAttributes);
 
+// Runs a chain of `state.range(0)` adds, with pairs of adds fused if
+// `state.range(1)` is non-zero, and reports the time per add.
+void BM_SequentialAddChain(::testing::benchmark::State& state) {
+  const int num_add = state.range(0);
+  auto buffer = CreateSequentialAddExecutable(num_add);
+
+  bc::Executable executable(buffer.data());
+
+  KernelRegistry kernel_registry;
+  RegisterBuiltinKernels(kernel_registry);
+  kernel_registry.Register<AddI32Kernel>();
+  if (state.range(1)) {
+    kernel_registry.RegisterFused<AddI32Kernel, AddI32Kernel>();
+  }
+
+  LoadedExecutable loaded_executable(executable, kernel_registry);
+
+  int32_t v = 1;
+  Value arg(v);
+  Value result;
+
+  auto function = loaded_executable.GetFunction("main");
+  ASSERT_TRUE(function);
+
+  std::vector<uint8_t> last_uses = {false};
+  for (auto s : state) {
+    absl::Notification notification;
+
+    ExecutionContext execution_context(&loaded_executable);
+    execution_context.set_exit_handler([&]() { notification.Notify(); });
+
+    execution_context.Call(function, last_uses, absl::Span<Value>(&arg, 1),
+                           absl::Span<Value>(&result, 1));
+    Execute(execution_context);
+    notification.WaitForNotification();
+  }
+  CHECK_EQ(result.Get<int32_t>(), num_add + 1);
+
+  state.counters["time_per_op"] = ::benchmark::Counter(
+      num_add, ::benchmark::Counter::kIsIterationInvariantRate |
+                   ::benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_SequentialAddChain)->ArgPair(1000, 0)->ArgPair(1000, 1);
+
 }  // namespace
 }  // namespace mlrt
@@ -1009,6 +1009,12 @@ void RegisterTfMlrtKernels(mlrt::KernelRegistry& registry) {
   registry.Register("tf_mlrt.promise_future", &PromiseFuture);
   registry.Register<PromiseReturnOp>();
 
+  // Superinstructions for chains of fallback ops and for ops consuming the
+  // result of an await, which are the most common sequences of kernels.
+  registry.RegisterFused<ExecuteOp, ExecuteOp>();
+  registry.RegisterFused<&AwaitTensor, &mlrt::InvokeKernel<ExecuteOp>>(
+      {"tf_mlrt.await", ExecuteOp::kName});
+
   registry.Merge(GetTfMlrtOptionalKernelRegistry());
 }
 
@@ -15,12 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <limits>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -327,6 +329,103 @@ TEST(FastParse, StatsCollection) {
   }
 }
 
+// Returns an Example with a packed int64 feature "ids" and a packed float
+// feature "weights", each holding `values`.
+static string ExampleWithPackedValues(const std::vector<int64_t>& values) {
+  Example example;
+  auto& features = *example.mutable_features()->mutable_feature();
+  Int64List* int64_list = features["ids"].mutable_int64_list();
+  FloatList* float_list = features["weights"].mutable_float_list();
+  for (int64_t value : values) {
+    int64_list->add_value(value);
+    float_list->add_value(static_cast<float>(value) / 3);
+  }
+  return Serialize(example);
+}
+
+// Returns values that exercise every varint length, including runs of
+// single-byte varints long enough for the vectorized decoding paths.
+static std::vector<int64_t> MixedLengthInt64Values() {
+  std::vector<int64_t> values;
+  for (int i = 0; i < 100; ++i) values.push_back(i);
+  for (int shift = 7; shift < 64; shift += 7) {
+    values.push_back((int64_t{1} << shift) - 1);
+    values.push_back(int64_t{1} << shift);
+  }
+  values.push_back(-1);
+  values.push_back(std::numeric_limits<int64_t>::min());
+  values.push_back(std::numeric_limits<int64_t>::max());
+  for (int i = 0; i < 70; ++i) values.push_back(i % 3 == 0 ? 300 + i : i);
+  return values;
+}
+
+TEST(FastParse, PackedValuesOfAllVarintLengths) {
+  const std::vector<int64_t> values = MixedLengthInt64Values();
+  const string serialized = ExampleWithPackedValues(values);
+  TestCorrectness(serialized);
+
+  const int64_t n = values.size();
+  Tensor expected_ids(DT_INT64, TensorShape({n}));
+  Tensor expected_weights(DT_FLOAT, TensorShape({n}));
+  for (int64_t i = 0; i < n; ++i) {
+    expected_ids.flat<int64_t>()(i) = values[i];
+    expected_weights.flat<float>()(i) = static_cast<float>(values[i]) / 3;
+  }
+
+  FastParseExampleConfig dense_config;
+  AddDenseFeature("ids", DT_INT64, {n}, false, n, &dense_config);
+  AddDenseFeature("weights", DT_FLOAT, {n}, false, n, &dense_config);
+  FastParseExampleConfig ragged_config;
+  ragged_config.ragged.emplace_back("ids", DT_INT64, DT_INT64);
+  ragged_config.ragged.emplace_back("weights", DT_FLOAT, DT_INT64);
+
+  const std::vector<tstring> batch = {serialized, serialized};
+  {
+    Result result;
+    TF_ASSERT_OK(FastParseExample(dense_config, batch, {}, nullptr, &result));
+    ASSERT_EQ(2, result.dense_values.size());
+    for (int64_t i = 0; i < n; ++i) {
+      EXPECT_EQ(values[i], result.dense_values[0].matrix<int64_t>()(1, i));
+      EXPECT_EQ(expected_weights.flat<float>()(i),
+                result.dense_values[1].matrix<float>()(1, i));
+    }
+  }
+  {
+    Result result;
+    TF_ASSERT_OK(FastParseExample(ragged_config, batch, {}, nullptr, &result));
+    ASSERT_EQ(2, result.ragged_values.size());
+    ASSERT_EQ(2 * n, result.ragged_values[0].NumElements());
+    for (int64_t i = 0; i < n; ++i) {
+      EXPECT_EQ(values[i], result.ragged_values[0].flat<int64_t>()(n + i));
+      EXPECT_EQ(expected_weights.flat<float>()(i),
+                result.ragged_values[1].flat<float>()(n + i));
+    }
+  }
+}
+
+TEST(FastParse, DenseShapeMismatchWithPackedValues) {
+  const std::vector<int64_t> values = MixedLengthInt64Values();
+  FastParseExampleConfig config;
+  AddDenseFeature("ids", DT_INT64, {10}, false, 10, &config);
+  Result result;
+  Status status = FastParseExample(config, {ExampleWithPackedValues(values)},
+                                   {}, nullptr, &result);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST(FastParse, TruncatedPackedVarint) {
+  // An Int64List feature "ids" whose packed values end in a byte with the
+  // continuation bit set.
+  const string serialized(
+      "\x0a\x0f\x0a\x0d\x0a\x03ids\x12\x06\x1a\x04\x0a\x02\x01\x81", 17);
+  FastParseExampleConfig config;
+  config.ragged.emplace_back("ids", DT_INT64, DT_INT64);
+  Result result;
+  Status status =
+      FastParseExample(config, {serialized}, {}, nullptr, &result);
+  EXPECT_FALSE(status.ok());
+}
+
 string RandStr(random::SimplePhilox* rng) {
   static const char key_char_lookup[] =
       "0123456789{}~`!@#$%^&*()"
@@ -429,6 +528,60 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+// Parses batches of 128 Examples, each with one packed feature of 256 values,
+// into a dense or a ragged output.
+//
+// `state.range(0)` selects the values: 0 for single-byte varints, 1 for
+// multi-byte varints and 2 for floats. `state.range(1)` selects the output: 0
+// for dense and 1 for ragged.
+static void BM_FastParsePackedFeature(::testing::benchmark::State& state) {
+  constexpr int kBatchSize = 128;
+  constexpr int kNumValues = 256;
+  const int value_kind = state.range(0);
+  const bool ragged = state.range(1) == 1;
+
+  Example example;
+  Feature& feature = (*example.mutable_features()->mutable_feature())["f"];
+  for (int i = 0; i < kNumValues; ++i) {
+    switch (value_kind) {
+      case 0:
+        feature.mutable_int64_list()->add_value(i % 128);
+        break;
+      case 1:
+        feature.mutable_int64_list()->add_value(int64_t{1000003} * i);
+        break;
+      default:
+        feature.mutable_float_list()->add_value(i * 0.5f);
+    }
+  }
+  const std::vector<tstring> serialized(kBatchSize, Serialize(example));
+  const DataType dtype = value_kind == 2 ? DT_FLOAT : DT_INT64;
+
+  FastParseExampleConfig config;
+  if (ragged) {
+    config.ragged.emplace_back("f", dtype, DT_INT64);
+  } else {
+    AddDenseFeature("f", dtype, {kNumValues}, false, kNumValues, &config);
+  }
+
+  for (auto s : state) {
+    Result result;
+    TF_CHECK_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          kBatchSize * kNumValues);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          kBatchSize * serialized[0].size());
+}
+
+BENCHMARK(BM_FastParsePackedFeature)
+    ->ArgPair(0, 0)
+    ->ArgPair(0, 1)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(2, 0)
+    ->ArgPair(2, 1);
+
 }  // namespace
 }  // namespace example
 }  // namespace tensorflow
@@ -15,8 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
+#include <map>
 #include <memory>
 #include <utility>
 
@@ -41,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/status.h"
@@ -49,6 +54,7 @@ limitations under the License.
 #include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/byte_swap_tensor.h"
+#include "tensorflow/core/util/tensor_bundle/mapped_tensor_buffer.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_slice_util.h"
 #include "tsl/lib/io/buffered_file.h"
@@ -422,6 +428,63 @@ Status PadAlignment(tsl::BufferedWritableFile* out, int alignment,
   return status;
 }
 
+// A tensor fetched by the read plan of BundleReader::LookupMany().
+struct PlannedTensor {
+  BundleEntryProto entry;
+  Tensor* val;
+  // Destination of the `entry.size()` bytes stored in the data file.
+  char* data;
+  // Number of reads that have to complete before all bytes are fetched.
+  std::atomic<int> pending_reads{0};
+};
+
+// A single read of a data file. Covers either one or more whole tensors, or a
+// section of a single large tensor.
+struct PlannedRead {
+  int32_t shard_id;
+  int64_t offset;
+  int64_t size;
+  std::vector<PlannedTensor*> tensors;
+};
+
+// Issues "read" against "file" and copies the fetched bytes to the tensors it
+// covers. A read that covers a single tensor is issued directly into the
+// tensor's buffer; coalesced reads go through a staging buffer.
+Status ExecutePlannedRead(RandomAccessFile* file, const PlannedRead& read) {
+  std::unique_ptr<char[]> staging;
+  char* scratch;
+  if (read.tensors.size() == 1) {
+    const PlannedTensor* t = read.tensors[0];
+    scratch = t->data + (read.offset - t->entry.offset());
+  } else {
+    staging.reset(new char[read.size]);
+    scratch = staging.get();
+  }
+
+  StringPiece result;
+  TF_RETURN_IF_ERROR(file->Read(read.offset, read.size, &result, scratch));
+  if (result.size() != read.size) {
+    return errors::DataLoss("Requested ", read.size, " bytes at offset ",
+                            read.offset, " but read ", result.size(),
+                            " bytes");
+  }
+
+  if (read.tensors.size() == 1) {
+    if (result.data() != scratch) {
+      memmove(scratch, result.data(), read.size);
+    }
+    return OkStatus();
+  }
+  for (PlannedTensor* t : read.tensors) {
+    const int64_t begin = std::max(read.offset, t->entry.offset());
+    const int64_t end = std::min(read.offset + read.size,
+                                 t->entry.offset() + t->entry.size());
+    memcpy(t->data + (begin - t->entry.offset()),
+           result.data() + (begin - read.offset), end - begin);
+  }
+  return OkStatus();
+}
+
 }  // namespace
 
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
@@ -770,6 +833,12 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
 BundleReader::BundleReader(
     Env* env, StringPiece prefix,
     bool enable_multi_threading_for_testing /* = false */)
+    : BundleReader(env, prefix,
+                   Options{/*use_mmap=*/false,
+                           enable_multi_threading_for_testing}) {}
+
+BundleReader::BundleReader(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
       prefix_(prefix),
       metadata_(nullptr),
@@ -777,7 +846,9 @@ BundleReader::BundleReader(
       index_cache_(nullptr),
       iter_(nullptr),
       need_to_swap_bytes_(false),
-      enable_multi_threading_for_testing_(enable_multi_threading_for_testing) {
+      enable_multi_threading_for_testing_(
+          options.enable_multi_threading_for_testing),
+      use_mmap_(options.use_mmap) {
   const string filename = MetaFilename(prefix_);
   uint64 file_size;
   status_ = env_->GetFileSize(filename, &file_size);
@@ -1024,6 +1095,275 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupMaybeAliased(StringPiece key, Allocator* allocator,
+                                        Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+
+  if (use_mmap_ && entry.slices().empty()) {
+    bool aliased = false;
+    TF_RETURN_IF_ERROR(GetAliasedValue(entry, val, &aliased));
+    if (aliased) return OkStatus();
+  }
+
+  *val = Tensor(allocator, entry.dtype(), TensorShape(entry.shape()));
+  if (entry.slices().empty()) {
+    return GetValue(entry, val);
+  } else {
+    return GetSliceValue(
+        key, entry,
+        /* a full slice */ TensorSlice(TensorShape(entry.shape()).dims()), val);
+  }
+}
+
+Status BundleReader::LookupMany(const std::vector<string>& keys,
+                                const std::vector<Tensor*>& vals,
+                                const ParallelLookupOptions& options,
+                                std::vector<ShardReadStats>* stats) {
+  CHECK_EQ(keys.size(), vals.size());
+  if (stats != nullptr) stats->clear();
+
+  // Collects the tensors that the read plan fetches, grouped by data file.
+  std::map<int32_t, std::vector<std::unique_ptr<PlannedTensor>>> planned;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    CHECK(vals[i] != nullptr);
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(keys[i], &entry));
+    if (!entry.slices().empty() || !DataTypeCanUseMemcpy(entry.dtype()) ||
+        vals[i]->NumElements() == 0) {
+      TF_RETURN_IF_ERROR(Lookup(keys[i], vals[i]));
+      continue;
+    }
+    if (entry.size() != vals[i]->TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", keys[i],
+                              "; stored size ", entry.size(),
+                              "; expected size ", vals[i]->TotalBytes());
+    }
+    auto t = std::make_unique<PlannedTensor>();
+    t->entry.Swap(&entry);
+    t->val = vals[i];
+    t->data = const_cast<char*>(vals[i]->tensor_data().data());
+    planned[t->entry.shard_id()].push_back(std::move(t));
+  }
+  if (planned.empty()) return OkStatus();
+
+  // Builds the reads of each data file in offset order, coalescing nearby
+  // entries and splitting large ones.
+  const int64_t max_read_bytes = std::max<int64_t>(options.max_read_bytes, 1);
+  const int64_t max_inflight_bytes =
+      std::max<int64_t>(options.max_inflight_bytes, 1);
+  std::unordered_map<int32_t, std::unique_ptr<RandomAccessFile>> files;
+  std::vector<std::vector<PlannedRead>> shard_reads;
+  for (auto& [shard_id, tensors] : planned) {
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, shard_id, num_shards_), &files[shard_id]));
+    absl::c_sort(tensors, [](const std::unique_ptr<PlannedTensor>& a,
+                             const std::unique_ptr<PlannedTensor>& b) {
+      return a->entry.offset() < b->entry.offset();
+    });
+    std::vector<PlannedRead>& reads = shard_reads.emplace_back();
+    for (const std::unique_ptr<PlannedTensor>& t : tensors) {
+      const int64_t offset = t->entry.offset();
+      const int64_t size = t->entry.size();
+      if (!reads.empty()) {
+        PlannedRead& last = reads.back();
+        const int64_t last_end = last.offset + last.size;
+        if (offset >= last_end &&
+            offset - last_end <= options.max_coalesce_gap_bytes &&
+            offset + size - last.offset <= max_read_bytes) {
+          last.size = offset + size - last.offset;
+          last.tensors.push_back(t.get());
+          t->pending_reads = 1;
+          continue;
+        }
+      }
+      for (int64_t section = 0; section < size; section += max_read_bytes) {
+        reads.push_back({shard_id, offset + section,
+                         std::min(max_read_bytes, size - section), {t.get()}});
+        ++t->pending_reads;
+      }
+    }
+  }
+
+  // Interleaves the reads of all data files, so that every shard makes
+  // progress concurrently.
+  std::vector<const PlannedRead*> schedule;
+  for (size_t round = 0;; ++round) {
+    const size_t scheduled = schedule.size();
+    for (const std::vector<PlannedRead>& reads : shard_reads) {
+      if (round < reads.size()) schedule.push_back(&reads[round]);
+    }
+    if (schedule.size() == scheduled) break;
+  }
+
+  // Validates the checksum of a fully fetched tensor.
+  auto finish_tensor = [this](const PlannedTensor& t) -> Status {
+    const uint32 actual_crc32c = crc32c::Value(t.data, t.entry.size());
+    if (crc32c::Unmask(t.entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "TensorBundle at ", prefix_, " shard ", t.entry.shard_id(), " (",
+          t.entry.size(), " bytes): Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(t.entry.crc32c())),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+    if (need_to_swap_bytes_) {
+      TF_RETURN_IF_ERROR(ByteSwapTensor(t.val));
+    }
+    return OkStatus();
+  };
+
+  struct ShardProgress {
+    int64_t num_reads = 0;
+    int64_t bytes_read = 0;
+    uint64 start_micros = std::numeric_limits<uint64>::max();
+    uint64 end_micros = 0;
+  };
+  // The state below is guarded by `mu`.
+  mutex mu;
+  condition_variable cv;
+  int64_t inflight_bytes = 0;
+  Status status;
+  std::map<int32_t, ShardProgress> progress;
+
+  auto charge = [max_inflight_bytes](const PlannedRead& read) {
+    return std::min(read.size, max_inflight_bytes);
+  };
+  auto run_read = [&](const PlannedRead* read) {
+    const uint64 start_micros = env_->NowMicros();
+    Status s = ExecutePlannedRead(files.at(read->shard_id).get(), *read);
+    if (s.ok()) {
+      for (PlannedTensor* t : read->tensors) {
+        if (t->pending_reads.fetch_sub(1) == 1) s.Update(finish_tensor(*t));
+      }
+    }
+    const uint64 end_micros = env_->NowMicros();
+
+    mutex_lock l(mu);
+    status.Update(s);
+    inflight_bytes -= charge(*read);
+    ShardProgress& p = progress[read->shard_id];
+    ++p.num_reads;
+    p.bytes_read += read->size;
+    p.start_micros = std::min(p.start_micros, start_micros);
+    p.end_micros = std::max(p.end_micros, end_micros);
+    cv.notify_all();
+  };
+
+  {
+    std::unique_ptr<thread::ThreadPool> pool;
+    if (options.num_threads > 1 && schedule.size() > 1) {
+      pool = std::make_unique<thread::ThreadPool>(env_, "restore_shards",
+                                                  options.num_threads);
+    }
+    for (const PlannedRead* read : schedule) {
+      {
+        // A read larger than the budget is admitted once nothing else is in
+        // flight.
+        mutex_lock l(mu);
+        while (inflight_bytes > 0 &&
+               inflight_bytes + charge(*read) > max_inflight_bytes) {
+          cv.wait(l);
+        }
+        if (!status.ok()) break;
+        inflight_bytes += charge(*read);
+      }
+      if (pool != nullptr) {
+        pool->Schedule([&run_read, read]() { run_read(read); });
+      } else {
+        run_read(read);
+      }
+    }
+    // Waits for the scheduled reads to finish.
+  }
+
+  mutex_lock l(mu);
+  if (stats != nullptr) {
+    for (const auto& [shard_id, tensors] : planned) {
+      ShardReadStats& shard_stats = stats->emplace_back();
+      shard_stats.shard_id = shard_id;
+      shard_stats.num_tensors = tensors.size();
+      auto it = progress.find(shard_id);
+      if (it == progress.end()) continue;
+      shard_stats.num_reads = it->second.num_reads;
+      shard_stats.bytes_read = it->second.bytes_read;
+      shard_stats.elapsed_micros =
+          it->second.end_micros - it->second.start_micros;
+    }
+  }
+  return status;
+}
+
+std::shared_ptr<ReadOnlyMemoryRegion> BundleReader::GetMappedShard(
+    int32_t shard_id) {
+  auto it = mapped_data_.find(shard_id);
+  if (it != mapped_data_.end()) return it->second;
+
+  const string filename = DataFilename(prefix_, shard_id, num_shards_);
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &region);
+  if (!s.ok()) {
+    VLOG(1) << "Unable to memory-map " << filename << ", falling back to "
+            << "copying reads: " << s;
+    region.reset();
+  }
+  std::shared_ptr<ReadOnlyMemoryRegion> mapped(std::move(region));
+  mapped_data_[shard_id] = mapped;
+  return mapped;
+}
+
+Status BundleReader::GetAliasedValue(const BundleEntryProto& entry,
+                                     Tensor* val, bool* aliased) {
+  *aliased = false;
+  // Strings and variants need decoding, and byte-swapped data needs a
+  // writable copy.
+  if (!DataTypeCanUseMemcpy(entry.dtype()) || need_to_swap_bytes_) {
+    return OkStatus();
+  }
+  const TensorShape stored_shape(entry.shape());
+  const int64_t expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+  if (expected_size == 0) return OkStatus();
+
+  std::shared_ptr<ReadOnlyMemoryRegion> region =
+      GetMappedShard(entry.shard_id());
+  if (region == nullptr) return OkStatus();
+  if (entry.offset() < 0 ||
+      entry.offset() + entry.size() > static_cast<int64_t>(region->length())) {
+    return errors::DataLoss("TensorBundle at ", prefix_, " shard ",
+                            entry.shard_id(), " (", region->length(),
+                            " bytes) is too short to hold ", entry.size(),
+                            " bytes at offset ", entry.offset());
+  }
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  if (reinterpret_cast<uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    // Only bundles written with a large enough `data_alignment` can be
+    // aliased; the caller falls back to an aligned copy.
+    return OkStatus();
+  }
+
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the mapped bytes ", actual_crc32c);
+  }
+
+  auto* buf = new MappedTensorBuffer(std::move(region), data, entry.size());
+  *val = Tensor(entry.dtype(), stored_shape, buf);
+  buf->Unref();
+  *aliased = true;
+  ++num_aliased_lookups_;
+  return OkStatus();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
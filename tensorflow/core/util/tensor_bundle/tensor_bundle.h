@@ -200,8 +200,49 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
+  struct Options {
+    // If true, the data files are memory-mapped when the underlying file
+    // system supports it, and `LookupMaybeAliased()` returns tensors whose
+    // buffers alias the mapped file contents instead of copies.
+    bool use_mmap = false;
+
+    bool enable_multi_threading_for_testing = false;
+  };
+
+  // Options for `LookupMany()`.
+  struct ParallelLookupOptions {
+    // Number of threads issuing reads. Reads of different data files are
+    // interleaved so that all shards make progress concurrently.
+    int num_threads = 8;
+
+    // Upper bound on the number of bytes covered by the reads in flight at any
+    // time. This also bounds the staging memory used by coalesced reads.
+    int64_t max_inflight_bytes = 256 << 20;
+
+    // Neighbouring entries of a data file that are at most this many bytes
+    // apart are fetched with a single read.
+    int64_t max_coalesce_gap_bytes = 64 << 10;
+
+    // No read covers more than this many bytes. Larger entries are split into
+    // sections that are read in parallel directly into the destination tensor.
+    int64_t max_read_bytes = 16 << 20;
+  };
+
+  // Per data file statistics collected by `LookupMany()`.
+  struct ShardReadStats {
+    int32_t shard_id = 0;
+    int64_t num_tensors = 0;
+    int64_t num_reads = 0;
+    int64_t bytes_read = 0;
+    // Wall time between the start of the first and the end of the last read
+    // of this data file.
+    int64_t elapsed_micros = 0;
+  };
+
   BundleReader(Env* const env, absl::string_view prefix,
                bool enable_multi_threading_for_testing = false);
+  BundleReader(Env* const env, absl::string_view prefix,
+               const Options& options);
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -251,6 +292,46 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the tensor keyed by "key", replacing "*val" with a tensor of the
+  // stored dtype and shape.
+  //
+  // If the reader was created with `Options::use_mmap`, the stored tensor is
+  // an unpartitioned tensor of a memcpy-able dtype in this machine's byte
+  // order, and its bytes are suitably aligned in the mapped data file, the
+  // returned tensor's buffer aliases the mapping and no copy is made. The
+  // mapping stays alive for as long as any such tensor refers to it, even
+  // after the reader is destroyed. The aliased buffer is read-only and does
+  // not report itself as owning its memory, so ops that modify their inputs
+  // in place will copy it first.
+  //
+  // Otherwise, "*val" is allocated from "allocator" and filled as in
+  // `Lookup()`. Validates the stored crc32c checksum in both cases.
+  // REQUIRES: status().ok()
+  Status LookupMaybeAliased(absl::string_view key, Allocator* allocator,
+                            Tensor* val) TF_MUST_USE_RESULT;
+
+  // Returns the number of tensors returned by `LookupMaybeAliased()` whose
+  // buffers alias a memory-mapped data file.
+  int64_t num_aliased_lookups() const { return num_aliased_lookups_; }
+
+  // Looks up the tensors keyed by "keys" into the corresponding "vals", with
+  // the same requirements and semantics as calling `Lookup()` on each pair.
+  //
+  // Unpartitioned tensors of memcpy-able dtypes are fetched according to a
+  // read plan built per data file: entries are sorted by offset, neighbouring
+  // entries are coalesced into large sequential reads, and the reads are run
+  // on a pool of `options.num_threads` threads with at most
+  // `options.max_inflight_bytes` in flight. Other tensors are looked up one by
+  // one on the calling thread.
+  //
+  // If "stats" is not null, it is filled with one element per data file that
+  // was read by the plan, ordered by shard id.
+  // REQUIRES: status().ok() && keys.size() == vals.size()
+  Status LookupMany(const std::vector<std::string>& keys,
+                    const std::vector<Tensor*>& vals,
+                    const ParallelLookupOptions& options,
+                    std::vector<ShardReadStats>* stats) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -317,6 +398,16 @@ class BundleReader {
                        const TensorSlice& slice_spec,
                        Tensor* val) TF_MUST_USE_RESULT;
 
+  // Returns the memory-mapped contents of data file "shard_id", or nullptr if
+  // the file system does not support memory-mapping the file.
+  std::shared_ptr<ReadOnlyMemoryRegion> GetMappedShard(int32_t shard_id);
+
+  // Tries to return the tensor described by "entry" as a view into the mapped
+  // data file. Sets "*aliased" to false, leaving "*val" untouched, if the
+  // entry cannot be aliased.
+  Status GetAliasedValue(const BundleEntryProto& entry, Tensor* val,
+                         bool* aliased) TF_MUST_USE_RESULT;
+
   Env* env_;  // Not owned.
   const std::string prefix_;
 
@@ -344,6 +435,14 @@ class BundleReader {
 
   bool enable_multi_threading_for_testing_ = false;
 
+  const bool use_mmap_ = false;
+
+  // Memory-mapped data files, keyed by shard id. A null value records that
+  // the shard could not be mapped, so that we don't retry for every tensor.
+  std::unordered_map<int32_t, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
+  int64_t num_aliased_lookups_ = 0;
+
   BundleReader(const BundleReader&) = delete;
   void operator=(const BundleReader&) = delete;
 };
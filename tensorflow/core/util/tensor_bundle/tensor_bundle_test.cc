@@ -914,6 +914,101 @@ TEST(TensorBundleTest, DirectoryStructure) {
                           "merged.data-00001-of-00002"});
 }
 
+TEST(TensorBundleTest, LookupManyCoalescesReadsPerShard) {
+  Env* env = Env::Default();
+  const std::vector<string> kBundlePrefixes = {Prefix("lookup_many0"),
+                                               Prefix("lookup_many1")};
+  for (int i = 0; i < 2; ++i) {
+    BundleWriter writer(env, kBundlePrefixes[i]);
+    for (int j = 0; j < 4; ++j) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("small", i, "_", j),
+                              Constant_2x3<float>(i * 10 + j)));
+    }
+    TF_EXPECT_OK(writer.Add(strings::StrCat("large", i),
+                            Constant_100x100<int32>(i + 1)));
+    TF_EXPECT_OK(writer.Add(strings::StrCat("string", i),
+                            Constant_2x3<tstring>(strings::StrCat(i))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const string kMerged = Prefix("lookup_many");
+  TF_ASSERT_OK(
+      MergeBundles(env, {kBundlePrefixes[0], kBundlePrefixes[1]}, kMerged));
+
+  BundleReader reader(env, kMerged);
+  TF_ASSERT_OK(reader.status());
+  std::vector<string> keys;
+  std::vector<Tensor> expected;
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      keys.push_back(strings::StrCat("small", i, "_", j));
+      expected.push_back(Constant_2x3<float>(i * 10 + j));
+    }
+    keys.push_back(strings::StrCat("large", i));
+    expected.push_back(Constant_100x100<int32>(i + 1));
+    keys.push_back(strings::StrCat("string", i));
+    expected.push_back(Constant_2x3<tstring>(strings::StrCat(i)));
+  }
+  std::vector<Tensor> restored;
+  std::vector<Tensor*> vals;
+  for (const Tensor& t : expected) {
+    restored.emplace_back(t.dtype(), t.shape());
+  }
+  for (Tensor& t : restored) vals.push_back(&t);
+
+  BundleReader::ParallelLookupOptions options;
+  options.num_threads = 4;
+  // Small enough to split the 40000-byte tensors into several sections, and
+  // to keep only a couple of reads in flight.
+  options.max_read_bytes = 4096;
+  options.max_inflight_bytes = 8192;
+  std::vector<BundleReader::ShardReadStats> stats;
+  TF_ASSERT_OK(reader.LookupMany(keys, vals, options, &stats));
+
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      test::ExpectTensorEqual<float>(restored[i * 6 + j], expected[i * 6 + j]);
+    }
+    test::ExpectTensorEqual<int32>(restored[i * 6 + 4], expected[i * 6 + 4]);
+    test::ExpectTensorEqual<tstring>(restored[i * 6 + 5], expected[i * 6 + 5]);
+  }
+
+  // String tensors are not part of the read plan. In each shard the four
+  // small tensors are fetched with one read, and the large one with ten.
+  ASSERT_EQ(2, stats.size());
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(i, stats[i].shard_id);
+    EXPECT_EQ(5, stats[i].num_tensors);
+    EXPECT_EQ(11, stats[i].num_reads);
+    EXPECT_EQ(4 * 6 * sizeof(float) + 100 * 100 * sizeof(int32),
+              stats[i].bytes_read);
+  }
+}
+
+TEST(TensorBundleTest, LookupManyValidatesChecksum) {
+  Env* env = Env::Default();
+  {
+    BundleWriter writer(env, Prefix("lookup_many_corrupt"));
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const string data_path = DataFilename(Prefix("lookup_many_corrupt"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(env, data_path, &data));
+  data[data.size() - 1] ^= 0x1;
+  TF_ASSERT_OK(WriteStringToFile(env, data_path, data));
+
+  BundleReader reader(env, Prefix("lookup_many_corrupt"));
+  TF_ASSERT_OK(reader.status());
+  Tensor a(DT_FLOAT, TensorShape({2, 3}));
+  Tensor b(DT_FLOAT, TensorShape({2, 3}));
+  Status s = reader.LookupMany({"a", "b"}, {&a, &b},
+                               BundleReader::ParallelLookupOptions(),
+                               /*stats=*/nullptr);
+  EXPECT_TRUE(errors::IsDataLoss(s)) << s;
+  EXPECT_TRUE(absl::StrContains(s.message(), "Checksum does not match")) << s;
+}
+
 TEST(TensorBundleTest, SortForSequentialAccess) {
   Env* env = Env::Default();
   const std::vector<string> kBundlePrefixes = {Prefix("worker0"),
@@ -1201,6 +1296,82 @@ TEST_F(TensorBundleAlignmentTest, AlignmentTest) {
   }
 }
 
+TEST(TensorBundleTest, MmapLookupAliasesAlignedTensors) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+    BundleWriter writer(Env::Default(), Prefix("mmap"), opts);
+    TF_EXPECT_OK(writer.Add("float", Constant_100x100<float>(1.5)));
+    TF_EXPECT_OK(writer.Add("int", Constant_2x3<int32>(7)));
+    TF_EXPECT_OK(writer.Add("string", Constant_2x3<tstring>("hello")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor float_val;
+  Tensor int_val;
+  Tensor string_val;
+  {
+    BundleReader::Options options;
+    options.use_mmap = true;
+    BundleReader reader(Env::Default(), Prefix("mmap"), options);
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(
+        reader.LookupMaybeAliased("float", cpu_allocator(), &float_val));
+    TF_ASSERT_OK(reader.LookupMaybeAliased("int", cpu_allocator(), &int_val));
+    TF_ASSERT_OK(
+        reader.LookupMaybeAliased("string", cpu_allocator(), &string_val));
+    // String tensors need decoding and are always copied.
+    EXPECT_EQ(2, reader.num_aliased_lookups());
+    // Aliased buffers must not be forwarded to ops that write in place.
+    EXPECT_FALSE(float_val.RefCountIsOne());
+  }
+  // The mapping outlives the reader.
+  test::ExpectTensorEqual<float>(float_val, Constant_100x100<float>(1.5));
+  test::ExpectTensorEqual<int32>(int_val, Constant_2x3<int32>(7));
+  test::ExpectTensorEqual<tstring>(string_val, Constant_2x3<tstring>("hello"));
+}
+
+TEST(TensorBundleTest, MmapLookupCopiesUnalignedTensors) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("mmap_unaligned"));
+    TF_EXPECT_OK(writer.Add("bool", Constant(true, TensorShape({1}))));
+    TF_EXPECT_OK(writer.Add("float", Constant_2x3<float>(2.5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options options;
+  options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_unaligned"), options);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.LookupMaybeAliased("float", cpu_allocator(), &val));
+  test::ExpectTensorEqual<float>(val, Constant_2x3<float>(2.5));
+  EXPECT_EQ(0, reader.num_aliased_lookups());
+  EXPECT_TRUE(val.RefCountIsOne());
+}
+
+TEST(TensorBundleTest, MmapLookupValidatesChecksum) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+    BundleWriter writer(Env::Default(), Prefix("mmap_corrupt"), opts);
+    TF_EXPECT_OK(writer.Add("float", Constant_100x100<float>(1.5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const string data_path = DataFilename(Prefix("mmap_corrupt"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), data_path, &data));
+  data[data.size() / 2] ^= 0x1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), data_path, data));
+
+  BundleReader::Options options;
+  options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_corrupt"), options);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  Status s = reader.LookupMaybeAliased("float", cpu_allocator(), &val);
+  EXPECT_TRUE(errors::IsDataLoss(s)) << s;
+  EXPECT_TRUE(absl::StrContains(s.message(), "Checksum does not match")) << s;
+}
+
 static void BM_BundleAlignment(::testing::benchmark::State& state) {
   {
     const int alignment = state.range(0);
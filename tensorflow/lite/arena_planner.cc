@@ -34,6 +34,27 @@ constexpr int32_t kLastActiveNodeUndefined =
 constexpr int32_t kNodeNotAssigned = std::numeric_limits<int32_t>::max();
 constexpr int32_t kScalarTensorBytes = 4;
 
+SharedArena::SharedArena(int id)
+    : id_(id), buffer_(kDefaultArenaAlignment, /*subgraph_index=*/0) {}
+
+void SharedArena::AddPlanner(ArenaPlanner* planner) {
+  planners_.push_back(planner);
+}
+
+void SharedArena::RemovePlanner(ArenaPlanner* planner) {
+  planners_.erase(std::remove(planners_.begin(), planners_.end(), planner),
+                  planners_.end());
+}
+
+TfLiteStatus SharedArena::OnBufferMoved(const ArenaPlanner* source) {
+  for (ArenaPlanner* planner : planners_) {
+    if (planner != source) {
+      TF_LITE_ENSURE_STATUS(planner->ResolveNonPersistentTensors());
+    }
+  }
+  return kTfLiteOk;
+}
+
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
                            bool preserve_all_tensors, int tensor_alignment,
@@ -50,6 +71,18 @@ ArenaPlanner::ArenaPlanner(TfLiteContext* context,
 ArenaPlanner::~ArenaPlanner() {
   arena_.ReleaseBuffer();
   persistent_arena_.ReleaseBuffer();
+  if (shared_arena_) {
+    shared_arena_->RemovePlanner(this);
+  }
+}
+
+void ArenaPlanner::ShareArena(std::shared_ptr<SharedArena> shared_arena) {
+  if (shared_arena_) {
+    shared_arena_->RemovePlanner(this);
+  }
+  shared_arena_ = std::move(shared_arena);
+  shared_arena_->AddPlanner(this);
+  arena_.UseSharedBuffer(&shared_arena_->buffer_);
 }
 
 std::intptr_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
@@ -397,6 +430,9 @@ TfLiteStatus ArenaPlanner::AcquireNonPersistentMemory() {
   bool reallocated;
   TF_LITE_ENSURE_STATUS(arena_.Commit(&reallocated));
   has_nonpersistent_memory_ = true;
+  if (reallocated && shared_arena_) {
+    TF_LITE_ENSURE_STATUS(shared_arena_->OnBufferMoved(this));
+  }
   // Resolve allocations for all tensors not on the persistent arena.
   TfLiteTensor* tensors = graph_info_->tensors();
   for (int i = 0; i < static_cast<int>(graph_info_->num_tensors()); ++i) {
@@ -412,6 +448,21 @@ bool ArenaPlanner::HasNonPersistentMemory() {
   return has_nonpersistent_memory_;
 }
 
+TfLiteStatus ArenaPlanner::ResolveNonPersistentTensors() {
+  // An arena that is not committed resolves all its tensors on its next
+  // commit, since it sees that the buffer moved.
+  if (!has_nonpersistent_memory_ || !arena_.IsCommitted()) {
+    return kTfLiteOk;
+  }
+  TfLiteTensor* tensors = graph_info_->tensors();
+  for (int i = 0; i < static_cast<int>(allocs_.size()); ++i) {
+    if (tensors[i].allocation_type == kTfLiteArenaRw) {
+      TF_LITE_ENSURE_STATUS(ResolveTensorAllocation(i, tensors));
+    }
+  }
+  return kTfLiteOk;
+}
+
 void ArenaPlanner::DumpDebugInfo(const std::vector<int>& execution_plan) const {
   arena_.DumpDebugInfo("kTfLiteArenaRw Dump:", execution_plan);
   persistent_arena_.DumpDebugInfo("kTfLiteArenaRwPersistent Dump:",
@@ -420,7 +471,8 @@ void ArenaPlanner::DumpDebugInfo(const std::vector<int>& execution_plan) const {
 
 void ArenaPlanner::GetAllocInfo(size_t* arena_size,
                                 size_t* arena_persist_size) const {
-  *arena_size = arena_.GetBufferSize();
+  *arena_size = shared_arena_ ? arena_.GetRequiredBufferSize()
+                              : arena_.GetBufferSize();
   *arena_persist_size = persistent_arena_.GetBufferSize();
 }
 
@@ -428,6 +480,9 @@ TfLiteStatus ArenaPlanner::Commit(bool* reallocated) {
   bool arena_reallocated, persistent_arena_reallocated;
   TF_LITE_ENSURE_STATUS(arena_.Commit(&arena_reallocated));
   has_nonpersistent_memory_ = true;
+  if (arena_reallocated && shared_arena_) {
+    TF_LITE_ENSURE_STATUS(shared_arena_->OnBufferMoved(this));
+  }
   TF_LITE_ENSURE_STATUS(
       persistent_arena_.Commit(&persistent_arena_reallocated));
   *reallocated = arena_reallocated;
@@ -32,6 +32,42 @@ namespace tflite {
 
 constexpr const int kDefaultArenaAlignment = 64;
 
+class ArenaPlanner;
+
+// A buffer that the non-persistent arenas of several ArenaPlanners share. The
+// planners must belong to subgraphs whose non-persistent tensors are never
+// live at the same time, e.g. the two branches of an IF. The buffer grows to
+// the largest plan of any of the planners.
+//
+// When a commit moves the buffer, the tensors of all other planners that
+// share it are resolved again, so that their pointers stay valid.
+class SharedArena {
+ public:
+  explicit SharedArena(int id);
+  SharedArena(const SharedArena&) = delete;
+  SharedArena& operator=(const SharedArena&) = delete;
+
+  // Identifies the shared arena among the shared arenas of an interpreter.
+  int id() const { return id_; }
+
+  // Returns the size of the shared buffer.
+  size_t size() const { return buffer_.GetSize(); }
+
+ private:
+  friend class ArenaPlanner;
+
+  void AddPlanner(ArenaPlanner* planner);
+  void RemovePlanner(ArenaPlanner* planner);
+
+  // Resolves the tensors of all planners other than `source`, whose commit
+  // moved the buffer.
+  TfLiteStatus OnBufferMoved(const ArenaPlanner* source);
+
+  const int id_;
+  ResizableAlignedBuffer buffer_;
+  std::vector<ArenaPlanner*> planners_;
+};
+
 // A memory planner that makes all the allocations using arenas.
 //
 // Before a model is executed by the interpreter, this class determines when
@@ -72,7 +108,20 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Places the non-persistent tensors in the buffer of `shared_arena`, which
+  // is shared with the planners of other subgraphs. Must be called before
+  // memory is allocated. When the arena is shared, GetAllocInfo() reports the
+  // size of the memory that this planner needs rather than the size of the
+  // shared buffer.
+  void ShareArena(std::shared_ptr<SharedArena> shared_arena);
+
  private:
+  friend class SharedArena;
+
+  // Resolves the tensors in the non-persistent arena again after another
+  // planner moved the shared buffer.
+  TfLiteStatus ResolveNonPersistentTensors();
+
   // Check whether the input tensor's memory may be shared the output tensor.
   // tensor_changed: true if the output tensor modifies the tensor data. For
   // example, `Reshape` doesn't modify data but Add does.
@@ -166,6 +215,9 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Store number of references to each tensor.
   std::vector<int> refcounts_;
+
+  // If set, `arena_` places its tensors in the buffer of this shared arena.
+  std::shared_ptr<SharedArena> shared_arena_;
 };
 
 }  // namespace tflite
@@ -1087,5 +1087,63 @@ TEST_F(ArenaPlannerTest, SimpleProfilerTest) {
   EXPECT_EQ(gNumDealloc, 1);
 }
 
+TEST(SharedArenaTest, PlannersShareNonPersistentArena) {
+  TfLiteContext context;
+  context.ReportError = ReportError;
+  auto shared_arena = std::make_shared<SharedArena>(/*id=*/3);
+  auto create_planner = [&](TestGraph* graph) {
+    auto planner = std::make_unique<ArenaPlanner>(
+        &context, std::unique_ptr<GraphInfo>(new TestGraphInfo(graph)),
+        /*preserve_all_tensors=*/false, kTensorAlignment);
+    planner->ShareArena(shared_arena);
+    CHECK(planner->ResetAllocations() == kTfLiteOk);
+    CHECK(planner->PlanAllocations() == kTfLiteOk);
+    return planner;
+  };
+  auto offset = [](ArenaPlanner* planner, const TfLiteTensor& tensor) {
+    return reinterpret_cast<std::intptr_t>(tensor.data.raw) -
+           planner->BasePointer(kTfLiteArenaRw);
+  };
+
+  TestGraph small_graph({1}, {{{1}, {2}, {}}}, {2});
+  TestGraph large_graph({0, 1},
+                        {
+                            {{0, 1}, {2}, {}},  // First op
+                            {{2, 0}, {4, 5}, {}},  // Second op
+                            {{4, 5}, {3}, {}}   // Third op
+                        },
+                        {3});
+  auto small_planner = create_planner(&small_graph);
+  auto large_planner = create_planner(&large_graph);
+  EXPECT_EQ(shared_arena->id(), 3);
+
+  ASSERT_EQ(small_planner->ExecuteAllocations(0, 0), kTfLiteOk);
+  const TfLiteTensor& small_output = (*small_graph.tensors())[2];
+  const std::ptrdiff_t small_output_offset =
+      offset(small_planner.get(), small_output);
+  size_t small_arena_size, large_arena_size, persistent_arena_size;
+  small_planner->GetAllocInfo(&small_arena_size, &persistent_arena_size);
+  EXPECT_EQ(shared_arena->size(), small_arena_size);
+
+  // Committing the larger plan grows the shared buffer, which may move it. The
+  // tensors of the small graph must follow.
+  ASSERT_EQ(large_planner->ExecuteAllocations(0, 2), kTfLiteOk);
+  EXPECT_EQ(small_planner->BasePointer(kTfLiteArenaRw),
+            large_planner->BasePointer(kTfLiteArenaRw));
+  EXPECT_EQ(offset(small_planner.get(), small_output), small_output_offset);
+  large_planner->GetAllocInfo(&large_arena_size, &persistent_arena_size);
+  EXPECT_GT(large_arena_size, small_arena_size);
+  EXPECT_EQ(shared_arena->size(), large_arena_size);
+  // Each planner reports the memory that it needs, not the shared buffer.
+  small_planner->GetAllocInfo(&small_arena_size, &persistent_arena_size);
+  EXPECT_LT(small_arena_size, large_arena_size);
+
+  // Releasing the memory of one planner leaves the shared buffer alone.
+  ASSERT_EQ(large_planner->ReleaseNonPersistentMemory(), kTfLiteOk);
+  large_planner.reset();
+  EXPECT_EQ(shared_arena->size(), large_arena_size);
+  EXPECT_EQ(offset(small_planner.get(), small_output), small_output_offset);
+}
+
 }  // namespace
 }  // namespace tflite
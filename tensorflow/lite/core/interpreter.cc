@@ -19,6 +19,7 @@ limitations under the License.
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <functional>
 #include <map>
 #include <memory>
@@ -28,8 +29,10 @@ limitations under the License.
 
 #include "ruy/denormal.h"  // from @ruy
 #include "tensorflow/lite/allocation.h"
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/signature_runner.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
@@ -39,6 +42,10 @@ limitations under the License.
 #include "tensorflow/lite/stderr_reporter.h"
 #include "tensorflow/lite/util.h"
 
+#ifndef TFLITE_USE_SIMPLE_MEMORY_PLANNER
+#include "tensorflow/lite/arena_planner.h"
+#endif
+
 // TODO(b/139446230): Move to portable platform header.
 #if defined(__ANDROID__)
 #define TFLITE_IS_MOBILE_PLATFORM
@@ -89,6 +96,46 @@ TfLiteQuantization GetQuantizationFromLegacy(
     TF_LITE_ENSURE_STATUS(status);                                          \
   } while (0)
 
+// Returns the subgraphs that `node` invokes. Each entry is a group of
+// subgraphs that may be live at the same time during one execution of the
+// node, while different entries are alternatives of which at most one runs.
+// Returns nothing for nodes that do not invoke subgraphs, or that invoke them
+// in a way that is not known here.
+std::vector<std::vector<int>> InvokedSubgraphs(
+    const TfLiteNode& node, const TfLiteRegistration& registration) {
+  if (node.builtin_data == nullptr) return {};
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinWhile: {
+      const auto* params =
+          static_cast<const TfLiteWhileParams*>(node.builtin_data);
+      return {{params->cond_subgraph_index, params->body_subgraph_index}};
+    }
+    case kTfLiteBuiltinIf: {
+      const auto* params =
+          static_cast<const TfLiteIfParams*>(node.builtin_data);
+      return {{params->then_subgraph_index}, {params->else_subgraph_index}};
+    }
+    case kTfLiteBuiltinCallOnce: {
+      const auto* params =
+          static_cast<const TfLiteCallOnceParams*>(node.builtin_data);
+      return {{params->init_subgraph_index}};
+    }
+    case kTfLiteBuiltinStablehloScatter: {
+      const auto* params =
+          static_cast<const TfLiteStablehloScatterParams*>(node.builtin_data);
+      return {{params->update_computation_subgraph_index}};
+    }
+    case kTfLiteBuiltinStablehloReduceWindow: {
+      const auto* params =
+          static_cast<const TfLiteStablehloReduceWindowParams*>(
+              node.builtin_data);
+      return {{params->body_subgraph_index}};
+    }
+    default:
+      return {};
+  }
+}
+
 }  // namespace
 
 Interpreter::Interpreter(ErrorReporter* error_reporter)
@@ -500,6 +547,157 @@ TfLiteStatus Interpreter::ApplyOptionsImpl(InterpreterOptions* options) {
           options->GetDynamicAllocationForLargeTensors());
     }
   }
+
+  // Handle `experimental_share_arenas_across_subgraphs_`. The interpreter
+  // builder applies options before the subgraphs are populated, and calls
+  // ShareArenasAcrossSubgraphs() itself once they are.
+  if (options->GetShareArenasAcrossSubgraphs()) {
+    TF_LITE_ENSURE_STATUS(ShareArenasAcrossSubgraphs());
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Interpreter::ShareArenasAcrossSubgraphs() {
+#ifndef TFLITE_USE_SIMPLE_MEMORY_PLANNER
+  const int num_subgraphs = subgraphs_.size();
+  if (options_ && options_->GetPreserveAllTensors()) {
+    return kTfLiteOk;
+  }
+  for (const auto& subgraph : subgraphs_) {
+    // Arenas can only be shared before they are planned.
+    if (subgraph->memory_planner_) return kTfLiteOk;
+  }
+
+  // Build the call graph. `invocations[i]` lists the invocations of subgraphs
+  // by the nodes of subgraph i, in the format of InvokedSubgraphs().
+  std::vector<std::vector<std::vector<int>>> invocations(num_subgraphs);
+  for (int i = 0; i < num_subgraphs; ++i) {
+    for (const auto& node_and_registration :
+         subgraphs_[i]->nodes_and_registration()) {
+      for (auto& invocation : InvokedSubgraphs(node_and_registration.first,
+                                               node_and_registration.second)) {
+        // Invalid indices are reported when the node is prepared.
+        invocation.erase(
+            std::remove_if(invocation.begin(), invocation.end(),
+                           [num_subgraphs](int callee) {
+                             return callee < 0 || callee >= num_subgraphs;
+                           }),
+            invocation.end());
+        invocations[i].push_back(std::move(invocation));
+      }
+    }
+  }
+
+  // `descendants[i][j]` is true if subgraph i transitively invokes subgraph j.
+  std::vector<std::vector<bool>> descendants(
+      num_subgraphs, std::vector<bool>(num_subgraphs, false));
+  for (int i = 0; i < num_subgraphs; ++i) {
+    std::vector<int> stack = {i};
+    while (!stack.empty()) {
+      const int caller = stack.back();
+      stack.pop_back();
+      for (const auto& invocation : invocations[caller]) {
+        for (int callee : invocation) {
+          if (!descendants[i][callee]) {
+            descendants[i][callee] = true;
+            stack.push_back(callee);
+          }
+        }
+      }
+    }
+  }
+
+  // Only subgraphs that are invoked exclusively through the call graph may
+  // share: the entry subgraphs of the model and of its signatures, and what
+  // they invoke. A subgraph that is also invoked in an unknown way, e.g. by a
+  // custom op or a delegate, may be live at any time, and so may anything it
+  // invokes. Subgraphs on a cycle are invoked recursively and are excluded as
+  // well.
+  std::vector<bool> reachable(num_subgraphs, false);
+  reachable[0] = true;
+  for (const auto& signature_def : signature_defs_) {
+    if (signature_def.subgraph_index < num_subgraphs) {
+      reachable[signature_def.subgraph_index] = true;
+    }
+  }
+  for (int i = 0; i < num_subgraphs; ++i) {
+    if (!reachable[i]) continue;
+    for (int j = 0; j < num_subgraphs; ++j) {
+      if (descendants[i][j]) reachable[j] = true;
+    }
+  }
+  std::vector<bool> eligible = reachable;
+  for (int i = 0; i < num_subgraphs; ++i) {
+    if (descendants[i][i]) eligible[i] = false;
+    if (reachable[i]) continue;
+    for (int j = 0; j < num_subgraphs; ++j) {
+      if (descendants[i][j]) eligible[j] = false;
+    }
+  }
+
+  // Two subgraphs may be live at the same time if one of them invokes the
+  // other, or if one invocation runs both of them, directly or indirectly.
+  auto runs = [&](int entry, int subgraph) {
+    return entry == subgraph || descendants[entry][subgraph];
+  };
+  std::vector<std::vector<bool>> conflicts(
+      num_subgraphs, std::vector<bool>(num_subgraphs, false));
+  for (int a = 0; a < num_subgraphs; ++a) {
+    for (int b = 0; b < num_subgraphs; ++b) {
+      if (descendants[a][b]) conflicts[a][b] = conflicts[b][a] = true;
+    }
+  }
+  for (int caller = 0; caller < num_subgraphs; ++caller) {
+    for (const auto& invocation : invocations[caller]) {
+      for (int x : invocation) {
+        for (int y : invocation) {
+          if (x == y) continue;
+          for (int a = 0; a < num_subgraphs; ++a) {
+            if (!runs(x, a)) continue;
+            for (int b = 0; b < num_subgraphs; ++b) {
+              if (runs(y, b)) conflicts[a][b] = conflicts[b][a] = true;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Greedily assign each eligible subgraph to the first group that it does
+  // not conflict with.
+  std::vector<std::vector<int>> groups;
+  for (int i = 0; i < num_subgraphs; ++i) {
+    if (!eligible[i]) continue;
+    bool assigned = false;
+    for (auto& group : groups) {
+      bool fits = true;
+      for (int member : group) {
+        if (conflicts[i][member]) {
+          fits = false;
+          break;
+        }
+      }
+      if (fits) {
+        group.push_back(i);
+        assigned = true;
+        break;
+      }
+    }
+    if (!assigned) groups.push_back({i});
+  }
+
+  for (auto& subgraph : subgraphs_) {
+    TF_LITE_ENSURE_STATUS(subgraph->SetSharedArena(nullptr));
+  }
+  int num_shared_arenas = 0;
+  for (const auto& group : groups) {
+    if (group.size() < 2) continue;
+    auto shared_arena = std::make_shared<SharedArena>(num_shared_arenas++);
+    for (int member : group) {
+      TF_LITE_ENSURE_STATUS(subgraphs_[member]->SetSharedArena(shared_arena));
+    }
+  }
+#endif  // TFLITE_USE_SIMPLE_MEMORY_PLANNER
   return kTfLiteOk;
 }
 
@@ -904,6 +904,12 @@ class Interpreter {
 
   TfLiteStatus ApplyOptionsImpl(InterpreterOptions* options);
 
+  /// Groups the subgraphs whose intermediate tensors are never live at the
+  /// same time, based on the subgraphs that control flow ops invoke, and lets
+  /// the subgraphs of each group share one arena. Must be called after the
+  /// subgraphs are populated and before tensors are allocated.
+  TfLiteStatus ShareArenasAcrossSubgraphs();
+
   // A pure C data structure used to communicate with the pure C plugin
   // interface. To avoid copying tensor metadata, this is also the definitive
   // structure to store tensors.
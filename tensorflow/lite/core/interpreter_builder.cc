@@ -889,6 +889,13 @@ TfLiteStatus InterpreterBuilder::operator()(
     return cleanup_and_error();
   }
 
+  // Arenas are shared based on the nodes and signatures parsed above, before
+  // delegates allocate tensors.
+  if (options_.GetShareArenasAcrossSubgraphs() &&
+      (*interpreter)->ShareArenasAcrossSubgraphs() != kTfLiteOk) {
+    return cleanup_and_error();
+  }
+
   if ((*interpreter)->SetMetadata(metadata_) != kTfLiteOk) {
     return cleanup_and_error();
   }
@@ -1521,9 +1521,13 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
 #ifdef TFLITE_USE_SIMPLE_MEMORY_PLANNER
     memory_planner_.reset(new SimplePlanner(&context_, CreateGraphInfo()));
 #else
-    memory_planner_ = std::make_unique<ArenaPlanner>(
+    auto arena_planner = std::make_unique<ArenaPlanner>(
         &context_, CreateGraphInfo(), ShouldPreserveAllTensors(),
         kDefaultTensorAlignment, subgraph_index_);
+    if (shared_arena_) {
+      arena_planner->ShareArena(shared_arena_);
+    }
+    memory_planner_ = std::move(arena_planner);
 #endif
     memory_planner_->PlanAllocations();
   }
@@ -2378,6 +2382,13 @@ void Subgraph::DumpMemoryPlannerDebugInfo() const {
 
 void Subgraph::GetMemoryAllocInfo(SubgraphAllocInfo* alloc_info) const {
   memset(alloc_info, 0, sizeof(SubgraphAllocInfo));
+  alloc_info->shared_arena_id = -1;
+#ifndef TFLITE_USE_SIMPLE_MEMORY_PLANNER
+  if (shared_arena_) {
+    alloc_info->shared_arena_id = shared_arena_->id();
+    alloc_info->shared_arena_size = shared_arena_->size();
+  }
+#endif
   if (memory_planner_ == nullptr) return;
   memory_planner_->GetAllocInfo(&alloc_info->arena_size,
                                 &alloc_info->arena_persist_size);
@@ -2394,6 +2405,17 @@ void Subgraph::GetMemoryAllocInfo(SubgraphAllocInfo* alloc_info) const {
   }
 }
 
+TfLiteStatus Subgraph::SetSharedArena(
+    std::shared_ptr<SharedArena> shared_arena) {
+  if (shared_arena == shared_arena_) return kTfLiteOk;
+  if (memory_planner_) {
+    ReportError("SetSharedArena() must be called before AllocateTensors().");
+    return kTfLiteError;
+  }
+  shared_arena_ = std::move(shared_arena);
+  return kTfLiteOk;
+}
+
 std::unique_ptr<GraphInfo> Subgraph::CreateGraphInfo() {
   return std::unique_ptr<GraphInfo>(new InterpreterInfo(this));
 }
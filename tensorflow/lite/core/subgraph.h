@@ -45,6 +45,7 @@ namespace tflite {
 
 #ifndef DOXYGEN_SKIP
 class SingleOpModel;  // Class for friend declarations.
+class SharedArena;
 
 namespace internal {
 class CommonOpaqueConversionUtil;  // Class for friend declarations.
@@ -422,12 +423,25 @@ class Subgraph {
     size_t arena_persist_size;
     size_t dynamic_size;
     size_t resource_size;
+    // If the non-persistent arena is shared with other subgraphs, the id of
+    // the shared arena and the size of its buffer. `arena_size` is then the
+    // part of the shared buffer that this subgraph needs. Otherwise -1 and 0.
+    int shared_arena_id;
+    size_t shared_arena_size;
   } SubgraphAllocInfo;
 
   // WARNING: This is an experimental API and subject to change.
   // Returns memory allocation status.
   void GetMemoryAllocInfo(SubgraphAllocInfo* alloc_info) const;
 
+  // WARNING: This is an experimental API and subject to change.
+  // Places the non-persistent tensors of the subgraph in `shared_arena`, whose
+  // buffer is shared with other subgraphs. The caller must make sure that
+  // the non-persistent tensors of those subgraphs are never live at the same
+  // time as the ones of this subgraph. Passing nullptr gives the subgraph an
+  // arena of its own. Must be called before tensors are allocated.
+  TfLiteStatus SetSharedArena(std::shared_ptr<SharedArena> shared_arena);
+
   // WARNING: This is an experimental API and subject to change.
   // Set the given `InterpreterOptions` object.
   void SetOptions(InterpreterOptions* options) { options_ = options; }
@@ -1115,6 +1129,10 @@ class Subgraph {
   // `InterpreterOptions` object which is being used and owned by Interpreter.
   InterpreterOptions* options_;
 
+  // If set, the memory planner places non-persistent tensors in this arena,
+  // which is shared with other subgraphs.
+  std::shared_ptr<SharedArena> shared_arena_;
+
   // Control edges (i.e., dependencies between nodes in addition to their data
   // dependencies); can be nullptr. Will be initialized from metadata associated
   // with the owning interpreter; the pointee is owned by the owning
@@ -29,7 +29,8 @@ class InterpreterOptions {
       : experimental_preserve_all_tensors_(false),
         experimental_ensure_dynamic_tensors_are_released_(false),
         experimental_optimize_memory_for_large_tensors_(0),
-        experimental_disable_delegate_clustering_(false) {}
+        experimental_disable_delegate_clustering_(false),
+        experimental_share_arenas_across_subgraphs_(false) {}
 
   /// Preserving all intermediates tensors for debugging.
   /// WARNING: This is an experimental API and subject to change.
@@ -93,11 +94,42 @@ class InterpreterOptions {
     experimental_disable_delegate_clustering_ = value;
   }
 
+  /// Lets subgraphs that never run at the same time share one arena for their
+  /// intermediate tensors, instead of each subgraph having an arena of its
+  /// own. For example, the two branches of an IF op, or the entry subgraphs
+  /// of different signatures, can share an arena, while a WHILE op's body
+  /// cannot share with its condition or with the subgraph that runs the loop.
+  ///
+  /// Subgraphs that are invoked by ops other than WHILE, IF, CALL_ONCE and
+  /// the StableHLO ops with subgraph parameters keep an arena of their own.
+  ///
+  /// Since entry subgraphs may share an arena, the input and output tensors of
+  /// a signature occupy the same memory as those of other signatures. They
+  /// are invalidated as soon as another signature's tensors are touched:
+  /// writing that signature's inputs, allocating its tensors or invoking it
+  /// can overwrite the current signature's inputs and outputs. Read the
+  /// outputs of a signature before using any other one, and set its inputs
+  /// again before invoking it. Must be applied before tensors are allocated.
+  /// Ignored when all tensors are preserved. The memory saved is reported by
+  /// `PrintInterpreterState()`.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetShareArenasAcrossSubgraphs(bool value = true) {
+    experimental_share_arenas_across_subgraphs_ = value;
+  }
+
+  /// Returns if the `experimental_share_arenas_across_subgraphs_` feature is
+  /// enabled.
+  /// WARNING: This is an experimental API and subject to change.
+  bool GetShareArenasAcrossSubgraphs() {
+    return experimental_share_arenas_across_subgraphs_;
+  }
+
  private:
   bool experimental_preserve_all_tensors_;
   bool experimental_ensure_dynamic_tensors_are_released_;
   int experimental_optimize_memory_for_large_tensors_;
   bool experimental_disable_delegate_clustering_;
+  bool experimental_share_arenas_across_subgraphs_;
 };
 
 }  // namespace tflite
@@ -121,6 +121,76 @@ TEST_F(SimpleIfTest, TestIfFalseWithLargeInputsTwice) {
   CheckIntTensor(output, {kNumLargeTensors}, expected2);
 }
 
+// Runs `SimpleIfTest` with the branches sharing one arena.
+class SharedArenaIfTest : public ControlFlowOpTest {
+ protected:
+  void SetUp() override {
+    AddSubgraphs(2);
+    builder_->BuildAddSubgraph(interpreter_->subgraph(1));
+    builder_->BuildMulSubgraph(interpreter_->subgraph(2));
+    builder_->BuildIfSubgraph(&interpreter_->primary_subgraph());
+
+    InterpreterOptions options;
+    options.SetShareArenasAcrossSubgraphs();
+    ASSERT_EQ(interpreter_->ApplyOptions(&options), kTfLiteOk);
+
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[0], {1});
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[1], {2});
+    interpreter_->ResizeInputTensor(interpreter_->inputs()[2], {1, 2});
+    ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+
+    FillIntTensor(interpreter_->tensor(interpreter_->inputs()[1]), {5, 7});
+    FillIntTensor(interpreter_->tensor(interpreter_->inputs()[2]), {1, 2});
+  }
+};
+
+TEST_F(SharedArenaIfTest, BranchesShareArena) {
+  Subgraph::SubgraphAllocInfo primary_info, then_info, else_info;
+  interpreter_->primary_subgraph().GetMemoryAllocInfo(&primary_info);
+  interpreter_->subgraph(1)->GetMemoryAllocInfo(&then_info);
+  interpreter_->subgraph(2)->GetMemoryAllocInfo(&else_info);
+  // The primary subgraph runs while either branch runs.
+  EXPECT_EQ(primary_info.shared_arena_id, -1);
+  EXPECT_GE(then_info.shared_arena_id, 0);
+  EXPECT_EQ(then_info.shared_arena_id, else_info.shared_arena_id);
+  EXPECT_EQ(then_info.shared_arena_size, else_info.shared_arena_size);
+}
+
+TEST_F(SharedArenaIfTest, TestIfTrueThenFalse) {
+  interpreter_->typed_input_tensor<bool>(0)[0] = true;
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  CheckIntTensor(interpreter_->tensor(interpreter_->outputs()[0]), {1, 2},
+                 {6, 9});
+
+  interpreter_->typed_input_tensor<bool>(0)[0] = false;
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  CheckIntTensor(interpreter_->tensor(interpreter_->outputs()[0]), {1, 2},
+                 {5, 14});
+}
+
+TEST_F(SharedArenaIfTest, TestIfWithLargeInputs) {
+  // Growing the inputs grows the shared arena, which may move it under the
+  // branch that is not being run.
+  const size_t kNumLargeTensors = 100000;
+  interpreter_->ResizeInputTensor(interpreter_->inputs()[1],
+                                  {kNumLargeTensors});
+  interpreter_->ResizeInputTensor(interpreter_->inputs()[2], {1});
+  ASSERT_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  FillIntTensor(interpreter_->tensor(interpreter_->inputs()[1]),
+                std::vector<int>(kNumLargeTensors, 1));
+  FillIntTensor(interpreter_->tensor(interpreter_->inputs()[2]), {3});
+
+  interpreter_->typed_input_tensor<bool>(0)[0] = true;
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  CheckIntTensor(interpreter_->tensor(interpreter_->outputs()[0]),
+                 {kNumLargeTensors}, std::vector<int>(kNumLargeTensors, 4));
+
+  interpreter_->typed_input_tensor<bool>(0)[0] = false;
+  ASSERT_EQ(interpreter_->Invoke(), kTfLiteOk);
+  CheckIntTensor(interpreter_->tensor(interpreter_->outputs()[0]),
+                 {kNumLargeTensors}, std::vector<int>(kNumLargeTensors, 3));
+}
+
 // Test IF op using subgraphs with dynamically sized outputs.
 // The computation is: `cond ? a + b : pad(a, b)`.
 class DynamicSubgraphIfTest : public ControlFlowOpTest {
@@ -20,6 +20,7 @@ limitations under the License.
 #include <cstdio>
 #include <functional>
 #include <limits>
+#include <map>
 #include <set>
 #include <sstream>
 #include <string>
@@ -587,12 +588,23 @@ void PrintInterpreterState(const Interpreter* interpreter,
   size_t total_arena_memory_bytes = 0;
   size_t total_dynamic_memory_bytes = 0;
   size_t total_resource_bytes = 0;
+  // Subgraphs that share an arena need only as much memory as the largest of
+  // them, so the shared buffer is counted once. Maps from the id of a shared
+  // arena to the size of its buffer and the sum of the arena sizes of the
+  // subgraphs that share it.
+  std::map<int, std::pair<size_t, size_t>> shared_arena_sizes;
 
   for (int i = 0; i < num_subgraphs; ++i) {
     const Subgraph& subgraph = *(interpreter->subgraph(i));
     Subgraph::SubgraphAllocInfo alloc_info;
     subgraph.GetMemoryAllocInfo(&alloc_info);
-    total_arena_memory_bytes += alloc_info.arena_size;
+    if (alloc_info.shared_arena_id >= 0) {
+      auto& sizes = shared_arena_sizes[alloc_info.shared_arena_id];
+      sizes.first = alloc_info.shared_arena_size;
+      sizes.second += alloc_info.arena_size;
+    } else {
+      total_arena_memory_bytes += alloc_info.arena_size;
+    }
     total_arena_memory_bytes += alloc_info.arena_persist_size;
     total_dynamic_memory_bytes += alloc_info.dynamic_size;
     // Resources are shared with all subgraphs. So calculate it only once.
@@ -600,6 +612,13 @@ void PrintInterpreterState(const Interpreter* interpreter,
       total_resource_bytes = alloc_info.resource_size;
     }
   }
+  size_t shared_arena_saved_bytes = 0;
+  for (const auto& [id, sizes] : shared_arena_sizes) {
+    total_arena_memory_bytes += sizes.first;
+    if (sizes.second > sizes.first) {
+      shared_arena_saved_bytes += sizes.second - sizes.first;
+    }
+  }
   size_t total_memory_bytes = total_arena_memory_bytes +
                               total_dynamic_memory_bytes + total_resource_bytes;
   printf("Total memory usage: %zu bytes (%.3f MB)\n", total_memory_bytes,
@@ -615,13 +634,23 @@ void PrintInterpreterState(const Interpreter* interpreter,
            total_resource_bytes,
            static_cast<float>(total_resource_bytes) / (1 << 20));
   }
+  if (!shared_arena_sizes.empty()) {
+    printf("- Arena memory saved by sharing across subgraphs: %zu bytes "
+           "(%.3f MB)\n",
+           shared_arena_saved_bytes,
+           static_cast<float>(shared_arena_saved_bytes) / (1 << 20));
+  }
   putchar('\n');
 
   for (int i = 0; i < num_subgraphs; ++i) {
     const Subgraph& subgraph = *(interpreter->subgraph(i));
     Subgraph::SubgraphAllocInfo alloc_info;
     subgraph.GetMemoryAllocInfo(&alloc_info);
-    if (alloc_info.arena_size) {
+    if (alloc_info.arena_size && alloc_info.shared_arena_id >= 0) {
+      printf("Subgraph#%-3d %-18s %10zu (shared arena #%d)\n", i,
+             "Arena (Normal)", alloc_info.arena_size,
+             alloc_info.shared_arena_id);
+    } else if (alloc_info.arena_size) {
       printf(
           "Subgraph#%-3d %-18s %10zu (%.2f%%)\n", i, "Arena (Normal)",
           alloc_info.arena_size,
@@ -110,9 +110,24 @@ class SimpleMemoryArena {
   explicit SimpleMemoryArena(size_t arena_alignment, int subgraph_index = 0)
       : committed_(false),
         high_water_mark_(0),
-        underlying_buffer_(arena_alignment, subgraph_index),
+        own_buffer_(arena_alignment, subgraph_index),
+        underlying_buffer_(&own_buffer_),
+        committed_buffer_ptr_(nullptr),
         active_allocs_() {}
 
+  // Makes the arena place its allocations in `buffer` instead of a buffer of
+  // its own. This lets arenas whose allocations are never live at the same
+  // time share memory, e.g. the arenas of subgraphs that never run at the same
+  // time. `buffer` must outlive the arena and must not be released by it, and
+  // its alignment must be at least the alignment of the arena. Must be called
+  // before the first Commit().
+  void UseSharedBuffer(ResizableAlignedBuffer* buffer) {
+    underlying_buffer_ = buffer;
+  }
+
+  // Returns true if the arena places its allocations in a shared buffer.
+  bool HasSharedBuffer() const { return underlying_buffer_ != &own_buffer_; }
+
   // Delete all allocs. This should be called when allocating the first node of
   // a subgraph.
   void ResetAllocs();
@@ -142,8 +157,15 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Makes sure that the underlying buffer can hold all allocations. Sets
+  // `arena_reallocated` if the buffer moved since the last commit, in which
+  // case all allocations must be resolved again.
   TfLiteStatus Commit(bool* arena_reallocated);
 
+  // Returns true if the arena was committed since the plan was last cleared or
+  // the buffer was last released.
+  bool IsCommitted() const { return committed_; }
+
   TfLiteStatus ResolveAlloc(TfLiteContext* context,
                             const ArenaAllocWithUsageInterval& alloc,
                             char** output_ptr);
@@ -155,13 +177,19 @@ class SimpleMemoryArena {
 
   // This releases the underlying buffer but does not clear the allocation plan.
   // Since all associated pointers are invalidated, the arena cannot be used
-  // again until Commit() is called & tensor allocations are resolved.
+  // again until Commit() is called & tensor allocations are resolved. A shared
+  // buffer is not released, since other arenas may still use it.
   TfLiteStatus ReleaseBuffer();
 
-  size_t GetBufferSize() const { return underlying_buffer_.GetSize(); }
+  size_t GetBufferSize() const { return underlying_buffer_->GetSize(); }
+
+  // Returns the size of the buffer needed by the current allocation plan. This
+  // is smaller than GetBufferSize() if the plan shrank since the last
+  // commit, or if the buffer is shared with arenas that need more memory.
+  size_t GetRequiredBufferSize() const { return high_water_mark_; }
 
   std::intptr_t BasePointer() const {
-    return reinterpret_cast<std::intptr_t>(underlying_buffer_.GetPtr());
+    return reinterpret_cast<std::intptr_t>(underlying_buffer_->GetPtr());
   }
 
   // Dumps the memory allocation information of this memory arena (which could
@@ -184,7 +212,11 @@ class SimpleMemoryArena {
  private:
   bool committed_;
   size_t high_water_mark_;
-  ResizableAlignedBuffer underlying_buffer_;
+  ResizableAlignedBuffer own_buffer_;
+  // Either `own_buffer_` or a buffer shared with other arenas.
+  ResizableAlignedBuffer* underlying_buffer_;
+  // The location of the underlying buffer at the last commit.
+  char* committed_buffer_ptr_;
   std::vector<ArenaAllocWithUsageInterval> active_allocs_;
 };
 
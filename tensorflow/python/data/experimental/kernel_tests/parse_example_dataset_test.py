@@ -1161,6 +1161,53 @@ class ParseExampleDatasetTest(test_base.DatasetTestBase,
     else:
       self.assertCountEqual(expected, actual)
 
+  def _fused_batch_test_dataset(self, num_elements):
+    serialized = []
+    for i in range(num_elements):
+      serialized.append(
+          example(
+              features=features({
+                  "a": int64_feature([i]),
+                  "b": float_feature([float(i)] * (i % 3)),
+                  "c": bytes_feature([b"x" * i]),
+              })).SerializeToString())
+    test_features = {
+        "a": parsing_ops.FixedLenFeature((), dtype=dtypes.int64),
+        "b": parsing_ops.VarLenFeature(dtype=dtypes.float32),
+        "c": parsing_ops.RaggedFeature(dtype=dtypes.string),
+    }
+    return dataset_ops.Dataset.from_tensor_slices(serialized), test_features
+
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(drop_remainder=[True, False])))
+  def testFusedBatchMatchesBatchThenParse(self, drop_remainder):
+    dataset, test_features = self._fused_batch_test_dataset(10)
+    expected = dataset.batch(4, drop_remainder=drop_remainder).apply(
+        contrib_parsing_ops.parse_example_dataset(test_features))
+    actual = dataset.apply(
+        contrib_parsing_ops.parse_example_dataset(
+            test_features,
+            num_parallel_calls=2,
+            batch_size=4,
+            drop_remainder=drop_remainder))
+    self.assertEqual(
+        dataset_ops.get_legacy_output_shapes(expected)["a"].as_list(),
+        dataset_ops.get_legacy_output_shapes(actual)["a"].as_list())
+    self.assertEqual(
+        self.evaluate(expected.cardinality()),
+        self.evaluate(actual.cardinality()))
+    self.assertDatasetsEqual(expected, actual)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testFusedBatchRequiresScalarStrings(self):
+    dataset, test_features = self._fused_batch_test_dataset(4)
+    with self.assertRaisesRegex(TypeError, "scalar strings"):
+      dataset.batch(2).apply(
+          contrib_parsing_ops.parse_example_dataset(
+              test_features, batch_size=2))
+
 
 class ParseExampleDatasetCheckpointTest(tf_record_test_base.FeaturesTestBase,
                                         checkpoint_test_base.CheckpointTestBase,
@@ -1187,5 +1234,31 @@ class ParseExampleDatasetCheckpointTest(tf_record_test_base.FeaturesTestBase,
             num_repeat=num_repeat, batch_size=batch_size), num_outputs)
 
 
+class ParseExampleAndBatchCheckpointTest(
+    checkpoint_test_base.CheckpointTestBase, parameterized.TestCase):
+
+  def _build_dataset(self, num_elements, batch_size):
+    serialized = [
+        example(features=features({
+            "a": int64_feature([i]),
+            "b": int64_feature(list(range(i % 4))),
+        })).SerializeToString() for i in range(num_elements)
+    ]
+    test_features = {
+        "a": parsing_ops.FixedLenFeature((), dtype=dtypes.int64),
+        "b": parsing_ops.VarLenFeature(dtype=dtypes.int64),
+    }
+    return dataset_ops.Dataset.from_tensor_slices(serialized).apply(
+        contrib_parsing_ops.parse_example_dataset(
+            test_features, num_parallel_calls=3, batch_size=batch_size))
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         checkpoint_test_base.default_test_combinations()))
+  def test(self, verify_fn):
+    verify_fn(self, lambda: self._build_dataset(num_elements=50, batch_size=4),
+              num_outputs=13)
+
+
 if __name__ == "__main__":
   test.main()
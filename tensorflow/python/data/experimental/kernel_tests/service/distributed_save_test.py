@@ -291,6 +291,14 @@ class DistributedSaveTest(
     with self.assertRaisesRegex(ValueError, "must not be empty"):
       self.evaluate(distributed_save_op.distributed_save(dataset, "", ""))
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testBadChunkFormat(self):
+    dataset = dataset_ops.Dataset.range(10)
+    with self.assertRaisesRegex(ValueError, "`chunk_format` must be one of"):
+      self.evaluate(
+          distributed_save_op.distributed_save(
+              dataset, "", "localhost", chunk_format="PARQUET"))
+
   @combinations.generate(test_base.default_test_combinations())
   def testBadCardinality(self):
     cluster = data_service_test_base.TestCluster(num_workers=1)
@@ -21,7 +21,11 @@ from tensorflow.python.saved_model import nested_structure_coder
 
 
 # TODO(b/250921378): Add example to docstring and export to TF API.
-def distributed_save(dataset, path, dispatcher_address, compression="AUTO"):
+def distributed_save(dataset,
+                     path,
+                     dispatcher_address,
+                     compression="AUTO",
+                     chunk_format=None):
   """Initiates the process of distributedly saving a dataset to disk.
 
   Args:
@@ -34,23 +38,33 @@ def distributed_save(dataset, path, dispatcher_address, compression="AUTO"):
       `dataset` materialization.  If `"AUTO"`, the tf.data runtime decides which
       algorithm to use.  If `"GZIP"` or `"SNAPPY"`, that specific algorithm is
       used.  If `None`, the `dataset` materialization is not compressed.
+    chunk_format: (Optional.) A string indicating the format of the snapshot
+      chunk files.  If `None` or `"TFRECORD"`, elements are written as
+      TFRecords of serialized tensors.  If `"COLUMNAR"`, batches of elements are
+      written as raw, aligned tensor buffers, which are faster to write and
+      read.  Elements with string or variant components, or whose shapes vary,
+      are written as TFRecords regardless.
 
   Returns:
     An operation which when executed performs the distributed save.
 
   Raises:
-    ValueError: If `dispatcher_address` is invalid.
+    ValueError: If `dispatcher_address` or `chunk_format` is invalid.
   """
   if not isinstance(dispatcher_address, str):
     raise ValueError("`dispatcher_address` must be a string, but is a "
                      f"{type(dispatcher_address)} ({dispatcher_address}")
   if not dispatcher_address:
     raise ValueError("`dispatcher_address` must not be empty")
+  if chunk_format not in (None, "TFRECORD", "COLUMNAR"):
+    raise ValueError("`chunk_format` must be one of None, \"TFRECORD\" or "
+                     f"\"COLUMNAR\", but is {chunk_format!r}")
 
   metadata = snapshot_pb2.DistributedSnapshotMetadata(
       element_spec=nested_structure_coder.encode_structure(
           dataset.element_spec).SerializeToString(),
       compression=compression,
+      chunk_format=chunk_format or "",
   )
 
   return gen_experimental_dataset_ops.distributed_save(
@@ -16,8 +16,11 @@
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.util import structure
 from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
 from tensorflow.python.framework import sparse_tensor
+from tensorflow.python.framework import tensor_shape
 from tensorflow.python.framework import tensor_spec
+from tensorflow.python.framework import tensor_util
 from tensorflow.python.ops import gen_experimental_dataset_ops
 from tensorflow.python.ops import parsing_ops
 from tensorflow.python.ops.ragged import ragged_tensor
@@ -28,14 +31,26 @@ from tensorflow.python.util.tf_export import tf_export
 class _ParseExampleDataset(dataset_ops.UnaryDataset):
   """A `Dataset` that parses `example` dataset into a `dict` dataset."""
 
-  def __init__(self, input_dataset, features, num_parallel_calls,
-               deterministic):
+  def __init__(self,
+               input_dataset,
+               features,
+               num_parallel_calls,
+               deterministic,
+               batch_size=None,
+               drop_remainder=False):
     self._input_dataset = input_dataset
-    if not structure.are_compatible(
-        input_dataset.element_spec,
-        tensor_spec.TensorSpec([None], dtypes.string)):
-      raise TypeError("Input dataset should be a dataset of vectors of "
-                      f"strings. Instead it is `{input_dataset.element_spec}`.")
+    if batch_size is None:
+      if not structure.are_compatible(
+          input_dataset.element_spec,
+          tensor_spec.TensorSpec([None], dtypes.string)):
+        raise TypeError(
+            "Input dataset should be a dataset of vectors of strings. Instead "
+            f"it is `{input_dataset.element_spec}`.")
+    elif not structure.are_compatible(
+        input_dataset.element_spec, tensor_spec.TensorSpec([], dtypes.string)):
+      raise TypeError("Input dataset should be a dataset of scalar strings "
+                      "when `batch_size` is set. Instead it is "
+                      f"`{input_dataset.element_spec}`.")
     self._num_parallel_calls = num_parallel_calls
     if deterministic is None:
       self._deterministic = "default"
@@ -60,8 +75,20 @@ class _ParseExampleDataset(dataset_ops.UnaryDataset):
     self._dense_defaults = params.dense_defaults_vec
     self._dense_shapes = params.dense_shapes_as_proto
     self._dense_types = params.dense_types
-    input_dataset_shape = dataset_ops.get_legacy_output_shapes(
-        self._input_dataset)
+    if batch_size is None:
+      input_dataset_shape = dataset_ops.get_legacy_output_shapes(
+          self._input_dataset)
+    else:
+      self._batch_size = ops.convert_to_tensor(
+          batch_size, dtype=dtypes.int64, name="batch_size")
+      self._drop_remainder = ops.convert_to_tensor(
+          drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+      # The batch dimension is only static if partial batches are dropped.
+      if tensor_util.constant_value(self._drop_remainder):
+        input_dataset_shape = tensor_shape.TensorShape(
+            [tensor_util.constant_value(self._batch_size)])
+      else:
+        input_dataset_shape = tensor_shape.TensorShape([None])
 
     self._element_spec = {}
 
@@ -81,20 +108,38 @@ class _ParseExampleDataset(dataset_ops.UnaryDataset):
       self._element_spec[key] = ragged_tensor.RaggedTensorSpec(
           input_dataset_shape.concatenate([None]), value_type, 1, splits_type)
 
-    variant_tensor = (
-        gen_experimental_dataset_ops.parse_example_dataset_v2(
-            self._input_dataset._variant_tensor,  # pylint: disable=protected-access
-            self._num_parallel_calls,
-            self._dense_defaults,
-            self._sparse_keys,
-            self._dense_keys,
-            self._sparse_types,
-            self._dense_shapes,
-            deterministic=self._deterministic,
-            ragged_keys=self._ragged_keys,
-            ragged_value_types=self._ragged_value_types,
-            ragged_split_types=self._ragged_split_types,
-            **self._flat_structure))
+    if batch_size is None:
+      variant_tensor = (
+          gen_experimental_dataset_ops.parse_example_dataset_v2(
+              self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+              self._num_parallel_calls,
+              self._dense_defaults,
+              self._sparse_keys,
+              self._dense_keys,
+              self._sparse_types,
+              self._dense_shapes,
+              deterministic=self._deterministic,
+              ragged_keys=self._ragged_keys,
+              ragged_value_types=self._ragged_value_types,
+              ragged_split_types=self._ragged_split_types,
+              **self._flat_structure))
+    else:
+      variant_tensor = (
+          gen_experimental_dataset_ops.parse_example_and_batch_dataset(
+              self._input_dataset._variant_tensor,  # pylint: disable=protected-access
+              self._batch_size,
+              self._drop_remainder,
+              self._num_parallel_calls,
+              self._dense_defaults,
+              self._sparse_keys,
+              self._dense_keys,
+              self._sparse_types,
+              self._dense_shapes,
+              deterministic=self._deterministic,
+              ragged_keys=self._ragged_keys,
+              ragged_value_types=self._ragged_value_types,
+              ragged_split_types=self._ragged_split_types,
+              **self._flat_structure))
     super(_ParseExampleDataset, self).__init__(input_dataset, variant_tensor)
 
   @property
@@ -105,13 +150,27 @@ class _ParseExampleDataset(dataset_ops.UnaryDataset):
 @tf_export("data.experimental.parse_example_dataset")
 @deprecation.deprecated(
     None, "Use `tf.data.Dataset.map(tf.io.parse_example(...))` instead.")
-def parse_example_dataset(features, num_parallel_calls=1, deterministic=None):
+def parse_example_dataset(features,
+                          num_parallel_calls=1,
+                          deterministic=None,
+                          batch_size=None,
+                          drop_remainder=False):
   """A transformation that parses `Example` protos into a `dict` of tensors.
 
   Parses a number of serialized `Example` protos given in `serialized`. We refer
   to `serialized` as a batch with `batch_size` many entries of individual
   `Example` protos.
 
+  If `batch_size` is set, the input dataset must contain scalar serialized
+  `Example` protos instead, and the transformation batches them itself. Each
+  batch is parsed straight into the batched output tensors, which avoids
+  copying the protos into a batch first:
+
+  ```python
+  # Instead of `dataset.batch(32).apply(parse_example_dataset(features))`:
+  dataset = dataset.apply(parse_example_dataset(features, batch_size=32))
+  ```
+
   This op parses serialized examples into a dictionary mapping keys to `Tensor`,
   `SparseTensor`, and `RaggedTensor` objects. `features` is a dict from keys to
   `VarLenFeature`, `RaggedFeature`, `SparseFeature`, and `FixedLenFeature`
@@ -131,6 +190,11 @@ def parse_example_dataset(features, num_parallel_calls=1, deterministic=None):
       `deterministic` is `None`, the
       `tf.data.Options.deterministic` dataset option (`True` by default) is used
       to decide whether to produce elements deterministically.
+   batch_size: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      number of consecutive scalar `Example` protos to parse into each batch.
+   drop_remainder: (Optional.) A `tf.bool` scalar `tf.Tensor`, representing
+      whether the last batch should be dropped in the case it has fewer than
+      `batch_size` elements. Only used if `batch_size` is set.
 
   Returns:
     A dataset transformation function, which can be passed to
@@ -145,7 +209,8 @@ def parse_example_dataset(features, num_parallel_calls=1, deterministic=None):
   def _apply_fn(dataset):
     """Function from `Dataset` to `Dataset` that applies the transformation."""
     out_dataset = _ParseExampleDataset(dataset, features, num_parallel_calls,
-                                       deterministic)
+                                       deterministic, batch_size,
+                                       drop_remainder)
     if any(
         isinstance(feature, parsing_ops.SparseFeature) or
         isinstance(feature, parsing_ops.RaggedFeature)
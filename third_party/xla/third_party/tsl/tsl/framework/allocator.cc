@@ -28,7 +28,7 @@ limitations under the License.
 namespace tsl {
 
 string AllocatorStats::DebugString() const {
-  return strings::Printf(
+  string result = strings::Printf(
       "Limit:            %20lld\n"
       "InUse:            %20lld\n"
       "MaxInUse:         %20lld\n"
@@ -45,6 +45,17 @@ string AllocatorStats::DebugString() const {
       static_cast<long long>(this->bytes_reserved),
       static_cast<long long>(this->peak_bytes_reserved),
       static_cast<long long>(this->largest_free_block_bytes));
+  if (this->thread_cache_hits) {
+    strings::Appendf(
+        &result,
+        "CacheHits:        %20lld\n"
+        "CacheMisses:      %20lld\n"
+        "CacheBytes:       %20lld\n",
+        static_cast<long long>(*this->thread_cache_hits),
+        static_cast<long long>(this->thread_cache_misses.value_or(0)),
+        static_cast<long long>(this->thread_cache_bytes.value_or(0)));
+  }
+  return result;
 }
 
 constexpr size_t Allocator::kAllocatorAlignment;
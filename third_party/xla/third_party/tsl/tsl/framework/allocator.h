@@ -93,6 +93,12 @@ struct AllocatorStats {
   std::optional<int64_t> pool_bytes;
   std::optional<int64_t> peak_pool_bytes;
 
+  // Stats for allocators that serve small allocations from thread caches (e.g.
+  // BFCAllocator with Options::thread_cache_max_bytes > 0).
+  std::optional<int64_t> thread_cache_hits;    // Allocations served by a cache.
+  std::optional<int64_t> thread_cache_misses;  // Cacheable allocations missed.
+  std::optional<int64_t> thread_cache_bytes;   // Bytes hoarded by caches.
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
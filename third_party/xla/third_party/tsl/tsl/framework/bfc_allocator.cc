@@ -23,6 +23,7 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "tsl/framework/allocator_retry.h"
 #include "tsl/lib/core/bits.h"
+#include "tsl/platform/cpu_info.h"
 #include "tsl/platform/file_system.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/mutex.h"
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tsl/platform/stacktrace.h"
 #include "tsl/platform/str_util.h"
 #include "tsl/platform/strcat.h"
+#include "tsl/platform/thread_index.h"
 #include "tsl/platform/types.h"
 #include "tsl/profiler/lib/scoped_memory_debug_annotation.h"
 #include "tsl/profiler/lib/traceme.h"
@@ -84,6 +86,27 @@ BFCAllocator::BFCAllocator(std::unique_ptr<SubAllocator> sub_allocator,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  if (opts.thread_cache_max_bytes > 0) {
+    while (num_thread_cache_classes_ < kNumThreadCacheClasses &&
+           (kMinAllocationSize << num_thread_cache_classes_) <=
+               opts.thread_cache_max_allocation_bytes) {
+      ++num_thread_cache_classes_;
+    }
+  }
+  if (num_thread_cache_classes_ > 0) {
+    num_thread_caches_ = std::max(1, port::NumSchedulableCPUs());
+    thread_caches_ = std::make_unique<ThreadCache[]>(num_thread_caches_);
+    cached_chunk_shards_ =
+        std::make_unique<CachedChunkShard[]>(kNumCachedChunkShards);
+    use_thread_caches_.store(true, std::memory_order_release);
+    VLOG(1) << "Enabling " << num_thread_caches_ << " thread caches of "
+            << strings::HumanReadableNumBytes(opts.thread_cache_max_bytes)
+            << " for allocations up to "
+            << strings::HumanReadableNumBytes(
+                   kMinAllocationSize << (num_thread_cache_classes_ - 1))
+            << " in " << name;
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -244,6 +267,10 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
   }
   void* r =
       AllocateRawInternal(unused_alignment, num_bytes, false, freed_by_count);
+  if (r == nullptr && FlushThreadCaches()) {
+    r = AllocateRawInternal(unused_alignment, num_bytes, false,
+                            freed_by_count);
+  }
   if (r != nullptr) {
     return r;
   } else {
@@ -263,6 +290,19 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
 
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
+  if (use_thread_caches_.load(std::memory_order_acquire) &&
+      allocation_attr.freed_by_func == nullptr) {
+    const int size_class = ThreadCacheSizeClass(num_bytes);
+    if (size_class >= 0) {
+      return AllocateFromThreadCache(size_class, num_bytes, allocation_attr);
+    }
+  }
+  return AllocateRawUncached(unused_alignment, num_bytes, allocation_attr);
+}
+
+void* BFCAllocator::AllocateRawUncached(
+    size_t unused_alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
   VLOG(3) << "AllocateRaw " << Name() << "  " << num_bytes;
   void* result = [&] {
     if (!opts_.allow_retry_on_failure || !allocation_attr.retry_on_failure) {
@@ -289,6 +329,10 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
       }
       void* res = AllocateRawInternal(unused_alignment, num_bytes,
                                       dump_log_on_failure, freed_by_count);
+      if (res == nullptr && FlushThreadCaches()) {
+        res = AllocateRawInternal(unused_alignment, num_bytes,
+                                  dump_log_on_failure, freed_by_count);
+      }
       if (res == nullptr) {
         int32 counter_value = log_counter.load(std::memory_order_relaxed);
         if (counter_value < kMaxFailureLogs) {
@@ -316,6 +360,155 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
   return result;
 }
 
+int BFCAllocator::ThreadCacheSizeClass(size_t num_bytes) {
+  if (num_bytes == 0 ||
+      num_bytes > (kMinAllocationSize << (num_thread_cache_classes_ - 1))) {
+    return -1;
+  }
+  const size_t rounded_bytes = RoundedBytes(num_bytes);
+  int size_class = Log2FloorNonZero(rounded_bytes >> kMinAllocationBits);
+  if ((kMinAllocationSize << size_class) < rounded_bytes) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+BFCAllocator::ThreadCache& BFCAllocator::CurrentThreadCache() {
+  return thread_caches_[port::CurrentThreadIndex() % num_thread_caches_];
+}
+
+BFCAllocator::CachedChunkShard& BFCAllocator::CachedChunkShardFor(
+    const void* ptr) const {
+  const std::uintptr_t p = reinterpret_cast<std::uintptr_t>(ptr);
+  return cached_chunk_shards_[(p >> kMinAllocationBits) %
+                              kNumCachedChunkShards];
+}
+
+void* BFCAllocator::AllocateFromThreadCache(
+    int size_class, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  const size_t class_bytes = kMinAllocationSize << size_class;
+  ThreadCache& cache = CurrentThreadCache();
+  void* ptr = nullptr;
+  {
+    mutex_lock l(cache.mu);
+    std::vector<void*>& magazine = cache.magazines[size_class];
+    if (!magazine.empty()) {
+      ptr = magazine.back();
+      magazine.pop_back();
+      cache.cached_bytes -= class_bytes;
+      ++cache.hits;
+    } else {
+      ++cache.misses;
+    }
+  }
+  if (ptr == nullptr) {
+    // Allocate the whole size class so that the chunk can later be reused for
+    // any request in the same class.
+    ptr =
+        AllocateRawUncached(kAllocatorAlignment, class_bytes, allocation_attr);
+  }
+  if (ptr != nullptr) {
+    CachedChunkShard& shard = CachedChunkShardFor(ptr);
+    mutex_lock l(shard.mu);
+    shard.chunks[ptr] = CachedChunk{size_class, num_bytes};
+  }
+  return ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  int size_class;
+  {
+    CachedChunkShard& shard = CachedChunkShardFor(ptr);
+    mutex_lock l(shard.mu);
+    auto it = shard.chunks.find(ptr);
+    if (it == shard.chunks.end()) {
+      return false;
+    }
+    size_class = it->second.size_class;
+  }
+  std::vector<void*> to_release;
+  if (!use_thread_caches_.load(std::memory_order_acquire)) {
+    // Hoarded chunks would bypass the freed-at timestamps.
+    to_release.push_back(ptr);
+  } else {
+    const size_t class_bytes = kMinAllocationSize << size_class;
+    ThreadCache& cache = CurrentThreadCache();
+    mutex_lock l(cache.mu);
+    if (cache.cached_bytes + class_bytes > opts_.thread_cache_max_bytes) {
+      to_release.push_back(ptr);
+    } else {
+      cache.magazines[size_class].push_back(ptr);
+      cache.cached_bytes += class_bytes;
+    }
+    if (++cache.deallocs_since_flush >= kThreadCacheFlushPeriod) {
+      // Chunks at the front of a magazine have been hoarded the longest.
+      cache.deallocs_since_flush = 0;
+      for (int c = 0; c < num_thread_cache_classes_; ++c) {
+        std::vector<void*>& magazine = cache.magazines[c];
+        const size_t n = magazine.size() / 2;
+        to_release.insert(to_release.end(), magazine.begin(),
+                          magazine.begin() + n);
+        magazine.erase(magazine.begin(), magazine.begin() + n);
+        cache.cached_bytes -= n * (kMinAllocationSize << c);
+      }
+    }
+  }
+  if (!to_release.empty()) {
+    ReleaseCachedChunks(to_release);
+  }
+  return true;
+}
+
+void BFCAllocator::ReleaseCachedChunks(const std::vector<void*>& ptrs) {
+  for (void* ptr : ptrs) {
+    {
+      CachedChunkShard& shard = CachedChunkShardFor(ptr);
+      mutex_lock l(shard.mu);
+      shard.chunks.erase(ptr);
+    }
+    DeallocateRawInternal(ptr);
+  }
+  retry_helper_.NotifyDealloc();
+}
+
+bool BFCAllocator::FlushThreadCaches() {
+  if (thread_caches_ == nullptr) {
+    return false;
+  }
+  std::vector<void*> to_release;
+  for (int i = 0; i < num_thread_caches_; ++i) {
+    ThreadCache& cache = thread_caches_[i];
+    mutex_lock l(cache.mu);
+    for (std::vector<void*>& magazine : cache.magazines) {
+      to_release.insert(to_release.end(), magazine.begin(), magazine.end());
+      magazine.clear();
+    }
+    cache.cached_bytes = 0;
+  }
+  if (to_release.empty()) {
+    return false;
+  }
+  VLOG(2) << "Flushing " << to_release.size()
+          << " chunks from thread caches of " << Name();
+  ReleaseCachedChunks(to_release);
+  return true;
+}
+
+void BFCAllocator::SetTimingCounter(SharedCounter* sc) {
+  {
+    mutex_lock l(lock_);
+    timing_counter_ = sc;
+  }
+  if (thread_caches_ != nullptr) {
+    // Hoarded chunks would bypass the freed-at timestamps.
+    use_thread_caches_.store(sc == nullptr, std::memory_order_release);
+    if (sc != nullptr) {
+      FlushThreadCaches();
+    }
+  }
+}
+
 // static
 size_t BFCAllocator::RoundedBytes(size_t bytes) {
   size_t rounded_bytes =
@@ -689,6 +882,10 @@ void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(4) << "[mem-debug] DeallocateRaw," << Name() << ","
           << (ptr ? RequestedSize(ptr) : 0) << "," << ptr << ","
           << tsl::CurrentStackTrace();
+  if (thread_caches_ != nullptr && ptr != nullptr &&
+      DeallocateToThreadCache(ptr)) {
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
@@ -942,6 +1139,15 @@ bool BFCAllocator::TracksAllocationSizes() const { return true; }
 
 size_t BFCAllocator::RequestedSize(const void* ptr) const {
   CHECK(ptr);
+  if (thread_caches_ != nullptr) {
+    // Chunks served by a thread cache span a whole size class.
+    CachedChunkShard& shard = CachedChunkShardFor(ptr);
+    mutex_lock l(shard.mu);
+    auto it = shard.chunks.find(ptr);
+    if (it != shard.chunks.end()) {
+      return it->second.requested_size;
+    }
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -1150,7 +1356,7 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
   // Record the general stats
   tensorflow::MemAllocatorStats* mas = md.mutable_stats();
-  mas->set_num_allocs(stats_.num_allocs);
+  mas->set_num_allocs(stats_.num_allocs + NumThreadCacheHits());
   mas->set_bytes_in_use(stats_.bytes_in_use);
   mas->set_peak_bytes_in_use(stats_.peak_bytes_in_use);
   mas->set_largest_alloc_size(stats_.largest_alloc_size);
@@ -1210,16 +1416,55 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
   return md;
 }
 
+int64_t BFCAllocator::NumThreadCacheHits() {
+  int64_t hits = 0;
+  for (int i = 0; i < num_thread_caches_; ++i) {
+    ThreadCache& cache = thread_caches_[i];
+    mutex_lock l(cache.mu);
+    hits += cache.hits;
+  }
+  return hits;
+}
+
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
-  mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats;
+  {
+    mutex_lock l(lock_);
+    stats = stats_;
+  }
+  if (thread_caches_ != nullptr) {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t cached_bytes = 0;
+    for (int i = 0; i < num_thread_caches_; ++i) {
+      ThreadCache& cache = thread_caches_[i];
+      mutex_lock l(cache.mu);
+      hits += cache.hits;
+      misses += cache.misses;
+      cached_bytes += cache.cached_bytes;
+    }
+    // Hits never reach the allocator, so they are not counted in stats_.
+    stats.num_allocs += hits;
+    stats.thread_cache_hits = hits;
+    stats.thread_cache_misses = misses;
+    stats.thread_cache_bytes = cached_bytes;
+  }
+  return stats;
 }
 
 bool BFCAllocator::ClearStats() {
-  mutex_lock l(lock_);
-  stats_.num_allocs = 0;
-  stats_.peak_bytes_in_use = stats_.bytes_in_use;
-  stats_.largest_alloc_size = 0;
+  {
+    mutex_lock l(lock_);
+    stats_.num_allocs = 0;
+    stats_.peak_bytes_in_use = stats_.bytes_in_use;
+    stats_.largest_alloc_size = 0;
+  }
+  for (int i = 0; i < num_thread_caches_; ++i) {
+    ThreadCache& cache = thread_caches_[i];
+    mutex_lock l(cache.mu);
+    cache.hits = 0;
+    cache.misses = 0;
+  }
   return true;
 }
 
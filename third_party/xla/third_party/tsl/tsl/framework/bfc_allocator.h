@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_TSL_FRAMEWORK_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tsl/framework/allocator.h"
 #include "tsl/framework/allocator_retry.h"
@@ -68,6 +70,18 @@ class BFCAllocator : public Allocator {
     // Controls when a chunk should be split, if its size exceeds the requested
     // allocation size.
     double fragmentation_fraction = 0;
+
+    // If greater than zero, small allocations are served from thread caches
+    // that sit in front of the allocator's global lock. A thread cache keeps
+    // "magazines" of recently freed chunks for a few power-of-two size classes
+    // and hoards at most this many bytes. Cached chunks still count as in use
+    // in GetStats(). Thread caches are bypassed while a timing counter is set
+    // (see SetTimingCounter()).
+    size_t thread_cache_max_bytes = 0;
+
+    // Allocations larger than this are never served from a thread cache. It is
+    // clamped to the largest thread cache size class.
+    size_t thread_cache_max_allocation_bytes = 64 << 10;
   };
   BFCAllocator(std::unique_ptr<SubAllocator> sub_allocator, size_t total_memory,
                const string& name, const Options& opts);
@@ -97,7 +111,7 @@ class BFCAllocator : public Allocator {
 
   bool ClearStats() override;
 
-  void SetTimingCounter(SharedCounter* sc) { timing_counter_ = sc; }
+  void SetTimingCounter(SharedCounter* sc);
 
   void SetSafeFrontier(uint64 count) override;
 
@@ -110,6 +124,9 @@ class BFCAllocator : public Allocator {
  private:
   struct Bin;
 
+  void* AllocateRawUncached(size_t alignment, size_t num_bytes,
+                            const AllocationAttributes& allocation_attr);
+
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure,
                             uint64 freed_before_count);
@@ -120,6 +137,61 @@ class BFCAllocator : public Allocator {
 
   void DeallocateRawInternal(void* ptr);
 
+  // Thread caches. Threads are mapped onto a fixed number of caches, each
+  // guarded by its own mutex, so threads on different cores rarely contend.
+  // Size class `c` holds chunks of exactly kMinAllocationSize << c bytes.
+  static constexpr int kNumThreadCacheClasses = 12;
+  // Every this many deallocations into a thread cache, the older half of each
+  // of its magazines is returned to the allocator.
+  static constexpr int kThreadCacheFlushPeriod = 1 << 14;
+
+  struct alignas(64) ThreadCache {
+    mutex mu;
+    std::array<std::vector<void*>, kNumThreadCacheClasses> magazines
+        TF_GUARDED_BY(mu);
+    size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+    int64_t hits TF_GUARDED_BY(mu) = 0;
+    int64_t misses TF_GUARDED_BY(mu) = 0;
+    int deallocs_since_flush TF_GUARDED_BY(mu) = 0;
+  };
+
+  // Maps every pointer handed out through a thread cache to its size class
+  // and the size of its latest request, sharded by address. A pointer stays
+  // in this map while it is hoarded in a magazine, and is removed when its
+  // chunk is returned to the allocator.
+  static constexpr int kNumCachedChunkShards = 64;
+  struct CachedChunk {
+    int size_class;
+    size_t requested_size;
+  };
+  struct alignas(64) CachedChunkShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, CachedChunk> chunks TF_GUARDED_BY(mu);
+  };
+
+  // Returns the thread cache size class for an allocation of `num_bytes`, or
+  // -1 if such allocations are not cached.
+  int ThreadCacheSizeClass(size_t num_bytes);
+  ThreadCache& CurrentThreadCache();
+  CachedChunkShard& CachedChunkShardFor(const void* ptr) const;
+
+  void* AllocateFromThreadCache(int size_class, size_t num_bytes,
+                                const AllocationAttributes& allocation_attr);
+
+  // Returns true if `ptr` was taken by a thread cache, in which case it must
+  // not be freed.
+  bool DeallocateToThreadCache(void* ptr);
+
+  // Returns chunks that were hoarded by thread caches to the allocator.
+  void ReleaseCachedChunks(const std::vector<void*>& ptrs);
+
+  // Returns all hoarded chunks to the allocator. Returns true if any chunk was
+  // released.
+  bool FlushThreadCaches();
+
+  // Returns the number of allocations served from hoarded chunks.
+  int64_t NumThreadCacheHits();
+
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
   //
@@ -592,7 +664,7 @@ class BFCAllocator : public Allocator {
 
   std::unique_ptr<SubAllocator> sub_allocator_;
   string name_;
-  SharedCounter* timing_counter_ = nullptr;
+  SharedCounter* timing_counter_ TF_GUARDED_BY(lock_) = nullptr;
   std::deque<ChunkHandle> timestamped_chunks_;
 
   std::atomic<uint64> safe_frontier_ = {0};
@@ -610,6 +682,14 @@ class BFCAllocator : public Allocator {
   // newly-created chunk.
   int64_t next_allocation_id_ TF_GUARDED_BY(lock_);
 
+  // Null iff thread caches are disabled.
+  std::unique_ptr<ThreadCache[]> thread_caches_;
+  int num_thread_caches_ = 0;
+  int num_thread_cache_classes_ = 0;
+  std::unique_ptr<CachedChunkShard[]> cached_chunk_shards_;
+  // False while thread caches are disabled or a timing counter is set.
+  std::atomic<bool> use_thread_caches_{false};
+
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
 #ifdef TENSORFLOW_MEM_DEBUG
@@ -0,0 +1,181 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tsl/framework/bfc_allocator.h"
+
+#include <memory>
+#include <vector>
+
+#include "tsl/framework/shared_counter.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/mem.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
+
+namespace tsl {
+namespace {
+
+class MallocSubAllocator : public SubAllocator {
+ public:
+  MallocSubAllocator() : SubAllocator({}, {}) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    *bytes_received = num_bytes;
+    return port::AlignedMalloc(num_bytes, Allocator::kAllocatorAlignment);
+  }
+
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+
+  bool SupportsCoalescing() const override { return false; }
+};
+
+std::unique_ptr<BFCAllocator> NewAllocator(size_t thread_cache_max_bytes,
+                                           size_t total_memory = 1 << 30) {
+  BFCAllocator::Options opts;
+  opts.thread_cache_max_bytes = thread_cache_max_bytes;
+  return std::make_unique<BFCAllocator>(std::make_unique<MallocSubAllocator>(),
+                                        total_memory, "bfc", opts);
+}
+
+TEST(BFCAllocatorTest, NoThreadCacheStatsByDefault) {
+  auto a = NewAllocator(/*thread_cache_max_bytes=*/0);
+  void* p = a->AllocateRaw(1, 1024);
+  a->DeallocateRaw(p);
+  auto stats = a->GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_FALSE(stats->thread_cache_hits);
+  EXPECT_EQ(0, stats->bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheReusesFreedChunks) {
+  auto a = NewAllocator(/*thread_cache_max_bytes=*/1 << 20);
+  void* p = a->AllocateRaw(1, 1000);
+  ASSERT_NE(nullptr, p);
+  // Allocations are rounded up to their size class.
+  EXPECT_EQ(1000, a->RequestedSize(p));
+  EXPECT_EQ(1024, a->AllocatedSize(p));
+  a->DeallocateRaw(p);
+
+  // The chunk stays hoarded by the thread cache.
+  auto stats = a->GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(1024, stats->bytes_in_use);
+  EXPECT_EQ(1024, *stats->thread_cache_bytes);
+  EXPECT_EQ(0, *stats->thread_cache_hits);
+  EXPECT_EQ(1, *stats->thread_cache_misses);
+
+  // A request in the same size class is served from the cache.
+  void* q = a->AllocateRaw(1, 700);
+  EXPECT_EQ(p, q);
+  EXPECT_EQ(700, a->RequestedSize(q));
+  stats = a->GetStats();
+  EXPECT_EQ(2, stats->num_allocs);
+  EXPECT_EQ(1, *stats->thread_cache_hits);
+  EXPECT_EQ(0, *stats->thread_cache_bytes);
+  a->DeallocateRaw(q);
+
+  // Large allocations bypass the cache.
+  void* r = a->AllocateRaw(1, 1 << 20);
+  a->DeallocateRaw(r);
+  stats = a->GetStats();
+  EXPECT_EQ(1, *stats->thread_cache_misses);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheIsBounded) {
+  auto a = NewAllocator(/*thread_cache_max_bytes=*/4096);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a->AllocateRaw(1, 1024));
+  }
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  auto stats = a->GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(4096, *stats->thread_cache_bytes);
+  EXPECT_EQ(4096, stats->bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheIsFlushedOnOutOfMemory) {
+  auto a = NewAllocator(/*thread_cache_max_bytes=*/1 << 20,
+                        /*total_memory=*/1 << 20);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 384; ++i) {
+    ptrs.push_back(a->AllocateRaw(1, 2048));
+  }
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  // Most memory is hoarded in the cache, but a large allocation still
+  // succeeds.
+  void* p = a->AllocateRaw(1, 512 << 10);
+  EXPECT_NE(nullptr, p);
+  a->DeallocateRaw(p);
+  EXPECT_EQ(0, *a->GetStats()->thread_cache_bytes);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheIsBypassedWithTimingCounter) {
+  auto a = NewAllocator(/*thread_cache_max_bytes=*/1 << 20);
+  a->DeallocateRaw(a->AllocateRaw(1, 1024));
+  EXPECT_EQ(1024, *a->GetStats()->thread_cache_bytes);
+
+  // Setting a timing counter returns the hoarded chunks.
+  SharedCounter counter;
+  a->SetTimingCounter(&counter);
+  EXPECT_EQ(0, *a->GetStats()->thread_cache_bytes);
+  a->DeallocateRaw(a->AllocateRaw(1, 1024));
+  auto stats = a->GetStats();
+  EXPECT_EQ(0, *stats->thread_cache_bytes);
+  EXPECT_EQ(1, *stats->thread_cache_misses);
+}
+
+static void BM_AllocationThreadedSmall(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const size_t thread_cache_max_bytes = state.range(1);
+  constexpr int kSubIters = 10000;
+
+  auto a = NewAllocator(thread_cache_max_bytes);
+  for (auto s : state) {
+    thread::ThreadPool pool(Env::Default(), "test", num_threads);
+    for (int t = 0; t < num_threads; t++) {
+      pool.Schedule([&a]() {
+        const std::vector<size_t> sizes = {256, 1024, 512, 4096, 16384, 2048};
+        void* held[4] = {};
+        for (int i = 0; i < kSubIters; i++) {
+          const int slot = i % 4;
+          if (held[slot] != nullptr) a->DeallocateRaw(held[slot]);
+          held[slot] = a->AllocateRaw(1, sizes[i % sizes.size()]);
+        }
+        for (void* p : held) a->DeallocateRaw(p);
+      });
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_threads * kSubIters);
+}
+
+BENCHMARK(BM_AllocationThreadedSmall)
+    ->UseRealTime()
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1 << 20)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1 << 20)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1 << 20);
+
+}  // namespace
+}  // namespace tsl
@@ -0,0 +1,37 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TSL_PLATFORM_THREAD_INDEX_H_
+#define TENSORFLOW_TSL_PLATFORM_THREAD_INDEX_H_
+
+#include <atomic>
+
+namespace tsl {
+namespace port {
+
+// Returns a small, process-wide unique index for the calling thread. The index
+// is assigned the first time a thread calls this function, so it can be used
+// to spread threads over a fixed number of per-thread structures.
+inline int CurrentThreadIndex() {
+  static std::atomic<int> next_index{0};
+  thread_local const int index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+}  // namespace port
+}  // namespace tsl
+
+#endif  // TENSORFLOW_TSL_PLATFORM_THREAD_INDEX_H_
@@ -170,6 +170,7 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_cpu_matmul_tiling_n_dim(8);
   opts.set_xla_cpu_matmul_tiling_k_dim(8);
   opts.set_xla_cpu_enable_mlir_fusion_outlining(true);
+  opts.set_xla_cpu_object_cache_size_mb(0);
   opts.set_xla_cpu_enable_experimental_deallocation(true);
 
   opts.set_xla_partitioning_algorithm(
@@ -1158,6 +1159,19 @@ void MakeDebugOptionsFlags(std::vector<tsl::Flag>* flag_list,
       bool_setter_for(&DebugOptions::set_xla_cpu_enable_mlir_fusion_outlining),
       debug_options->xla_cpu_enable_mlir_fusion_outlining(),
       "Enable MLIR fusion outlining (to improve compile time)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_object_cache_size_mb",
+      int64_setter_for(&DebugOptions::set_xla_cpu_object_cache_size_mb),
+      debug_options->xla_cpu_object_cache_size_mb(),
+      "Size in MB of the in-memory cache of the object code of the kernels "
+      "compiled by the CPU JIT. 0 (the default) disables the in-memory "
+      "cache. Executables compiled with a cache can't be exported."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_object_cache_dir",
+      string_setter_for(&DebugOptions::set_xla_cpu_object_cache_dir),
+      debug_options->xla_cpu_object_cache_dir(),
+      "If non-empty, the CPU JIT also caches object code in files in this "
+      "directory, which may be shared between processes."));
   flag_list->push_back(tsl::Flag(
       "xla_cpu_enable_custom_matmul_tiling",
       bool_setter_for(&DebugOptions::set_xla_cpu_enable_custom_matmul_tiling),
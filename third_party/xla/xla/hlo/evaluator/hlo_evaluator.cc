@@ -3038,6 +3038,96 @@ Status HloEvaluator::HandleScatter(const HloInstruction* hlo) {
   return OkStatus();
 }
 
+// Returns the distance, in elements, between consecutive indices of every
+// dimension of `shape` in its physical layout.
+static DimensionVector PhysicalStrides(const Shape& shape) {
+  DimensionVector strides(shape.rank());
+  int64_t stride = 1;
+  for (int64_t dim : LayoutUtil::MinorToMajor(shape)) {
+    strides[dim] = stride;
+    stride *= shape.dimensions(dim);
+  }
+  return strides;
+}
+
+// Fills `result` with `operand` broadcast along `dimensions`. The result is
+// written in physical order and the operand offset of each result dimension
+// is precomputed as a stride, zero along the broadcast dimensions, so that the
+// inner loop is a strided copy rather than the per-element index computation
+// of LiteralBase::Broadcast.
+template <int kPrimitiveSize>
+static void BroadcastLinearly(const Literal& operand,
+                              absl::Span<const int64_t> dimensions,
+                              Literal* result) {
+  const Shape& shape = result->shape();
+  const int64_t rank = shape.rank();
+  const DimensionVector operand_strides = PhysicalStrides(operand.shape());
+  DimensionVector strides(rank, 0);
+  for (int64_t i = 0; i < dimensions.size(); ++i) {
+    strides[dimensions[i]] = operand_strides[i];
+  }
+  absl::Span<const int64_t> minor_to_major = LayoutUtil::MinorToMajor(shape);
+  const int64_t inner_size = shape.dimensions(minor_to_major[0]);
+  const int64_t inner_stride = strides[minor_to_major[0]] * kPrimitiveSize;
+  const int64_t num_rows = ShapeUtil::ElementsIn(shape) / inner_size;
+
+  const char* source = static_cast<const char*>(operand.untyped_data());
+  char* dest = static_cast<char*>(result->untyped_data());
+  DimensionVector index(rank, 0);
+  int64_t source_offset = 0;
+  for (int64_t row = 0; row < num_rows; ++row) {
+    const char* source_row = source + source_offset * kPrimitiveSize;
+    for (int64_t i = 0; i < inner_size; ++i) {
+      std::memcpy(dest, source_row + i * inner_stride, kPrimitiveSize);
+      dest += kPrimitiveSize;
+    }
+    // Moves to the next row, incrementing the outer dimensions in minor to
+    // major order.
+    for (int64_t k = 1; k < rank; ++k) {
+      const int64_t dim = minor_to_major[k];
+      source_offset += strides[dim];
+      if (++index[dim] < shape.dimensions(dim)) {
+        break;
+      }
+      source_offset -= strides[dim] * shape.dimensions(dim);
+      index[dim] = 0;
+    }
+  }
+}
+
+// Broadcasts `operand` into `result` with BroadcastLinearly. Returns false,
+// leaving `result` untouched, if the shapes are not supported.
+static bool TryBroadcastLinearly(const Literal& operand,
+                                 absl::Span<const int64_t> dimensions,
+                                 Literal* result) {
+  const Shape& shape = result->shape();
+  if (!shape.is_static() || !operand.shape().is_static() ||
+      !LayoutUtil::IsDenseArray(shape) ||
+      !LayoutUtil::IsDenseArray(operand.shape()) || shape.rank() == 0 ||
+      ShapeUtil::IsZeroElementArray(shape)) {
+    return false;
+  }
+  switch (ShapeUtil::ByteSizeOfPrimitiveType(shape.element_type())) {
+    case 1:
+      BroadcastLinearly<1>(operand, dimensions, result);
+      return true;
+    case 2:
+      BroadcastLinearly<2>(operand, dimensions, result);
+      return true;
+    case 4:
+      BroadcastLinearly<4>(operand, dimensions, result);
+      return true;
+    case 8:
+      BroadcastLinearly<8>(operand, dimensions, result);
+      return true;
+    case 16:
+      BroadcastLinearly<16>(operand, dimensions, result);
+      return true;
+    default:
+      return false;
+  }
+}
+
 Status HloEvaluator::HandleBroadcast(const HloInstruction* broadcast) {
   const Literal& operand = GetEvaluatedLiteralFor(broadcast->operand(0));
   TF_RET_CHECK(broadcast->shape().element_type() ==
@@ -3059,6 +3149,14 @@ Status HloEvaluator::HandleBroadcast(const HloInstruction* broadcast) {
         broadcast->ToString());
   }
 
+  if (use_fast_path_) {
+    Literal result(broadcast->shape());
+    if (TryBroadcastLinearly(operand, broadcast->dimensions(), &result)) {
+      evaluated_[broadcast] = std::move(result);
+      return OkStatus();
+    }
+  }
+
   TF_ASSIGN_OR_RETURN(
       evaluated_[broadcast],
       operand.Broadcast(broadcast->shape(), broadcast->dimensions()));
@@ -4306,6 +4404,225 @@ static StatusOr<bool> GenerateReduceOutputElement(
   return true;
 }
 
+// Returns the opcode of `computation` if it computes a single add, multiply,
+// maximum or minimum of its two parameters, in order, all scalars of `type`.
+static std::optional<HloOpcode> GetElementwiseReducerOpcode(
+    const HloComputation* computation, PrimitiveType type) {
+  const HloInstruction* root = computation->root_instruction();
+  switch (root->opcode()) {
+    case HloOpcode::kAdd:
+    case HloOpcode::kMultiply:
+    case HloOpcode::kMaximum:
+    case HloOpcode::kMinimum:
+      break;
+    default:
+      return std::nullopt;
+  }
+  if (computation->num_parameters() != 2 ||
+      root->operand(0) != computation->parameter_instruction(0) ||
+      root->operand(1) != computation->parameter_instruction(1)) {
+    return std::nullopt;
+  }
+  for (const HloInstruction* instruction :
+       {root, root->operand(0), root->operand(1)}) {
+    if (!ShapeUtil::IsScalarWithElementType(instruction->shape(), type)) {
+      return std::nullopt;
+    }
+  }
+  return root->opcode();
+}
+
+// Reduces `input` along `dimensions_to_reduce` into `result`, applying the
+// reducer `opcode` natively instead of evaluating the reducer computation for
+// every element. The elements of each output are visited in the same order as
+// GenerateReduceOutputElement, floating point sums are accumulated in double
+// in the same chunks as its fast add path, and the element functions match
+// those of HloEvaluatorTypedVisitor, so the results are bitwise identical.
+template <typename NativeT>
+static void ReduceLinearly(HloOpcode opcode, const Literal& input,
+                           NativeT init_value,
+                           absl::Span<const int64_t> dimensions_to_reduce,
+                           Literal* result) {
+  const Shape& input_shape = input.shape();
+  const DimensionVector input_strides = PhysicalStrides(input_shape);
+  // The reduced dimensions in minor to major order, and the input dimensions
+  // of the kept ones in the order of the result dimensions.
+  DimensionVector reduced_sizes;
+  DimensionVector reduced_strides;
+  for (int64_t dim : LayoutUtil::MinorToMajor(input_shape)) {
+    if (absl::c_linear_search(dimensions_to_reduce, dim)) {
+      reduced_sizes.push_back(input_shape.dimensions(dim));
+      reduced_strides.push_back(input_strides[dim]);
+    }
+  }
+  DimensionVector kept_strides;
+  for (int64_t dim = 0; dim < input_shape.rank(); ++dim) {
+    if (!absl::c_linear_search(dimensions_to_reduce, dim)) {
+      kept_strides.push_back(input_strides[dim]);
+    }
+  }
+  int64_t num_reduced = 1;
+  for (int64_t size : reduced_sizes) {
+    num_reduced *= size;
+  }
+  const int64_t inner_size = reduced_sizes.empty() ? 1 : reduced_sizes[0];
+  const int64_t inner_stride = reduced_strides.empty() ? 0 : reduced_strides[0];
+  absl::Span<const NativeT> data = input.data<NativeT>();
+
+  // Calls `step` on each reduced element of the output whose first input
+  // element is at `base`.
+  auto for_each_reduced_element = [&](int64_t base, auto step) {
+    if (num_reduced == 0) {
+      return;
+    }
+    DimensionVector index(reduced_sizes.size(), 0);
+    int64_t offset = base;
+    for (int64_t row = 0; row < num_reduced / inner_size; ++row) {
+      for (int64_t i = 0; i < inner_size; ++i) {
+        step(data[offset + i * inner_stride]);
+      }
+      for (int64_t k = 1; k < reduced_sizes.size(); ++k) {
+        offset += reduced_strides[k];
+        if (++index[k] < reduced_sizes[k]) {
+          break;
+        }
+        offset -= reduced_strides[k] * reduced_sizes[k];
+        index[k] = 0;
+      }
+    }
+  };
+
+  auto reduce = [&](int64_t base) -> NativeT {
+    NativeT accumulator = init_value;
+    switch (opcode) {
+      case HloOpcode::kAdd:
+        if constexpr (std::is_floating_point_v<NativeT>) {
+          static constexpr int kChunkSize = 512;
+          double sum = static_cast<double>(init_value);
+          double chunk_sum = 0.0;
+          int num_chunk_elements = 0;
+          for_each_reduced_element(base, [&](NativeT value) {
+            chunk_sum += static_cast<double>(value);
+            if (++num_chunk_elements == kChunkSize) {
+              sum += chunk_sum;
+              chunk_sum = 0.0;
+              num_chunk_elements = 0;
+            }
+          });
+          if (num_chunk_elements > 0) {
+            sum += chunk_sum;
+          }
+          return static_cast<NativeT>(sum);
+        } else {
+          for_each_reduced_element(base, [&](NativeT value) {
+            accumulator =
+                static_cast<NativeT>(ToArithmeticSafeType(accumulator) +
+                                     ToArithmeticSafeType(value));
+          });
+        }
+        break;
+      case HloOpcode::kMultiply:
+        for_each_reduced_element(base, [&](NativeT value) {
+          accumulator = static_cast<NativeT>(ToArithmeticSafeType(accumulator) *
+                                             ToArithmeticSafeType(value));
+        });
+        break;
+      case HloOpcode::kMaximum:
+        for_each_reduced_element(base, [&](NativeT value) {
+          if constexpr (std::numeric_limits<NativeT>::has_quiet_NaN) {
+            if (std::isnan(accumulator)) {
+              return;
+            }
+            if (std::isnan(value)) {
+              accumulator = value;
+              return;
+            }
+          }
+          accumulator = std::max(accumulator, value);
+        });
+        break;
+      case HloOpcode::kMinimum:
+        for_each_reduced_element(base, [&](NativeT value) {
+          if constexpr (std::numeric_limits<NativeT>::has_quiet_NaN) {
+            if (std::isnan(accumulator)) {
+              return;
+            }
+            if (std::isnan(value)) {
+              accumulator = value;
+              return;
+            }
+          }
+          accumulator = std::min(accumulator, value);
+        });
+        break;
+      default:
+        LOG(FATAL) << "Unexpected reducer opcode: " << opcode;
+    }
+    return accumulator;
+  };
+
+  ShapeUtil::ForEachIndexNoStatus(
+      result->shape(), [&](absl::Span<const int64_t> output_index) {
+        int64_t base = 0;
+        for (int64_t i = 0; i < output_index.size(); ++i) {
+          base += output_index[i] * kept_strides[i];
+        }
+        result->Set<NativeT>(output_index, reduce(base));
+        return true;
+      });
+}
+
+// Reduces `input` into `result` with ReduceLinearly. Returns false, leaving
+// `result` untouched, if the reducer or the element type is not supported.
+static bool TryReduceLinearly(const Literal& input, const Literal& init_value,
+                              const HloComputation* function,
+                              absl::Span<const int64_t> dimensions_to_reduce,
+                              Literal* result) {
+  const PrimitiveType type = input.shape().element_type();
+  if (!input.shape().is_static() || !LayoutUtil::IsDenseArray(input.shape()) ||
+      init_value.shape().element_type() != type ||
+      result->shape().element_type() != type) {
+    return false;
+  }
+  std::optional<HloOpcode> opcode = GetElementwiseReducerOpcode(function, type);
+  if (!opcode.has_value()) {
+    return false;
+  }
+  switch (type) {
+    case F32:
+      ReduceLinearly<float>(*opcode, input, init_value.GetFirstElement<float>(),
+                            dimensions_to_reduce, result);
+      return true;
+    case F64:
+      ReduceLinearly<double>(*opcode, input,
+                             init_value.GetFirstElement<double>(),
+                             dimensions_to_reduce, result);
+      return true;
+    case S32:
+      ReduceLinearly<int32_t>(*opcode, input,
+                              init_value.GetFirstElement<int32_t>(),
+                              dimensions_to_reduce, result);
+      return true;
+    case S64:
+      ReduceLinearly<int64_t>(*opcode, input,
+                              init_value.GetFirstElement<int64_t>(),
+                              dimensions_to_reduce, result);
+      return true;
+    case U32:
+      ReduceLinearly<uint32_t>(*opcode, input,
+                               init_value.GetFirstElement<uint32_t>(),
+                               dimensions_to_reduce, result);
+      return true;
+    case U64:
+      ReduceLinearly<uint64_t>(*opcode, input,
+                               init_value.GetFirstElement<uint64_t>(),
+                               dimensions_to_reduce, result);
+      return true;
+    default:
+      return false;
+  }
+}
+
 Status HloEvaluator::HandleReduce(const HloInstruction* hlo) {
   const HloReduceInstruction* reduce = Cast<HloReduceInstruction>(hlo);
   int64_t num_args = reduce->inputs().size();
@@ -4369,26 +4686,32 @@ Status HloEvaluator::HandleReduce(const HloInstruction* hlo) {
     }
   }
 
-  const int num_threads = ShapeUtil::GetForEachIndexParallelThreadCount() + 1;
-  std::vector<std::unique_ptr<HloEvaluator>> embedded_evaluators;
-  embedded_evaluators.reserve(num_threads);
-  for (int i = 0; i < num_threads; ++i) {
-    embedded_evaluators.push_back(CreateEmbedded(max_loop_iterations_));
-  }
-
   absl::InlinedVector<Literal, 1> results(num_args);
   for (int64_t i = 0; i < num_args; ++i) {
     results[i] = Literal(is_tuple ? out_shape.tuple_shapes(i) : out_shape);
   }
 
-  TF_RETURN_IF_ERROR(ShapeUtil::ForEachIndexParallelWithStatus(
-      output_shape, [&](absl::Span<const int64_t> output_index, int thread_id) {
-        return GenerateReduceOutputElement(
-            is_tuple, output_index, init_values, input_args,
-            absl::Span<Literal>(results), function,
-            embedded_evaluators[thread_id + 1].get(), arg_dim_steps,
-            arg_dim_counts, result_to_arg_index);
-      }));
+  if (!use_fast_path_ || is_tuple ||
+      !TryReduceLinearly(*input_args[0], *init_values[0], function,
+                         dimensions_to_reduce, &results[0])) {
+    const int num_threads =
+        ShapeUtil::GetForEachIndexParallelThreadCount() + 1;
+    std::vector<std::unique_ptr<HloEvaluator>> embedded_evaluators;
+    embedded_evaluators.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      embedded_evaluators.push_back(CreateEmbedded(max_loop_iterations_));
+    }
+
+    TF_RETURN_IF_ERROR(ShapeUtil::ForEachIndexParallelWithStatus(
+        output_shape,
+        [&](absl::Span<const int64_t> output_index, int thread_id) {
+          return GenerateReduceOutputElement(
+              is_tuple, output_index, init_values, input_args,
+              absl::Span<Literal>(results), function,
+              embedded_evaluators[thread_id + 1].get(), arg_dim_steps,
+              arg_dim_counts, result_to_arg_index);
+        }));
+  }
 
   if (is_tuple) {
     Literal tuple_result(inferred_return_shape);
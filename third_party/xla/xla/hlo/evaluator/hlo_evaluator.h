@@ -200,7 +200,10 @@ class HloEvaluator : public ConstDfsHloVisitorWithDefault {
     return dynamic_dimension_inference_;
   }
 
-  // Enable the fast path for certain operations like dot or convolution.
+  // Enable the fast path for certain operations like dot or convolution. It
+  // also evaluates elementwise ops, broadcasts and simple reductions over
+  // dense arrays with typed loops over their buffers rather than element by
+  // element through multi-dimensional indices.
   void set_use_fast_path(bool value) { use_fast_path_ = value; }
 
   // Handles evaluation of a custom-call op.
@@ -49,6 +49,7 @@ limitations under the License.
 #include "xla/service/dynamic_dimension_inference.h"
 #include "xla/service/hlo_element_type_converter.h"
 #include "xla/service/hlo_module_config.h"
+#include "xla/service/hlo_parser.h"
 #include "xla/service/shape_inference.h"
 #include "xla/shape.h"
 #include "xla/shape_util.h"
@@ -2647,6 +2648,211 @@ void BM_ReducePrecisely(::testing::benchmark::State& state) {
 
 BENCHMARK(BM_ReducePrecisely);
 
+// Tests that the fast paths of elementwise ops, broadcast and reduce give
+// bitwise the same results as the generic evaluation.
+class HloEvaluatorFastPathTest : public HloTestBase {
+ protected:
+  void ExpectSameResultWithFastPath(absl::string_view hlo_text) {
+    TF_ASSERT_OK_AND_ASSIGN(auto module,
+                            ParseAndReturnVerifiedModule(hlo_text));
+    HloEvaluator evaluator;
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal expected, evaluator.Evaluate(*module->entry_computation(), {}));
+    HloEvaluator fast_path_evaluator;
+    fast_path_evaluator.set_use_fast_path(true);
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal result,
+        fast_path_evaluator.Evaluate(*module->entry_computation(), {}));
+    EXPECT_TRUE(LiteralTestUtil::Equal(expected, result));
+  }
+};
+
+TEST_F(HloEvaluatorFastPathTest, Elementwise) {
+  constexpr absl::string_view hlo_text = R"(
+  HloModule Elementwise
+
+  ENTRY main {
+    a = f32[2,3]{0,1} constant({{1, -2, 3.5}, {-4, 0, nan}})
+    b = f32[2,3]{0,1} constant({{6, 5, nan}, {3, -0, 1}})
+    c = f32[2,3]{1,0} constant({{7, 8, 9}, {10, 11, 12}})
+    add = f32[2,3]{0,1} add(a, b)
+    max = f32[2,3]{0,1} maximum(a, b)
+    min = f32[2,3]{0,1} minimum(b, a)
+    mixed_layouts = f32[2,3]{1,0} subtract(a, c)
+    exp = f32[2,3]{0,1} exponential(a)
+    clamp = f32[2,3]{0,1} clamp(b, a, max)
+    i = s32[4] constant({2147483647, -2147483648, 7, -7})
+    j = s32[4] constant({1, -1, 0, 2})
+    wrap = s32[4] add(i, j)
+    product = s32[4] multiply(i, i)
+    div = s32[4] divide(i, j)
+    h = bf16[3] constant({1.5, -2.25, 3})
+    sum = bf16[3] add(h, h)
+    pred = pred[2,3]{0,1} compare(a, b), direction=LT
+    select = f32[2,3]{0,1} select(pred, a, b)
+    ROOT tuple = (f32[2,3]{0,1}, f32[2,3]{0,1}, f32[2,3]{0,1},
+                  f32[2,3]{1,0}, f32[2,3]{0,1}, f32[2,3]{0,1}, s32[4],
+                  s32[4], s32[4], bf16[3], f32[2,3]{0,1})
+        tuple(add, max, min, mixed_layouts, exp, clamp, wrap, product, div,
+              sum, select)
+  }
+  )";
+  ExpectSameResultWithFastPath(hlo_text);
+}
+
+TEST_F(HloEvaluatorFastPathTest, Broadcast) {
+  constexpr absl::string_view hlo_text = R"(
+  HloModule Broadcast
+
+  ENTRY main {
+    scalar = s8[] constant(-3)
+    vector = f32[3] constant({1, 2, 3})
+    matrix = f64[4,2]{0,1} constant({{1, 2}, {3, 4}, {5, 6}, {7, 8}})
+    complex = c128[2] constant({(1, 2), (3, 4)})
+    b0 = s8[2,3] broadcast(scalar), dimensions={}
+    b1 = f32[2,3,4]{0,2,1} broadcast(vector), dimensions={1}
+    b2 = f64[2,3,4]{1,0,2} broadcast(matrix), dimensions={2,0}
+    b3 = f64[4,5,2]{2,1,0} broadcast(matrix), dimensions={0,2}
+    b4 = c128[2,2]{0,1} broadcast(complex), dimensions={1}
+    ROOT tuple = (s8[2,3], f32[2,3,4]{0,2,1}, f64[2,3,4]{1,0,2},
+                  f64[4,5,2]{2,1,0}, c128[2,2]{0,1})
+        tuple(b0, b1, b2, b3, b4)
+  }
+  )";
+  ExpectSameResultWithFastPath(hlo_text);
+}
+
+TEST_F(HloEvaluatorFastPathTest, Reduce) {
+  constexpr absl::string_view hlo_text = R"(
+  HloModule Reduce
+
+  add_f32 {
+    lhs = f32[] parameter(0)
+    rhs = f32[] parameter(1)
+    ROOT add = f32[] add(lhs, rhs)
+  }
+
+  max_f32 {
+    lhs = f32[] parameter(0)
+    rhs = f32[] parameter(1)
+    ROOT max = f32[] maximum(lhs, rhs)
+  }
+
+  min_f64 {
+    lhs = f64[] parameter(0)
+    rhs = f64[] parameter(1)
+    ROOT min = f64[] minimum(lhs, rhs)
+  }
+
+  add_s32 {
+    lhs = s32[] parameter(0)
+    rhs = s32[] parameter(1)
+    ROOT add = s32[] add(lhs, rhs)
+  }
+
+  multiply_u64 {
+    lhs = u64[] parameter(0)
+    rhs = u64[] parameter(1)
+    ROOT multiply = u64[] multiply(lhs, rhs)
+  }
+
+  subtract_f32 {
+    lhs = f32[] parameter(0)
+    rhs = f32[] parameter(1)
+    ROOT subtract = f32[] subtract(lhs, rhs)
+  }
+
+  ENTRY main {
+    iota = f32[3,700,2]{1,0,2} iota(), iota_dimension=1
+    seven = f32[] constant(7)
+    sevens = f32[3,700,2]{1,0,2} broadcast(seven), dimensions={}
+    values = f32[3,700,2]{1,0,2} divide(iota, sevens)
+    zero = f32[] constant(0)
+    sum = f32[3] reduce(values, zero), dimensions={1,2}, to_apply=add_f32
+    nans = f32[2,2] constant({{1, nan}, {3, 4}})
+    lowest = f32[] constant(-inf)
+    max = f32[2] reduce(nans, lowest), dimensions={1}, to_apply=max_f32
+    doubles = f64[2,3]{0,1} constant({{5, -1, 2}, {0, 8, -0}})
+    highest = f64[] constant(inf)
+    min = f64[3] reduce(doubles, highest), dimensions={0}, to_apply=min_f64
+    ints = s32[2,2] constant({{2147483647, 1}, {-5, 6}})
+    int_zero = s32[] constant(0)
+    int_sum = s32[] reduce(ints, int_zero), dimensions={0,1}, to_apply=add_s32
+    uints = u64[3,0] constant({{}, {}, {}})
+    one = u64[] constant(1)
+    empty = u64[3] reduce(uints, one), dimensions={1}, to_apply=multiply_u64
+    difference = f32[3] reduce(values, zero), dimensions={1,2},
+        to_apply=subtract_f32
+    ROOT tuple = (f32[3], f32[2], f64[3], s32[], u64[3], f32[3])
+        tuple(sum, max, min, int_sum, empty, difference)
+  }
+  )";
+  ExpectSameResultWithFastPath(hlo_text);
+}
+
+// Evaluates `hlo_text` on a f32[512,512] argument, with the fast path enabled
+// when the benchmark argument is non-zero.
+void RunEvaluatorBenchmark(::testing::benchmark::State& state,
+                           absl::string_view hlo_text) {
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(hlo_text).value();
+  Literal arg(ShapeUtil::MakeShape(F32, {512, 512}));
+  arg.PopulateWithValue(1.5f);
+  for (auto s : state) {
+    HloEvaluator evaluator;
+    evaluator.set_use_fast_path(state.range(0) != 0);
+    evaluator.Evaluate(*module->entry_computation(), {&arg}).value();
+  }
+}
+
+void BM_EvaluateElementwise(::testing::benchmark::State& state) {
+  RunEvaluatorBenchmark(state, R"(
+  HloModule BM_EvaluateElementwise
+
+  ENTRY main {
+    p = f32[512,512] parameter(0)
+    add = f32[512,512] add(p, p)
+    multiply = f32[512,512] multiply(add, p)
+    ROOT max = f32[512,512] maximum(multiply, p)
+  }
+  )");
+}
+
+BENCHMARK(BM_EvaluateElementwise)->Arg(0)->Arg(1);
+
+void BM_EvaluateBroadcast(::testing::benchmark::State& state) {
+  RunEvaluatorBenchmark(state, R"(
+  HloModule BM_EvaluateBroadcast
+
+  ENTRY main {
+    p = f32[512,512] parameter(0)
+    ROOT broadcast = f32[512,8,512] broadcast(p), dimensions={0,2}
+  }
+  )");
+}
+
+BENCHMARK(BM_EvaluateBroadcast)->Arg(0)->Arg(1);
+
+void BM_EvaluateReduce(::testing::benchmark::State& state) {
+  RunEvaluatorBenchmark(state, R"(
+  HloModule BM_EvaluateReduce
+
+  max {
+    lhs = f32[] parameter(0)
+    rhs = f32[] parameter(1)
+    ROOT max = f32[] maximum(lhs, rhs)
+  }
+
+  ENTRY main {
+    p = f32[512,512] parameter(0)
+    lowest = f32[] constant(-inf)
+    ROOT reduce = f32[512] reduce(p, lowest), dimensions={1}, to_apply=max
+  }
+  )");
+}
+
+BENCHMARK(BM_EvaluateReduce)->Arg(0)->Arg(1);
+
 TEST_P(HloEvaluatorBf16Test, ReduceAdd) {
   HloComputation::Builder b(TestName());
 
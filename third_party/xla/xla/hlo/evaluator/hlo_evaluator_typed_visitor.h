@@ -23,6 +23,7 @@ limitations under the License.
 #include <cmath>
 #include <cstdint>
 #include <functional>
+#include <initializer_list>
 #include <limits>
 #include <memory>
 #include <optional>
@@ -39,10 +40,14 @@ limitations under the License.
 #include "xla/hlo/evaluator/hlo_evaluator.h"
 #include "xla/hlo/ir/hlo_casting_utils.h"
 #include "xla/hlo/ir/hlo_instructions.h"
+#include "xla/layout.h"
+#include "xla/layout_util.h"
 #include "xla/literal.h"
 #include "xla/literal_util.h"
 #include "xla/primitive_util.h"
 #include "xla/service/shape_inference.h"
+#include "xla/shape.h"
+#include "xla/shape_util.h"
 #include "xla/types.h"
 #include "xla/util.h"
 #include "xla/xla_data.pb.h"
@@ -1593,23 +1598,61 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
   }
 
  private:
-  StatusOr<Literal> ElementWiseUnaryOp(
-      const HloInstruction* instruction,
-      const std::function<ElementwiseT(ElementwiseT)>& unary_op) {
+  // Returns true if the elementwise fast path applies: `operands` are dense
+  // static arrays with the same dimensions and physical layout as `shape`.
+  // The element function is then run over the flat buffers in a plain loop
+  // that the compiler can inline and vectorize, instead of materializing a
+  // multi-dimensional index and doing a layout lookup for every element.
+  bool CanUseLinearLoop(const Shape& shape,
+                        std::initializer_list<const Literal*> operands) const {
+    if (!parent_->use_fast_path_ || !shape.IsArray() || !shape.has_layout() ||
+        !shape.is_static() || !LayoutUtil::IsDenseArray(shape)) {
+      return false;
+    }
+    for (const Literal* operand : operands) {
+      const Shape& operand_shape = operand->shape();
+      if (!operand_shape.IsArray() || !operand_shape.has_layout() ||
+          !operand_shape.is_static() ||
+          !LayoutUtil::IsDenseArray(operand_shape) ||
+          !ShapeUtil::SameDimensions(shape, operand_shape) ||
+          !Layout::Equal().MinorToMajorOnly()(shape.layout(),
+                                              operand_shape.layout())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <typename UnaryOp>
+  StatusOr<Literal> ElementWiseUnaryOp(const HloInstruction* instruction,
+                                       UnaryOp&& unary_op) {
     const Literal& operand_literal =
         parent_->GetEvaluatedLiteralFor(instruction->operand(0));
+    if (CanUseLinearLoop(instruction->shape(), {&operand_literal})) {
+      Literal result(instruction->shape());
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      absl::Span<const ReturnT> operand_data = operand_literal.data<ReturnT>();
+      for (int64_t i = 0; i < result_data.size(); ++i) {
+        result_data[i] = static_cast<ReturnT>(static_cast<ElementwiseT>(
+            unary_op(static_cast<ElementwiseT>(operand_data[i]))));
+      }
+      return std::move(result);
+    }
+
+    const std::function<ElementwiseT(ElementwiseT)> unary_function =
+        std::forward<UnaryOp>(unary_op);
     TF_ASSIGN_OR_RETURN(
         auto result_literal,
         (HloEvaluator::ElementWiseUnaryOpImpl<ReturnT, ReturnT>(
-            instruction, ConvertUnaryFunction(unary_op), operand_literal)));
+            instruction, ConvertUnaryFunction(unary_function),
+            operand_literal)));
 
     return std::move(result_literal);
   }
 
-  StatusOr<Literal> ElementWiseBinaryOp(
-      const HloInstruction* instruction,
-      const std::function<ElementwiseT(ElementwiseT, ElementwiseT)>&
-          binary_op) {
+  template <typename BinaryOp>
+  StatusOr<Literal> ElementWiseBinaryOp(const HloInstruction* instruction,
+                                        BinaryOp&& binary_op) {
     const auto& shape = instruction->shape();
     const auto* lhs = instruction->operand(0);
     const auto* rhs = instruction->operand(1);
@@ -1621,9 +1664,25 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (CanUseLinearLoop(shape, {&lhs_literal, &rhs_literal})) {
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      absl::Span<const ReturnT> lhs_data = lhs_literal.data<ReturnT>();
+      absl::Span<const ReturnT> rhs_data = rhs_literal.data<ReturnT>();
+      for (int64_t i = 0; i < result_data.size(); ++i) {
+        result_data[i] = static_cast<ReturnT>(static_cast<ElementwiseT>(
+            binary_op(static_cast<ElementwiseT>(lhs_data[i]),
+                      static_cast<ElementwiseT>(rhs_data[i]))));
+      }
+      return std::move(result);
+    }
+
+    const std::function<ElementwiseT(ElementwiseT, ElementwiseT)>
+        binary_function = std::forward<BinaryOp>(binary_op);
+    const std::function<ReturnT(ReturnT, ReturnT)> converted_binary_function =
+        ConvertBinaryFunction(binary_function);
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
-          return ConvertBinaryFunction(binary_op)(
+          return converted_binary_function(
               lhs_literal.Get<ReturnT>(multi_index),
               rhs_literal.Get<ReturnT>(multi_index));
         }));
@@ -1648,6 +1707,17 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (CanUseLinearLoop(shape, {&lhs_literal, &rhs_literal, &ehs_literal})) {
+      absl::Span<ReturnT> result_data = result.data<ReturnT>();
+      absl::Span<const LhsType> lhs_data = lhs_literal.data<LhsType>();
+      absl::Span<const RhsType> rhs_data = rhs_literal.data<RhsType>();
+      absl::Span<const EhsType> ehs_data = ehs_literal.data<EhsType>();
+      for (int64_t i = 0; i < result_data.size(); ++i) {
+        result_data[i] = ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+      }
+      return std::move(result);
+    }
+
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
           return ternary_op(lhs_literal.Get<LhsType>(multi_index),
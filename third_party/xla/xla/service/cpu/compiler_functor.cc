@@ -22,6 +22,8 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
@@ -38,10 +40,12 @@ limitations under the License.
 #include "xla/runtime/execution_engine.h"
 #include "xla/service/cpu/cpu_runtime.h"
 #include "xla/service/cpu/llvm_ir_runtime.h"
+#include "xla/service/cpu/metrics.h"
 #include "xla/service/llvm_ir/llvm_util.h"
 #include "xla/statusor.h"
 #include "xla/types.h"
 #include "xla/util.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/logging.h"
 
 namespace xla {
@@ -106,6 +110,21 @@ llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> CompilerFunctor::operator()(
     pre_optimization_hook_(module);
   }
 
+  std::string cache_key;
+  if (object_cache_ != nullptr) {
+    cache_key = ObjectCodeCache::Key(module, *target_machine_,
+                                     CacheKeyOptions());
+    if (std::unique_ptr<llvm::MemoryBuffer> memory_buffer =
+            object_cache_->Lookup(cache_key)) {
+      VLOG(2) << "Found object code for module " << module.getName().str()
+              << " in the object cache";
+      RunPostCodegenHook(*memory_buffer);
+      return std::move(memory_buffer);
+    }
+  }
+
+  const uint64_t start_usecs = tsl::Env::Default()->NowMicros();
+
   llvm::OptimizationLevel opt_level;
   if (optimize_for_size_) {
     opt_level = llvm::OptimizationLevel::Os;
@@ -211,18 +230,43 @@ llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> CompilerFunctor::operator()(
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
       new llvm::SmallVectorMemoryBuffer(std::move(stream_buffer)));
 
-  if (post_codegen_hook_) {
-    llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
-        llvm::object::ObjectFile::createObjectFile(*memory_buffer);
-    if (obj_file) {
-      post_codegen_hook_(*obj_file.get());
-    } else {
-      LOG(WARNING) << "Could convert memory buffer to object file!";
-    }
+  RecordLlvmToObjectDuration(tsl::Env::Default()->NowMicros() - start_usecs);
+
+  if (object_cache_ != nullptr) {
+    object_cache_->Insert(cache_key, memory_buffer->getMemBufferRef());
   }
 
+  RunPostCodegenHook(*memory_buffer);
+
   return std::move(memory_buffer);
 }
 
+std::string CompilerFunctor::CacheKeyOptions() const {
+  return absl::StrCat(
+      "opt_level=", opt_level_, ",optimize_for_size=", optimize_for_size_,
+      ",disable_expensive_passes=", disable_expensive_passes_,
+      ",disable_slp_vectorizer=", disable_slp_vectorizer_,
+      ",fast_math_flags=", fast_math_flags_.allowReassoc(),
+      fast_math_flags_.noNaNs(), fast_math_flags_.noInfs(),
+      fast_math_flags_.noSignedZeros(), fast_math_flags_.allowReciprocal(),
+      fast_math_flags_.allowContract(), fast_math_flags_.approxFunc(),
+      ",dfsan=", dfsan_enabled_, ":",
+      absl::StrJoin(dfsan_abi_list_files_, ":"),
+      ",convert_to_xla_runtime_abi=",
+      absl::StrJoin(convert_to_xla_runtime_abi_, ":"));
+}
+
+void CompilerFunctor::RunPostCodegenHook(
+    const llvm::MemoryBuffer& memory_buffer) {
+  if (!post_codegen_hook_) return;
+  llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
+      llvm::object::ObjectFile::createObjectFile(memory_buffer);
+  if (obj_file) {
+    post_codegen_hook_(*obj_file.get());
+  } else {
+    LOG(WARNING) << "Could convert memory buffer to object file!";
+  }
+}
+
 }  // namespace cpu
 }  // namespace xla
@@ -28,6 +28,7 @@ limitations under the License.
 #include "llvm/IR/Module.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
+#include "xla/service/cpu/object_code_cache.h"
 #include "xla/service/llvm_compiler.h"
 
 namespace xla {
@@ -47,7 +48,8 @@ class CompilerFunctor : public llvm::orc::IRCompileLayer::IRCompiler {
           post_codegen_hook = nullptr,
       bool dfsan_enabled = false,
       const std::vector<std::string>& dfsan_abi_list_files = {},
-      const std::vector<std::string>& convert_to_xla_runtime_abi = {})
+      const std::vector<std::string>& convert_to_xla_runtime_abi = {},
+      ObjectCodeCache* object_cache = nullptr)
       : IRCompiler(llvm::orc::IRSymbolMapper::ManglingOptions()),
         target_machine_(target_machine),
         opt_level_(opt_level),
@@ -60,9 +62,12 @@ class CompilerFunctor : public llvm::orc::IRCompileLayer::IRCompiler {
         post_codegen_hook_(std::move(post_codegen_hook)),
         dfsan_enabled_(dfsan_enabled),
         dfsan_abi_list_files_(dfsan_abi_list_files),
-        convert_to_xla_runtime_abi_(convert_to_xla_runtime_abi) {}
+        convert_to_xla_runtime_abi_(convert_to_xla_runtime_abi),
+        object_cache_(object_cache) {}
 
-  // Compile a Module to an ObjectFile.
+  // Compile a Module to an ObjectFile. If there is an object cache, modules
+  // whose object code is cached are not compiled again, and the post
+  // optimization hook is not called for them.
   llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> operator()(
       llvm::Module& module) override;
 
@@ -79,6 +84,14 @@ class CompilerFunctor : public llvm::orc::IRCompileLayer::IRCompiler {
   const bool dfsan_enabled_ = false;
   const std::vector<std::string> dfsan_abi_list_files_;
   const std::vector<std::string> convert_to_xla_runtime_abi_;
+  // Not owned; may be null.
+  ObjectCodeCache* object_cache_;
+
+  // Returns a description of the options that affect the generated code, for
+  // use in object cache keys.
+  std::string CacheKeyOptions() const;
+
+  void RunPostCodegenHook(const llvm::MemoryBuffer& memory_buffer);
 };
 
 }  // namespace cpu
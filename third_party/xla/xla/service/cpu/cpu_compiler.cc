@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/cpu/cpu_compiler.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -146,6 +147,7 @@ limitations under the License.
 #include "xla/service/cpu/dot_op_emitter.h"
 #include "xla/service/cpu/hlo_xla_runtime_pipeline.h"
 #include "xla/service/cpu/ir_emitter.h"
+#include "xla/service/cpu/object_code_cache.h"
 #include "xla/service/cpu/parallel_task_assignment.h"
 #include "xla/service/cpu/runtime/collectives.h"
 #include "xla/service/cpu/runtime/convolution_call.h"
@@ -1038,6 +1040,24 @@ llvm::CodeGenOptLevel CodeGenOptLevel(const HloModuleConfig& module_config) {
   }
 }
 
+// Returns the object code cache that the JIT should use, or nullptr if object
+// code caching is disabled. Modules found in the cache are not optimized, and
+// the module is split per kernel when there is a cache, so the cache is not
+// used if someone needs to see the IR of the whole module.
+ObjectCodeCache* GetObjectCodeCache(const HloModuleConfig& module_config,
+                                    bool needs_module_ir) {
+  const DebugOptions& debug_options = module_config.debug_options();
+  if (needs_module_ir ||
+      (debug_options.xla_cpu_object_cache_size_mb() <= 0 &&
+       debug_options.xla_cpu_object_cache_dir().empty())) {
+    return nullptr;
+  }
+  return ObjectCodeCache::GetOrCreate(
+      debug_options.xla_cpu_object_cache_dir(),
+      std::max<int64_t>(0, debug_options.xla_cpu_object_cache_size_mb()) *
+          1024 * 1024);
+}
+
 std::pair<LLVMCompiler::ModuleHook, LLVMCompiler::ModuleHook> GetIRModuleHooks(
     const HloModule& hlo_module,
     const LLVMCompiler::ModuleHook& user_pre_optimization_hook,
@@ -1385,6 +1405,11 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   // CpuExecutable to an AOT compilation result.
   std::vector<std::string> obj_files;
 
+  ObjectCodeCache* object_cache = GetObjectCodeCache(
+      module->config(),
+      /*needs_module_ir=*/user_pre_optimization_hook_ != nullptr ||
+          user_post_optimization_hook_ != nullptr ||
+          DumpingEnabledForHloModule(*module));
   auto jit = SimpleOrcJIT::Create(
       CompilerTargetOptions(module->config()),
       CodeGenOptLevel(module->config()),
@@ -1393,7 +1418,7 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
       options::SlpVectorizerDisabled(module->config()),
       llvm_ir::GetCpuFastMathFlags(module->config()), pre_optimization_ir_hook,
       post_optimization_ir_hook,
-      CreateOrcJITPostCompilationHook(module.get(), &obj_files));
+      CreateOrcJITPostCompilationHook(module.get(), &obj_files), object_cache);
   if (!jit) {
     return Internal("Creating JIT failed: %s",
                          llvm::toString(jit.takeError()));
@@ -1458,19 +1483,31 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
 
   TF_RETURN_IF_ERROR(ir_emitter.EmitConstantGlobals());
 
+  // With an object cache, the functions of computations called by control flow
+  // are compiled and cached on their own, so that they are reused when other
+  // parts of the HLO module change. They are called once per iteration or
+  // branch, so they gain little from being inlined.
+  std::unique_ptr<CallGraph> call_graph;
+  if (object_cache != nullptr) call_graph = CallGraph::Build(module.get());
+  std::vector<llvm::Function*> kernels;
   for (ComputationToEmit subcomputation :
        SubcomputationEmissionOrder(entry_computation)) {
     if (subcomputation.computation->IsFusionComputation()) {
       continue;
     }
-    TF_RETURN_IF_ERROR(
-        ir_emitter
-            .EmitComputation(
-                subcomputation.computation, subcomputation.computation->name(),
-                /*is_top_level_computation=*/false,
-                schedule.sequence(subcomputation.computation).instructions(),
-                subcomputation.allow_reassociation)
-            .status());
+    TF_ASSIGN_OR_RETURN(
+        llvm::Function * function,
+        ir_emitter.EmitComputation(
+            subcomputation.computation, subcomputation.computation->name(),
+            /*is_top_level_computation=*/false,
+            schedule.sequence(subcomputation.computation).instructions(),
+            subcomputation.allow_reassociation));
+    if (call_graph != nullptr &&
+        call_graph->GetNode(subcomputation.computation).context() ==
+            CallContext::kControlFlow &&
+        std::find(kernels.begin(), kernels.end(), function) == kernels.end()) {
+      kernels.push_back(function);
+    }
   }
   absl::string_view function_name_prefix = entry_computation->name().empty()
                                                ? "__compute"
@@ -1498,9 +1535,18 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   TF_RETURN_IF_ERROR(VerifyLlvmModule(*llvm_module));
 
   // JIT compile the LLVM IR module to in-memory machine code.
-  llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
-                                                 std::move(llvm_context));
-  cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  if (object_cache != nullptr) {
+    llvm::orc::ThreadSafeContext thread_safe_context(std::move(llvm_context));
+    for (std::unique_ptr<llvm::Module>& part :
+         SplitModuleByKernel(std::move(llvm_module), kernels)) {
+      cantFail((*jit)->AddModule(
+          llvm::orc::ThreadSafeModule(std::move(part), thread_safe_context)));
+    }
+  } else {
+    llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
+                                                   std::move(llvm_context));
+    cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  }
 
   TF_ASSIGN_OR_RETURN(
       auto cpu_executable,
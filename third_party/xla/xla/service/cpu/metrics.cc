@@ -0,0 +1,58 @@
+/* Copyright 2023 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/metrics.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tsl/lib/monitoring/counter.h"
+#include "tsl/lib/monitoring/sampler.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+auto* compile_time_usecs_histogram = tsl::monitoring::Sampler<1>::New(
+    {"/xla/service/cpu/compile_time_usecs_histogram",
+     "The wall-clock time spent on compiling the graphs in microseconds.",
+     "phase"},
+    // These exponential buckets cover the following range:
+    // Minimum: 1 ms
+    // Maximum: 1 ms * 2 ^ 24 == ~4.66 hours
+    {tsl::monitoring::Buckets::Exponential(1000, 2, 25)});
+
+auto* object_cache_lookups = tsl::monitoring::Counter<1>::New(
+    "/xla/service/cpu/object_cache_lookups",
+    "Number of lookups in the object code cache of the CPU JIT.", "result");
+
+}  // namespace
+
+void RecordLlvmToObjectDuration(const uint64_t time_usecs) {
+  static auto* cell = compile_time_usecs_histogram->GetCell("llvm_to_object");
+  cell->Add(time_usecs);
+}
+
+void IncrementObjectCacheLookupCount(absl::string_view result) {
+  object_cache_lookups->GetCell(std::string(result))->IncrementBy(1);
+}
+
+int64_t GetObjectCacheLookupCount(absl::string_view result) {
+  return object_cache_lookups->GetCell(std::string(result))->value();
+}
+
+}  // namespace cpu
+}  // namespace xla
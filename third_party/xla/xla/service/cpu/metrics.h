@@ -0,0 +1,39 @@
+/* Copyright 2023 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_METRICS_H_
+#define XLA_SERVICE_CPU_METRICS_H_
+
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+namespace xla {
+namespace cpu {
+
+// LLVM optimization and code generation of a module (LLVM -> object code).
+void RecordLlvmToObjectDuration(uint64_t time_usecs);
+
+// Counts lookups in the object code cache by `result`, which is one of
+// "memory_hit", "disk_hit" or "miss".
+void IncrementObjectCacheLookupCount(absl::string_view result);
+
+// Gets the number of object code cache lookups with `result`.
+int64_t GetObjectCacheLookupCount(absl::string_view result);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_METRICS_H_
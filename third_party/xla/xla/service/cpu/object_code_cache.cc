@@ -0,0 +1,340 @@
+/* Copyright 2023 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/object_code_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include "xla/service/cpu/metrics.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/random.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+constexpr char kKernelPlaceholderName[] = "__xla_cpu_kernel";
+
+std::string PrintModule(const llvm::Module& module) {
+  std::string ir;
+  llvm::raw_string_ostream ir_stream(ir);
+  module.print(ir_stream, /*AAW=*/nullptr);
+  ir_stream.flush();
+  return ir;
+}
+
+std::string FingerprintToString(const std::string& s) {
+  tsl::Fprint128 fingerprint = tsl::Fingerprint128(s);
+  return absl::StrFormat("%016x%016x", fingerprint.high64, fingerprint.low64);
+}
+
+// Makes `global` visible to other modules. It may end up anywhere in memory,
+// out of the range of PC-relative references.
+void Externalize(llvm::GlobalValue& global) {
+  global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+  global.setDSOLocal(false);
+}
+
+// Adds to `globals` the globals with local linkage that the definitions in
+// `globals` refer to, directly or through other such globals.
+void AddReachableLocals(
+    absl::flat_hash_set<const llvm::GlobalValue*>* globals) {
+  std::vector<const llvm::GlobalValue*> worklist(globals->begin(),
+                                                 globals->end());
+  absl::flat_hash_set<const llvm::Constant*> visited_constants;
+  std::vector<const llvm::Value*> values;
+  auto add_operands = [&values](const llvm::User& user) {
+    for (const llvm::Use& use : user.operands()) values.push_back(use.get());
+  };
+  while (!worklist.empty()) {
+    const llvm::GlobalValue* global = worklist.back();
+    worklist.pop_back();
+    if (const auto* function = llvm::dyn_cast<llvm::Function>(global)) {
+      if (function->hasPersonalityFn()) {
+        values.push_back(function->getPersonalityFn());
+      }
+      for (const llvm::BasicBlock& block : *function) {
+        for (const llvm::Instruction& instruction : block) {
+          add_operands(instruction);
+        }
+      }
+    } else if (const auto* variable =
+                   llvm::dyn_cast<llvm::GlobalVariable>(global)) {
+      if (variable->hasInitializer()) {
+        values.push_back(variable->getInitializer());
+      }
+    }
+    while (!values.empty()) {
+      const llvm::Value* value = values.back();
+      values.pop_back();
+      if (const auto* other = llvm::dyn_cast<llvm::GlobalValue>(value)) {
+        if (other->hasLocalLinkage() && globals->insert(other).second) {
+          worklist.push_back(other);
+        }
+      } else if (const auto* constant = llvm::dyn_cast<llvm::Constant>(value)) {
+        if (visited_constants.insert(constant).second) add_operands(*constant);
+      }
+    }
+  }
+}
+
+// Returns a copy of `module` that only keeps the definitions of `definitions`
+// and of the locals they refer to, and the declarations they use.
+std::unique_ptr<llvm::Module> CloneDefinitions(
+    const llvm::Module& module,
+    absl::flat_hash_set<const llvm::GlobalValue*> definitions) {
+  AddReachableLocals(&definitions);
+  llvm::ValueToValueMapTy value_map;
+  std::unique_ptr<llvm::Module> part = llvm::CloneModule(
+      module, value_map, [&definitions](const llvm::GlobalValue* global) {
+        return definitions.contains(global);
+      });
+  for (llvm::Function& function : llvm::make_early_inc_range(*part)) {
+    if (function.isDeclaration() && function.use_empty()) {
+      function.eraseFromParent();
+    }
+  }
+  for (llvm::GlobalVariable& variable :
+       llvm::make_early_inc_range(part->globals())) {
+    if (variable.isDeclaration() && variable.use_empty()) {
+      variable.eraseFromParent();
+    }
+  }
+  return part;
+}
+
+}  // namespace
+
+/*static*/ ObjectCodeCache* ObjectCodeCache::GetOrCreate(
+    const std::string& directory, int64_t capacity_bytes) {
+  static absl::Mutex mu(absl::kConstInit);
+  static auto* caches =
+      new absl::flat_hash_map<std::string, std::unique_ptr<ObjectCodeCache>>();
+  absl::MutexLock lock(&mu);
+  std::unique_ptr<ObjectCodeCache>& cache = (*caches)[directory];
+  if (cache == nullptr) {
+    cache = std::make_unique<ObjectCodeCache>(directory, capacity_bytes);
+  }
+  return cache.get();
+}
+
+ObjectCodeCache::ObjectCodeCache(std::string directory, int64_t capacity_bytes)
+    : directory_(std::move(directory)), capacity_bytes_(capacity_bytes) {
+  if (!directory_.empty()) {
+    absl::Status status = tsl::Env::Default()->RecursivelyCreateDir(directory_);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to create object code cache directory "
+                   << directory_ << ": " << status;
+    }
+  }
+}
+
+/*static*/ std::string ObjectCodeCache::Key(
+    const llvm::Module& module, const llvm::TargetMachine& target_machine,
+    absl::string_view options) {
+  return FingerprintToString(absl::StrCat(
+      LLVM_VERSION_STRING, "\n", target_machine.getTargetTriple().str(), "\n",
+      target_machine.getTargetCPU().str(), "\n",
+      target_machine.getTargetFeatureString().str(), "\n", options, "\n",
+      PrintModule(module)));
+}
+
+std::unique_ptr<llvm::MemoryBuffer> ObjectCodeCache::Lookup(
+    const std::string& key) {
+  std::shared_ptr<const std::string> object;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+      object = it->second.object;
+    }
+  }
+  if (object != nullptr) {
+    IncrementObjectCacheLookupCount("memory_hit");
+    // The JIT takes ownership of the buffer, and the entry may be evicted
+    // while it is in use, so hand out a copy.
+    return llvm::MemoryBuffer::getMemBufferCopy(*object);
+  }
+
+  if (!directory_.empty()) {
+    tsl::Env* env = tsl::Env::Default();
+    const std::string path = FilePath(key);
+    std::string contents;
+    if (env->FileExists(path).ok() &&
+        tsl::ReadFileToString(env, path, &contents).ok()) {
+      IncrementObjectCacheLookupCount("disk_hit");
+      std::unique_ptr<llvm::MemoryBuffer> buffer =
+          llvm::MemoryBuffer::getMemBufferCopy(contents);
+      absl::MutexLock lock(&mu_);
+      InsertInMemory(key, std::make_shared<const std::string>(
+                              std::move(contents)));
+      return buffer;
+    }
+  }
+
+  IncrementObjectCacheLookupCount("miss");
+  return nullptr;
+}
+
+void ObjectCodeCache::Insert(const std::string& key,
+                             llvm::MemoryBufferRef object) {
+  auto contents = std::make_shared<const std::string>(object.getBuffer());
+
+  if (!directory_.empty()) {
+    // Write to a temporary file first, so that concurrent readers in other
+    // processes never see a partially written object.
+    tsl::Env* env = tsl::Env::Default();
+    const std::string path = FilePath(key);
+    const std::string tmp_path =
+        absl::StrCat(path, ".tmp.", absl::Hex(tsl::random::New64()));
+    absl::Status status = tsl::WriteStringToFile(env, tmp_path, *contents);
+    if (status.ok()) status = env->RenameFile(tmp_path, path);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to write object code cache entry " << path
+                   << ": " << status;
+      env->DeleteFile(tmp_path).IgnoreError();
+    }
+  }
+
+  absl::MutexLock lock(&mu_);
+  InsertInMemory(key, std::move(contents));
+}
+
+int64_t ObjectCodeCache::size_bytes() const {
+  absl::MutexLock lock(&mu_);
+  return size_bytes_;
+}
+
+void ObjectCodeCache::InsertInMemory(
+    const std::string& key, std::shared_ptr<const std::string> object) {
+  const int64_t object_size = object->size();
+  if (object_size > capacity_bytes_) return;
+
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    // Another thread compiled the same module concurrently.
+    lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+    return;
+  }
+
+  while (size_bytes_ + object_size > capacity_bytes_) {
+    auto evicted = entries_.find(lru_.back());
+    size_bytes_ -= evicted->second.object->size();
+    entries_.erase(evicted);
+    lru_.pop_back();
+  }
+  lru_.push_front(key);
+  entries_[key] = Entry{std::move(object), lru_.begin()};
+  size_bytes_ += object_size;
+}
+
+std::string ObjectCodeCache::FilePath(const std::string& key) const {
+  return tsl::io::JoinPath(directory_, absl::StrCat(key, ".o"));
+}
+
+std::vector<std::unique_ptr<llvm::Module>> SplitModuleByKernel(
+    std::unique_ptr<llvm::Module> module,
+    absl::Span<llvm::Function* const> kernels) {
+  // Value names are derived from the names of HLO instructions and
+  // computations, ids included.
+  for (llvm::GlobalVariable& variable : module->globals()) {
+    if (variable.hasLocalLinkage() && variable.isConstant()) {
+      variable.setName("");
+    }
+  }
+  for (llvm::Function& function : *module) {
+    if (function.hasLocalLinkage()) function.setName("");
+    for (llvm::Argument& argument : function.args()) argument.setName("");
+    for (llvm::BasicBlock& block : function) {
+      block.setName("");
+      for (llvm::Instruction& instruction : block) instruction.setName("");
+    }
+  }
+  // Mutable globals such as the RNG state must not be duplicated. They are
+  // defined by the module of the rest.
+  for (llvm::GlobalVariable& variable : module->globals()) {
+    if (variable.hasLocalLinkage() && !variable.isConstant()) {
+      if (!variable.hasName()) variable.setName("__xla_cpu_global");
+      Externalize(variable);
+    }
+  }
+
+  std::vector<std::unique_ptr<llvm::Module>> parts;
+  absl::flat_hash_set<const llvm::GlobalValue*> split_kernels;
+  for (llvm::Function* kernel : kernels) {
+    // The callees of `kernel` have their final names already.
+    kernel->setName(kKernelPlaceholderName);
+    Externalize(*kernel);
+    std::unique_ptr<llvm::Module> part = CloneDefinitions(*module, {kernel});
+    part->setModuleIdentifier("");
+    part->setSourceFileName("");
+    const std::string name = absl::StrCat(
+        kKernelPlaceholderName, "_", FingerprintToString(PrintModule(*part)));
+    if (llvm::Function* same_kernel = module->getFunction(name)) {
+      kernel->replaceAllUsesWith(same_kernel);
+      kernel->eraseFromParent();
+      continue;
+    }
+    kernel->setName(name);
+    part->getFunction(kKernelPlaceholderName)->setName(name);
+    part->setModuleIdentifier(name);
+    part->setSourceFileName(name);
+    split_kernels.insert(kernel);
+    parts.push_back(std::move(part));
+  }
+
+  absl::flat_hash_set<const llvm::GlobalValue*> rest;
+  for (const llvm::GlobalValue& global : module->global_values()) {
+    if (!global.isDeclaration() && !global.hasLocalLinkage() &&
+        !split_kernels.contains(&global)) {
+      rest.insert(&global);
+    }
+  }
+  parts.push_back(CloneDefinitions(*module, std::move(rest)));
+  return parts;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,125 @@
+/* Copyright 2023 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_OBJECT_CODE_CACHE_H_
+#define XLA_SERVICE_CPU_OBJECT_CODE_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Target/TargetMachine.h"
+
+namespace xla {
+namespace cpu {
+
+// Caches the object code that `CompilerFunctor` generates for LLVM modules, so
+// that compiling a module whose IR was compiled before skips LLVM optimization
+// and code generation. The CPU compiler splits its module into one module per
+// kernel (see `SplitModuleByKernel`) before compiling it with a cache, so that
+// a kernel is reused whenever its code is unchanged: when the same HLO module
+// is compiled again, e.g. by another client or (with a cache directory) by
+// another process, but also when the HLO module only differs elsewhere, e.g.
+// because a cluster boundary moved or other shapes changed.
+//
+// Entries live in memory, where the least recently used ones are evicted once
+// they take more than `capacity_bytes`, and optionally in files in a directory
+// that can be shared between processes. A lookup that finds an entry only on
+// disk adds it to memory.
+//
+// Lookups are counted in the /xla/service/cpu/object_cache_lookups metric.
+//
+// This class is thread-safe.
+class ObjectCodeCache {
+ public:
+  // Returns the process-wide cache that stores its files in `directory` (or
+  // no files, if `directory` is empty). The cache is created on first use,
+  // with the in-memory capacity of that call.
+  static ObjectCodeCache* GetOrCreate(const std::string& directory,
+                                      int64_t capacity_bytes);
+
+  ObjectCodeCache(std::string directory, int64_t capacity_bytes);
+
+  // Returns the key under which the object code for `module` is cached.
+  // `options` must describe all compiler options that affect the generated
+  // code other than the target, which is taken from `target_machine`.
+  static std::string Key(const llvm::Module& module,
+                         const llvm::TargetMachine& target_machine,
+                         absl::string_view options);
+
+  // Returns the object code cached under `key`, or nullptr if there is none.
+  std::unique_ptr<llvm::MemoryBuffer> Lookup(const std::string& key);
+
+  // Caches `object` under `key`.
+  void Insert(const std::string& key, llvm::MemoryBufferRef object);
+
+  // The number of bytes of object code cached in memory.
+  int64_t size_bytes() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<const std::string> object;
+    // Position of the key in `lru_`.
+    std::list<std::string>::iterator lru_position;
+  };
+
+  void InsertInMemory(const std::string& key,
+                      std::shared_ptr<const std::string> object)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  std::string FilePath(const std::string& key) const;
+
+  const std::string directory_;
+  const int64_t capacity_bytes_;
+
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<std::string, Entry> entries_ ABSL_GUARDED_BY(mu_);
+  // Keys from the most to the least recently used.
+  std::list<std::string> lru_ ABSL_GUARDED_BY(mu_);
+  int64_t size_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+
+  ObjectCodeCache(const ObjectCodeCache&) = delete;
+  ObjectCodeCache& operator=(const ObjectCodeCache&) = delete;
+};
+
+// Splits `module` into one module per function of `kernels`, and one module
+// for the rest of it, which comes last. `kernels` must list callees before
+// their callers.
+//
+// The module of a kernel defines the kernel and the functions and constants
+// with local linkage that it refers to, which are duplicated in every module
+// that refers to them so that they can still be inlined. Kernels are renamed
+// after a fingerprint of their module, and value names are dropped, so that
+// the module of a kernel only depends on its code and on the code of what it
+// refers to, not on names derived from the rest of the HLO module. Kernels
+// whose modules are identical are merged.
+std::vector<std::unique_ptr<llvm::Module>> SplitModuleByKernel(
+    std::unique_ptr<llvm::Module> module,
+    absl::Span<llvm::Function* const> kernels);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_OBJECT_CODE_CACHE_H_
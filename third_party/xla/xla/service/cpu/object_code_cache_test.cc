@@ -0,0 +1,246 @@
+/* Copyright 2023 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/object_code_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "xla/service/cpu/metrics.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+std::string Contents(const std::unique_ptr<llvm::MemoryBuffer>& buffer) {
+  if (buffer == nullptr) return "<null>";
+  return buffer->getBuffer().str();
+}
+
+void Insert(ObjectCodeCache& cache, const std::string& key,
+            const std::string& object) {
+  cache.Insert(key, llvm::MemoryBufferRef(object, key));
+}
+
+TEST(ObjectCodeCacheTest, LookupReturnsInsertedObject) {
+  ObjectCodeCache cache(/*directory=*/"", /*capacity_bytes=*/1024);
+  const int64_t misses = GetObjectCacheLookupCount("miss");
+  const int64_t hits = GetObjectCacheLookupCount("memory_hit");
+
+  EXPECT_EQ(Contents(cache.Lookup("a")), "<null>");
+  Insert(cache, "a", "object a");
+  EXPECT_EQ(Contents(cache.Lookup("a")), "object a");
+  EXPECT_EQ(cache.size_bytes(), 8);
+
+  EXPECT_EQ(GetObjectCacheLookupCount("miss"), misses + 1);
+  EXPECT_EQ(GetObjectCacheLookupCount("memory_hit"), hits + 1);
+}
+
+TEST(ObjectCodeCacheTest, EvictsLeastRecentlyUsed) {
+  ObjectCodeCache cache(/*directory=*/"", /*capacity_bytes=*/20);
+  Insert(cache, "a", "aaaaaaaa");
+  Insert(cache, "b", "bbbbbbbb");
+  // Make "a" the most recently used entry.
+  EXPECT_EQ(Contents(cache.Lookup("a")), "aaaaaaaa");
+  Insert(cache, "c", "cccccccc");
+
+  EXPECT_EQ(Contents(cache.Lookup("a")), "aaaaaaaa");
+  EXPECT_EQ(Contents(cache.Lookup("b")), "<null>");
+  EXPECT_EQ(Contents(cache.Lookup("c")), "cccccccc");
+  EXPECT_EQ(cache.size_bytes(), 16);
+
+  // Objects larger than the cache are not cached.
+  Insert(cache, "d", std::string(21, 'd'));
+  EXPECT_EQ(Contents(cache.Lookup("d")), "<null>");
+  EXPECT_EQ(cache.size_bytes(), 16);
+}
+
+TEST(ObjectCodeCacheTest, SharesObjectsThroughDirectory) {
+  const std::string directory =
+      tsl::io::JoinPath(tsl::testing::TmpDir(), "object_code_cache_test");
+  {
+    ObjectCodeCache cache(directory, /*capacity_bytes=*/1024);
+    Insert(cache, "a", "object a");
+  }
+  EXPECT_TRUE(tsl::Env::Default()
+                  ->FileExists(tsl::io::JoinPath(directory, "a.o"))
+                  .ok());
+
+  // A cache without an in-memory tier still finds the object on disk.
+  ObjectCodeCache cache(directory, /*capacity_bytes=*/0);
+  const int64_t disk_hits = GetObjectCacheLookupCount("disk_hit");
+  EXPECT_EQ(Contents(cache.Lookup("a")), "object a");
+  EXPECT_EQ(Contents(cache.Lookup("b")), "<null>");
+  EXPECT_EQ(GetObjectCacheLookupCount("disk_hit"), disk_hits + 1);
+}
+
+// A module with two kernels that only differ by their names, and that call a
+// local function and use a constant and a mutable global.
+constexpr absl::string_view kModule = R"(
+@0 = private unnamed_addr constant [2 x i32] [i32 1, i32 2]
+@rng_state = private global i32 7
+
+define internal i32 @add.5(i32 %x, i32 %y) {
+  %sum.6 = add i32 %x, %y
+  ret i32 %sum.6
+}
+
+define internal i32 @body.1(i32 %x) {
+  %c = load i32, ptr @0
+  %r = load i32, ptr @rng_state
+  %a = call i32 @add.5(i32 %x, i32 %c)
+  %b = call i32 @add.5(i32 %a, i32 %r)
+  ret i32 %b
+}
+
+define internal i32 @body.2(i32 %y) {
+  %c.1 = load i32, ptr @0
+  %r.1 = load i32, ptr @rng_state
+  %a.1 = call i32 @add.5(i32 %y, i32 %c.1)
+  %b.1 = call i32 @add.5(i32 %a.1, i32 %r.1)
+  ret i32 %b.1
+}
+
+define i32 @entry(i32 %x) {
+  %a = call i32 @body.1(i32 %x)
+  %b = call i32 @body.2(i32 %a)
+  ret i32 %b
+}
+)";
+
+// The same kernel as in `kModule`, with other names, in a module with another
+// entry function.
+constexpr absl::string_view kOtherModule = R"(
+@0 = private unnamed_addr constant [2 x i32] [i32 1, i32 2]
+@rng_state = private global i32 7
+
+define internal i32 @add.17(i32 %lhs, i32 %rhs) {
+  %add.18 = add i32 %lhs, %rhs
+  ret i32 %add.18
+}
+
+define internal i32 @body.13(i32 %p) {
+  %c = load i32, ptr @0
+  %r = load i32, ptr @rng_state
+  %a = call i32 @add.17(i32 %p, i32 %c)
+  %b = call i32 @add.17(i32 %a, i32 %r)
+  ret i32 %b
+}
+
+define i32 @other_entry(i32 %x) {
+  %a = call i32 @body.13(i32 %x)
+  %b = mul i32 %a, %a
+  ret i32 %b
+}
+)";
+
+std::unique_ptr<llvm::Module> ParseModule(llvm::LLVMContext& context,
+                                          absl::string_view ir) {
+  llvm::SMDiagnostic error;
+  std::unique_ptr<llvm::Module> module = llvm::parseAssemblyString(
+      llvm::StringRef(ir.data(), ir.size()), error, context);
+  CHECK(module != nullptr) << error.getMessage().str();
+  return module;
+}
+
+std::vector<std::unique_ptr<llvm::Module>> Split(
+    std::unique_ptr<llvm::Module> module,
+    const std::vector<std::string>& kernel_names) {
+  std::vector<llvm::Function*> kernels;
+  for (const std::string& name : kernel_names) {
+    kernels.push_back(module->getFunction(name));
+    CHECK(kernels.back() != nullptr) << name;
+  }
+  return SplitModuleByKernel(std::move(module), kernels);
+}
+
+std::string Print(const llvm::Module& module) {
+  std::string ir;
+  llvm::raw_string_ostream stream(ir);
+  module.print(stream, /*AAW=*/nullptr);
+  stream.flush();
+  return ir;
+}
+
+int NumDefinedFunctions(const llvm::Module& module) {
+  int num_defined = 0;
+  for (const llvm::Function& function : module) {
+    if (!function.isDeclaration()) ++num_defined;
+  }
+  return num_defined;
+}
+
+TEST(SplitModuleByKernelTest, SplitsKernelsOut) {
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> parts =
+      Split(ParseModule(context, kModule), {"body.1", "body.2"});
+
+  // The two kernels are identical, so they share a module.
+  ASSERT_EQ(parts.size(), 2);
+  const llvm::Module& kernel = *parts[0];
+  const llvm::Module& rest = *parts[1];
+  EXPECT_FALSE(llvm::verifyModule(kernel, &llvm::errs()));
+  EXPECT_FALSE(llvm::verifyModule(rest, &llvm::errs()));
+
+  // The kernel module defines the kernel and a copy of the function it calls,
+  // and only declares the mutable global.
+  const std::string kernel_name = kernel.getModuleIdentifier();
+  const llvm::Function* kernel_function = kernel.getFunction(kernel_name);
+  ASSERT_NE(kernel_function, nullptr);
+  EXPECT_FALSE(kernel_function->isDeclaration());
+  EXPECT_EQ(NumDefinedFunctions(kernel), 2);
+  ASSERT_NE(kernel.getNamedGlobal("rng_state"), nullptr);
+  EXPECT_TRUE(kernel.getNamedGlobal("rng_state")->isDeclaration());
+
+  // The rest calls the kernel twice and defines the mutable global.
+  ASSERT_NE(rest.getFunction("entry"), nullptr);
+  EXPECT_EQ(NumDefinedFunctions(rest), 1);
+  ASSERT_NE(rest.getFunction(kernel_name), nullptr);
+  EXPECT_TRUE(rest.getFunction(kernel_name)->isDeclaration());
+  EXPECT_EQ(rest.getFunction(kernel_name)->getNumUses(), 2);
+  ASSERT_NE(rest.getNamedGlobal("rng_state"), nullptr);
+  EXPECT_FALSE(rest.getNamedGlobal("rng_state")->isDeclaration());
+}
+
+TEST(SplitModuleByKernelTest, KernelModuleOnlyDependsOnKernelCode) {
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> parts =
+      Split(ParseModule(context, kModule), {"body.1", "body.2"});
+  std::vector<std::unique_ptr<llvm::Module>> other_parts =
+      Split(ParseModule(context, kOtherModule), {"body.13"});
+  ASSERT_EQ(parts.size(), 2);
+  ASSERT_EQ(other_parts.size(), 2);
+
+  EXPECT_EQ(Print(*parts[0]), Print(*other_parts[0]));
+  EXPECT_NE(Print(*parts[1]), Print(*other_parts[1]));
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -32,6 +32,7 @@ limitations under the License.
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/TargetParser/Triple.h"
 #include "xla/service/cpu/compiler_functor.h"
+#include "xla/service/cpu/object_code_cache.h"
 #include "xla/types.h"
 
 namespace xla {
@@ -55,6 +56,9 @@ class SimpleOrcJIT : public llvm::JITEventListener {
   // {pre,post}_optimization_hook is invoked on the module before/after all
   // LLVM IR-level optimizations.  post_codegen_hook is invoked after
   // compiling to machine code.
+  //
+  // If `object_cache` is not null, object code is looked up there before
+  // compiling a module, and added there after compiling it.
   SimpleOrcJIT(
       std::unique_ptr<llvm::orc::ExecutorProcessControl> target_process_control,
       std::unique_ptr<llvm::orc::ExecutionSession> execution_session,
@@ -65,7 +69,8 @@ class SimpleOrcJIT : public llvm::JITEventListener {
       LLVMCompiler::ModuleHook pre_optimization_hook,
       LLVMCompiler::ModuleHook post_optimization_hook,
       absl::AnyInvocable<void(const llvm::object::ObjectFile&)>
-          post_codegen_hook);
+          post_codegen_hook,
+      ObjectCodeCache* object_cache = nullptr);
 
   static llvm::Expected<std::unique_ptr<SimpleOrcJIT>> Create(
       const llvm::TargetOptions& target_options,
@@ -75,7 +80,8 @@ class SimpleOrcJIT : public llvm::JITEventListener {
       LLVMCompiler::ModuleHook pre_optimization_hook,
       LLVMCompiler::ModuleHook post_optimization_hook,
       absl::AnyInvocable<void(const llvm::object::ObjectFile&)>
-          post_codegen_hook);
+          post_codegen_hook,
+      ObjectCodeCache* object_cache = nullptr);
 
   ~SimpleOrcJIT() override;
 